@@ -0,0 +1,85 @@
+#include "../../lib/Lumos.h"
+
+
+// Draws a short loop of a bar going around, saved as PNG frames
+static vector<string> makeFrames(int count){
+    std::filesystem::create_directories("frames");
+    vector<string> paths;
+
+    TextureData frame;
+    for(int i = 0; i < count; i++){
+        TM::acquireTexture(frame, 64, 64);
+        {
+            OverlayScope overlay(frame);
+            SDL_SetRenderDrawColor(Sys::renderer, 0, 0, 0, 0);
+            SDL_RenderClear(Sys::renderer);
+
+            double angle = i * 2 * M_PI / count;
+            SDL_Point end = {32 + (int)(26 * cos(angle)), 32 + (int)(26 * sin(angle))};
+            overlay.line({32, 32}, end, {240, 200, 60, 255}, 6);
+        }
+
+        string path = "frames/frame_" + to_string(i) + ".png";
+        if(TM::saveTexture(frame, path) == NO_ERROR) paths.push_back(path);
+    }
+
+    TM::freeTexture(frame);
+    return paths;
+}
+
+
+
+int main(int argc, char** argv){
+    int error;
+    error = Sys::initWindow("Animation Example");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+
+    // An image sequence, and a GIF if one is given: ./Animation icon.gif
+    Animation sequence, gif;
+    error = sequence.open(makeFrames(24), 40);
+    CHECK_ERROR(error);
+
+    if(argc > 1){
+        error = gif.open(argv[1]);
+        CHECK_ERROR(error);
+    }
+
+
+    // MAIN APP LOOP ---------------------------------------------------
+    cout << "Game Started...\n\n" << endl;
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+        // Space pauses both
+        if(Sys::Keyboard::getKeyDown() == SDLK_SPACE){
+            if(sequence.isPlaying()) { sequence.pause(); gif.pause(); }
+            else { sequence.play(); gif.play(); }
+        }
+
+        error = sequence.update();
+        CHECK_ERROR(error);
+
+        SDL_Rect rect = {100, 100, 128, 128};
+        sequence.render(rect);
+
+        if(argc > 1){
+            gif.update();
+            SDL_Rect gifRect = {300, 100, -1, 256};
+            gif.render(gifRect);
+        }
+
+        SDL_Rect label = {20, 20, -1, 24};
+        GUI::TextDynamic("Frame " + to_string(sequence.getFrameIndex()), label);
+
+        Sys::presentFrame();
+    }
+
+    sequence.close();
+    gif.close();
+    TM::cleanup();
+    return Sys::cleanup();
+}
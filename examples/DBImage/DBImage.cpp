@@ -0,0 +1,51 @@
+#include "../../lib/Lumos.h"
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("DB Image Example");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    // Expects: CREATE TABLE products (id int PRIMARY KEY, image bytea, updated_at timestamptz)
+    error = DB::init("lumos");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    Statement list("productList", "SELECT id, updated_at FROM products ORDER BY id LIMIT 24", 0);
+    Statement image("productImage", "SELECT image FROM products WHERE id = $1", 1);
+    if(DB::prepareStatement(list) != NO_ERROR || DB::prepareStatement(image) != NO_ERROR) exit(EXIT_FAILURE);
+
+    vector<TextureData> thumbnails;
+
+
+    // MAIN APP LOOP ---------------------------------------------------
+    cout << "Game Started...\n\n" << endl;
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+        // Only the ids and versions are queried every second, the images
+        // themselves are fetched only for the new or changed rows
+        DBResult rows;
+        if(Sys::getCurrentFrame() % 60 == 0 && DB::execPrepared(list, {}, rows) == NO_ERROR){
+            thumbnails.resize(rows.rowCount());
+            for(int i = 0; i < rows.rowCount(); i++){
+                error = DB::loadTexture(thumbnails[i], image, rows.getValue(i, 0), rows.getValue(i, 1), false);
+                if(error != NO_ERROR && error != DB_TEXTURE_PENDING) cout << Sys::checkError(error) << endl;
+            }
+        }
+
+        for(int i = 0; i < (int)thumbnails.size(); i++){
+            if(thumbnails[i].tex == nullptr) continue;
+            SDL_Rect dr = {20 + (i % 6) * 130, 20 + (i / 6) * 130, 120, 120};
+            TM::renderTexture(thumbnails[i], dr);
+        }
+
+        Sys::presentFrame();
+    }
+
+    for(TextureData& td : thumbnails) TM::freeTexture(td);
+    TM::cleanup();
+    return Sys::cleanup();
+}
@@ -0,0 +1,37 @@
+#include "../../lib/Lumos.h"
+
+
+// Consumes the frames published by the FrameSink example, without a window
+int main(){
+    FrameSinkReader reader;
+    int error = reader.open("/lumos-frames");
+    if(error != NO_ERROR){
+        cout << "Start the FrameSink example first: " << Sys::checkError(error) << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    FrameSinkReader::Frame frame;
+    while(true){
+        error = reader.wait(frame, 2000);
+        if(error == FRAMESINK_TIMEOUT) break;
+        if(error != NO_ERROR){
+            cout << Sys::checkError(error) << endl;
+            break;
+        }
+
+        // The pixels are read in place, a real consumer would hand them to an encoder here
+        Uint64 sum = 0;
+        for(int y = 0; y < frame.height; y += 16)
+            for(int x = 0; x < frame.width; x += 16) sum += frame.pixels[y * frame.pitch + x * 4];
+
+        bool intact = reader.release();
+        if(frame.sequence % 60 == 0 || !intact){
+            cout << "Frame " << frame.sequence << " (" << frame.width << "x" << frame.height << ")"
+                 << ", skipped: " << reader.getSkipped()
+                 << (intact ? "" : ", overwritten while reading") << endl;
+        }
+    }
+
+    reader.close();
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include "../../lib/Lumos.h"
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("Frame Sink Example");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    // Every presented frame goes into the ring, run FrameReader to consume them
+    error = FrameSink::open("/lumos-frames", 3, FRAMESINK_OVERWRITE);
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+
+    // MAIN APP LOOP ---------------------------------------------------
+    cout << "Game Started...\n\n" << endl;
+    int x = 0;
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+        x = (x + 4) % Sys::winWidth;
+        SDL_Rect rect = {x, Sys::winHeight / 2 - 25, 50, 50};
+        SDL_SetRenderDrawColor(Sys::renderer, 60, 200, 240, 255);
+        SDL_RenderFillRect(Sys::renderer, &rect);
+
+        if(Sys::getCurrentFrame() % 60 == 0){
+            FrameSinkStats stats = FrameSink::getStats();
+            cout << "Published: " << stats.published << ", dropped: " << stats.dropped
+                 << ", readback: " << stats.lastReadbackMs << "ms" << endl;
+        }
+
+        Sys::presentFrame();
+    }
+
+    return Sys::cleanup();
+}
@@ -0,0 +1,72 @@
+#include "../../lib/Lumos.h"
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("Layer Example");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    // State of the panel, everything its content depends on
+    const int COLUMNS = 6, ROWS = 10;
+    int selected = -1;
+    bool showGrid = true;
+
+
+    // MAIN APP LOOP ---------------------------------------------------
+    cout << "Game Started...\n\n" << endl;
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+
+        // A panel of 60 buttons, rendered into a texture once and just blitted
+        // on the next frames. The hash holds the state the panel depends on,
+        // so selecting a button renders it again. Hover colors are picked up
+        // by the layer itself, and the buttons keep returning their state.
+        SDL_Rect panel = {20, 20, 6 * 130 + 10, 10 * 50 + 10};
+        Uint64 hash = (Uint64)(selected + 1) << 1 | showGrid;
+
+        GUI::beginLayer("panel", panel, hash);
+        GUI::Rect(panel, SDL_COLOR_M_GUN);
+
+        static int hovered = -1;
+        int nowHovered = -1;
+        for(int i = 0; i < COLUMNS * ROWS; i++){
+            SDL_Rect button = {panel.x + 10 + (i % COLUMNS) * 130, panel.y + 10 + (i / COLUMNS) * 50, 120, 40};
+
+            SDL_Color color = SDL_COLOR_WHITE;
+            if(i == hovered) color = SDL_COLOR_GRAY;
+            if(i == selected) color = SDL_COLOR_GREEN;
+
+            int state = GUI::Button("Item " + to_string(i), button, SDL_COLOR_BLACK, color);
+            if(state == GUI_CURSOR_CLICKED) selected = i;
+            if(state != GUI_CURSOR_OUTSIDE) nowHovered = i;
+        }
+        hovered = nowHovered;
+
+        if(showGrid){
+            for(int c = 1; c < COLUMNS; c++){
+                int x = panel.x + 5 + c * 130;
+                GUI::Line({x, panel.y + 5}, {x, panel.y + panel.h - 5}, SDL_COLOR_GRAY);
+            }
+        }
+        GUI::endLayer();
+
+
+        // Outside of the layer, drawn every frame
+        int state = GUI::Button(showGrid ? "Hide grid" : "Show grid", {20, panel.y + panel.h + 20, 200, 40});
+        if(state == GUI_CURSOR_CLICKED) showGrid = !showGrid;
+
+        SDL_Rect label = {240, panel.y + panel.h + 30, -1, 20};
+        GUI::TextDynamic("FPS: " + to_string(Sys::getFPS()) + ", selected: " + to_string(selected), label);
+
+
+        Sys::presentFrame();
+    }
+
+    GUI::freeLayer("panel");
+    TM::cleanup();
+    return Sys::cleanup();
+}
@@ -0,0 +1,56 @@
+#include "../../lib/Lumos.h"
+
+
+static const char* TEXT =
+    "Lumos draws this paragraph out of the glyph atlas, wrapped at the width of "
+    "its rect. Move the mouse left and right to change the width, the lines are "
+    "laid out again only when it changes, otherwise the cached layout is drawn.\n"
+    "Newlines always start a new line, and a word too long for the width, like "
+    "Pneumonoultramicroscopicsilicovolcanoconiosis, is broken between its characters.";
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("Paragraph Example");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    // MAIN APP LOOP ---------------------------------------------------
+    cout << "Game Started...\n\n" << endl;
+    const int aligns[3] = {GUI_ALIGN_LEFT, GUI_ALIGN_CENTER, GUI_ALIGN_RIGHT};
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+
+        // App Code and Logic...
+
+        // The wrap width follows the mouse, split between three columns
+        int width = max(60, Sys::Mouse::getPos().x / 3 - 30);
+
+        for(int i = 0; i < 3; i++){
+            // Paragraph wraps the text at the width of the dRect,
+            // the height -1 is replaced by the height of all the lines
+            SDL_Rect dRect = {20 + i * (width + 30), 60, width, -1};
+
+            GUI::pushFontSize(18);          // Line height
+            GUI::pushTextAlignX(aligns[i]);
+            GUI::Paragraph(TEXT, dRect, SDL_COLOR_WHITE);
+
+            GUI::Rect(dRect, SDL_COLOR_GRAY, 1);
+        }
+
+
+        // measureText measures a text without drawing it
+        string info = "Wrap width: " + to_string(width) + "px";
+        SDL_Rect infoRect = {20, 20, GUI::measureText(info, 24), 24};
+        GUI::Text(info, infoRect, SDL_COLOR_GREEN);
+
+
+        Sys::presentFrame();
+    }
+
+    TM::cleanup();
+    return Sys::cleanup();
+}
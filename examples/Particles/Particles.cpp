@@ -0,0 +1,95 @@
+#include "../../lib/Lumos.h"
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("Particles Example");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+
+    // A small dot texture, drawn once with an overlay
+    TextureData dot;
+    error = TM::acquireTexture(dot, 8, 8);
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+    {
+        // Pooled textures keep their old content, the overlay target is cleared first
+        OverlayScope overlay(dot);
+        SDL_SetRenderDrawColor(Sys::renderer, 0, 0, 0, 0);
+        SDL_RenderClear(Sys::renderer);
+        overlay.fillRect({2, 0, 4, 8}, SDL_COLOR_WHITE);
+        overlay.fillRect({0, 2, 8, 4}, SDL_COLOR_WHITE);
+    }
+
+
+    // 60k particles, alarm like fountains of dots and a cursor trail of squares
+    ParticleSystem particles(60000);
+
+    EmitterConfig fountain;
+    fountain.rate = 12000;
+    fountain.spread = M_PI / 6;
+    fountain.speedMin = 250;
+    fountain.speedMax = 450;
+    fountain.lifeMin = 1.5;
+    fountain.lifeMax = 2.5;
+    fountain.sizeStart = 6;
+    fountain.sizeEnd = 2;
+    fountain.colorStart = {255, 60, 40, 255};
+    fountain.colorEnd = {255, 200, 0, 0};
+    fountain.gravity = {0, 300};
+
+    for(int i = 0; i < 2; i++){
+        fountain.position = {(float)Sys::winWidth * (i + 1) / 3, (float)Sys::winHeight - 20};
+        particles.addEmitter(fountain, dot);
+    }
+
+    EmitterConfig trail;
+    trail.rate = 2000;
+    trail.spread = M_PI;
+    trail.speedMin = 10;
+    trail.speedMax = 60;
+    trail.lifeMin = 0.5;
+    trail.lifeMax = 1;
+    trail.sizeStart = 4;
+    trail.sizeEnd = 0;
+    trail.colorStart = SDL_COLOR_CYAN;
+    trail.colorEnd = {0, 0, 255, 0};
+    trail.drag = 2;
+    int cursor = particles.addEmitter(trail);
+
+
+    // MAIN APP LOOP ---------------------------------------------------
+    cout << "Game Started...\n\n" << endl;
+    Uint64 last = SDL_GetPerformanceCounter();
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+        Uint64 now = SDL_GetPerformanceCounter();
+        float dt = (float)(now - last) / SDL_GetPerformanceFrequency();
+        last = now;
+
+        // Follow the cursor, and burst on click
+        SDL_Point mouse = Sys::Mouse::getPos();
+        particles.getEmitter(cursor)->position = {(float)mouse.x, (float)mouse.y};
+        if(Sys::Mouse::isClicked()) particles.burst(cursor, 3000);
+
+        particles.update(dt);
+        particles.render();
+
+        SDL_Rect label = {20, 20, -1, 24};
+        GUI::TextDynamic(
+            to_string(particles.getAliveCount()) + " particles, " +
+            to_string(particles.getSubmissions()) + " draw calls, " +
+            ParticleSystem::getKernelName() + ", " + to_string((int)(1 / max(dt, 0.001f))) + " FPS",
+            label
+        );
+
+        Sys::presentFrame();
+    }
+
+    TM::freeTexture(dot);
+    TM::cleanup();
+    return Sys::cleanup();
+}
@@ -0,0 +1,106 @@
+#include "../../lib/Lumos.h"
+
+
+// Time in ms since the given SDL_GetPerformanceCounter() value
+static double msSince(Uint64 start){
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+
+// Creates a surface of the given format filled with noise
+static SDL_Surface* noiseSurface(int w, int h, Uint32 format){
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, SDL_BITSPERPIXEL(format), format);
+    if(surface == nullptr) return nullptr;
+
+    Uint8* pixels = (Uint8*)surface->pixels;
+    for(size_t i = 0; i < (size_t)surface->pitch * h; i++) pixels[i] = rand();
+
+    // Grayscale images are loaded as 8 bit surfaces with a gray palette
+    if(format == SDL_PIXELFORMAT_INDEX8){
+        SDL_Color gray[256];
+        for(int i = 0; i < 256; i++) gray[i] = {(Uint8)i, (Uint8)i, (Uint8)i, 255};
+        SDL_SetPaletteColors(surface->format->palette, gray, 0, 256);
+    }
+    return surface;
+}
+
+
+int main(){
+    const int W = 4096, H = 4096;
+    const int RUNS = 5;
+
+    cout << "Pixel kernels: " << Pixel::getKernelName() << ", "
+         << Jobs::getThreadCount() + 1 << " threads" << endl << endl;
+
+
+    // FORMAT CONVERSION -----------------------------------------------
+    // SDL_ConvertSurfaceFormat is what TM::loadTexture used before
+    struct { const char* name; Uint32 format; } formats[] = {
+        {"RGB24 ", SDL_PIXELFORMAT_RGB24},
+        {"BGRA32", SDL_PIXELFORMAT_BGRA32},
+        {"ARGB32", SDL_PIXELFORMAT_ARGB32},
+        {"Gray8 ", SDL_PIXELFORMAT_INDEX8}
+    };
+
+    for(auto& f : formats){
+        SDL_Surface* surface = noiseSurface(W, H, f.format);
+        if(surface == nullptr) exit(EXIT_FAILURE);
+
+        double sdlMs = 0, pixelMs = 0;
+        for(int i = 0; i < RUNS; i++){
+            Uint64 start = SDL_GetPerformanceCounter();
+            SDL_Surface* a = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+            sdlMs += msSince(start);
+
+            start = SDL_GetPerformanceCounter();
+            SDL_Surface* b = Pixel::convertToRGBA32(surface);
+            pixelMs += msSince(start);
+
+            // Both should give the same pixels
+            if(i == 0 && memcmp(a->pixels, b->pixels, (size_t)a->pitch * H) != 0){
+                cout << f.name << " results differ!" << endl;
+            }
+            SDL_FreeSurface(a);
+            SDL_FreeSurface(b);
+        }
+
+        cout << f.name << " -> RGBA32   SDL: " << sdlMs / RUNS << " ms,  Pixel: " << pixelMs / RUNS << " ms" << endl;
+        SDL_FreeSurface(surface);
+    }
+    cout << endl;
+
+
+    // ALPHA AND TINT --------------------------------------------------
+    // Single threaded, so it is only the kernel against SDL
+    SDL_Surface* rgba = noiseSurface(W, H, SDL_PIXELFORMAT_RGBA32);
+    if(rgba == nullptr) exit(EXIT_FAILURE);
+    vector<Uint8> out((size_t)W * H * 4);
+    const Uint8* src = (const Uint8*)rgba->pixels;
+
+    double sdlMs = 0, pixelMs = 0, unpremultiplyMs = 0, tintMs = 0;
+    for(int i = 0; i < RUNS; i++){
+        Uint64 start = SDL_GetPerformanceCounter();
+        SDL_PremultiplyAlpha(W, H, SDL_PIXELFORMAT_RGBA32, src, W * 4, SDL_PIXELFORMAT_RGBA32, out.data(), W * 4);
+        sdlMs += msSince(start);
+
+        start = SDL_GetPerformanceCounter();
+        Pixel::premultiply(src, out.data(), W * H);
+        pixelMs += msSince(start);
+
+        start = SDL_GetPerformanceCounter();
+        Pixel::unpremultiply(out.data(), out.data(), W * H);
+        unpremultiplyMs += msSince(start);
+
+        start = SDL_GetPerformanceCounter();
+        Pixel::tint(src, out.data(), W * H, {255, 128, 64, 200});
+        tintMs += msSince(start);
+    }
+
+    cout << "Premultiply     SDL: " << sdlMs / RUNS << " ms,  Pixel: " << pixelMs / RUNS << " ms" << endl;
+    cout << "Unpremultiply   Pixel: " << unpremultiplyMs / RUNS << " ms" << endl;
+    cout << "Tint            Pixel: " << tintMs / RUNS << " ms" << endl;
+
+    SDL_FreeSurface(rgba);
+    Jobs::shutdown();
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "../../lib/Lumos.h"
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("Plot Example");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+
+    // A series holds the samples and draws them decimated to the pixel
+    // width of its rect, min/max keeps every spike, LTTB keeps the shape
+    // with a single point per pixel column
+    PlotSeries minmax(SDL_COLOR_GREEN, 2, PLOT_DECIMATE_MINMAX);
+    PlotSeries lttb(SDL_COLOR_CYAN, 2, PLOT_DECIMATE_LTTB);
+
+    // The view is the data range shown in the rect, 2 million samples here
+    const double SAMPLES = 2000000;
+    minmax.setView(0, SAMPLES, -3, 3);
+    lttb.setView(0, SAMPLES, -3, 3);
+
+    double t = 0;
+    double value = 0;
+
+
+    // MAIN APP LOOP ---------------------------------------------------
+    cout << "Game Started...\n\n" << endl;
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+
+        // Simulated sensor, 5000 new samples every frame
+        // Only the last pixel columns get tessellated again
+        for(int i = 0; i < 5000 && t < SAMPLES; i++, t++){
+            value = value * 0.999 + ((rand() % 2001) - 1000) / 10000.0;
+            if(rand() % 50000 == 0) value += 2;    // Rare spikes
+
+            minmax.append(t, value);
+            lttb.append(t, value);
+        }
+
+        GUI::Rect({20, 20, 1000, 300}, SDL_COLOR_M_GUN);
+        minmax.render({20, 20, 1000, 300});
+
+        GUI::Rect({20, 360, 1000, 300}, SDL_COLOR_M_GUN);
+        lttb.render({20, 360, 1000, 300});
+
+        SDL_Rect label = {30, 25, -1, 20};
+        GUI::TextDynamic(to_string(minmax.size()) + " samples, " + to_string(minmax.getDrawnPoints()) + " drawn (min/max)", label);
+        label = {30, 365, -1, 20};
+        GUI::TextDynamic(to_string(lttb.size()) + " samples, " + to_string(lttb.getDrawnPoints()) + " drawn (LTTB)", label);
+
+
+        // Short lines can be drawn right away, thick and joined
+        SDL_FPoint zigzag[] = {{1060, 40}, {1100, 120}, {1140, 40}, {1180, 120}, {1220, 40}};
+        GUI::Polyline(zigzag, 5, SDL_COLOR_YELLOW, 6);
+
+
+        Sys::presentFrame();
+    }
+
+    TM::cleanup();
+    return Sys::cleanup();
+}
@@ -0,0 +1,89 @@
+#include "../../lib/Lumos.h"
+
+
+// Time in ms since the given SDL_GetPerformanceCounter() value
+static double msSince(Uint64 start){
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+
+// Size of the file in bytes
+static size_t fileSize(const string& path){
+    return filesystem::exists(path) ? filesystem::file_size(path) : 0;
+}
+
+
+int main(){
+    const int W = 2048, H = 2048;
+    const int RUNS = 5;
+
+    // UI LIKE TEST IMAGE ----------------------------------------------
+    // Flat panels, gradients and soft edges, with a bit of noise
+    vector<Uint8> image((size_t)W * H * 4);
+    for(int y = 0; y < H; y++){
+        for(int x = 0; x < W; x++){
+            Uint8* px = &image[((size_t)y * W + x) * 4];
+            int panel = (x / 256 + y / 256) % 3;
+
+            if(panel == 0){
+                px[0] = 32; px[1] = 32; px[2] = 45; px[3] = 255;
+            } else if(panel == 1){
+                px[0] = x / 8; px[1] = y / 8; px[2] = 128; px[3] = 255;
+            } else {
+                px[0] = 200 + rand() % 8; px[1] = 120; px[2] = 40; px[3] = (x % 256) < 16 ? (x % 16) * 16 : 255;
+            }
+        }
+    }
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(image.data(), W, H, 32, W * 4, SDL_PIXELFORMAT_RGBA32);
+    if(surface == nullptr) exit(EXIT_FAILURE);
+
+
+    // ENCODE ----------------------------------------------------------
+    Uint64 start = SDL_GetPerformanceCounter();
+    IMG_SavePNG(surface, "bench.png");
+    double pngSaveMs = msSince(start);
+
+    start = SDL_GetPerformanceCounter();
+    QOI::save("bench.qoi", image.data(), W, H);
+    double qoiSaveMs = msSince(start);
+
+    cout << "Encode   PNG: " << pngSaveMs << " ms (" << fileSize("bench.png") / 1024 << " KB),  "
+         << "QOI: " << qoiSaveMs << " ms (" << fileSize("bench.qoi") / 1024 << " KB)" << endl;
+
+
+    // DECODE ----------------------------------------------------------
+    // IMG_Load and the conversion to RGBA32 is what TM::loadTexture does for the PNG
+    double pngMs = 0, qoiMs = 0;
+    for(int i = 0; i < RUNS; i++){
+        start = SDL_GetPerformanceCounter();
+        SDL_Surface* loaded = IMG_Load("bench.png");
+        SDL_Surface* converted = loaded;
+        if(loaded != nullptr && loaded->format->format != SDL_PIXELFORMAT_RGBA32){
+            converted = Pixel::convertToRGBA32(loaded);
+            SDL_FreeSurface(loaded);
+        }
+        pngMs += msSince(start);
+        SDL_FreeSurface(converted);
+
+        vector<Uint8> pixels;
+        int width, height;
+        start = SDL_GetPerformanceCounter();
+        int err = QOI::load("bench.qoi", pixels, width, height);
+        qoiMs += msSince(start);
+
+        // Lossless, so the pixels must be the same
+        if(i == 0 && (err != NO_ERROR || pixels != image)){
+            cout << "QOI decoded image doesnt match!" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    cout << "Decode   PNG: " << pngMs / RUNS << " ms,  QOI: " << qoiMs / RUNS << " ms" << endl;
+
+    SDL_FreeSurface(surface);
+    remove("bench.png");
+    remove("bench.qoi");
+    Jobs::shutdown();
+    return 0;
+}
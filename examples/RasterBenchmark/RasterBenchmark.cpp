@@ -0,0 +1,179 @@
+#include "../../lib/Lumos.h"
+
+
+// Compares the CPU raster canvas with the SDL renderer on the kinds of
+// draws the other examples do. To compare it with the SDL software
+// renderer, the one used on the machines without a GPU, run it headless:
+//     LUMOS_HEADLESS=1 ./RasterBenchmark
+
+
+// Time in ms since the given SDL_GetPerformanceCounter() value
+static double msSince(Uint64 start){
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+
+// A round sprite with soft edges, premultiplied
+static void makeSprite(RasterImage& image, int size){
+    image.width = image.height = size;
+    image.pixels.resize((size_t)size * size * 4);
+
+    float r = size / 2.0f;
+    for(int y = 0; y < size; y++){
+        for(int x = 0; x < size; x++){
+            float d = std::sqrt((x + 0.5f - r) * (x + 0.5f - r) + (y + 0.5f - r) * (y + 0.5f - r));
+            Uint8 a = (Uint8)(255 * std::clamp(r - d, 0.0f, 1.0f));
+            Uint8* px = &image.pixels[((size_t)y * size + x) * 4];
+            px[0] = a * 240 / 255; px[1] = a * 160 / 255; px[2] = a * 60 / 255; px[3] = a;
+        }
+    }
+}
+
+
+// The same pixels in a texture, for the SDL renderer
+static int toTexture(const RasterImage& image, TextureData& td){
+    int err = TM::acquireTexture(td, image.width, image.height, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING);
+    if(err != NO_ERROR) return err;
+
+    SDL_UpdateTexture(TM::resolve(td), nullptr, image.pixels.data(), image.width * 4);
+    SDL_SetTextureBlendMode(TM::resolve(td), TM::getPremultipliedBlendMode());
+    return NO_ERROR;
+}
+
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("Raster Benchmark");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    const int W = Sys::winWidth, H = Sys::winHeight;
+    const int FRAMES = 60;
+
+    SDL_RendererInfo info;
+    SDL_GetRendererInfo(Sys::renderer, &info);
+    cout << "SDL renderer: " << info.name << ", Pixel kernels: " << Pixel::getKernelName()
+         << ", " << Jobs::getThreadCount() + 1 << " threads" << endl << endl;
+
+
+    // THE DRAWN CONTENT -----------------------------------------------
+    RasterImage sprite, label;
+    makeSprite(sprite, 32);
+
+    TTF_Font* font = TTF_OpenFont("../../assets/fonts/font.ttf", 20);
+    if(font == nullptr) exit(EXIT_FAILURE);
+    SDL_Surface* text = TTF_RenderUTF8_Blended(font, "Settings", SDL_COLOR_WHITE);
+    TTF_CloseFont(font);
+    if(text == nullptr) exit(EXIT_FAILURE);
+    label.fromSurface(text);
+    SDL_FreeSurface(text);
+
+    TextureData spriteTd, labelTd;
+    if(toTexture(sprite, spriteTd) != NO_ERROR || toTexture(label, labelTd) != NO_ERROR) exit(EXIT_FAILURE);
+
+    vector<SDL_Rect> rects, sprites;
+    vector<SDL_Color> colors;
+    for(int i = 0; i < 5000; i++){
+        rects.push_back({rand() % W, rand() % H, 10 + rand() % 120, 10 + rand() % 80});
+        colors.push_back({(Uint8)rand(), (Uint8)rand(), (Uint8)rand(), (Uint8)(64 + rand() % 192)});
+    }
+    for(int i = 0; i < 20000; i++){
+        int size = 8 + rand() % 40;
+        sprites.push_back({rand() % W, rand() % H, size, size});
+    }
+
+    PolylineMesh line(2.0f, {80, 200, 255, 255});
+    for(int i = 0; i < 20000; i++){
+        line.add({(float)i * W / 20000, H / 2 + (float)(sin(i * 0.01) * H / 3 + (rand() % 40 - 20))});
+    }
+
+    RasterCanvas canvas(W, H);
+
+
+    // WORKLOADS -------------------------------------------------------
+    struct Workload{
+        const char* name;
+        function<void()> sdl;
+        function<void()> raster;
+    };
+
+    Workload workloads[] = {
+        {"5000 rects    ",
+            [&](){
+                for(size_t i = 0; i < rects.size(); i++){
+                    SDL_SetRenderDrawColor(Sys::renderer, colors[i].r, colors[i].g, colors[i].b, colors[i].a);
+                    SDL_RenderFillRect(Sys::renderer, &rects[i]);
+                }
+            },
+            [&](){
+                for(size_t i = 0; i < rects.size(); i++) canvas.fillRect(rects[i], colors[i]);
+            }
+        },
+        {"20000 sprites ",
+            [&](){
+                for(SDL_Rect& r : sprites) TM::renderTexture(spriteTd, r);
+            },
+            [&](){
+                for(SDL_Rect& r : sprites) canvas.blit(sprite, nullptr, r);
+            }
+        },
+        {"500 labels    ",
+            [&](){
+                for(int i = 0; i < 500; i++){
+                    SDL_Rect r = {(i % 20) * 60, (i / 20) * 28, label.width, label.height};
+                    TM::renderTexture(labelTd, r);
+                }
+            },
+            [&](){
+                for(int i = 0; i < 500; i++){
+                    canvas.blit(label, nullptr, {(i % 20) * 60, (i / 20) * 28, label.width, label.height});
+                }
+            }
+        },
+        {"20000 pt line ",
+            [&](){ line.render(); },
+            [&](){ line.render(canvas); }
+        }
+    };
+
+
+    // RUN -------------------------------------------------------------
+    for(Workload& w : workloads){
+        double sdlMs = 0, rasterMs = 0;
+
+        for(int f = 0; f < FRAMES && Sys::isRunning; f++){
+            Sys::handleEvents();
+
+            Uint64 start = SDL_GetPerformanceCounter();
+            w.sdl();
+            SDL_RenderFlush(Sys::renderer);     // SDL batches the draws, this makes it do them
+            sdlMs += msSince(start);
+
+            Sys::presentFrame();
+        }
+
+        for(int f = 0; f < FRAMES && Sys::isRunning; f++){
+            Sys::handleEvents();
+
+            Uint64 start = SDL_GetPerformanceCounter();
+            canvas.clear({21, 20, 21, 255});
+            w.raster();
+            canvas.present();
+            SDL_RenderFlush(Sys::renderer);
+            rasterMs += msSince(start);
+
+            Sys::presentFrame();
+        }
+
+        cout << w.name << "  SDL: " << sdlMs / FRAMES << " ms,  Raster: " << rasterMs / FRAMES
+             << " ms (flush " << canvas.getStats().flushMs << " ms)" << endl;
+    }
+
+    TM::freeTexture(spriteTd);
+    TM::freeTexture(labelTd);
+    TM::cleanup();
+    return Sys::cleanup();
+}
@@ -0,0 +1,106 @@
+#include "../../lib/Lumos.h"
+
+
+// Time in ms since the given SDL_GetPerformanceCounter() value
+static double msSince(Uint64 start){
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+
+// Waits for the GPU to finish the queued work, by reading back one pixel
+static void syncGPU(const TextureData& td){
+    Uint32 pixel;
+    SDL_Rect area = {0, 0, 1, 1};
+    SDL_SetRenderTarget(Sys::renderer, TM::resolve(td));
+    SDL_RenderReadPixels(Sys::renderer, &area, SDL_PIXELFORMAT_RGBA32, &pixel, 4);
+    SDL_SetRenderTarget(Sys::renderer, nullptr);
+}
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("Scale Benchmark");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+
+    // 4K TEST IMAGE ---------------------------------------------------
+    // Fine concentric rings, they turn into moire
+    // patterns when downscaled without proper filtering
+    const int W = 3840, H = 2160;
+    vector<Uint8> pixels((size_t)W * H * 4);
+    for(int y = 0; y < H; y++){
+        for(int x = 0; x < W; x++){
+            double dx = x - W / 2.0, dy = y - H / 2.0;
+            Uint8 v = (Uint8)(127.5 + 127.5 * cos((dx*dx + dy*dy) * 0.0005));
+
+            Uint8* p = &pixels[((size_t)y * W + x) * 4];
+            p[0] = v; p[1] = v; p[2] = 255 - v; p[3] = 255;
+        }
+    }
+
+    TextureData image;
+    error = TM::acquireTexture(image, W, H);
+    CHECK_ERROR(error);
+    SDL_UpdateTexture(image.tex, &image.src, pixels.data(), W * 4);
+
+
+    // GPU RESIZE ------------------------------------------------------
+    // TM::resize renders the texture smaller, one sample per pixel
+    TextureData gpu;
+    TM::copy(image, gpu);
+    syncGPU(gpu);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    TM::resize(gpu, 480);
+    syncGPU(gpu);
+    cout << "TM::resize            480px: " << msSince(start) << " ms" << endl;
+
+
+    // CPU VARIANTS ----------------------------------------------------
+    const char* names[] = {"box", "bilinear", "lanczos"};
+    TextureData variants[3];
+
+    for(int filter = TM_FILTER_BOX; filter <= TM_FILTER_LANCZOS; filter++){
+        start = SDL_GetPerformanceCounter();
+        error = TM::scaleVariant(image, variants[filter], 480, -1, filter);
+        CHECK_ERROR(error);
+        double cold = msSince(start);
+
+        // Asking again is only a cache lookup
+        start = SDL_GetPerformanceCounter();
+        TextureData cached;
+        for(int i = 0; i < 1000; i++) TM::scaleVariant(image, cached, 480, -1, filter);
+        double hit = msSince(start) / 1000;
+        TM::freeTexture(cached);
+
+        cout << "TM::scaleVariant " << names[filter] << " 480px: " << cold << " ms, cached: " << hit << " ms" << endl;
+    }
+
+    // Just the CPU scaling, without the read back and upload
+    vector<Uint8> small((size_t)480 * 270 * 4);
+    start = SDL_GetPerformanceCounter();
+    TM::scalePixels(pixels.data(), W, H, small.data(), 480, 270);
+    cout << "TM::scalePixels lanczos 480px: " << msSince(start) << " ms on "
+         << Jobs::getThreadCount() << " worker threads" << endl;
+
+
+    // MAIN APP LOOP ---------------------------------------------------
+    // Shows the GPU resize next to the three filters
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+        SDL_Rect dRect = {10, 10, gpu.width, gpu.height};
+        TM::renderTexture(gpu, dRect);
+
+        for(int i = 0; i < 3; i++){
+            dRect.x = 10 + (i + 1) % 2 * (gpu.width + 10);
+            dRect.y = 10 + (i + 1) / 2 * (gpu.height + 10);
+            TM::renderTexture(variants[i], dRect);
+        }
+
+        Sys::presentFrame();
+    }
+
+    TM::cleanup();
+    return Sys::cleanup();
+}
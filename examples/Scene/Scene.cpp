@@ -0,0 +1,97 @@
+#include "../../lib/Lumos.h"
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("Scene Example");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+
+    // Two sprites, a crate and a moving marker
+    TextureData crate, marker;
+    error = TM::acquireTexture(crate, 32, 32);
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+    error = TM::acquireTexture(marker, 16, 16);
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+    {
+        OverlayScope overlay(crate);
+        overlay.fillRect({0, 0, 32, 32}, {140, 90, 40, 255});
+        overlay.fillRect({3, 3, 26, 26}, {180, 120, 60, 255});
+    }
+    {
+        OverlayScope overlay(marker);
+        overlay.fillRect({0, 0, 16, 16}, {60, 200, 240, 255});
+    }
+
+
+    // 100k objects spread over a 20000x20000 world, the first 2000 of them keep moving
+    const int COUNT = 100000, MOVING = 2000;
+    const float WORLD = 20000;
+    Scene scene(128);
+    vector<int> ids;
+    vector<SDL_FPoint> velocity;
+    for(int i = 0; i < COUNT; i++){
+        bool moving = i < MOVING;
+        SDL_FRect rect = {
+            (float)(rand() % (int)WORLD),
+            (float)(rand() % (int)WORLD),
+            moving ? 16.0f : 32.0f,
+            moving ? 16.0f : 32.0f
+        };
+        ids.push_back(scene.add(moving ? marker : crate, rect, moving ? 1 : 0));
+        if(moving) velocity.push_back({(float)(rand() % 200 - 100) / 20, (float)(rand() % 200 - 100) / 20});
+    }
+
+
+    // MAIN APP LOOP ---------------------------------------------------
+    cout << "Game Started...\n\n" << endl;
+    Camera camera;
+    camera.position = {WORLD / 2, WORLD / 2};
+    camera.zoom = 2.0f;
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+        SDL_Keycode key = Sys::Keyboard::getKeyDown();
+        if(key == SDLK_PLUS || key == SDLK_EQUALS) camera.zoom *= 1.25f;
+        if(key == SDLK_MINUS) camera.zoom /= 1.25f;
+        camera.position.x += 1;
+
+        // Moving objects only touch the grid when they cross into another cell
+        for(int i = 0; i < MOVING; i++){
+            const SDL_FRect* rect = scene.getRect(ids[i]);
+            float x = rect->x + velocity[i].x, y = rect->y + velocity[i].y;
+            if(x < 0 || x > WORLD) velocity[i].x = -velocity[i].x;
+            if(y < 0 || y > WORLD) velocity[i].y = -velocity[i].y;
+            scene.move(ids[i], x, y);
+        }
+
+        // Clicking hides the objects under the mouse
+        if(Sys::Mouse::isClicked()){
+            SDL_Point mouse = Sys::Mouse::getPos();
+            SDL_FPoint world = camera.toWorld({(float)mouse.x, (float)mouse.y});
+            vector<int> hit;
+            scene.query({world.x, world.y, 1, 1}, hit);
+            for(int id : hit) scene.setVisible(id, false);
+        }
+
+        error = scene.render(camera);
+        CHECK_ERROR(error);
+
+        SDL_Rect label = {20, 20, -1, 24};
+        GUI::TextDynamic(
+            to_string(scene.getDrawnCount()) + " of " + to_string(scene.getCount()) +
+            " objects drawn, zoom " + to_string(camera.zoom),
+            label
+        );
+
+        Sys::presentFrame();
+    }
+
+    TM::freeTexture(crate);
+    TM::freeTexture(marker);
+    TM::cleanup();
+    return Sys::cleanup();
+}
@@ -24,12 +24,11 @@ int main(){
         //  - Position and size
         //  - Color (optional)
         //
-        // The Text() function stores the text texture
-        // into memory for faster reuse next frame
-        // that is why this function is good for
-        // rendering some texts that are not that too
-        // often changing, like titles, descriptions, 
-        // states, but not somthing that changes every frame
+        // The text is drawn glyph by glyph out of the glyph
+        // atlas, every glyph is rasterized only once per size,
+        // so any text in any color costs no new textures.
+        // GUI::setTextMode(GUI_TEXT_TEXTURES) switches back to
+        // a cached texture per (text, color) instead
 
         SDL_Rect dRect = {20, 20, -1, 48};
         GUI::Text(
@@ -41,13 +40,22 @@ int main(){
 
         // On the other hand we have Dynamic Text which would be used
         // for something like frame counter, that can definatly not be
-        // reused the next frame, or not that offten
+        // reused the next frame, or not that offten. With the glyph
+        // atlas it is drawn just like GUI::Text
         dRect = {20, 80, -1, 24};
         GUI::TextDynamic(
             "Frame Counter: " + to_string(Sys::getCurrentFrame()),
             dRect
         );
 
+        GlyphAtlasStats stats = GlyphAtlas::getStats();
+        dRect = {20, 120, -1, 18};
+        GUI::Text(
+            "Atlas pages: " + to_string(stats.pages) + ", glyphs: " + to_string(stats.glyphs),
+            dRect,
+            SDL_COLOR_GREEN
+        );
+
 
         // STYLES --------------------------------------------------------
         // No styles
@@ -0,0 +1,46 @@
+#include "../../lib/Lumos.h"
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("TextArea Example");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    // MAIN APP LOOP ---------------------------------------------------
+    cout << "Game Started...\n\n" << endl;
+    int logged = 0;
+    bool notesFilled = false;
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+
+        // App Code and Logic...
+
+        // Text areas are identified by a uniqueId, like inputs. They return
+        // the text as a rope, which can be edited directly, here the first
+        // frame fills the log with 200k lines and every next one appends a line
+        Rope& log = GUI::TextArea("Log", {20, 20, 600, 440}, {40, 40, 40, 255}, SDL_COLOR_WHITE);
+        if(logged == 0){
+            string lines;
+            for(; logged < 200000; logged++) lines += "[" + to_string(logged) + "] worker finished a job\n";
+            log.insert(log.size(), lines);
+        }
+        log.insert(log.size(), "[" + to_string(logged++) + "] frame presented\n");
+
+
+        // Notes, with a pushed line height
+        GUI::pushFontSize(26);
+        Rope& notes = GUI::TextArea("Notes", {640, 20, 300, 440});
+        if(!notesFilled) notes.assign("Click to type,\nthe arrows move the caret\nand Shift selects.");
+        notesFilled = true;
+
+
+        Sys::presentFrame();
+    }
+
+    TM::cleanup();
+    return Sys::cleanup();
+}
@@ -0,0 +1,82 @@
+#include "../../lib/Lumos.h"
+
+
+int main(){
+    int error;
+    error = Sys::initWindow("Tilemap Example");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+    error = Sys::initFont("../../assets/fonts/font.ttf");
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+
+
+    // A tileset of 4 cells of 32x32: floor, wall, door and a highlighted floor
+    TextureData tileset;
+    error = TM::acquireTexture(tileset, 128, 32);
+    if(error != NO_ERROR) exit(EXIT_FAILURE);
+    {
+        OverlayScope overlay(tileset);
+        overlay.fillRect({0, 0, 32, 32}, {60, 60, 70, 255});
+        overlay.fillRect({1, 1, 30, 30}, {80, 80, 92, 255});
+        overlay.fillRect({32, 0, 32, 32}, {200, 200, 210, 255});
+        overlay.fillRect({64, 0, 32, 32}, {80, 80, 92, 255});
+        overlay.fillRect({72, 4, 16, 24}, {160, 100, 40, 255});
+        overlay.fillRect({96, 0, 32, 32}, {60, 60, 70, 255});
+        overlay.fillRect({97, 1, 30, 30}, {40, 160, 80, 255});
+    }
+
+
+    // A 1000x1000 tiles floor plan, rooms of 12x12 with doors
+    Tilemap map(1000, 1000, 32);
+    map.setTileset(tileset);
+    for(int y = 0; y < map.getHeight(); y++){
+        for(int x = 0; x < map.getWidth(); x++){
+            bool wall = x % 12 == 0 || y % 12 == 0;
+            bool door = (x % 12 == 6 && y % 12 == 0) || (y % 12 == 6 && x % 12 == 0);
+            map.setTile(x, y, door ? 2 : wall ? 1 : 0);
+        }
+    }
+
+
+    // MAIN APP LOOP ---------------------------------------------------
+    cout << "Game Started...\n\n" << endl;
+    SDL_FPoint camera = {0, 0};
+    float zoom = 1.0f;
+    while(Sys::isRunning){
+        Sys::handleEvents();
+
+        // Slowly pan over the map
+        camera.x += 2;
+        camera.y += 1;
+
+        SDL_Keycode key = Sys::Keyboard::getKeyDown();
+        if(key == SDLK_PLUS || key == SDLK_EQUALS) zoom *= 1.25f;
+        if(key == SDLK_MINUS) zoom /= 1.25f;
+
+        // Clicking a floor tile highlights it, only its chunk is drawn again
+        SDL_Rect viewport = {0, 0, Sys::winWidth, Sys::winHeight};
+        if(Sys::Mouse::isClicked()){
+            SDL_Point mouse = Sys::Mouse::getPos();
+            int x = (int)((camera.x + mouse.x / zoom) / map.getTileSize());
+            int y = (int)((camera.y + mouse.y / zoom) / map.getTileSize());
+            int tile = map.getTile(x, y);
+            if(tile == 0 || tile == 3) map.setTile(x, y, tile == 0 ? 3 : 0);
+        }
+
+        error = map.render(camera, viewport, zoom);
+        CHECK_ERROR(error);
+
+        SDL_Rect label = {20, 20, -1, 24};
+        GUI::TextDynamic(
+            to_string(map.getVisibleChunks()) + " chunks drawn, " +
+            to_string(map.getChunkRebuilds()) + " chunk rebuilds, zoom " + to_string(zoom),
+            label
+        );
+
+        Sys::presentFrame();
+    }
+
+    TM::freeTexture(tileset);
+    TM::cleanup();
+    return Sys::cleanup();
+}
@@ -0,0 +1,346 @@
+#include "./Animation.h"
+#include "../System/Sys.h"
+#include "../Jobs/Jobs.h"
+
+
+
+// SOURCE ------------------------------------------------------------------------------------------
+// Runs on the jobs
+
+/** Decode Next
+ * 
+ * INTERNAL USE
+ * 
+ * Decodes the next frame of the clip into the staging buffer, going back
+ * to the first one at the end when looping.
+ *
+ * @param loop Animation::loop when the job was given out, it isnt read from the job
+ */
+void Animation::Source::decodeNext(bool loop){
+    end = false;
+    error = isGIF ? decodeGIF(loop) : decodeImage(loop);
+}
+
+
+
+
+/** Decode GIF
+ * 
+ * INTERNAL USE
+ */
+int Animation::Source::decodeGIF(bool loop){
+    staging.resize((size_t)width * height * 4);
+
+    bool clipEnd;
+    int err = gif.next(staging.data(), delay, clipEnd);
+    if(err != NO_ERROR) return err;
+
+    if(clipEnd){
+        if(!loop){
+            end = true;
+            return NO_ERROR;
+        }
+        if(nextIndex == 0) return ANIM_NO_FRAMES;
+
+        err = gif.rewind();
+        if(err != NO_ERROR) return err;
+        nextIndex = 0;
+
+        err = gif.next(staging.data(), delay, clipEnd);
+        if(err != NO_ERROR) return err;
+        if(clipEnd) return ANIM_NO_FRAMES;
+    }
+
+    index = nextIndex++;
+    return NO_ERROR;
+}
+
+
+
+
+/** Decode Image
+ * 
+ * INTERNAL USE
+ */
+int Animation::Source::decodeImage(bool loop){
+    if(nextPath >= paths.size()){
+        if(!loop){
+            end = true;
+            return NO_ERROR;
+        }
+        nextPath = 0;
+        nextIndex = 0;
+    }
+
+    SDL_Surface* loaded = IMG_Load(paths[nextPath].c_str());
+    if(loaded == nullptr) return ANIM_OPEN_FAILED;
+
+    SDL_Surface* surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if(surface == nullptr) return TM_SURFACE_CONVERT_ERROR;
+
+    // The first frame sets the size of the sequence
+    if(width == 0){
+        width = surface->w;
+        height = surface->h;
+    }
+    if(surface->w != width || surface->h != height){
+        SDL_FreeSurface(surface);
+        return ANIM_FRAME_SIZE_MISMATCH;
+    }
+
+    staging.resize((size_t)width * height * 4);
+    for(int y = 0; y < height; y++){
+        memcpy(&staging[(size_t)y * width * 4], (Uint8*)surface->pixels + (size_t)y * surface->pitch, (size_t)width * 4);
+    }
+    SDL_FreeSurface(surface);
+
+    delay = frameMs;
+    index = nextIndex++;
+    nextPath++;
+    return NO_ERROR;
+}
+
+
+
+
+
+// ANIMATION ---------------------------------------------------------------------------------------
+
+/** Animation
+ * 
+ * @param window Number of frames decoded ahead, the shown one included.
+ *               The memory used is about window textures of the clip size.
+ */
+Animation::Animation(int window) : slots(max(2, window)) {}
+
+
+
+
+Animation::~Animation(){
+    close();
+}
+
+
+
+
+/** Open
+ * 
+ * Opens an animated GIF, its frames are decoded while it plays.
+ * 
+ * @param path Path of the GIF file
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Animation::open(const string& path){
+    close();
+
+    shared_ptr<Source> s = make_shared<Source>();
+    int err = s->gif.open(path);
+    if(err != NO_ERROR){
+        lastError = err;
+        return err;
+    }
+
+    s->isGIF = true;
+    s->width = width = s->gif.getWidth();
+    s->height = height = s->gif.getHeight();
+
+    source = s;
+    decodeAhead();
+    return NO_ERROR;
+}
+
+
+
+
+/** Open
+ * 
+ * Opens a sequence of images of the same size, played one after another.
+ * Any format IMG_Load supports can be used.
+ * 
+ * @param paths Paths of the frames, in order
+ * @param frameMs How long each frame is shown, in milliseconds
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Animation::open(const vector<string>& paths, int frameMs){
+    close();
+    if(paths.empty()){
+        lastError = ANIM_NO_FRAMES;
+        return ANIM_NO_FRAMES;
+    }
+
+    source = make_shared<Source>();
+    source->paths = paths;
+    source->frameMs = max(1, frameMs);
+
+    decodeAhead();
+    return NO_ERROR;
+}
+
+
+
+
+/** Close
+ * 
+ * Stops the playback and frees the frame textures. A frame still being
+ * decoded is left to the job, which drops it once done.
+ */
+void Animation::close(){
+    source.reset();
+    for(Slot& slot : slots) TM::freeTexture(slot.td);
+
+    head = 0;
+    ready = 0;
+    decoding = false;
+    decodedAll = false;
+    finished = false;
+    elapsed = 0;
+    width = height = 0;
+    lastError = NO_ERROR;
+}
+
+
+
+
+/** Set Loop
+ * 
+ * @param loop Should the clip start again once it ends, true by default
+ */
+void Animation::setLoop(bool loop){
+    this->loop = loop;
+
+    if(loop && decodedAll){
+        decodedAll = false;
+        finished = false;
+    }
+}
+
+
+
+
+/** Get Frame
+ * 
+ * @return Texture of the shown frame, or nullptr if the first one isnt decoded yet
+ */
+const TextureData* Animation::getFrame() const{
+    return ready > 0 ? &slots[head].td : nullptr;
+}
+
+
+
+
+/** Upload
+ * 
+ * INTERNAL USE
+ * 
+ * Uploads the frame decoded by the job into the next free slot of the ring.
+ * 
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Animation::upload(){
+    Slot& slot = slots[(head + ready) % slots.size()];
+    width = source->width;
+    height = source->height;
+
+    if(slot.td.tex == nullptr || slot.td.width != width || slot.td.height != height){
+        int err = TM::acquireTexture(slot.td, width, height, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING);
+        if(err != NO_ERROR) return err;
+    }
+
+    SDL_Rect area = {0, 0, width, height};
+    if(SDL_UpdateTexture(TM::resolve(slot.td), &area, source->staging.data(), width * 4)) return TM_TEXTURE_UPDATE_ERROR;
+
+    slot.delay = source->delay;
+    slot.index = source->index;
+    if(ready == 0) elapsed = 0;
+    ready++;
+    return NO_ERROR;
+}
+
+
+
+
+/** Decode Ahead
+ * 
+ * INTERNAL USE
+ * 
+ * Gives the next frame to the jobs, if there is a free slot for it.
+ */
+void Animation::decodeAhead(){
+    if(!source || decoding || decodedAll || lastError != NO_ERROR) return;
+    if(ready >= (int)slots.size()) return;
+
+    // The job gets its own copy of loop, setLoop can change it meanwhile
+    decoding = true;
+    source->done.store(false, std::memory_order_relaxed);
+    Jobs::submit([source = this->source, loop = this->loop](){
+        source->decodeNext(loop);
+        source->done.store(true, std::memory_order_release);
+    });
+}
+
+
+
+
+/** Update
+ * 
+ * Collects the decoded frames, moves the playback forward by the time
+ * of the last frame and keeps the ring filled. Call it once a frame.
+ * 
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Animation::update(){
+    if(!source) return ANIM_NOT_OPEN;
+    int error = NO_ERROR;
+
+    // COLLECT THE DECODED FRAME ------------------------------------------------------------
+    if(decoding && source->done.load(std::memory_order_acquire)){
+        decoding = false;
+        if(source->error != NO_ERROR) error = source->error;
+        else if(source->end) decodedAll = true;
+        else error = upload();
+    }
+
+    // ADVANCE BY THE FRAME CLOCK -----------------------------------------------------------
+    if(playing && !finished && ready > 0){
+        elapsed += Sys::deltaTime * speed;
+        while(elapsed >= slots[head].delay){
+            if(ready > 1){
+                elapsed -= slots[head].delay;
+                head = (head + 1) % slots.size();
+                ready--;
+                continue;
+            }
+
+            // The last frame of the clip stays shown
+            if(decodedAll) finished = true;
+
+            // Decoding fell behind, the frame is shown longer instead of rushing later
+            elapsed = slots[head].delay;
+            break;
+        }
+    }
+
+    if(error != NO_ERROR) lastError = error;
+    decodeAhead();
+    return error;
+}
+
+
+
+
+/** Render
+ * 
+ * Draws the shown frame. Nothing is drawn until the first frame is decoded.
+ * 
+ * @param dr Destination rect, -1 for width or height keeps the aspect ratio
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Animation::render(SDL_Rect& dr){
+    if(!source) return ANIM_NOT_OPEN;
+
+    const TextureData* frame = getFrame();
+    if(frame == nullptr) return NO_ERROR;
+
+    return TM::renderTexture(*frame, dr);
+}
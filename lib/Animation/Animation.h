@@ -0,0 +1,143 @@
+#pragma once
+#ifndef MySDL_ANIMATION
+#define MySDL_ANIMATION
+
+#include "../lib.h"
+#include "../TextureManager/TM.h"
+
+
+// GIF DECODER -------------------------------------------------------------------------------------
+// Decodes an animated GIF one frame at a time, reading the file trough a
+// small buffer. Only the composed canvas is kept, never the whole clip,
+// so the memory doesnt grow with the number of frames.
+class GIFDecoder{
+    public:
+    GIFDecoder() = default;
+    GIFDecoder(const GIFDecoder&) = delete;
+    GIFDecoder& operator=(const GIFDecoder&) = delete;
+    ~GIFDecoder();
+
+    int open(const string& path);
+    int next(Uint8* rgba, int& delayMs, bool& end);
+    int rewind();
+    void close();
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    private:
+    SDL_RWops* file = nullptr;
+    Sint64 firstFrame = 0;          // File offset of the first block after the header
+
+    Uint8 buffer[65536];
+    size_t bufferPos = 0, bufferSize = 0;
+
+    int width = 0, height = 0;
+    Uint8 globalPalette[256 * 3];
+    int globalColors = 0;
+
+    vector<Uint8> canvas;           // RGBA32, the frames are composed on it
+    vector<Uint8> saved;            // Canvas before the last frame, for the "restore to previous" disposal
+    vector<Uint8> data;             // LZW data of the current frame
+    vector<Uint8> indices;          // Decoded palette indices of the current frame
+
+    // Disposal of the previous frame, done before the next one is drawn
+    int disposal = 0;
+    SDL_Rect disposalRect = {0, 0, 0, 0};
+
+    bool readBytes(Uint8* out, size_t size);
+    bool readByte(Uint8& out);
+    bool readSubBlocks(vector<Uint8>* out);
+    size_t decodeLZW(int minCodeSize, size_t pixels);
+};
+
+
+
+// ANIMATION ---------------------------------------------------------------------------------------
+// Plays an animated GIF or a sequence of images. Frames are decoded ahead
+// by the jobs, one at a time, and uploaded into a small ring of pooled
+// textures, so the memory is bounded by the decode-ahead window and not
+// by the length of the clip. Playback follows the frame clock, and when
+// decoding falls behind the current frame is simply shown longer.
+class Animation{
+    public:
+    Animation(int window = 4);
+    Animation(const Animation&) = delete;
+    Animation& operator=(const Animation&) = delete;
+    ~Animation();
+
+    int open(const string& path);
+    int open(const vector<string>& paths, int frameMs = 100);
+    void close();
+
+    int update();
+    int render(SDL_Rect& dr);
+
+    void play() { playing = true; }
+    void pause() { playing = false; }
+    void setLoop(bool loop);
+    void setSpeed(float speed) { this->speed = max(speed, 0.0f); }
+
+    bool isPlaying() const { return playing; }
+    bool isFinished() const { return finished; }
+    const TextureData* getFrame() const;
+    int getFrameIndex() const { return ready > 0 ? slots[head].index : -1; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getError() const { return lastError; }
+
+    private:
+    // Decoder state, shared with the job decoding the next frame, so
+    // closing the animation never has to wait for it
+    struct Source{
+        GIFDecoder gif;
+        bool isGIF = false;
+
+        vector<string> paths;       // Image sequence
+        int frameMs = 100;
+        size_t nextPath = 0;
+
+        int width = 0, height = 0;  // Of a sequence known after its first frame
+
+        // Written by the job, read by the main thread once done is set
+        vector<Uint8> staging;      // RGBA32 pixels of the decoded frame
+        int delay = 0;
+        int index = 0;              // Index of the decoded frame in the clip
+        int nextIndex = 0;
+        bool end = false;           // The clip ended and is not looping
+        int error = NO_ERROR;
+        atomic<bool> done{false};
+
+        void decodeNext(bool loop);
+        int decodeGIF(bool loop);
+        int decodeImage(bool loop);
+    };
+
+    struct Slot{
+        TextureData td;
+        int delay = 0;
+        int index = 0;
+    };
+
+    shared_ptr<Source> source;
+    vector<Slot> slots;             // Ring of decoded frames, the shown one is at head
+    int head = 0;
+    int ready = 0;                  // Decoded frames in the ring, the shown one included
+    bool decoding = false;          // A job is decoding the next frame
+    bool decodedAll = false;        // The clip ended and is not looping
+
+    int width = 0, height = 0;
+    bool loop = true;
+    bool playing = true;
+    bool finished = false;
+    float speed = 1.0f;
+    double elapsed = 0;             // Milliseconds the shown frame has been shown
+
+    int lastError = NO_ERROR;
+
+    int upload();
+    void decodeAhead();
+};
+
+#endif
+// Creator: @AndrijaRD
@@ -0,0 +1,357 @@
+#include "./Animation.h"
+
+
+
+GIFDecoder::~GIFDecoder(){
+    close();
+}
+
+
+
+
+/** Open
+ * 
+ * Opens the file and reads its header and the global palette.
+ * 
+ * @param path Path of the GIF file
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int GIFDecoder::open(const string& path){
+    close();
+
+    file = SDL_RWFromFile(path.c_str(), "rb");
+    if(file == nullptr) return ANIM_OPEN_FAILED;
+
+    Uint8 header[13];
+    if(!readBytes(header, sizeof(header))) return ANIM_INVALID_GIF;
+    if(memcmp(header, "GIF87a", 6) != 0 && memcmp(header, "GIF89a", 6) != 0) return ANIM_INVALID_GIF;
+
+    width = header[6] | header[7] << 8;
+    height = header[8] | header[9] << 8;
+    if(width == 0 || height == 0) return ANIM_INVALID_GIF;
+
+    globalColors = 0;
+    if(header[10] & 0x80){
+        globalColors = 1 << ((header[10] & 7) + 1);
+        if(!readBytes(globalPalette, globalColors * 3)) return ANIM_INVALID_GIF;
+    }
+
+    firstFrame = SDL_RWtell(file) - (Sint64)(bufferSize - bufferPos);
+    canvas.assign((size_t)width * height * 4, 0);
+    disposal = 0;
+    return NO_ERROR;
+}
+
+
+
+
+/** Close
+ * 
+ * Closes the file and frees the canvas.
+ */
+void GIFDecoder::close(){
+    if(file != nullptr) SDL_RWclose(file);
+    file = nullptr;
+    bufferPos = bufferSize = 0;
+    width = height = 0;
+
+    vector<Uint8>().swap(canvas);
+    vector<Uint8>().swap(saved);
+    vector<Uint8>().swap(data);
+    vector<Uint8>().swap(indices);
+}
+
+
+
+
+/** Rewind
+ * 
+ * Goes back to the first frame.
+ * 
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int GIFDecoder::rewind(){
+    if(file == nullptr) return ANIM_NOT_OPEN;
+    if(SDL_RWseek(file, firstFrame, RW_SEEK_SET) < 0) return ANIM_OPEN_FAILED;
+
+    bufferPos = bufferSize = 0;
+    std::fill(canvas.begin(), canvas.end(), 0);
+    disposal = 0;
+    return NO_ERROR;
+}
+
+
+
+
+/** Read Bytes
+ * 
+ * INTERNAL USE
+ * 
+ * @return False if the file ended before all the bytes were read
+ */
+bool GIFDecoder::readBytes(Uint8* out, size_t size){
+    while(size > 0){
+        if(bufferPos == bufferSize){
+            bufferSize = SDL_RWread(file, buffer, 1, sizeof(buffer));
+            bufferPos = 0;
+            if(bufferSize == 0) return false;
+        }
+
+        size_t n = min(size, bufferSize - bufferPos);
+        memcpy(out, buffer + bufferPos, n);
+        bufferPos += n;
+        out += n;
+        size -= n;
+    }
+    return true;
+}
+
+
+
+
+/** Read Byte
+ * 
+ * INTERNAL USE
+ */
+bool GIFDecoder::readByte(Uint8& out){
+    return readBytes(&out, 1);
+}
+
+
+
+
+/** Read Sub Blocks
+ * 
+ * INTERNAL USE
+ * 
+ * Reads the data sub-blocks up to the terminating empty one.
+ * 
+ * @param out Filled with the data of all the sub-blocks, or nullptr to skip them
+ * @return False if the file ended
+ */
+bool GIFDecoder::readSubBlocks(vector<Uint8>* out){
+    if(out != nullptr) out->clear();
+
+    Uint8 size, block[255];
+    while(true){
+        if(!readByte(size)) return false;
+        if(size == 0) return true;
+        if(!readBytes(block, size)) return false;
+        if(out != nullptr) out->insert(out->end(), block, block + size);
+    }
+}
+
+
+
+
+/** Decode LZW
+ * 
+ * INTERNAL USE
+ * 
+ * Decodes the LZW data of the frame into palette indices.
+ * Broken data just stops the decoding, the rest of the frame stays as it was.
+ * 
+ * @param minCodeSize LZW minimum code size from the file
+ * @param pixels Number of pixels in the frame
+ * @return Number of decoded pixels
+ */
+size_t GIFDecoder::decodeLZW(int minCodeSize, size_t pixels){
+    indices.resize(pixels);
+
+    Uint16 prefix[4096];
+    Uint8 suffix[4096];
+    Uint8 stack[4097];
+
+    const int clear = 1 << minCodeSize, eoi = clear + 1;
+    for(int i = 0; i < clear; i++){
+        prefix[i] = 0;
+        suffix[i] = i;
+    }
+
+    int codeSize = minCodeSize + 1, next = eoi + 1, old = -1;
+    Uint8 first = 0;
+
+    Uint32 bits = 0;
+    int bitCount = 0;
+    size_t pos = 0, out = 0;
+
+    while(out < pixels){
+        while(bitCount < codeSize){
+            if(pos >= data.size()) return out;
+            bits |= (Uint32)data[pos++] << bitCount;
+            bitCount += 8;
+        }
+        int code = bits & ((1 << codeSize) - 1);
+        bits >>= codeSize;
+        bitCount -= codeSize;
+
+        if(code == clear){
+            codeSize = minCodeSize + 1;
+            next = eoi + 1;
+            old = -1;
+            continue;
+        }
+        if(code == eoi) break;
+
+        if(old == -1){
+            if(code > clear) return out;
+            indices[out++] = code;
+            first = code;
+            old = code;
+            continue;
+        }
+
+        // Walk the string of the code backwards onto the stack
+        int in = code, sp = 0;
+        if(code >= next){
+            if(code > next) return out;
+            stack[sp++] = first;    // The code being defined, the previous string plus its first byte
+            code = old;
+        }
+        while(code >= clear){
+            stack[sp++] = suffix[code];
+            code = prefix[code];
+        }
+        first = code;
+        stack[sp++] = first;
+
+        while(sp > 0 && out < pixels) indices[out++] = stack[--sp];
+
+        if(next < 4096){
+            prefix[next] = old;
+            suffix[next] = first;
+            next++;
+            if(next == (1 << codeSize) && codeSize < 12) codeSize++;
+        }
+        old = in;
+    }
+
+    return out;
+}
+
+
+
+
+/** Next
+ * 
+ * Decodes the next frame and composes it onto the canvas.
+ * 
+ * @param rgba Filled with the composed frame, width * height RGBA32 pixels
+ * @param delayMs Set to how long the frame is shown, in milliseconds
+ * @param end Set to true, with nothing decoded, once there are no more frames
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int GIFDecoder::next(Uint8* rgba, int& delayMs, bool& end){
+    if(file == nullptr) return ANIM_NOT_OPEN;
+    end = false;
+
+    int delay = 0, transparent = -1, frameDisposal = 0;
+    while(true){
+        Uint8 type;
+        if(!readByte(type) || type == 0x3B){     // Trailer, or a file cut short
+            end = true;
+            return NO_ERROR;
+        }
+
+        // EXTENSIONS -----------------------------------------------------------------------
+        if(type == 0x21){
+            Uint8 label;
+            if(!readByte(label)) return ANIM_INVALID_GIF;
+            if(label != 0xF9){
+                if(!readSubBlocks(nullptr)) return ANIM_INVALID_GIF;
+                continue;
+            }
+
+            // Graphic control, applies to the next image
+            if(!readSubBlocks(&data)) return ANIM_INVALID_GIF;
+            if(data.size() >= 4){
+                frameDisposal = (data[0] >> 2) & 7;
+                delay = data[1] | data[2] << 8;
+                transparent = (data[0] & 1) ? data[3] : -1;
+            }
+            continue;
+        }
+
+        if(type != 0x2C) return ANIM_INVALID_GIF;
+
+        // IMAGE DESCRIPTOR -----------------------------------------------------------------
+        Uint8 d[9];
+        if(!readBytes(d, sizeof(d))) return ANIM_INVALID_GIF;
+        int x = d[0] | d[1] << 8, y = d[2] | d[3] << 8;
+        int w = d[4] | d[5] << 8, h = d[6] | d[7] << 8;
+        bool interlaced = d[8] & 0x40;
+
+        Uint8 localPalette[256 * 3];
+        const Uint8* palette = globalPalette;
+        int colors = globalColors;
+        if(d[8] & 0x80){
+            colors = 1 << ((d[8] & 7) + 1);
+            if(!readBytes(localPalette, colors * 3)) return ANIM_INVALID_GIF;
+            palette = localPalette;
+        }
+        if(colors == 0) return ANIM_INVALID_GIF;
+
+        Uint8 minCodeSize;
+        if(!readByte(minCodeSize) || minCodeSize < 2 || minCodeSize > 8) return ANIM_INVALID_GIF;
+        if(!readSubBlocks(&data)) return ANIM_INVALID_GIF;
+
+        // DISPOSE THE PREVIOUS FRAME -------------------------------------------------------
+        if(disposal == 2){
+            SDL_Rect area = disposalRect;
+            for(int row = max(0, area.y); row < min(height, area.y + area.h); row++){
+                int x0 = max(0, area.x), x1 = min(width, area.x + area.w);
+                if(x1 > x0) memset(&canvas[((size_t)row * width + x0) * 4], 0, (size_t)(x1 - x0) * 4);
+            }
+        }
+        else if(disposal == 3 && saved.size() == canvas.size()){
+            canvas = saved;
+        }
+        if(frameDisposal == 3) saved = canvas;
+
+        // DRAW THE FRAME -------------------------------------------------------------------
+        size_t decoded = decodeLZW(minCodeSize, (size_t)w * h);
+
+        // Rows of interlaced images come in four passes
+        static const int passStart[4] = {0, 4, 2, 1}, passStep[4] = {8, 8, 4, 2};
+        int pass = 0, row = 0;
+
+        for(int r = 0; r < h && (size_t)r * w < decoded; r++){
+            int destRow = r;
+            if(interlaced){
+                while(pass < 4 && row >= h){
+                    pass++;
+                    if(pass < 4) row = passStart[pass];
+                }
+                destRow = row;
+                row += passStep[pass];
+            }
+
+            int cy = y + destRow;
+            if(cy < 0 || cy >= height) continue;
+
+            const Uint8* src = &indices[(size_t)r * w];
+            int count = (int)min((size_t)w, decoded - (size_t)r * w);
+            for(int c = 0; c < count; c++){
+                int cx = x + c;
+                if(cx >= width) break;
+
+                int index = src[c];
+                if(index == transparent || index >= colors) continue;
+
+                Uint8* px = &canvas[((size_t)cy * width + cx) * 4];
+                px[0] = palette[index * 3];
+                px[1] = palette[index * 3 + 1];
+                px[2] = palette[index * 3 + 2];
+                px[3] = 255;
+            }
+        }
+
+        disposal = frameDisposal;
+        disposalRect = {x, y, w, h};
+
+        memcpy(rgba, canvas.data(), canvas.size());
+        // Like the browsers, tiny delays are taken as 100ms
+        delayMs = delay < 2 ? 100 : delay * 10;
+        return NO_ERROR;
+    }
+}
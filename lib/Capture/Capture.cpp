@@ -0,0 +1,294 @@
+#include "./Capture.h"
+#include "../System/Sys.h"
+#include "../Jobs/Jobs.h"
+#include "../Qoi/Qoi.h"
+
+
+
+/** Init From Env
+ * 
+ * INTERNAL USE
+ * 
+ * Reads the LUMOS_HEADLESS, LUMOS_CAPTURE and LUMOS_CAPTURE_FRAME
+ * environment variables. Called by Sys::initWindow.
+ */
+void Capture::initFromEnv(){
+    const char* value = SDL_getenv("LUMOS_HEADLESS");
+    headless = value != nullptr && string(value) == "1";
+
+    value = SDL_getenv("LUMOS_CAPTURE");
+    if(value == nullptr || *value == '\0') return;
+
+    string path = value;
+    bool qoi = path.size() >= 4 && path.compare(path.size() - 4, 4, ".qoi") == 0;
+    envRequest = {path, qoi ? CAPTURE_QOI : CAPTURE_PNG};
+
+    value = SDL_getenv("LUMOS_CAPTURE_FRAME");
+    envFrame = value != nullptr ? max(0, atoi(value)) : 30;
+}
+
+
+
+
+/** Is Headless
+ * 
+ * INTERNAL USE
+ * 
+ * @return True if the window should be hidden and rendered in software
+ */
+bool Capture::isHeadless(){ return headless; }
+
+
+
+
+/** Request
+ * 
+ * Captures the next frame presented by Sys::presentFrame into the file.
+ * 
+ * @param path Path of the file to be written
+ * @param format CAPTURE_PNG or CAPTURE_QOI
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Capture::request(const string& path, int format){
+    if(format != CAPTURE_PNG && format != CAPTURE_QOI) return CAPTURE_INVALID_FORMAT;
+
+    requests.push_back({path, format});
+    return NO_ERROR;
+}
+
+
+
+
+/** Start Sequence
+ * 
+ * Captures every n-th presented frame into the directory, as frame_000042.qoi
+ * (or .png), numbered by Sys::getCurrentFrame(). If the jobs fall behind
+ * the capture waits for them, so no frame is dropped.
+ * 
+ * @param directory Directory the frames are written into, it must exist
+ * @param format CAPTURE_PNG or CAPTURE_QOI
+ * @param every Capture every n-th frame
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Capture::startSequence(const string& directory, int format, int every){
+    if(format != CAPTURE_PNG && format != CAPTURE_QOI) return CAPTURE_INVALID_FORMAT;
+
+    sequenceDirectory = directory;
+    sequenceFormat = format;
+    sequenceEvery = max(1, every);
+    return NO_ERROR;
+}
+
+
+
+
+/** Stop Sequence
+ * 
+ * Stops capturing the frames, the already captured ones are still written.
+ */
+void Capture::stopSequence(){ sequenceEvery = 0; }
+
+
+
+
+/** Acquire Buffer
+ * 
+ * INTERNAL USE
+ * 
+ * @param size Size of the buffer in bytes
+ * @return A buffer from the pool, or a new one if there is none
+ */
+vector<Uint8> Capture::acquireBuffer(size_t size){
+    vector<Uint8> buffer;
+    {
+        lock_guard<mutex> lock(poolMutex);
+        if(!freeBuffers.empty()){
+            buffer = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+    }
+
+    // Resizing a pooled buffer of the same size doesnt allocate
+    buffer.resize(size);
+    return buffer;
+}
+
+
+
+
+/** Release Buffer
+ * 
+ * INTERNAL USE
+ * 
+ * Puts the buffer back into the pool, at most maxPending are kept.
+ */
+void Capture::releaseBuffer(vector<Uint8>&& buffer){
+    lock_guard<mutex> lock(poolMutex);
+    if((int)freeBuffers.size() < maxPending) freeBuffers.push_back(std::move(buffer));
+}
+
+
+
+
+/** Write
+ * 
+ * INTERNAL USE
+ * 
+ * Encodes the frame into every requested file. Runs on the jobs.
+ * 
+ * @param pixels Tightly packed RGBA32 pixels of the frame
+ * @param width Width of the frame
+ * @param height Height of the frame
+ * @param requests Files to be written
+ */
+void Capture::write(const vector<Uint8>& pixels, int width, int height, const vector<Request>& requests){
+    for(const Request& req : requests){
+        int err = NO_ERROR;
+
+        if(req.format == CAPTURE_QOI){
+            err = QOI::save(req.path, pixels.data(), width, height);
+        } else {
+            SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(
+                (void*)pixels.data(), width, height, 32, width * 4, SDL_PIXELFORMAT_RGBA32
+            );
+            if(surface == nullptr || IMG_SavePNG(surface, req.path.c_str()) != 0) err = CAPTURE_ENCODE_ERROR;
+            SDL_FreeSurface(surface);
+        }
+
+        lock_guard<mutex> lock(statsMutex);
+        if(err == NO_ERROR){
+            stats.written++;
+        } else {
+            stats.failed++;
+            lastError = err;
+        }
+    }
+}
+
+
+
+
+/** End Frame
+ * 
+ * INTERNAL USE
+ * 
+ * Reads the frame back, if it is to be captured, and hands it to the jobs.
+ * Called by Sys::presentFrame before presenting, since the back buffer
+ * is undefined after SDL_RenderPresent.
+ * 
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Capture::endFrame(){
+    int frame = Sys::getCurrentFrame();
+
+    // COLLECT THE REQUESTS OF THIS FRAME ---------------------------------------------------
+    vector<Request> now;
+    now.swap(requests);
+
+    if(sequenceEvery > 0 && frame % sequenceEvery == 0){
+        char name[32];
+        snprintf(name, sizeof(name), "frame_%06d.%s", frame, sequenceFormat == CAPTURE_QOI ? "qoi" : "png");
+        now.push_back({(filesystem::path(sequenceDirectory) / name).string(), sequenceFormat});
+    }
+
+    bool envCapture = envFrame >= 0 && frame == envFrame;
+    if(envCapture) now.push_back(envRequest);
+
+    if(now.empty()) return NO_ERROR;
+
+    // WAIT FOR THE JOBS IF THEY FELL BEHIND ------------------------------------------------
+    {
+        unique_lock<mutex> lock(statsMutex);
+        doneCV.wait(lock, []{ return stats.pending < maxPending; });
+    }
+
+    // READ BACK ----------------------------------------------------------------------------
+    // From the window, even if a texture was left as the render target
+    SDL_Texture* target = SDL_GetRenderTarget(Sys::renderer);
+    if(target != nullptr) SDL_SetRenderTarget(Sys::renderer, nullptr);
+
+    int width, height;
+    SDL_GetRendererOutputSize(Sys::renderer, &width, &height);
+    vector<Uint8> buffer = acquireBuffer((size_t)width * height * 4);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    int status = SDL_RenderReadPixels(Sys::renderer, NULL, SDL_PIXELFORMAT_RGBA32, buffer.data(), width * 4);
+    double readbackMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    if(target != nullptr) SDL_SetRenderTarget(Sys::renderer, target);
+
+    if(status != 0){
+        releaseBuffer(std::move(buffer));
+        return CAPTURE_READ_PIXELS_FAILED;
+    }
+
+    {
+        lock_guard<mutex> lock(statsMutex);
+        stats.captured++;
+        stats.pending++;
+        stats.lastReadbackMs = readbackMs;
+    }
+
+    // ENCODE AND WRITE ON THE JOBS ---------------------------------------------------------
+    Jobs::submit([buffer = std::move(buffer), width, height, now = std::move(now)]() mutable {
+        Capture::write(buffer, width, height, now);
+        Capture::releaseBuffer(std::move(buffer));
+
+        {
+            lock_guard<mutex> lock(statsMutex);
+            stats.pending--;
+        }
+        doneCV.notify_all();
+    });
+
+    // The environment capture is done, wait for it to be written and quit
+    if(envCapture){
+        Capture::wait();
+        Sys::isRunning = false;
+    }
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Wait
+ * 
+ * Waits until every captured frame is written.
+ */
+void Capture::wait(){
+    unique_lock<mutex> lock(statsMutex);
+    doneCV.wait(lock, []{ return stats.pending == 0; });
+}
+
+
+
+
+/** Get Error
+ * 
+ * Returns the last error of the encoding and writing done on the jobs, and clears it.
+ * 
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Capture::getError(){
+    lock_guard<mutex> lock(statsMutex);
+    int err = lastError;
+    lastError = NO_ERROR;
+    return err;
+}
+
+
+
+
+CaptureStats Capture::getStats(){
+    CaptureStats copy;
+    {
+        lock_guard<mutex> lock(statsMutex);
+        copy = stats;
+    }
+
+    lock_guard<mutex> lock(poolMutex);
+    copy.pooledBuffers = freeBuffers.size();
+    return copy;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef MySDL_CAPTURE
+#define MySDL_CAPTURE
+
+#include "../lib.h"
+
+
+// FORMATS -----------------------------------------------------------------------------------------
+#define CAPTURE_PNG     0       // Smaller files, slow to encode
+#define CAPTURE_QOI     1       // Lossless as well, many times faster to encode
+
+
+
+// CAPTURE STATS -----------------------------------------------------------------------------------
+struct CaptureStats{
+    Uint64 captured = 0;        // Frames read back from the renderer
+    Uint64 written = 0;         // Files encoded and written by the jobs
+    Uint64 failed = 0;          // Files that failed to be encoded or written
+    int pending = 0;            // Frames still being encoded
+    int pooledBuffers = 0;      // Idle readback buffers waiting in the pool
+    double lastReadbackMs = 0;  // Time SDL_RenderReadPixels stalled the last captured frame
+};
+
+
+
+// FRAME CAPTURE -----------------------------------------------------------------------------------
+// Captures the frames Sys::presentFrame presents. Only the readback is
+// done on the main thread, into a pooled buffer, the encoding and the file
+// write are done by the jobs, so capturing doesnt stall the loop.
+//
+// Environment variables, used by the golden image tests:
+//   LUMOS_HEADLESS=1           Hidden window and the software renderer, same output everywhere
+//   LUMOS_CAPTURE=<path>       Captures one frame into the path (.qoi or .png) and quits
+//   LUMOS_CAPTURE_FRAME=<n>    Frame to be captured, 30 by default
+class Capture{
+    friend class Sys;
+
+    private:
+    struct Request{
+        string path;
+        int format;
+    };
+
+    static inline vector<Request> requests;             // Requested for the next presented frame
+
+    static inline string sequenceDirectory;
+    static inline int sequenceFormat = CAPTURE_QOI;
+    static inline int sequenceEvery = 0;                // 0 when no sequence is being captured
+
+    static inline bool headless = false;
+    static inline Request envRequest;
+    static inline int envFrame = -1;                    // Frame captured for LUMOS_CAPTURE
+
+    // Readback buffers, returned by the jobs once the frame is written
+    static inline vector<vector<Uint8>> freeBuffers;
+    static inline mutex poolMutex;
+    static inline const int maxPending = 4;             // Frames in flight before the capture waits
+
+    static inline mutex statsMutex;
+    static inline condition_variable doneCV;
+    static inline CaptureStats stats;
+    static inline int lastError = NO_ERROR;
+
+    static void initFromEnv();
+    static bool isHeadless();
+    static int endFrame();
+
+    static vector<Uint8> acquireBuffer(size_t size);
+    static void releaseBuffer(vector<Uint8>&& buffer);
+    static void write(const vector<Uint8>& pixels, int width, int height, const vector<Request>& requests);
+
+    public:
+    static int request(const string& path, int format = CAPTURE_PNG);
+    static int startSequence(const string& directory, int format = CAPTURE_QOI, int every = 1);
+    static void stopSequence();
+
+    static void wait();
+    static int getError();
+    static CaptureStats getStats();
+};
+
+#endif
+// Creator: @AndrijaRD
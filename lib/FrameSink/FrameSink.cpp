@@ -0,0 +1,468 @@
+#include "./FrameSink.h"
+#include "../System/Sys.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <ctime>
+#endif
+
+
+
+#ifdef __linux__
+
+// Not the private futex flags, the word is shared between processes
+static void futexWake(atomic<Uint32>* word){
+    syscall(SYS_futex, (Uint32*)word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+
+// @return False if it timed out
+static bool futexWait(atomic<Uint32>* word, Uint32 expected, int timeoutMs){
+    timespec timeout = {timeoutMs / 1000, (long)(timeoutMs % 1000) * 1000000};
+    long r = syscall(SYS_futex, (Uint32*)word, FUTEX_WAIT, expected, timeoutMs >= 0 ? &timeout : nullptr, nullptr, 0);
+    return !(r == -1 && errno == ETIMEDOUT);
+}
+
+
+static Uint64 monotonicMs(){
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (Uint64)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+#endif
+
+
+
+// The slot at the index, the slots follow the header
+static FrameSinkSlot* slotByIndex(Uint8* memory, Uint64 index){
+    FrameSinkHeader* h = (FrameSinkHeader*)memory;
+    size_t headerSize = (sizeof(FrameSinkHeader) + 63) & ~(size_t)63;
+    return (FrameSinkSlot*)(memory + headerSize + (size_t)h->slotStride * (index % h->slotCount));
+}
+
+
+
+
+// FRAME SINK --------------------------------------------------------------------------------------
+
+/** Open
+ * 
+ * Creates the shared memory ring and starts publishing the presented frames
+ * into it. The readers open it by the same name with FrameSinkReader.
+ * 
+ * @param name Name of the shared memory, like "/lumos-frames"
+ * @param slots Number of frames in the ring, with FRAMESINK_DROP a reader that
+ * dies holding a frame costs one, so 3 or more keep the frames coming
+ * @param policy FRAMESINK_OVERWRITE or FRAMESINK_DROP
+ * @param maxWidth Largest frame width, 0 for the current size of the window
+ * @param maxHeight Largest frame height, 0 for the current size of the window
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int FrameSink::open(const string& name, int slots, int policy, int maxWidth, int maxHeight){
+#ifdef __linux__
+    close();
+
+    if(maxWidth <= 0 || maxHeight <= 0) SDL_GetRendererOutputSize(Sys::renderer, &maxWidth, &maxHeight);
+    if(maxWidth <= 0 || maxHeight <= 0) return FRAMESINK_FRAME_TOO_LARGE;
+    slots = max(2, slots);
+
+    // Every slot and its pixels start on a cache line
+    size_t pixelOffset = (sizeof(FrameSinkSlot) + 63) & ~(size_t)63;
+    size_t slotStride = (pixelOffset + (size_t)maxWidth * maxHeight * 4 + 63) & ~(size_t)63;
+    size_t headerSize = (sizeof(FrameSinkHeader) + 63) & ~(size_t)63;
+    size_t size = headerSize + slotStride * slots;
+    if(slotStride > UINT32_MAX) return FRAMESINK_FRAME_TOO_LARGE;
+
+    // CREATE THE SHARED MEMORY -------------------------------------------------------------
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if(fd < 0) return FRAMESINK_SHM_FAILED;
+
+    if(ftruncate(fd, size) != 0){
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return FRAMESINK_SHM_FAILED;
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mapped == MAP_FAILED){
+        shm_unlink(name.c_str());
+        return FRAMESINK_SHM_FAILED;
+    }
+
+    memory = (Uint8*)mapped;
+    memorySize = size;
+    shmName = name;
+    FrameSink::policy = policy;
+    stats = FrameSinkStats();
+
+    // HEADER -------------------------------------------------------------------------------
+    // The memory comes zeroed, so every slot starts with seq 0 and no readers
+    FrameSinkHeader* h = new (memory) FrameSinkHeader();
+    h->version = FRAMESINK_VERSION;
+    h->slotCount = slots;
+    h->slotStride = slotStride;
+    h->pixelOffset = pixelOffset;
+    h->maxWidth = maxWidth;
+    h->maxHeight = maxHeight;
+    h->latest.store(0);
+    for(int i = 0; i < slots; i++) new (memory + headerSize + slotStride * i) FrameSinkSlot();
+
+    // Readers check the magic last, once everything else is in place
+    atomic_thread_fence(std::memory_order_release);
+    h->magic = FRAMESINK_MAGIC;
+    return NO_ERROR;
+#else
+    (void)name; (void)slots; (void)policy; (void)maxWidth; (void)maxHeight;
+    return FRAMESINK_UNSUPPORTED;
+#endif
+}
+
+
+
+
+/** Close
+ * 
+ * Stops publishing the frames and removes the shared memory. Readers that
+ * still have it mapped keep it until they close it. Called by Sys::cleanup.
+ */
+void FrameSink::close(){
+#ifdef __linux__
+    if(memory == nullptr) return;
+
+    munmap(memory, memorySize);
+    shm_unlink(shmName.c_str());
+    memory = nullptr;
+    memorySize = 0;
+#endif
+}
+
+
+
+
+/** Get Stats
+ * 
+ * @return Counters of the published and dropped frames
+ */
+FrameSinkStats FrameSink::getStats(){ return stats; }
+
+
+
+
+/** Slot At
+ * 
+ * INTERNAL USE
+ * 
+ * @return Slot holding the frame with the sequence
+ */
+FrameSinkSlot* FrameSink::slotAt(Uint64 sequence){
+    return slotByIndex(memory, sequence - 1);
+}
+
+
+
+
+/** Claim Slot
+ * 
+ * INTERNAL USE
+ * 
+ * Marks a slot as being written with the sequence. With FRAMESINK_DROP it
+ * is the first slot from slotAt(sequence) on that no reader holds, skipping
+ * the one of the newest frame so the readers can always get it. A reader
+ * that died while holding a slot takes only that slot out of the ring.
+ * 
+ * @param sequence Sequence of the frame to be written
+ * @return The claimed slot, nullptr if every slot is held
+ */
+FrameSinkSlot* FrameSink::claimSlot(Uint64 sequence){
+    FrameSinkHeader* h = header();
+    Uint64 writing = sequence * 2 - 1;
+
+    if(policy != FRAMESINK_DROP){
+        FrameSinkSlot* slot = slotAt(sequence);
+        slot->seq.store(writing, std::memory_order_seq_cst);
+        return slot;
+    }
+
+    Uint64 newest = (sequence - 1) * 2;
+    for(Uint32 i = 0; i < h->slotCount; i++){
+        FrameSinkSlot* slot = slotByIndex(memory, sequence - 1 + i);
+        Uint64 previous = slot->seq.load(std::memory_order_relaxed);
+        if(newest != 0 && previous == newest) continue;
+
+        // Marked first and only then checked for readers, a reader counts
+        // itself first and then checks the mark, so one of the two backs off
+        slot->seq.store(writing, std::memory_order_seq_cst);
+        if(slot->readers.load(std::memory_order_seq_cst) == 0) return slot;
+
+        // Held, the frame in it stays as it was
+        slot->seq.store(previous, std::memory_order_seq_cst);
+    }
+    return nullptr;
+}
+
+
+
+
+/** End Frame
+ * 
+ * INTERNAL USE
+ * 
+ * Reads the frame back into the next slot and wakes the readers.
+ * Called by Sys::presentFrame before presenting.
+ * 
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int FrameSink::endFrame(){
+#ifdef __linux__
+    if(memory == nullptr) return NO_ERROR;
+    FrameSinkHeader* h = header();
+
+    int width, height;
+    SDL_GetRendererOutputSize(Sys::renderer, &width, &height);
+    if(width > (int)h->maxWidth || height > (int)h->maxHeight){
+        stats.dropped++;
+        return FRAMESINK_FRAME_TOO_LARGE;
+    }
+
+    Uint64 sequence = h->latest.load(std::memory_order_relaxed) + 1;
+
+    // Readers hold every free slot, never wait for them
+    FrameSinkSlot* slot = FrameSink::claimSlot(sequence);
+    if(slot == nullptr){
+        stats.dropped++;
+        return NO_ERROR;
+    }
+
+    // WRITE THE FRAME ----------------------------------------------------------------------
+    // The odd seq is visible before any of the pixels
+    atomic_thread_fence(std::memory_order_release);
+
+    // From the window, even if a texture was left as the render target
+    SDL_Texture* target = SDL_GetRenderTarget(Sys::renderer);
+    if(target != nullptr) SDL_SetRenderTarget(Sys::renderer, nullptr);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    int status = SDL_RenderReadPixels(Sys::renderer, NULL, SDL_PIXELFORMAT_RGBA32, (Uint8*)slot + h->pixelOffset, width * 4);
+    stats.lastReadbackMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    if(target != nullptr) SDL_SetRenderTarget(Sys::renderer, target);
+
+    if(status != 0){
+        // Leave the slot as not holding any frame
+        slot->seq.store(0, std::memory_order_release);
+        stats.dropped++;
+        return CAPTURE_READ_PIXELS_FAILED;
+    }
+
+    slot->width = width;
+    slot->height = height;
+    slot->pitch = width * 4;
+    slot->format = SDL_PIXELFORMAT_RGBA32;
+    slot->frame = Sys::getCurrentFrame();
+    slot->timeNs = (Uint64)(start * 1e9 / SDL_GetPerformanceFrequency());
+
+    // PUBLISH ------------------------------------------------------------------------------
+    slot->seq.store(sequence * 2, std::memory_order_release);
+    h->latest.store(sequence, std::memory_order_release);
+    h->wake.fetch_add(1, std::memory_order_release);
+    if(h->waiters.load(std::memory_order_acquire) > 0) futexWake(&h->wake);
+
+    stats.published++;
+    return NO_ERROR;
+#else
+    return NO_ERROR;
+#endif
+}
+
+
+
+
+
+// FRAME SINK READER -------------------------------------------------------------------------------
+
+FrameSinkReader::~FrameSinkReader(){
+    close();
+}
+
+
+
+
+/** Open
+ * 
+ * Maps the ring created by FrameSink::open in the rendering process.
+ * 
+ * @param name Name the ring was created with
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int FrameSinkReader::open(const string& name){
+#ifdef __linux__
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if(fd < 0) return FRAMESINK_SHM_FAILED;
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(FrameSinkHeader)){
+        ::close(fd);
+        return FRAMESINK_INVALID;
+    }
+
+    // Read and write, the readers count of the slots is written as well
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mapped == MAP_FAILED) return FRAMESINK_SHM_FAILED;
+
+    memory = (Uint8*)mapped;
+    memorySize = info.st_size;
+
+    FrameSinkHeader* h = header();
+    bool valid = h->magic == FRAMESINK_MAGIC && h->version == FRAMESINK_VERSION;
+    atomic_thread_fence(std::memory_order_acquire);
+
+    size_t headerSize = (sizeof(FrameSinkHeader) + 63) & ~(size_t)63;
+    if(!valid || h->slotCount == 0 || headerSize + (size_t)h->slotStride * h->slotCount > memorySize){
+        close();
+        return FRAMESINK_INVALID;
+    }
+
+    // Start from the newest frame
+    lastSequence = h->latest.load(std::memory_order_acquire);
+    if(lastSequence > 0) lastSequence--;
+    skipped = 0;
+    return NO_ERROR;
+#else
+    (void)name;
+    return FRAMESINK_UNSUPPORTED;
+#endif
+}
+
+
+
+
+/** Close
+ * 
+ * Releases the held frame and unmaps the ring.
+ */
+void FrameSinkReader::close(){
+#ifdef __linux__
+    if(memory == nullptr) return;
+
+    release();
+    munmap(memory, memorySize);
+    memory = nullptr;
+    memorySize = 0;
+#endif
+}
+
+
+
+
+/** Wait
+ * 
+ * Waits for a frame newer then the last one returned and holds its slot.
+ * If the reader fell behind it jumps to the newest frame, the frames in
+ * between are counted as skipped. The previously held frame is released.
+ * 
+ * @param frame Filled with the frame, its pixels point into the shared memory
+ * @param timeoutMs How long to wait in total, -1 for no limit
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int FrameSinkReader::wait(Frame& frame, int timeoutMs){
+#ifdef __linux__
+    if(memory == nullptr) return FRAMESINK_INVALID;
+    release();
+
+    FrameSinkHeader* h = header();
+
+    // Wakeups without a new frame dont restart the timeout
+    Uint64 deadline = timeoutMs >= 0 ? monotonicMs() + timeoutMs : 0;
+
+    while(true){
+        Uint32 wake = h->wake.load(std::memory_order_acquire);
+        Uint64 latest = h->latest.load(std::memory_order_acquire);
+
+        // SLEEP UNTIL THERE IS A NEW FRAME -------------------------------------------------
+        if(latest <= lastSequence){
+            int remaining = -1;
+            if(timeoutMs >= 0){
+                Uint64 now = monotonicMs();
+                if(now >= deadline) return FRAMESINK_TIMEOUT;
+                remaining = deadline - now;
+            }
+
+            h->waiters.fetch_add(1, std::memory_order_acq_rel);
+            bool woken = true;
+            if(h->latest.load(std::memory_order_acquire) <= lastSequence) woken = futexWait(&h->wake, wake, remaining);
+            h->waiters.fetch_sub(1, std::memory_order_acq_rel);
+
+            if(!woken) return FRAMESINK_TIMEOUT;
+            continue;
+        }
+
+        // FIND AND HOLD ITS SLOT ------------------------------------------------------------
+        // The slot is found by its seq, with FRAMESINK_DROP frames go into any free slot
+        FrameSinkSlot* slot = nullptr;
+        for(Uint32 i = 0; i < h->slotCount && slot == nullptr; i++){
+            FrameSinkSlot* candidate = slotByIndex(memory, latest - 1 + i);
+            if(candidate->seq.load(std::memory_order_acquire) == latest * 2) slot = candidate;
+        }
+        if(slot == nullptr) continue;   // Already overwritten, a newer frame is being published
+
+        // Counted first and only then checked, the renderer does it the other way around
+        slot->readers.fetch_add(1, std::memory_order_seq_cst);
+
+        // Already being overwritten by a newer frame, try that one
+        if(slot->seq.load(std::memory_order_seq_cst) != latest * 2){
+            slot->readers.fetch_sub(1, std::memory_order_release);
+            continue;
+        }
+
+        frame.pixels = (const Uint8*)slot + h->pixelOffset;
+        frame.width = slot->width;
+        frame.height = slot->height;
+        frame.pitch = slot->pitch;
+        frame.format = slot->format;
+        frame.sequence = latest;
+        frame.frame = slot->frame;
+        frame.timeNs = slot->timeNs;
+
+        skipped += latest - lastSequence - 1;
+        lastSequence = latest;
+        held = slot;
+        heldSequence = latest;
+        return NO_ERROR;
+    }
+#else
+    (void)frame; (void)timeoutMs;
+    return FRAMESINK_UNSUPPORTED;
+#endif
+}
+
+
+
+
+/** Release
+ * 
+ * Lets the renderer reuse the slot of the held frame.
+ * 
+ * @return True if the frame stayed intact while it was held. With
+ *         FRAMESINK_OVERWRITE a slow reader can get it overwritten.
+ */
+bool FrameSinkReader::release(){
+    if(held == nullptr) return true;
+
+    atomic_thread_fence(std::memory_order_acquire);
+    bool intact = held->seq.load(std::memory_order_relaxed) == heldSequence * 2;
+    held->readers.fetch_sub(1, std::memory_order_release);
+
+    held = nullptr;
+    return intact;
+}
@@ -0,0 +1,138 @@
+#pragma once
+#ifndef MySDL_FRAMESINK
+#define MySDL_FRAMESINK
+
+#include "../lib.h"
+
+
+// POLICIES ----------------------------------------------------------------------------------------
+#define FRAMESINK_OVERWRITE     0   // The oldest slot is always reused, readers notice it trough the sequence
+#define FRAMESINK_DROP          1   // The new frame goes into a slot no reader holds, and is dropped if there is none
+
+#define FRAMESINK_MAGIC         0x53464d4c  // "LMFS"
+#define FRAMESINK_VERSION       2
+
+
+
+// SHARED MEMORY LAYOUT ----------------------------------------------------------------------------
+// The header is followed by slotCount slots, slotStride bytes apart. With
+// FRAMESINK_OVERWRITE the frame with the sequence s is in the slot
+// (s - 1) % slotCount, with FRAMESINK_DROP in any slot no reader held, so
+// readers find a frame by its seq. Each slot is a seqlock: seq is odd while
+// the frame is being written and 2 * s once it is published, so a reader
+// compares it before and after reading. The writer marks seq odd before it
+// looks at readers, and a reader counts itself in readers before it looks
+// at seq, both sequentially consistent, so they never both miss each other.
+struct FrameSinkHeader{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 slotCount;
+    Uint32 slotStride;              // Bytes from one slot to the next
+    Uint32 pixelOffset;             // Bytes from the start of a slot to its pixels
+    Uint32 maxWidth;
+    Uint32 maxHeight;
+    atomic<Uint32> wake;            // Futex word, bumped with every published frame
+    atomic<Uint32> waiters;         // Readers sleeping on it, the renderer skips the wake syscall without them
+    atomic<Uint64> latest;          // Sequence of the newest frame, 0 before the first one
+};
+
+struct FrameSinkSlot{
+    atomic<Uint64> seq;
+    atomic<Uint32> readers;         // Readers holding the slot
+    Uint32 width;
+    Uint32 height;
+    Uint32 pitch;
+    Uint32 format;                  // SDL_PIXELFORMAT_RGBA32
+    Uint32 frame;                   // Sys::getCurrentFrame() of the renderer
+    Uint64 timeNs;                  // When it was read back, SDL_GetPerformanceCounter in nanoseconds
+};
+
+static_assert(atomic<Uint64>::is_always_lock_free, "Frame sink needs lock free atomics in shared memory");
+
+
+
+// FRAME SINK STATS --------------------------------------------------------------------------------
+struct FrameSinkStats{
+    Uint64 published = 0;       // Frames written into the ring
+    Uint64 dropped = 0;         // Frames not written, held slot or too large
+    double lastReadbackMs = 0;  // Time SDL_RenderReadPixels stalled the last published frame
+};
+
+
+
+// FRAME SINK --------------------------------------------------------------------------------------
+// Publishes every presented frame into a POSIX shared memory ring, for an
+// encoder or any other process to pick up. The frame is read back straight
+// into the slot, and the renderer never waits for the readers: depending on
+// the policy a slow reader either gets its frame overwritten or makes the
+// new frames drop. Readers are woken trough a futex. Linux only.
+class FrameSink{
+    friend class Sys;
+
+    private:
+    static inline Uint8* memory = nullptr;
+    static inline size_t memorySize = 0;
+    static inline string shmName;
+    static inline int policy = FRAMESINK_OVERWRITE;
+
+    static inline FrameSinkStats stats;
+
+    static FrameSinkHeader* header() { return (FrameSinkHeader*)memory; }
+    static FrameSinkSlot* slotAt(Uint64 sequence);
+    static FrameSinkSlot* claimSlot(Uint64 sequence);
+
+    static int endFrame();
+
+    public:
+    static int open(const string& name, int slots = 3, int policy = FRAMESINK_OVERWRITE, int maxWidth = 0, int maxHeight = 0);
+    static void close();
+    static bool isOpen() { return memory != nullptr; }
+
+    static FrameSinkStats getStats();
+};
+
+
+
+// FRAME SINK READER -------------------------------------------------------------------------------
+// The other end of the ring, used by the consuming process. Frames are
+// read in place, the slot is held from wait() until release().
+class FrameSinkReader{
+    public:
+    struct Frame{
+        const Uint8* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        int pitch = 0;
+        Uint32 format = 0;
+        Uint64 sequence = 0;
+        Uint32 frame = 0;
+        Uint64 timeNs = 0;
+    };
+
+    FrameSinkReader() = default;
+    FrameSinkReader(const FrameSinkReader&) = delete;
+    FrameSinkReader& operator=(const FrameSinkReader&) = delete;
+    ~FrameSinkReader();
+
+    int open(const string& name);
+    void close();
+
+    int wait(Frame& frame, int timeoutMs = -1);
+    bool release();
+
+    Uint64 getSkipped() const { return skipped; }
+
+    private:
+    Uint8* memory = nullptr;
+    size_t memorySize = 0;
+
+    FrameSinkSlot* held = nullptr;
+    Uint64 heldSequence = 0;
+    Uint64 lastSequence = 0;
+    Uint64 skipped = 0;         // Published frames never returned by wait
+
+    FrameSinkHeader* header() const { return (FrameSinkHeader*)memory; }
+};
+
+#endif
+// Creator: @AndrijaRD
@@ -0,0 +1,128 @@
+#pragma once
+#ifndef MySDL_FLATMAP
+#define MySDL_FLATMAP
+
+#include "../lib.h"
+
+
+// FLAT MAP ----------------------------------------------------------------------------------------
+// Open addressing hash map from 64-bit keys, usually hashed ids, to values
+// stored inline in a single array. Linear probing, with backward shift on
+// erase so there are no tombstones. Lookups never allocate, inserts only
+// when the table grows. Pointers to the values are valid until the next
+// insert or erase.
+template<typename V>
+class FlatMap{
+    public:
+    FlatMap(size_t capacity = 16){ rehash(capacity); }
+
+    V* find(Uint64 key){
+        key = fix(key);
+        for(size_t i = mix(key) & mask;; i = (i + 1) & mask){
+            if(slots[i].key == key) return &slots[i].value;
+            if(slots[i].key == 0) return nullptr;
+        }
+    }
+
+    // The value of the key, default constructed if it isnt in the map
+    V& operator[](Uint64 key){
+        V* found = find(key);
+        if(found != nullptr) return *found;
+        return insert(key, V());
+    }
+
+    // Assumes the key isnt in the map yet
+    V& insert(Uint64 key, V value){
+        if((count + 1) * 2 > slots.size()) rehash(slots.size() * 2);
+
+        key = fix(key);
+        size_t i = mix(key) & mask;
+        while(slots[i].key != 0) i = (i + 1) & mask;
+
+        slots[i].key = key;
+        slots[i].value = std::move(value);
+        count++;
+        return slots[i].value;
+    }
+
+    bool erase(Uint64 key){
+        key = fix(key);
+        size_t i = mix(key) & mask;
+        while(slots[i].key != key){
+            if(slots[i].key == 0) return false;
+            i = (i + 1) & mask;
+        }
+
+        // Shift the following entries of the cluster back into the hole,
+        // unless that would move them before their home slot
+        for(size_t j = (i + 1) & mask; slots[j].key != 0; j = (j + 1) & mask){
+            size_t home = mix(slots[j].key) & mask;
+            if(((j - home) & mask) >= ((j - i) & mask)){
+                slots[i].key = slots[j].key;
+                slots[i].value = std::move(slots[j].value);
+                i = j;
+            }
+        }
+
+        slots[i].key = 0;
+        slots[i].value = V();
+        count--;
+        return true;
+    }
+
+    void clear(){
+        for(Slot& slot : slots){
+            slot.key = 0;
+            slot.value = V();
+        }
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Calls f(key, value) for every entry, the map must not change meanwhile
+    template<typename F>
+    void forEach(F f){
+        for(Slot& slot : slots) if(slot.key != 0) f(slot.key, slot.value);
+    }
+
+    private:
+    struct Slot{
+        Uint64 key = 0;     // 0 marks an empty slot
+        V value = V();
+    };
+
+    vector<Slot> slots;
+    size_t mask = 0;
+    size_t count = 0;
+
+    // 0 is the empty slot, so that key is stored as 1
+    static Uint64 fix(Uint64 key){ return key != 0 ? key : 1; }
+
+    // Spreads the bits, so keys differing only in the high bits dont collide
+    static size_t mix(Uint64 key){
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return (size_t)key;
+    }
+
+    void rehash(size_t capacity){
+        size_t size = 16;
+        while(size < capacity) size *= 2;
+
+        vector<Slot> old = std::move(slots);
+        slots.clear();
+        slots.resize(size);
+        mask = size - 1;
+        count = 0;
+
+        for(Slot& slot : old){
+            if(slot.key != 0) insert(slot.key, std::move(slot.value));
+        }
+    }
+};
+
+#endif
+// Creator: @AndrijaRD
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef MySDL_GAPBUFFER
+#define MySDL_GAPBUFFER
+
+#include "../lib.h"
+
+
+// GAP BUFFER --------------------------------------------------------------------------------------
+// Sequence with a gap of free space kept at the last edit. Inserting or
+// erasing at the gap is O(1), the gap only moves by the distance to the
+// next edit, so typing and deleting around a caret never shifts the rest
+// of the sequence. Grows by doubling, like a vector.
+template<typename T>
+class GapBuffer{
+    public:
+    int size() const { return buffer.size() - (gapEnd - gapBegin); }
+    bool empty() const { return size() == 0; }
+
+    T& operator[](int i){ return buffer[i < gapBegin ? i : i + (gapEnd - gapBegin)]; }
+    const T& operator[](int i) const { return buffer[i < gapBegin ? i : i + (gapEnd - gapBegin)]; }
+
+    void insert(int pos, const T& item){
+        if(gapBegin == gapEnd) grow(1);
+        moveGap(pos);
+        buffer[gapBegin++] = item;
+    }
+
+    void erase(int pos, int count){
+        if(count <= 0) return;
+        moveGap(pos);
+        gapEnd += count;
+    }
+
+    void clear(){
+        gapBegin = 0;
+        gapEnd = buffer.size();
+    }
+
+    private:
+    vector<T> buffer;
+    int gapBegin = 0;       // [gapBegin, gapEnd) of buffer is free
+    int gapEnd = 0;
+
+    void moveGap(int pos){
+        if(pos < gapBegin){
+            // The items before the gap move behind it
+            int n = gapBegin - pos;
+            std::move_backward(buffer.begin() + pos, buffer.begin() + gapBegin, buffer.begin() + gapEnd);
+            gapBegin -= n;
+            gapEnd -= n;
+        } else if(pos > gapBegin){
+            int n = pos - gapBegin;
+            std::move(buffer.begin() + gapEnd, buffer.begin() + gapEnd + n, buffer.begin() + gapBegin);
+            gapBegin += n;
+            gapEnd += n;
+        }
+    }
+
+    void grow(int needed){
+        int items = size();
+        int capacity = max<int>(16, max<int>(buffer.size() * 2, items + needed));
+
+        // The items after the gap go to the end of the larger buffer
+        int after = buffer.size() - gapEnd;
+        buffer.resize(capacity);
+        std::move_backward(buffer.begin() + gapEnd, buffer.begin() + gapEnd + after, buffer.end());
+        gapEnd = capacity - after;
+    }
+};
+
+#endif
+// Creator: @AndrijaRD
@@ -0,0 +1,411 @@
+#include "./Rope.h"
+
+
+
+/** Insert
+ *
+ * Inserts the text at the byte offset. Text that fits in a chunk goes
+ * into the chunk at the offset, larger text is added as chunks of its own.
+ *
+ * @param pos Byte offset, clamped to the size
+ * @param text UTF-8 text
+ */
+void Rope::insert(size_t pos, string_view text){
+    if(text.empty()) return;
+    pos = min(pos, size());
+    edits++;
+    edited = min(edited, pos);
+
+    if(root != -1 && text.size() <= ROPE_CHUNK){
+        size_t chunkStart = 0;
+        int chunk = editChunk(root, pos, 0, text, chunkStart);
+
+        // A chunk grown over twice the size is split in half, so edits stay small
+        size_t chunkSize = nodes[chunk].text.size();
+        if(chunkSize > 2 * ROPE_CHUNK){
+            int left, right;
+            split(root, chunkStart + chunkSize / 2, left, right);
+            root = merge(left, right);
+        }
+        return;
+    }
+
+    int left, right;
+    split(root, pos, left, right);
+    root = merge(merge(left, build(text)), right);
+}
+
+
+
+
+/** Erase
+ *
+ * Removes the bytes in [from, to).
+ *
+ * @param from First byte
+ * @param to One past the last byte, clamped to the size
+ */
+void Rope::erase(size_t from, size_t to){
+    to = min(to, size());
+    if(from >= to) return;
+    edits++;
+    edited = min(edited, from);
+
+    // Within one chunk only its text changes
+    size_t chunkStart = 0;
+    if(editChunk(root, from, to - from, "", chunkStart) != -1) return;
+
+    int left, middle, right;
+    split(root, from, left, middle);
+    split(middle, to - from, middle, right);
+    freeTree(middle);
+    root = merge(left, right);
+}
+
+
+
+
+/** Assign
+ *
+ * Replaces the whole text.
+ *
+ * @param text UTF-8 text
+ */
+void Rope::assign(string_view text){
+    clear();
+    insert(0, text);
+}
+
+
+
+
+/** Clear
+ *
+ * Removes the whole text.
+ */
+void Rope::clear(){
+    nodes.clear();
+    freeNodes.clear();
+    root = -1;
+    edits++;
+    edited = 0;
+}
+
+
+
+
+/** At
+ *
+ * @param pos Byte offset, smaller than the size
+ * @return The byte at the offset
+ */
+char Rope::at(size_t pos) const{
+    int node = root;
+    while(node != -1){
+        const Node& n = nodes[node];
+        size_t leftBytes = n.left == -1 ? 0 : nodes[n.left].bytes;
+
+        if(pos < leftBytes){
+            node = n.left;
+            continue;
+        }
+        pos -= leftBytes;
+        if(pos < n.text.size()) return n.text[pos];
+        pos -= n.text.size();
+        node = n.right;
+    }
+    return 0;
+}
+
+
+
+
+/** Line Start
+ *
+ * @param line Line index, 0 is the first line
+ * @return Byte offset of the first byte of the line, the size if there is no such line
+ */
+size_t Rope::lineStart(int line) const{
+    if(line <= 0) return 0;
+    if(line >= lineCount()) return size();
+
+    // The line starts after its line-th newline
+    size_t base = 0;
+    int node = root;
+    while(node != -1){
+        const Node& n = nodes[node];
+        int leftNewlines = n.left == -1 ? 0 : nodes[n.left].newlines;
+
+        if(line <= leftNewlines){
+            node = n.left;
+            continue;
+        }
+        line -= leftNewlines;
+        base += n.left == -1 ? 0 : nodes[n.left].bytes;
+
+        if(line <= n.ownNewlines){
+            for(size_t i = 0; i < n.text.size(); i++){
+                if(n.text[i] == '\n' && --line == 0) return base + i + 1;
+            }
+        }
+        line -= n.ownNewlines;
+        base += n.text.size();
+        node = n.right;
+    }
+    return size();
+}
+
+
+
+
+/** Line End
+ *
+ * @param line Line index, 0 is the first line
+ * @return Byte offset of the newline ending the line, the size for the last line
+ */
+size_t Rope::lineEnd(int line) const{
+    if(line + 1 >= lineCount()) return size();
+    return lineStart(line + 1) - 1;
+}
+
+
+
+
+/** Line Of
+ *
+ * @param pos Byte offset
+ * @return Index of the line the byte is in
+ */
+int Rope::lineOf(size_t pos) const{
+    int line = 0;
+    int node = root;
+    while(node != -1){
+        const Node& n = nodes[node];
+        size_t leftBytes = n.left == -1 ? 0 : nodes[n.left].bytes;
+
+        if(pos < leftBytes){
+            node = n.left;
+            continue;
+        }
+        line += n.left == -1 ? 0 : nodes[n.left].newlines;
+        pos -= leftBytes;
+
+        if(pos < n.text.size()){
+            for(size_t i = 0; i < pos; i++) line += n.text[i] == '\n';
+            return line;
+        }
+        line += n.ownNewlines;
+        pos -= n.text.size();
+        node = n.right;
+    }
+    return line;
+}
+
+
+
+
+/** Copy
+ *
+ * Appends the bytes in [from, to) to the string, visiting only the chunks in the range.
+ *
+ * @param from First byte
+ * @param to One past the last byte, clamped to the size
+ * @param out String the bytes are appended to
+ */
+void Rope::copy(size_t from, size_t to, string& out) const{
+    to = min(to, size());
+    if(from < to) copyRange(root, from, to, out);
+}
+
+
+
+
+// TREE --------------------------------------------------------------------------------------------
+
+int Rope::newNode(string text){
+    int node;
+    if(!freeNodes.empty()){
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        node = nodes.size();
+        nodes.emplace_back();
+    }
+
+    // Xorshift, the priorities only have to be random enough to keep the tree balanced
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    Node& n = nodes[node];
+    n.text = std::move(text);
+    n.left = n.right = -1;
+    n.priority = seed;
+    setText(node);
+    return node;
+}
+
+
+
+
+void Rope::freeTree(int node){
+    if(node == -1) return;
+    freeTree(nodes[node].left);
+    freeTree(nodes[node].right);
+    string().swap(nodes[node].text);
+    freeNodes.push_back(node);
+}
+
+
+
+
+// Recounts the subtree of the node, its children have to be up to date
+void Rope::update(int node){
+    Node& n = nodes[node];
+    n.bytes = n.text.size();
+    n.newlines = n.ownNewlines;
+    if(n.left != -1){
+        n.bytes += nodes[n.left].bytes;
+        n.newlines += nodes[n.left].newlines;
+    }
+    if(n.right != -1){
+        n.bytes += nodes[n.right].bytes;
+        n.newlines += nodes[n.right].newlines;
+    }
+}
+
+
+
+
+// Recounts the node after its text changed
+void Rope::setText(int node){
+    Node& n = nodes[node];
+    n.ownNewlines = std::count(n.text.begin(), n.text.end(), '\n');
+    update(node);
+}
+
+
+
+
+// Joins two trees, all of a is before all of b
+int Rope::merge(int a, int b){
+    if(a == -1) return b;
+    if(b == -1) return a;
+
+    if(nodes[a].priority > nodes[b].priority){
+        int right = merge(nodes[a].right, b);
+        nodes[a].right = right;
+        update(a);
+        return a;
+    }
+
+    int left = merge(a, nodes[b].left);
+    nodes[b].left = left;
+    update(b);
+    return b;
+}
+
+
+
+
+// Splits the tree into the bytes before pos and the rest, the chunk at pos is split in two
+void Rope::split(int node, size_t pos, int& left, int& right){
+    if(node == -1){
+        left = right = -1;
+        return;
+    }
+
+    size_t leftBytes = nodes[node].left == -1 ? 0 : nodes[nodes[node].left].bytes;
+    size_t own = nodes[node].text.size();
+
+    if(pos <= leftBytes){
+        int a, b;
+        split(nodes[node].left, pos, a, b);
+        nodes[node].left = b;
+        update(node);
+        left = a;
+        right = node;
+    }
+    else if(pos >= leftBytes + own){
+        int a, b;
+        split(nodes[node].right, pos - leftBytes - own, a, b);
+        nodes[node].right = a;
+        update(node);
+        left = node;
+        right = b;
+    }
+    else {
+        // Inside the chunk, its tail becomes a node of its own
+        size_t at = pos - leftBytes;
+        string tail = nodes[node].text.substr(at);
+        int tailNode = newNode(std::move(tail));
+
+        int after = nodes[node].right;
+        nodes[node].text.resize(at);
+        nodes[node].right = -1;
+        setText(node);
+
+        left = node;
+        right = merge(tailNode, after);
+    }
+}
+
+
+
+
+// A tree of the text cut into chunks
+int Rope::build(string_view text){
+    int tree = -1;
+    for(size_t i = 0; i < text.size(); i += ROPE_CHUNK){
+        tree = merge(tree, newNode(string(text.substr(i, ROPE_CHUNK))));
+    }
+    return tree;
+}
+
+
+
+
+// Replaces count bytes at pos with the text if they are all in one chunk, returns
+// that chunk and its offset in the subtree, or -1 if the bytes span more chunks
+int Rope::editChunk(int node, size_t pos, size_t count, string_view text, size_t& chunkStart){
+    Node& n = nodes[node];
+    size_t leftBytes = n.left == -1 ? 0 : nodes[n.left].bytes;
+    size_t own = n.text.size();
+
+    int chunk = -1;
+    if(n.left != -1 && pos + count <= leftBytes){
+        chunk = editChunk(n.left, pos, count, text, chunkStart);
+    }
+    else if(pos >= leftBytes && pos + count <= leftBytes + own){
+        n.text.replace(pos - leftBytes, count, text);
+        n.ownNewlines = std::count(n.text.begin(), n.text.end(), '\n');
+        chunkStart = leftBytes;
+        chunk = node;
+    }
+    else if(n.right != -1 && pos >= leftBytes + own){
+        chunk = editChunk(n.right, pos - leftBytes - own, count, text, chunkStart);
+        chunkStart += leftBytes + own;
+    }
+
+    if(chunk != -1) update(node);
+    return chunk;
+}
+
+
+
+
+void Rope::copyRange(int node, size_t from, size_t to, string& out) const{
+    if(node == -1 || from >= to) return;
+
+    const Node& n = nodes[node];
+    size_t leftBytes = n.left == -1 ? 0 : nodes[n.left].bytes;
+    size_t own = n.text.size();
+
+    if(from < leftBytes) copyRange(n.left, from, min(to, leftBytes), out);
+
+    size_t begin = max(from, leftBytes);
+    size_t end = min(to, leftBytes + own);
+    if(begin < end) out.append(n.text, begin - leftBytes, end - begin);
+
+    if(to > leftBytes + own) copyRange(n.right, max(from, leftBytes + own) - leftBytes - own, to - leftBytes - own, out);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef MySDL_ROPE
+#define MySDL_ROPE
+
+#include "../lib.h"
+
+#define ROPE_CHUNK 1024     // Bytes a chunk is filled up to, it is split in half once it grows over twice that
+
+
+// ROPE --------------------------------------------------------------------------------------------
+// Text kept as chunks in a balanced tree, a treap ordered by the position
+// of the chunks, where every node also counts the bytes and the newlines of
+// its subtree. Finding a byte, the start of a line or the line of a byte walks
+// down the tree, O(log n), and small edits change only the chunk they are in,
+// so documents of hundreds of thousands of lines stay as fast to edit as
+// small ones. Offsets are in bytes of UTF-8 text, lines are separated by '\n'.
+class Rope{
+    public:
+    size_t size() const { return root == -1 ? 0 : nodes[root].bytes; }
+    bool empty() const { return size() == 0; }
+    int lineCount() const { return (root == -1 ? 0 : nodes[root].newlines) + 1; }
+    Uint64 version() const { return edits; }       // Changes with every edit
+    size_t editedFrom() const { return edited; }    // Lowest byte edited since markSeen(), npos if none
+    void markSeen(){ edited = string::npos; }
+
+    void insert(size_t pos, string_view text);
+    void erase(size_t from, size_t to);
+    void assign(string_view text);
+    void clear();
+
+    char at(size_t pos) const;
+    size_t lineStart(int line) const;
+    size_t lineEnd(int line) const;                 // Before the newline of the line
+    int lineOf(size_t pos) const;
+    void copy(size_t from, size_t to, string& out) const;   // Appends the bytes in [from, to)
+
+    private:
+    struct Node {
+        string text;
+        int left = -1;
+        int right = -1;
+        Uint32 priority = 0;
+        int ownNewlines = 0;    // In the text of this node
+        size_t bytes = 0;       // Of the whole subtree
+        int newlines = 0;       // Of the whole subtree
+    };
+
+    vector<Node> nodes;         // Indexed by the children, freed ones are reused
+    vector<int> freeNodes;
+    int root = -1;
+    Uint32 seed = 0x9e3779b9;
+    Uint64 edits = 0;
+    size_t edited = string::npos;
+
+    int newNode(string text);
+    void freeTree(int node);
+    void update(int node);
+    void setText(int node);
+
+    int merge(int a, int b);
+    void split(int node, size_t pos, int& left, int& right);
+    int build(string_view text);
+    int editChunk(int node, size_t pos, size_t count, string_view text, size_t& chunkStart);
+    void copyRange(int node, size_t from, size_t to, string& out) const;
+};
+
+#endif
+// Creator: @AndrijaRD
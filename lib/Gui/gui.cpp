@@ -5,26 +5,72 @@
 
 
 
+/** Remove Text
+ * 
+ * INTERNAL USE
+ * 
+ * Frees the cached text texture and takes it out of textLru, counting it as evicted.
+ * 
+ * @param text The cached text, the pointer is invalid afterwards
+ */
+void GUI::removeText(LoadedText* text){
+    textStats.residentBytes -= text->bytes;
+    textStats.evictions++;
+
+    TM::freeTexture(text->td);
+    textLru.erase(text->lru);
+    loadedTexts.erase(text->key);
+    textStats.entries = loadedTexts.size();
+}
+
+
+
+
 /** Remove Oldest
  * 
  * INTERNAL USE
  * 
- * Used for removing the oldest text texture of loadedTexts map.
+ * Frees the least recently drawn text texture, the back of textLru.
  */
 void GUI::removeOldest(){
-    // Iterator to the oldest object
-    auto oldestIt = loadedTexts.begin();
+    if(textLru.empty()) return;
 
-    // Iterate through the map and find the oldest element
-    for (auto it = loadedTexts.begin(); it != loadedTexts.end(); ++it) {
-        if (oldestIt == loadedTexts.begin() || oldestIt->second > it->second) {
-            oldestIt = it;
-        }
+    LoadedText* text = loadedTexts.find(textLru.back());
+    if(text == nullptr){
+        textLru.pop_back();
+        return;
     }
+    GUI::removeText(text);
+}
+
+
+
 
-    // Free the texture and erase the item from the map
-    TM::freeTexture(oldestIt->second.td);
-    loadedTexts.erase(oldestIt);
+/** Evict Texts
+ * 
+ * INTERNAL USE
+ * 
+ * Frees the least recently drawn text textures until there is room for a new
+ * one within the byte budget and the count limit. With pinning the texts drawn
+ * this frame are kept even if that goes over the budget, they are evicted on
+ * a later frame once they are no longer drawn.
+ * 
+ * @param incoming Bytes of the texture about to be added
+ */
+void GUI::evictTexts(size_t incoming){
+    int frame = Sys::getCurrentFrame();
+
+    while(!textLru.empty()){
+        bool overBudget = textStats.residentBytes + incoming > textBudget;
+        bool overCount = max_num_of_loaded_textures >= 0 && (int)loadedTexts.size() >= max_num_of_loaded_textures;
+        if(!overBudget && !overCount) return;
+
+        // Everything in front of the oldest is newer, so drawn this frame as well
+        LoadedText* oldest = loadedTexts.find(textLru.back());
+        if(pinTexts && oldest != nullptr && oldest->frame == frame) return;
+
+        removeOldest();
+    }
 }
 
 
@@ -43,32 +89,98 @@ string color2hex(const SDL_Color& color){
 
 
 
-/** Load New Text
+/** Text Style
  * 
  * INTERNAL FUNCTION
  * 
- * Funtion for inserting a new text texture into map.
- * It also calles removeOldest if map is full.
+ * @return The font, quality and size bucket of the height packed together,
+ *         texts drawn at heights of the same bucket share the texture
  */
-GUI::LoadedText* GUI::loadNewText(const string& title, const SDL_Color& color){
-    // If there is more loaded Textures then allowed, remove the oldest
-    if(loadedTexts.size() >= max_num_of_loaded_textures){
-        removeOldest();
+Uint64 GUI::textStyle(int height, int quality, int font){
+    return (Uint64)font << 32 | (Uint64)quality << 16 | (Uint64)Fonts::pointSize(height, font);
+}
+
+
+
+
+/** Text Key
+ * 
+ * INTERNAL FUNCTION
+ * 
+ * @return Key of the (text, color, style) in loadedTexts, hashed without any formatting
+ */
+Uint64 GUI::textKey(string_view title, const SDL_Color& color, Uint64 style){
+    return GUI::combine(GUI::combine(GUI::hash(title), toUint32(color)), style);
+}
+
+
+
+
+/** Get Text
+ * 
+ * INTERNAL FUNCTION
+ * 
+ * Finds the cached text texture and moves it to the front of textLru,
+ * or renders a new one if it isnt cached.
+ * 
+ * @return Pointer to the text, valid until the next text is loaded
+ */
+GUI::LoadedText* GUI::getText(string_view title, const SDL_Color& color, int height, int quality, int font){
+    Uint64 style = GUI::textStyle(height, quality, font);
+    LoadedText* found = loadedTexts.find(GUI::textKey(title, color, style));
+    if(found == nullptr) return loadNewText(title, color, height, quality, font);
+
+    // A different text with the same hash, it is replaced
+    if(found->title != title || found->style != style){
+        GUI::removeText(found);
+        return loadNewText(title, color, height, quality, font);
     }
 
+    LoadedText& text = *found;
+    text.frame = Sys::getCurrentFrame();
+    textLru.splice(textLru.begin(), textLru, text.lru);
+    textStats.hits++;
+    return &text;
+}
+
+
+
+
+/** Load New Text
+ * 
+ * INTERNAL FUNCTION
+ * 
+ * Funtion for inserting a new text texture into map.
+ * It evicts the least recently drawn texts if the cache is full.
+ * The text is rendered at the font size bucket of the height.
+ */
+GUI::LoadedText* GUI::loadNewText(string_view title, const SDL_Color& color, int height, int quality, int font){
     // Create the new LoadedText item
     LoadedText newText;
     newText.color = color;
     newText.frame = Sys::getCurrentFrame();
-    newText.title = title;
+    newText.title = string(title);
+    newText.style = GUI::textStyle(height, quality, font);
 
     // Create the texture
-    int err = TM::createTextTexture(newText.td, newText.title, newText.color);
+    int err = TM::createTextTexture(newText.td, newText.title, newText.color, height, quality, font);
     CHECK_ERROR(err);
+    newText.bytes = TM::getTextureBytes(newText.td);     // The whole pooled size class
+
+    // Make room for it before it is inserted, so it can never evict itself
+    GUI::evictTexts(newText.bytes);
 
     // Insert the item and return the pointer to it
-    loadedTexts.insert({newText.getId(), newText});
-    return &(loadedTexts.at(newText.getId()));
+    newText.key = GUI::textKey(title, color, newText.style);
+    textLru.push_front(newText.key);
+    newText.lru = textLru.begin();
+
+    textStats.misses++;
+    textStats.residentBytes += newText.bytes;
+
+    LoadedText& inserted = loadedTexts.insert(newText.key, std::move(newText));
+    textStats.entries = loadedTexts.size();
+    return &inserted;
 }
 
 
@@ -89,7 +201,7 @@ GUI::LoadedText* GUI::loadNewText(const string& title, const SDL_Color& color){
  * 
  */
 int GUI::Button(
-    const string& title, 
+    string_view title, 
     const SDL_Rect& dRect,
     const SDL_Color& textColor,
     const SDL_Color& buttonColor
@@ -107,36 +219,38 @@ int GUI::Button(
     if(textAlignY == -1) textAlignY = GUI_ALIGN_CENTER; // Default
     GUI::pTextAlignY = -1;
 
+    int font = GUI::pFont;
+    if(font == -1) font = FONT_DEFAULT;
+    GUI::pFont = -1;
 
-
-    // CHECK VALIDITY OF dRect -------------------------------------------
-    if(dRect.w < 1 || dRect.h < 1) return GUI_CURSOR_OUTSIDE;
-
+    int textQuality = GUI::pTextQuality;
+    if(textQuality == -1) textQuality = TEXT_BLENDED;
+    GUI::pTextQuality = -1;
 
 
-    // FIND BUTTON TEXTURE
-    LoadedText* textPointer = nullptr;
-    string id = title + color2hex(textColor);
 
-    auto it = loadedTexts.find(id);
-    if (it != loadedTexts.end()) {
-        // Save the pointer to that LOadedText item
-        textPointer = &it->second;
-        
-        // Update with the current frame
-        textPointer->frame = Sys::getCurrentFrame();
-    } else {
-        // Create new Text Texture
-        textPointer = loadNewText(title, textColor);
-    }
+    // CHECK VALIDITY OF dRect -------------------------------------------
+    if(dRect.w < 1 || dRect.h < 1) return GUI_CURSOR_OUTSIDE;
 
 
 
     // BUTTON BACK -------------------------------------------------------
     // Render the buttons background, filled rect, 
     // and then on top of it will be white text
-    SDL_SetRenderDrawColor(Sys::renderer, buttonColor);
-    SDL_RenderFillRect(Sys::renderer, &dRect);
+    // Buttons usually change color when hovered, the
+    // layer is rendered again when any of them does
+    if(activeLayer != 0){
+        for(const SDL_Color& c : {buttonColor, textColor}){
+            Uint32 packed = toUint32(c);
+            layerColors = (layerColors ^ packed) * GUI_HASH_PRIME;
+        }
+    }
+
+    if(!layerCached){
+        SDL_Rect backRect = toLayer(dRect);
+        SDL_SetRenderDrawColor(Sys::renderer, buttonColor);
+        SDL_RenderFillRect(Sys::renderer, &backRect);
+    }
     
 
 
@@ -150,58 +264,71 @@ int GUI::Button(
     int maxTextWidth = dRect.w - padding*2;
     int maxTextHeight = dRect.h - padding*2;
 
-    // TEXT DRECT --------------------------------------------------------
-    SDL_Rect text_dRect;
-
-    if(fontSize == -1){
-        // if required width is less then maximal allowed then
-        // the height is the limiting factor, so its max height
-
-        // We calc the text width in case of max height and compare it to max allowed width
-        int textWidth = textPointer->td.width * (float)maxTextHeight / textPointer->td.height;
-        if(textWidth <= maxTextWidth){
-            // This means that text is maximal height, 
-            // and width is less then max, there will be
-            // left-right free space
-            text_dRect.h = maxTextHeight;
-        } else {
-            // This means that text is maximal width, 
-            // and height is less then max, there will be
-            // top-bottom free space
-            textWidth = maxTextWidth;
-            text_dRect.h = textPointer->td.height * (float)maxTextWidth / textPointer->td.width;
+    // Natural size of the text, only the ratio matters. It is measured
+    // at the height it would most likely be drawn at, without rendering it
+    int naturalHeight = max(1, fontSize == -1 ? maxTextHeight : fontSize);
+    int naturalWidth = GUI::measureText(title, naturalHeight, font);
+
+    // An empty title only skips the text, the button is still hit tested
+    if(naturalWidth > 0){
+        // TEXT DRECT --------------------------------------------------------
+        SDL_Rect text_dRect;
+
+        if(fontSize == -1){
+            // if required width is less then maximal allowed then
+            // the height is the limiting factor, so its max height
+
+            // We calc the text width in case of max height and compare it to max allowed width
+            int textWidth = naturalWidth * (float)maxTextHeight / naturalHeight;
+            if(textWidth <= maxTextWidth){
+                // This means that text is maximal height, 
+                // and width is less then max, there will be
+                // left-right free space
+                text_dRect.h = maxTextHeight;
+            } else {
+                // This means that text is maximal width, 
+                // and height is less then max, there will be
+                // top-bottom free space
+                textWidth = maxTextWidth;
+                text_dRect.h = naturalHeight * (float)maxTextWidth / naturalWidth;
+            }
+        } else{
+            text_dRect.h = fontSize;
         }
-    } else{
-        text_dRect.h = fontSize;
-    }
 
 
-    // DRECT WIDTH -----------------------------------------------------------------
-    text_dRect.w = text_dRect.h * (float)textPointer->td.width / textPointer->td.height;
+        // DRECT WIDTH -----------------------------------------------------------------
+        text_dRect.w = text_dRect.h * (float)naturalWidth / naturalHeight;
 
-    // DRECT X POS
-    if(textAlignX == GUI_ALIGN_LEFT){
-        text_dRect.x = dRect.x + padding;
-    } else if(textAlignX == GUI_ALIGN_CENTER){
-        text_dRect.x = dRect.x + dRect.w/2 - text_dRect.w/2;
-    } else if(textAlignX == GUI_ALIGN_RIGHT){
-        text_dRect.x = dRect.x + dRect.w - padding - text_dRect.w;
-    }
+        // DRECT X POS
+        if(textAlignX == GUI_ALIGN_LEFT){
+            text_dRect.x = dRect.x + padding;
+        } else if(textAlignX == GUI_ALIGN_CENTER){
+            text_dRect.x = dRect.x + dRect.w/2 - text_dRect.w/2;
+        } else if(textAlignX == GUI_ALIGN_RIGHT){
+            text_dRect.x = dRect.x + dRect.w - padding - text_dRect.w;
+        }
 
-    // DRECT Y POS
-    if(textAlignY == GUI_ALIGN_TOP){
-        text_dRect.y = dRect.y + padding;
-    } else if(textAlignY == GUI_ALIGN_CENTER) {
-        text_dRect.y = dRect.y + dRect.h/2 - text_dRect.h/2;
-    } else if(textAlignY == GUI_ALIGN_BOTTOM) {
-        text_dRect.y = dRect.y + dRect.h - padding - text_dRect.h;
-    }
+        // DRECT Y POS
+        if(textAlignY == GUI_ALIGN_TOP){
+            text_dRect.y = dRect.y + padding;
+        } else if(textAlignY == GUI_ALIGN_CENTER) {
+            text_dRect.y = dRect.y + dRect.h/2 - text_dRect.h/2;
+        } else if(textAlignY == GUI_ALIGN_BOTTOM) {
+            text_dRect.y = dRect.y + dRect.h - padding - text_dRect.h;
+        }
 
 
-    // Now render the text
-    int err = TM::renderTexture(textPointer->td, text_dRect);
-    CHECK_ERROR(err);
+        // Now render the text
+        if(textMode == GUI_TEXT_TEXTURES){
+            LoadedText* textPointer = GUI::getText(title, textColor, naturalHeight, textQuality, font);
+            GUI::renderInLayer(textPointer->td, text_dRect);
+        } else {
+            GUI::renderTextInLayer(title, text_dRect, textColor, textQuality, font);
+        }
+    }
 
+    // Hit testing is done in screen space, even inside a cached layer
     if(Sys::Mouse::isHovering(dRect)){
         if(Sys::Mouse::isClicked()){
             return GUI_CURSOR_CLICKED;
@@ -222,8 +349,8 @@ int GUI::Button(
 /** Text
  * 
  * Draws a optimized verion of text on the screen.
- * It doesnt respond to any push styles since all of them
- * can be controlled trough dRect param.
+ * It responds only to the font and quality push styles,
+ * the rest can be controlled trough dRect param.
  * 
  * @param title Text to be rendered.
  * @param dRect position and size of the text, one dimension can be left as -1 for
@@ -233,26 +360,23 @@ int GUI::Button(
  * @param color The color of the text
  * 
  */
-void GUI::Text(const string& title, SDL_Rect& dRect, const SDL_Color& color){
-    if(dRect.w < 1 && dRect.h < 1) return;
+void GUI::Text(string_view title, SDL_Rect& dRect, const SDL_Color& color){
+    int font = GUI::pFont == -1 ? FONT_DEFAULT : GUI::pFont;
+    int textQuality = GUI::pTextQuality == -1 ? TEXT_BLENDED : GUI::pTextQuality;
+    GUI::pFont = -1;
+    GUI::pTextQuality = -1;
 
-    LoadedText* textPointer = nullptr;
-    string id = title + color2hex(color);
+    if(dRect.w < 1 && dRect.h < 1) return;
 
-    auto it = loadedTexts.find(id);
-    if (it != loadedTexts.end()) {
-        // Save the pointer to that LoadedText item
-        textPointer = &it->second;
-        
-        // Update with the current frame
-        textPointer->frame = Sys::getCurrentFrame();
-    } else {
-        // Create new Text Texture
-        textPointer = loadNewText(title, color);
+    if(textMode == GUI_TEXT_ATLAS){
+        GUI::renderTextInLayer(title, dRect, color, textQuality, font);
+        return;
     }
 
+    LoadedText* textPointer = GUI::getText(title, color, dRect.h, textQuality, font);
+
     // Render the texture
-    TM::renderTexture(textPointer->td, dRect);
+    GUI::renderInLayer(textPointer->td, dRect);
 }
 
 
@@ -274,16 +398,30 @@ void GUI::Text(const string& title, SDL_Rect& dRect, const SDL_Color& color){
  * @param color The color of the text
  * 
  */
-void GUI::TextDynamic(const string& title, SDL_Rect& dRect, const SDL_Color& color){
+void GUI::TextDynamic(string_view title, SDL_Rect& dRect, const SDL_Color& color){
+    int font = GUI::pFont == -1 ? FONT_DEFAULT : GUI::pFont;
+    int textQuality = GUI::pTextQuality == -1 ? TEXT_BLENDED : GUI::pTextQuality;
+    GUI::pFont = -1;
+    GUI::pTextQuality = -1;
+
     if(dRect.w < 1 && dRect.h < 1) return;
 
+    // The glyph atlas has no texture per string to begin with
+    if(textMode == GUI_TEXT_ATLAS){
+        GUI::renderTextInLayer(title, dRect, color, textQuality, font);
+        return;
+    }
+
+    // Inside a cached layer the texture is only needed for the missing dimension
+    if(layerCached && dRect.w > 0 && dRect.h > 0) return;
+
     // Create the texture
     TextureData td;
-    int err = TM::createTextTexture(td, title, color);
+    int err = TM::createTextTexture(td, string(title), color, dRect.h, textQuality, font);
     CHECK_ERROR(err);
 
     // Render the texture
-    TM::renderTexture(td, dRect);
+    GUI::renderInLayer(td, dRect);
 
     // Free Texture Data
     TM::freeTexture(td); 
@@ -292,11 +430,170 @@ void GUI::TextDynamic(const string& title, SDL_Rect& dRect, const SDL_Color& col
 
 
 
-void GUI::clearLoadedTexts(){
-    for(auto text : loadedTexts){
-        TM::freeTexture(text.second.td);
+/** Measure Text
+ * 
+ * Measures the text without rendering it, out of the glyph advances
+ * cached per font and size.
+ * 
+ * @param text Text to be measured
+ * @param height Height the text would be drawn at
+ * @param fontId Font registered with Fonts::load
+ * @return Width of the text at that height
+ */
+int GUI::measureText(string_view text, int height, int fontId){
+    int width = 0;
+    int err = Fonts::measure(text, height, width, fontId);
+    CHECK_ERROR(err);
+    return width;
+}
+
+
+
+
+/** Layout Text
+ * 
+ * Wraps the text into lines no wider then maxWidth, see Fonts::wrap. The layout
+ * is cached by the text, height, font and width, so an unchanged paragraph is
+ * laid out only once.
+ * 
+ * @param text Text to be laid out, newlines start a new line
+ * @param height Height of a line
+ * @param maxWidth Width to wrap at, 0 or less to break only at the newlines
+ * @param fontId Font registered with Fonts::load
+ * @return The layout, valid until the next text is laid out
+ */
+const TextLayout& GUI::layoutText(string_view text, int height, int maxWidth, int fontId){
+    Uint64 key = GUI::combine(GUI::combine(GUI::combine(GUI::hash(text), height), fontId), maxWidth);
+
+    CachedLayout* cached = layouts.find(key);
+    if(cached == nullptr){
+        if(layouts.size() >= GUI_LAYOUT_CACHE_SIZE) GUI::pruneLayouts();
+        cached = &layouts.insert(key, CachedLayout());
+    }
+    else if(
+        cached->text == text && cached->height == height &&
+        cached->font == fontId && cached->width == maxWidth
+    ){
+        cached->frame = Sys::getCurrentFrame();
+        return cached->layout;
+    }
+
+    // New, or a different paragraph with the same hash that is replaced
+    cached->text = string(text);
+    cached->height = height;
+    cached->font = fontId;
+    cached->width = maxWidth;
+    cached->frame = Sys::getCurrentFrame();
+
+    int err = Fonts::wrap(text, height, maxWidth, cached->layout, fontId);
+    CHECK_ERROR(err);
+    return cached->layout;
+}
+
+
+
+
+/** Prune Layouts
+ * 
+ * INTERNAL USE
+ * 
+ * Drops the cached layouts that were not used this frame.
+ */
+void GUI::pruneLayouts(){
+    int frame = Sys::getCurrentFrame();
+
+    staleLayouts.clear();
+    layouts.forEach([&](Uint64 key, CachedLayout& cached){
+        if(cached.frame != frame) staleLayouts.push_back(key);
+    });
+    for(Uint64 key : staleLayouts) layouts.erase(key);
+}
+
+
+
+
+/** Paragraph
+ * 
+ * Draws a multi-line text, wrapped at the width of the dRect. The layout is
+ * cached, so drawing an unchanged paragraph every frame costs only the drawing.
+ * It supports the font size (line height), text align, font and quality push
+ * styles. Lines outside of the dRect are not drawn.
+ * 
+ * @param text Text to be rendered, newlines start a new line
+ * @param dRect Position and size of the paragraph, the width is required. If the
+ *              height is -1 it is replaced by the height of all the lines
+ * @param color The color of the text
+ */
+void GUI::Paragraph(string_view text, SDL_Rect& dRect, const SDL_Color& color){
+    // COPY STYLES -------------------------------------------------------
+    int lineHeight = GUI::pFontSize;
+    if(lineHeight == -1) lineHeight = GUI_DEFAULT_LINE_HEIGHT;
+    GUI::pFontSize = -1;
+
+    int textAlignX = GUI::pTextAlignX;
+    if(textAlignX == -1) textAlignX = GUI_ALIGN_LEFT;
+    GUI::pTextAlignX = -1;
+
+    int textAlignY = GUI::pTextAlignY;
+    if(textAlignY == -1) textAlignY = GUI_ALIGN_TOP;
+    GUI::pTextAlignY = -1;
+
+    int font = GUI::pFont == -1 ? FONT_DEFAULT : GUI::pFont;
+    int textQuality = GUI::pTextQuality == -1 ? TEXT_BLENDED : GUI::pTextQuality;
+    GUI::pFont = -1;
+    GUI::pTextQuality = -1;
+
+    if(dRect.w < 1 || lineHeight < 1) return;
+
+
+
+    // LAYOUT ------------------------------------------------------------
+    const TextLayout& layout = GUI::layoutText(text, lineHeight, dRect.w, font);
+    if(dRect.h < 0) dRect.h = layout.height;
+
+    int y = dRect.y;
+    if(textAlignY == GUI_ALIGN_CENTER) y = dRect.y + dRect.h/2 - layout.height/2;
+    else if(textAlignY == GUI_ALIGN_BOTTOM) y = dRect.y + dRect.h - layout.height;
+
+
+
+    // LINES -------------------------------------------------------------
+    for(const TextLine& line : layout.lines){
+        bool visible = y + lineHeight > dRect.y && y < dRect.y + dRect.h;
+        if(line.end > line.begin && visible){
+            SDL_Rect lineRect = {dRect.x, y, line.width, lineHeight};
+            if(textAlignX == GUI_ALIGN_CENTER) lineRect.x = dRect.x + dRect.w/2 - line.width/2;
+            else if(textAlignX == GUI_ALIGN_RIGHT) lineRect.x = dRect.x + dRect.w - line.width;
+
+            string_view lineText = text.substr(line.begin, line.end - line.begin);
+            if(textMode == GUI_TEXT_TEXTURES){
+                LoadedText* textPointer = GUI::getText(lineText, color, lineHeight, textQuality, font);
+                GUI::renderInLayer(textPointer->td, lineRect);
+            }
+            else if(!layerCached){
+                // Natural width, the layout already measured it
+                SDL_Rect rect = toLayer(lineRect);
+                rect.w = 0;
+                int err = GlyphAtlas::draw(lineText, rect, color, textQuality, font);
+                CHECK_ERROR(err);
+            }
+        }
+        y += lineHeight;
     }
+}
+
+
+
+
+void GUI::clearLoadedTexts(){
+    loadedTexts.forEach([](Uint64, LoadedText& text){
+        TM::freeTexture(text.td);
+    });
     loadedTexts.clear();
+    textLru.clear();
+
+    textStats.residentBytes = 0;
+    textStats.entries = 0;
 }
 
 void GUI::setMaxNumOfLoadedTextures(const int& num){ max_num_of_loaded_textures = num; }
@@ -304,6 +601,61 @@ void GUI::setMaxNumOfLoadedTextures(const int& num){ max_num_of_loaded_textures
 
 
 
+/** Set Text Cache Budget
+ * 
+ * Sets how much texture memory the text textures of GUI_TEXT_TEXTURES can
+ * hold, the least recently drawn ones are freed once it is exceeded.
+ * 
+ * @param bytes Budget in bytes, 32MB by default
+ */
+void GUI::setTextCacheBudget(size_t bytes){
+    textBudget = bytes;
+    GUI::evictTexts(0);
+}
+
+
+
+
+/** Set Text Cache Pinning
+ * 
+ * @param pin If true (default) the texts drawn this frame are never evicted,
+ *            the cache can go over the budget until they stop being drawn
+ */
+void GUI::setTextCachePinning(bool pin){ pinTexts = pin; }
+
+
+
+
+/** Get Text Cache Stats
+ * 
+ * @return Hits, misses, evictions and the memory of the cached text textures
+ */
+TextCacheStats GUI::getTextCacheStats(){
+    TextCacheStats stats = textStats;
+    stats.budget = textBudget;
+    return stats;
+}
+
+
+
+
+/** Set Text Mode
+ * 
+ * Picks how GUI::Text, GUI::TextDynamic and GUI::Button draw their text.
+ * 
+ * @param mode GUI_TEXT_ATLAS (default) draws the strings out of the glyph atlas, with
+ *             no texture per string. GUI_TEXT_TEXTURES renders every (string, color)
+ *             into its own texture, kept in loadedTexts.
+ */
+void GUI::setTextMode(int mode){
+    if(mode == textMode) return;
+    if(mode == GUI_TEXT_ATLAS) GUI::clearLoadedTexts();
+    textMode = mode;
+}
+
+
+
+
 /** Rect
  * 
  * This function can currently draw either
@@ -319,12 +671,15 @@ void GUI::Rect(
     const SDL_Color& color,
     const int thickness
 ){
+    if(layerCached) return;
+    SDL_Rect rect = toLayer(dRect);
+
     SDL_SetRenderDrawColor(Sys::renderer, color);
 
     if(thickness == -1){
-        SDL_RenderFillRect(Sys::renderer, &dRect);
+        SDL_RenderFillRect(Sys::renderer, &rect);
     } else {
-        SDL_RenderDrawRect(Sys::renderer, &dRect);
+        SDL_RenderDrawRect(Sys::renderer, &rect);
     }
 }
 
@@ -345,328 +700,1568 @@ void GUI::Line(
     const SDL_Point& p2,
     const SDL_Color& color
 ){
+    if(layerCached) return;
+
     SDL_SetRenderDrawColor(Sys::renderer, color);
-    SDL_RenderDrawLine(Sys::renderer, p1, p2);
+    SDL_RenderDrawLine(Sys::renderer, toLayer(p1), toLayer(p2));
 }
 
 
 
 
 
-/** Input
- * 
- * Renders a Input field using a unique id.
+/** Polyline
  * 
- * The UniqueId should not be changes and needs to be
- * unique to each input field as it is used for accessing
- * the stored state of the field. Returing the value of
- * the filed, the user inputed text.
+ * Renders a thick line trough all the points, with joined corners,
+ * in a single draw call. For long lines that grow over time, like
+ * plots, keep a PolylineMesh or a PlotSeries instead.
  * 
- * @param uniqueId A unique string intrenaly used to itentify the input field acrros diffrent frames
- * @param dRect A SDL_Rect representing where and what size should field be rendered
- * @param placeholder A text displayed on the input filed when input is empty
- * @param background SDL_Color representing the background field color
- * @param foreground SDL_Color representing the text color 
- * @return The value of the field
+ * @param points Array of the points of the line
+ * @param count Number of points
+ * @param color SDL_Color of the line
+ * @param thickness Thickness of the line in pixels
  */
-string GUI::Input(
-    const string& uniqueId,
-    const SDL_Rect& dRect,
-    const string& placeholder,
-    const SDL_Color& background,
-    const SDL_Color& foreground
-){  
-    /**
-     * Improvements:
-     *      - Char Position changer, like give the arrows some functionality
-     *        left and right curosr movement, on each focus it should be set to
-     *        max, the last char, but also make it changable using arrows and even
-     *        with mouse click, advanced
-     *        ! Problem: Each char should then be treated individualy as the program
-     *                   must known where to draw the caret, where each char begins
-     */
+void GUI::Polyline(
+    const SDL_FPoint* points,
+    int count,
+    const SDL_Color& color,
+    float thickness
+){
+    if(layerCached) return;
 
+    // Reused every call, so its buffers are allocated only once
+    static PolylineMesh mesh;
+    mesh.clear();
+    mesh.setStyle(thickness, color);
 
-    // COPY STYLES -------------------------------------------------------
-    // First we copy the pushed styles
-    int fontSize = GUI::pFontSize;
-    GUI::pFontSize = -1;
+    Layer* layer = GUI::getActiveLayer();
+    if(layer == nullptr){
+        mesh.add(points, count);
+    } else {
+        for(int i = 0; i < count; i++){
+            mesh.add({points[i].x - layer->rect.x, points[i].y - layer->rect.y});
+        }
+    }
 
-    int textAlignX = GUI::pTextAlignX;
-    if(textAlignX == -1) textAlignX = GUI_ALIGN_LEFT; // Default
-    GUI::pTextAlignX = -1;
+    int err = mesh.render();
+    CHECK_ERROR(err);
+}
 
-    int textAlignY = GUI::pTextAlignY;
-    if(textAlignY == -1) textAlignY = GUI_ALIGN_CENTER; // Default
-    GUI::pTextAlignY = -1;
 
-    bool autoFocus = GUI::pAutoFocus;
-    GUI::pAutoFocus = false;
 
-    bool inputLock = GUI::pInputLock;
-    GUI::pInputLock = false;
 
 
+// INPUT -------------------------------------------------------------------------------------------
 
+// Keys that act again while held, their bit in KeyRepeat::held is the index
+static const SDL_Keycode INPUT_KEYS[] = {SDLK_BACKSPACE, SDLK_DELETE, SDLK_LEFT, SDLK_RIGHT, SDLK_HOME, SDLK_END};
+static const int INPUT_KEY_COUNT = sizeof(INPUT_KEYS) / sizeof(INPUT_KEYS[0]);
 
-    // FIND STATE --------------------------------------------------------
-    // Get the pointer to the buttons state using uniqueId
-    InputState* state = nullptr;
-    auto it = inputStates.find(uniqueId);
-    if(it != inputStates.end()){
-        state = &it->second;
-    } else{
-        // If the state doesnt exist, create it
-        inputStates.insert({uniqueId, InputState(uniqueId)});
-        state = &inputStates.at(uniqueId);
-    }
+// Bytes of the codepoint in UTF-8
+static int utf8Length(Uint32 codepoint){
+    if(codepoint < 0x80) return 1;
+    if(codepoint < 0x800) return 2;
+    if(codepoint < 0x10000) return 3;
+    return 4;
+}
 
-    if(inputLock){
-        autoFocus = false;
-        if(state->focused) Sys::Keyboard::unfocus();
-        state->focused = false;
-    }
 
 
-    if(autoFocus){
-        Sys::Keyboard::focus();
-        state->focused = true;
+/** Key Repeats
+ * 
+ * INTERNAL USE
+ * 
+ * Counts how many times a key acts this frame. It acts once when
+ * pressed, and while held it repeats every GUI_KEY_REPEAT_INTERVAL
+ * after GUI_KEY_REPEAT_DELAY. The repeats follow the time and not the
+ * frames, so a slow frame catches up with more of them.
+ * 
+ * @param repeat Held keys of the focused widget
+ * @param keys Keys the widget repeats, at most 32
+ * @param key Index into the keys
+ * @return Number of times the key acts this frame
+ */
+int GUI::keyRepeats(KeyRepeat& repeat, const SDL_Keycode* keys, int key){
+    SDL_Keycode keycode = keys[key];
+    Uint32 bit = 1u << key;
+
+    bool down = Sys::Keyboard::isKeyDown(keycode);
+    bool wasDown = repeat.held & bit;
+    if(down) repeat.held |= bit;
+    else repeat.held &= ~bit;
+
+    Uint64 now = SDL_GetTicks64();
+
+    // Pressed this frame, also when pressed and released within it
+    if(!wasDown && (down || Sys::Keyboard::getKeyDown() == keycode)){
+        if(down){
+            repeat.key = keycode;
+            repeat.at = now + GUI_KEY_REPEAT_DELAY;
+        }
+        return 1;
     }
 
+    // Only the last pressed key repeats, as the OS does it
+    if(!down || repeat.key != keycode || now < repeat.at) return 0;
+
+    int repeats = 1 + (now - repeat.at) / GUI_KEY_REPEAT_INTERVAL;
+    repeat.at += (Uint64)repeats * GUI_KEY_REPEAT_INTERVAL;
+    return repeats;
+}
+
+
+
+
+/** Measure Input
+ * 
+ * INTERNAL USE
+ * 
+ * Fills the advance and the kerning of the glyphs in [from, to),
+ * the kerning is with the glyph before each one.
+ * 
+ * @param state State of the input
+ * @param from First glyph
+ * @param to One past the last glyph, clamped to the glyph count
+ * @param height Height of the text in pixels
+ * @param font Font id
+ */
+void GUI::measureInput(InputState& state, int from, int to, int height, int font){
+    to = min(to, state.glyphs.size());
+    for(int i = max(from, 0); i < to; i++){
+        InputGlyph& glyph = state.glyphs[i];
+        Uint32 previous = i > 0 ? state.glyphs[i - 1].codepoint : 0;
+
+        int err = Fonts::glyphMetrics(glyph.codepoint, previous, height, glyph.advance, glyph.kerning, font);
+        if(err != NO_ERROR){
+            CHECK_ERROR(err);
+            return;
+        }
+    }
+}
+
+
+
+
+/** Insert Input
+ * 
+ * INTERNAL USE
+ * 
+ * Replaces the selection with the text, at the caret. Only the new
+ * glyphs and the one after them are measured, the rest keep their metrics.
+ * 
+ * @param state State of the input
+ * @param text UTF-8 text, control characters are skipped as the input is a single line
+ * @param height Height of the text in pixels
+ * @param font Font id
+ */
+void GUI::insertInput(InputState& state, string_view text, int height, int font){
+    int from = min(state.caret, state.anchor);
+    int to = max(state.caret, state.anchor);
+    size_t fromByte = GUI::inputByteOffset(state, from);
+    size_t toByte = GUI::inputByteOffset(state, to);
+
+    state.glyphs.erase(from, to - from);
+    state.value.erase(fromByte, toByte - fromByte);
+    state.caret = from;
+
+    for(size_t i = 0; i < text.size();){
+        Uint32 codepoint = Fonts::nextCodepoint(text, i);
+        if(codepoint < 0x20 || codepoint == 0x7f) continue;
+
+        InputGlyph glyph;
+        glyph.codepoint = codepoint;
+        state.glyphs.insert(state.caret++, glyph);
+    }
+    state.anchor = state.caret;
+
+    // The glyph after the inserted ones got a new neighbour
+    GUI::measureInput(state, from, state.caret + 1, height, font);
+
+    // Only the new glyphs are encoded into the value
+    inputScratch.clear();
+    GUI::encodeInput(state, from, state.caret, inputScratch);
+    state.value.insert(fromByte, inputScratch);
+    state.offsetGlyph = state.caret;
+    state.offsetByte = fromByte + inputScratch.size();
+    state.editedAt = SDL_GetTicks64();
+}
+
+
+
+
+/** Erase Input
+ * 
+ * INTERNAL USE
+ * 
+ * Removes the glyphs in [from, to) and puts the caret where they were.
+ * 
+ * @param state State of the input
+ * @param from First glyph
+ * @param to One past the last glyph
+ * @param height Height of the text in pixels
+ * @param font Font id
+ */
+void GUI::eraseInput(InputState& state, int from, int to, int height, int font){
+    from = max(from, 0);
+    to = min(to, state.glyphs.size());
+    if(from >= to) return;
+
+    size_t fromByte = GUI::inputByteOffset(state, from);
+    size_t toByte = GUI::inputByteOffset(state, to);
+
+    state.glyphs.erase(from, to - from);
+    state.value.erase(fromByte, toByte - fromByte);
+    state.caret = state.anchor = from;
+    state.offsetGlyph = from;
+    state.offsetByte = fromByte;
+
+    // The glyph after the erased ones got a new neighbour
+    GUI::measureInput(state, from, from + 1, height, font);
+
+    state.editedAt = SDL_GetTicks64();
+}
+
+
+
+
+/** Encode Input
+ * 
+ * INTERNAL USE
+ * 
+ * Appends the glyphs in [from, to) to the string as UTF-8.
+ * 
+ * @param state State of the input
+ * @param from First glyph
+ * @param to One past the last glyph
+ * @param out String the text is appended to
+ */
+void GUI::encodeInput(InputState& state, int from, int to, string& out){
+    for(int i = from; i < to; i++){
+        Uint32 c = state.glyphs[i].codepoint;
+        if(c < 0x80){
+            out += (char)c;
+        } else if(c < 0x800){
+            out += (char)(0xc0 | (c >> 6));
+            out += (char)(0x80 | (c & 0x3f));
+        } else if(c < 0x10000){
+            out += (char)(0xe0 | (c >> 12));
+            out += (char)(0x80 | ((c >> 6) & 0x3f));
+            out += (char)(0x80 | (c & 0x3f));
+        } else {
+            out += (char)(0xf0 | (c >> 18));
+            out += (char)(0x80 | ((c >> 12) & 0x3f));
+            out += (char)(0x80 | ((c >> 6) & 0x3f));
+            out += (char)(0x80 | (c & 0x3f));
+        }
+    }
+}
+
+
+
+
+/** Input Byte Offset
+ * 
+ * INTERNAL USE
+ * 
+ * Finds where a glyph starts in the UTF-8 value. It walks from the glyph
+ * asked for last, or from an end of the value if that is closer, so
+ * edits at the caret cost only the distance the caret moved.
+ * 
+ * @param state State of the input
+ * @param glyph Glyph index, up to the glyph count
+ * @return Byte offset of the glyph in the value
+ */
+size_t GUI::inputByteOffset(InputState& state, int glyph){
+    int size = state.glyphs.size();
+    if(glyph < abs(state.offsetGlyph - glyph)){
+        state.offsetGlyph = 0;
+        state.offsetByte = 0;
+    }
+    else if(size - glyph < abs(state.offsetGlyph - glyph)){
+        state.offsetGlyph = size;
+        state.offsetByte = state.value.size();
+    }
+
+    while(state.offsetGlyph < glyph) state.offsetByte += utf8Length(state.glyphs[state.offsetGlyph++].codepoint);
+    while(state.offsetGlyph > glyph) state.offsetByte -= utf8Length(state.glyphs[--state.offsetGlyph].codepoint);
+    return state.offsetByte;
+}
+
+
+
+
+/** Input Caret At
+ * 
+ * INTERNAL USE
+ * 
+ * Finds the glyph boundary closest to a position in the visible text.
+ * Before the text it gives the glyph before the scroll, so dragging past
+ * the left edge scrolls, and after the visible glyphs the end of them.
+ * 
+ * @param state State of the input
+ * @param units Position from the start of the visible text, in the units of the glyph metrics
+ * @param end One past the last visible glyph
+ * @return Index of the glyph the caret would be before
+ */
+int GUI::inputCaretAt(const InputState& state, double units, int end){
+    if(units < 0) return max(state.scroll - 1, 0);
+
+    double pen = 0;
+    for(int i = state.scroll; i < end; i++){
+        const InputGlyph& glyph = state.glyphs[i];
+        double step = glyph.advance + (i > state.scroll ? glyph.kerning : 0);
+        if(units < pen + step / 2) return i;
+        pen += step;
+    }
+
+    return end;
+}
+
+
+
+
+/** Input
+ * 
+ * Renders a Input field using a unique id.
+ * 
+ * The UniqueId should not be changes and needs to be
+ * unique to each input field as it is used for accessing
+ * the stored state of the field. Returing the value of
+ * the filed, the user inputed text.
+ * 
+ * The text is kept as glyphs with their metrics in a gap buffer, so
+ * typing or deleting at the caret measures only the glyphs it touches
+ * and the visible part is found by walking from the scroll. It is always
+ * drawn out of the glyph atlas, whatever the text mode is. The caret moves
+ * with the arrows, Home and End, and with the mouse, Shift or dragging
+ * selects, and Ctrl+A, C, X and V work with the clipboard.
+ * 
+ * @param uniqueId A unique string intrenaly used to itentify the input field acrros diffrent frames
+ * @param dRect A SDL_Rect representing where and what size should field be rendered
+ * @param placeholder A text displayed on the input filed when input is empty
+ * @param background SDL_Color representing the background field color
+ * @param foreground SDL_Color representing the text color 
+ * @return The value of the field
+ */
+string GUI::Input(
+    string_view uniqueId,
+    const SDL_Rect& dRect,
+    const string& placeholder,
+    const SDL_Color& background,
+    const SDL_Color& foreground
+){
+    // COPY STYLES -------------------------------------------------------
+    // First we copy the pushed styles
+    int fontSize = GUI::pFontSize;
+    GUI::pFontSize = -1;
+
+    int textAlignX = GUI::pTextAlignX;
+    if(textAlignX == -1) textAlignX = GUI_ALIGN_LEFT; // Default
+    GUI::pTextAlignX = -1;
+
+    int textAlignY = GUI::pTextAlignY;
+    if(textAlignY == -1) textAlignY = GUI_ALIGN_CENTER; // Default
+    GUI::pTextAlignY = -1;
+
+    bool autoFocus = GUI::pAutoFocus;
+    GUI::pAutoFocus = false;
+
+    bool inputLock = GUI::pInputLock;
+    GUI::pInputLock = false;
+
+    int font = GUI::pFont;
+    if(font == -1) font = FONT_DEFAULT;
+    GUI::pFont = -1;
+
+    int textQuality = GUI::pTextQuality;
+    if(textQuality == -1) textQuality = TEXT_BLENDED;
+    GUI::pTextQuality = -1;
 
-    // DRAW BACKGROUND ---------------------------------------------------
-    GUI::Rect(dRect, background);           // Background field
-    GUI::Rect(dRect, SDL_COLOR_BLACK, 1);   // 1px black Outline
 
 
 
+    // FIND STATE --------------------------------------------------------
+    // Get the pointer to the inputs state using uniqueId
+    Uint64 id = GUI::getID(uniqueId);
+    InputState* state = inputStates.find(id);
+    if(state == nullptr){
+        // If the state doesnt exist, create it
+        state = &inputStates.insert(id, InputState(string(uniqueId)));
+    }
+
+    if(inputLock){
+        autoFocus = false;
+        if(state->focused) Sys::Keyboard::unfocus();
+        state->focused = false;
+        state->dragging = false;
+    }
+
+
+    if(autoFocus){
+        Sys::Keyboard::focus();
+        state->focused = true;
+    }
+
+
+    // DRAW BACKGROUND ---------------------------------------------------
+    GUI::Rect(dRect, background);           // Background field
+    GUI::Rect(dRect, SDL_COLOR_BLACK, 1);   // 1px black Outline
+
+
     // DEFINE PADDING ----------------------------------------------------
     // This is the paddings for the text relative to the field
     int paddingX = 5;
     int paddingY = 3;
 
+    // If there is no fontSize speicified make the font max height
+    int textHeight = fontSize == -1 ? dRect.h - paddingY*2 : fontSize;
+    int fieldWidth = dRect.w - paddingX*2;
+    if(textHeight < 1 || fieldWidth < 1) return state->value;
+
+
+    // METRICS -----------------------------------------------------------
+    // Every glyph is measured when typed, and all of them
+    // again only when the height or the font changes
+    Uint64 metrics = GUI::combine(textHeight, font);
+    if(state->metrics != metrics){
+        state->metrics = metrics;
+        GUI::measureInput(*state, 0, state->glyphs.size(), textHeight, font);
+    }
 
+    // The glyph metrics are in the units of the size bucket
+    double scale = Fonts::getScale(textHeight, font);
+    if(scale <= 0) return state->value;
+    double limit = fieldWidth / scale;
+
+    // Walks from the scroll over the glyphs that fit in the field
+    auto visibleEnd = [&](double& width){
+        int end = state->scroll;
+        width = 0;
+        while(end < state->glyphs.size()){
+            const InputGlyph& glyph = state->glyphs[end];
+            double step = glyph.advance + (end > state->scroll ? glyph.kerning : 0);
+            if(width + step > limit) break;
+            width += step;
+            end++;
+        }
+        return end;
+    };
 
-    // TEXT RECT CALCULATION ---------------------------------------------
-    SDL_Rect textRect; // Calculate the position and size of the text
+    // Left of the visible text, aligned only when all of it fits
+    auto textLeft = [&](int end, double width){
+        int x = dRect.x + paddingX;
+        if(state->scroll != 0 || end != state->glyphs.size()) return x;
 
-    // TEXT RECT HEIGHT --------------------------------------------------
-    // If there is no fontSize speicified make the font max height
-    if(fontSize == -1){
-        textRect.h = dRect.h - paddingY*2;
+        int free = fieldWidth - (int)(width * scale);
+        if(textAlignX == GUI_ALIGN_CENTER) x += free / 2;
+        else if(textAlignX == GUI_ALIGN_RIGHT) x += free;
+        return x;
+    };
+
+
+    // KEYBOARD ----------------------------------------------------------
+    if(state->focused){
+        SDL_Keymod mod = Sys::Keyboard::getMod();
+        bool shift = mod & KMOD_SHIFT;
+        bool command = mod & (KMOD_CTRL | KMOD_GUI);
+
+        // Typed text replaces the selection
+        const string& typed = Sys::Keyboard::getText();
+        if(!typed.empty()) GUI::insertInput(*state, typed, textHeight, font);
+
+        // Held keys repeat with time
+        for(int k = 0; k < INPUT_KEY_COUNT; k++){
+            int repeats = GUI::keyRepeats(state->repeat, INPUT_KEYS, k);
+            for(int r = 0; r < repeats; r++){
+                int size = state->glyphs.size();
+                int from = min(state->caret, state->anchor);
+                int to = max(state->caret, state->anchor);
+                bool selected = from != to;
+
+                switch(INPUT_KEYS[k]){
+                    case SDLK_BACKSPACE:
+                        if(selected) GUI::eraseInput(*state, from, to, textHeight, font);
+                        else GUI::eraseInput(*state, state->caret - 1, state->caret, textHeight, font);
+                        break;
+                    case SDLK_DELETE:
+                        if(selected) GUI::eraseInput(*state, from, to, textHeight, font);
+                        else GUI::eraseInput(*state, state->caret, state->caret + 1, textHeight, font);
+                        break;
+                    case SDLK_LEFT:
+                        // Without Shift a selection collapses to its edge
+                        if(selected && !shift) state->caret = from;
+                        else state->caret = max(state->caret - 1, 0);
+                        break;
+                    case SDLK_RIGHT:
+                        if(selected && !shift) state->caret = to;
+                        else state->caret = min(state->caret + 1, size);
+                        break;
+                    case SDLK_HOME:
+                        state->caret = 0;
+                        break;
+                    case SDLK_END:
+                        state->caret = size;
+                        break;
+                }
+                if(!shift) state->anchor = state->caret;
+                state->editedAt = SDL_GetTicks64();
+            }
+        }
+
+        // Shortcuts
+        SDL_Keycode key = Sys::Keyboard::getKeyDown();
+        int from = min(state->caret, state->anchor);
+        int to = max(state->caret, state->anchor);
+        if(command && key == SDLK_a){
+            state->anchor = 0;
+            state->caret = state->glyphs.size();
+        }
+        else if(command && (key == SDLK_c || key == SDLK_x) && from != to){
+            inputScratch.clear();
+            GUI::encodeInput(*state, from, to, inputScratch);
+            SDL_SetClipboardText(inputScratch.c_str());
+            if(key == SDLK_x) GUI::eraseInput(*state, from, to, textHeight, font);
+        }
+        else if(command && key == SDLK_v){
+            char* clipboard = SDL_GetClipboardText();
+            if(clipboard != nullptr){
+                GUI::insertInput(*state, clipboard, textHeight, font);
+                SDL_free(clipboard);
+            }
+        }
     } else {
-        textRect.h = fontSize;
+        // Keys held while unfocused dont repeat once focused
+        state->repeat.held = 0;
     }
 
-    // TEXT RECT WIDTH ---------------------------------------------------
-    textRect.w = textRect.h * (float)state->td.width / state->td.height;
 
-    // TEXT RECT X POS ---------------------------------------------------
-    // Depending on the placement, left, center, right. Default: left
-    if(textAlignX == GUI_ALIGN_LEFT){
-        textRect.x = dRect.x + paddingX;
-    } else if(textAlignX == GUI_ALIGN_RIGHT){
-        textRect.x = dRect.x + dRect.w - paddingX - textRect.w;
-    } else if(textAlignX == GUI_ALIGN_CENTER){
-        textRect.x = dRect.x + dRect.w/2 - textRect.w/2;
+    // MOUSE -------------------------------------------------------------
+    // If the user clicks on the field, focus it and put the caret
+    // there, else if he clicks somewhere else unfocus it
+    bool pressed = !inputLock && Sys::Mouse::isPressed();
+    if(pressed && Sys::Mouse::isHovering(dRect)){
+        Sys::Keyboard::focus();
+        state->focused = true;
+        state->dragging = true;
+    }
+    else if(pressed && state->focused){
+        Sys::Keyboard::unfocus();
+        state->focused = false;
     }
+    if(!Sys::Mouse::isDown()) state->dragging = false;
+
+    // Pressing puts the caret, dragging selects
+    if(state->dragging){
+        double width;
+        int end = visibleEnd(width);
+        double units = (Sys::Mouse::getPos().x - textLeft(end, width)) / scale;
 
-    // TEXT RECT Y POS ---------------------------------------------------
+        state->caret = GUI::inputCaretAt(*state, units, end);
+
+        // Only a drag past the right edge scrolls on, a glyph every frame
+        if(Sys::Mouse::getPos().x > dRect.x + dRect.w) state->caret = min(end + 1, state->glyphs.size());
+        if(pressed && !(Sys::Keyboard::getMod() & KMOD_SHIFT)) state->anchor = state->caret;
+        state->editedAt = SDL_GetTicks64();
+    }
+
+    // If Sys::Keyboard::unfocus() was runned but the input still wants the focus
+    if(state->focused && !Sys::Keyboard::isFocused()) Sys::Keyboard::focus();
+
+
+    // SCROLL ------------------------------------------------------------
+    // Keeps the caret visible, walking only over the glyphs that fit
+    int size = state->glyphs.size();
+    state->caret = min(max(state->caret, 0), size);
+    state->anchor = min(max(state->anchor, 0), size);
+
+    // Smallest scroll that still shows the glyphs in [scroll, last)
+    auto firstFitting = [&](int last){
+        int first = last;
+        double width = 0;
+        while(first > 0){
+            double step = state->glyphs[first - 1].advance + (first < last ? state->glyphs[first].kerning : 0);
+            if(width + step > limit) break;
+            width += step;
+            first--;
+        }
+        return first;
+    };
+
+    if(state->caret < state->scroll) state->scroll = state->caret;
+    state->scroll = max(state->scroll, firstFitting(state->caret));
+
+    // Once the text got shorter dont leave empty space after it
+    state->scroll = min(state->scroll, firstFitting(size));
+
+    double width;
+    int end = visibleEnd(width);
+    int textX = textLeft(end, width);
+
+    int textY;
     if(textAlignY == GUI_ALIGN_BOTTOM){
-        textRect.y = dRect.y + dRect.h - paddingY - textRect.h;
-    } else if(textAlignY == GUI_ALIGN_CENTER){
-        textRect.y = dRect.y + dRect.h/2 - textRect.h/2;
+        textY = dRect.y + dRect.h - paddingY - textHeight;
     } else if(textAlignY == GUI_ALIGN_TOP){
-        textRect.y = dRect.y + paddingY;
+        textY = dRect.y + paddingY;
+    } else {
+        textY = dRect.y + dRect.h/2 - textHeight/2;
     }
-    
 
-    // Render the text
-    TM::renderTexture(state->td, textRect);
+    // X of the boundary before a visible glyph
+    auto boundaryX = [&](int glyph){
+        double pen = 0;
+        for(int i = state->scroll; i < glyph; i++){
+            pen += state->glyphs[i].advance + (i > state->scroll ? state->glyphs[i].kerning : 0);
+        }
+        return textX + (int)(pen * scale);
+    };
+
+
+    // DRAW --------------------------------------------------------------
+    // Selection
+    int selectFrom = max(min(state->caret, state->anchor), state->scroll);
+    int selectTo = min(max(state->caret, state->anchor), end);
+    if(selectFrom < selectTo){
+        int x1 = boundaryX(selectFrom);
+        int x2 = boundaryX(selectTo);
+        GUI::Rect({x1, dRect.y + paddingY, x2 - x1, dRect.h - paddingY*2}, {foreground.r, foreground.g, foreground.b, 70});
+    }
+
+    // Text, or the placeholder if there is none
+    if(!layerCached){
+        SDL_Rect rect = toLayer({textX, textY, 0, textHeight});
+        int err = NO_ERROR;
+        if(size > 0){
+            inputScratch.clear();
+            GUI::encodeInput(*state, state->scroll, end, inputScratch);
+            err = GlyphAtlas::draw(inputScratch, rect, foreground, textQuality, font);
+        }
+        else if(!placeholder.empty()){
+            SDL_Color color = foreground;
+            color.a *= 0.75;
+
+            int placeholderWidth = GUI::measureText(placeholder, textHeight, font);
+            if(textAlignX == GUI_ALIGN_CENTER) rect.x += (fieldWidth - placeholderWidth) / 2;
+            else if(textAlignX == GUI_ALIGN_RIGHT) rect.x += fieldWidth - placeholderWidth;
+            err = GlyphAtlas::draw(placeholder, rect, color, textQuality, font);
+        }
+        CHECK_ERROR(err);
+    }
 
     if(inputLock) GUI::Rect(dRect, {120, 120, 120, 120});
 
-    // Check if placeholder was rendered
-    bool placeholderActive = false;
-    if(state->value == "") placeholderActive = true;
+    // The caret is shown for GUI_CARET_BLINK ms after every edit, and then blinks
+    if(state->focused && (SDL_GetTicks64() - state->editedAt) / GUI_CARET_BLINK % 2 == 0){
+        int x = boundaryX(min(state->caret, end));
+        if(size == 0 && textAlignX == GUI_ALIGN_CENTER) x = dRect.x + dRect.w/2;
+        else if(size == 0 && textAlignX == GUI_ALIGN_RIGHT) x = dRect.x + dRect.w - paddingX;
+
+        GUI::Line({x, dRect.y + paddingY}, {x, dRect.y + dRect.h - paddingY}, foreground);
+    }
+
+    // A focused input blinks and takes text, so its layer
+    // can not stay cached, it is rendered again next frame
+    if(activeLayer != 0 && state->focused) GUI::getActiveLayer()->invalidated = true;
+
+    // Return the value
+    return state->value;
+}
+
+
+
+
+
+/** Destroy Input / Reset Input
+ * 
+ * This function  should be called if you need to 
+ * restart the field or you are sure that its out 
+ * of scope and its data is no longer important.
+ * 
+ * @param uniqueId Id of the input to be reset, destroyed.
+ */
+void GUI::DestroyInput(string_view uniqueId){
+    Uint64 id = GUI::getID(uniqueId);
+    InputState* state = inputStates.find(id);
+    if(state == nullptr) return;
+
+    if(state->focused) Sys::Keyboard::unfocus();
+    inputStates.erase(id);
+    return;
+}
+
+
+
+
+// TEXT AREA ---------------------------------------------------------------------------------------
+
+// Keys that act again while held in a text area, their bit in KeyRepeat::held is the index
+static const SDL_Keycode AREA_KEYS[] = {
+    SDLK_BACKSPACE, SDLK_DELETE, SDLK_RETURN, SDLK_LEFT, SDLK_RIGHT, SDLK_UP,
+    SDLK_DOWN, SDLK_HOME, SDLK_END, SDLK_PAGEUP, SDLK_PAGEDOWN
+};
+static const int AREA_KEY_COUNT = sizeof(AREA_KEYS) / sizeof(AREA_KEYS[0]);
+
+// A byte continuing a UTF-8 sequence, the caret never stops before it
+static bool isContinuation(char c){ return ((Uint8)c & 0xc0) == 0x80; }
+
+static size_t previousBoundary(const Rope& text, size_t pos){
+    if(pos == 0) return 0;
+    pos--;
+    while(pos > 0 && isContinuation(text.at(pos))) pos--;
+    return pos;
+}
+
+static size_t nextBoundary(const Rope& text, size_t pos){
+    if(pos >= text.size()) return text.size();
+    pos++;
+    while(pos < text.size() && isContinuation(text.at(pos))) pos++;
+    return pos;
+}
+
+
+
+/** Layout Area Line
+ * 
+ * INTERNAL USE
+ * 
+ * Returns the layout of a line of the text area, laid out only if it
+ * isnt cached yet. The reference is valid until the next line is laid out.
+ * 
+ * @param state State of the text area
+ * @param line Line index
+ * @param height Line height in pixels
+ * @param font Font id
+ * @return The text of the line and the x of each of its bytes
+ */
+const GUI::AreaLine& GUI::layoutAreaLine(TextAreaState& state, int line, int height, int font){
+    // Keys are the line + 1, as 0 marks the empty slots
+    AreaLine* cached = state.lines.find(line + 1);
+    if(cached != nullptr) return *cached;
+
+    AreaLine& layout = state.lines.insert(line + 1, AreaLine());
+    state.text->copy(state.text->lineStart(line), state.text->lineEnd(line), layout.text);
+    layout.x.assign(layout.text.size() + 1, 0);
+
+    double scale = Fonts::getScale(height, font);
+    double pen = 0;
+    Uint32 previous = 0;
+    bool reported = false;
+    for(size_t i = 0; i < layout.text.size();){
+        size_t start = i;
+        Uint32 codepoint = Fonts::nextCodepoint(layout.text, i);
+
+        int advance = 0, kerning = 0;
+        int err = Fonts::glyphMetrics(codepoint, previous, height, advance, kerning, font);
+        if(err != NO_ERROR && !reported){
+            CHECK_ERROR(err);
+            reported = true;
+        }
+
+        // All bytes of the glyph are at its start
+        int x = (int)lround(pen * scale);
+        for(size_t b = start; b < i; b++) layout.x[b] = x;
+
+        pen += kerning + advance;
+        previous = codepoint;
+    }
+    layout.x.back() = (int)lround(pen * scale);
+
+    return layout;
+}
+
+
+
+
+/** Edit Area
+ * 
+ * INTERNAL USE
+ * 
+ * Replaces the bytes in [from, to) with the text and puts the caret after it.
+ * Only the layout of the edited line is dropped, unless lines were added or
+ * removed, then the layouts of the lines after it are dropped as well.
+ * 
+ * @param state State of the text area
+ * @param from First byte
+ * @param to One past the last byte
+ * @param text UTF-8 text
+ */
+void GUI::editArea(TextAreaState& state, size_t from, size_t to, string_view text){
+    int line = state.text->lineOf(from);
+    bool sameLine = text.find('\n') == string_view::npos && state.text->lineOf(to) == line;
+
+    state.text->erase(from, to);
+    state.text->insert(from, text);
+
+    if(sameLine) state.lines.erase(line + 1);
+    else GUI::dropAreaLines(state, line);
+    state.version = state.text->version();
+    state.text->markSeen();
+
+    state.caret = state.anchor = from + text.size();
+    state.preferredX = -1;
+    state.reveal = true;
+    state.editedAt = SDL_GetTicks64();
+}
+
+
+
+
+/** Drop Area Lines
+ * 
+ * INTERNAL USE
+ * 
+ * Drops the cached layouts of the lines from a line on, the ones before it stay.
+ * 
+ * @param state State of the text area
+ * @param from First line to be laid out again
+ */
+void GUI::dropAreaLines(TextAreaState& state, int from){
+    staleLines.clear();
+    state.lines.forEach([&](Uint64 key, AreaLine&){
+        if((int)key - 1 >= from) staleLines.push_back(key);
+    });
+    for(Uint64 key : staleLines) state.lines.erase(key);
+}
+
+
+
+
+/** Area Offset At
+ * 
+ * INTERNAL USE
+ * 
+ * Finds the glyph boundary of a line closest to an x, with a binary search over the x of its bytes.
+ * 
+ * @param state State of the text area
+ * @param line Line index
+ * @param x Pixels from the start of the line
+ * @param height Line height in pixels
+ * @param font Font id
+ * @return Byte offset in the text
+ */
+size_t GUI::areaOffsetAt(TextAreaState& state, int line, int x, int height, int font){
+    const AreaLine& layout = GUI::layoutAreaLine(state, line, height, font);
+    size_t size = layout.text.size();
+
+    // The boundaries before and after the first byte past x
+    size_t after = std::upper_bound(layout.x.begin(), layout.x.end(), x) - layout.x.begin();
+    after = min(after, size);
+    while(after < size && isContinuation(layout.text[after])) after++;
+
+    size_t before = after > 0 ? after - 1 : 0;
+    while(before > 0 && isContinuation(layout.text[before])) before--;
+
+    size_t byte = x - layout.x[before] <= layout.x[after] - x ? before : after;
+    return state.text->lineStart(line) + byte;
+}
+
+
+
+
+/** Text Area
+ * 
+ * Renders a multi-line text field using a unique id, for editing
+ * or showing documents of any length, like logs and notes.
+ * 
+ * The text is kept in a rope with a line index, so finding a line and
+ * editing take O(log n) whatever the size of the document is. Only the
+ * visible lines are laid out and drawn, their layouts are cached and an
+ * edit lays out again only its own line. Long lines are drawn only within
+ * the field. The mouse wheel scrolls smoothly, the caret moves with the
+ * arrows, Home, End, PageUp and PageDown, Shift or dragging selects,
+ * and Ctrl+A, C, X and V work with the clipboard. It supports the font
+ * size (line height), font, quality, auto focus and input lock push styles.
+ * 
+ * @param uniqueId A unique string intrenaly used to itentify the text area acrros diffrent frames
+ * @param dRect A SDL_Rect representing where and what size should the field be rendered
+ * @param background SDL_Color representing the background field color
+ * @param foreground SDL_Color representing the text color
+ * @return The text of the field, it can be edited trough it, like appending the new log lines.
+ *         The reference is valid until the text area is destroyed
+ */
+Rope& GUI::TextArea(
+    string_view uniqueId,
+    const SDL_Rect& dRect,
+    const SDL_Color& background,
+    const SDL_Color& foreground
+){
+    // COPY STYLES -------------------------------------------------------
+    int lineHeight = GUI::pFontSize;
+    if(lineHeight == -1) lineHeight = GUI_DEFAULT_LINE_HEIGHT;
+    GUI::pFontSize = -1;
+
+    bool autoFocus = GUI::pAutoFocus;
+    GUI::pAutoFocus = false;
+
+    bool inputLock = GUI::pInputLock;
+    GUI::pInputLock = false;
+
+    int font = GUI::pFont;
+    if(font == -1) font = FONT_DEFAULT;
+    GUI::pFont = -1;
+
+    int textQuality = GUI::pTextQuality;
+    if(textQuality == -1) textQuality = TEXT_BLENDED;
+    GUI::pTextQuality = -1;
+
+
+
+
+    // FIND STATE --------------------------------------------------------
+    Uint64 id = GUI::getID(uniqueId);
+    TextAreaState* state = textAreas.find(id);
+    if(state == nullptr){
+        state = &textAreas.insert(id, TextAreaState());
+        state->text = make_unique<Rope>();
+    }
+    Rope& text = *state->text;
+
+    if(inputLock){
+        autoFocus = false;
+        if(state->focused) Sys::Keyboard::unfocus();
+        state->focused = false;
+        state->dragging = false;
+    }
+
+    if(autoFocus){
+        Sys::Keyboard::focus();
+        state->focused = true;
+    }
+
+
+    // DRAW BACKGROUND ---------------------------------------------------
+    GUI::Rect(dRect, background);           // Background field
+    GUI::Rect(dRect, SDL_COLOR_BLACK, 1);   // 1px black Outline
 
-    // If the rendered text is larger then the allowed width
-    // and we are also not talking about the placeholder THEN
-    // make the removed variable larger by one, signaling to the
-    // next frame that it should cut out one more frame from the left
-    if(textRect.w > (dRect.w - paddingX*2) && !placeholderActive){
-        state->removed++;
-        state->change = true;
+    int paddingX = 5;
+    int paddingY = 3;
+    SDL_Rect view = {dRect.x + paddingX, dRect.y + paddingY, dRect.w - paddingX*2, dRect.h - paddingY*2};
+    if(view.w < 1 || view.h < 1 || lineHeight < 1) return text;
+
+
+    // LINE LAYOUTS ------------------------------------------------------
+    // Edits made trough the returned rope drop the layouts from the first
+    // line they edited on, so appending to a log lays out only its end
+    Uint64 metrics = GUI::combine(lineHeight, font);
+    if(state->metrics != metrics || state->version != text.version()){
+        if(state->metrics != metrics) state->lines.clear();
+        else GUI::dropAreaLines(*state, text.lineOf(min(text.editedFrom(), text.size())));
+
+        state->metrics = metrics;
+        state->version = text.version();
+        text.markSeen();
+        state->caret = min(state->caret, text.size());
+        state->anchor = min(state->anchor, text.size());
     }
 
+    Uint64 now = SDL_GetTicks64();
+    int rows = max(view.h / lineHeight, 1);
 
 
-    // If the keyboard is focused on the field draw the caret, text cursor
+    // KEYBOARD ----------------------------------------------------------
     if(state->focused){
-        // The cursor would be drawn for half a second and then be not drawn for 
-        // another half a second, this is acheved trough clock which changes value
-        // every (FPS / 2)frames so it can be devieded using %2 operator
-        int blinkClock = static_cast<int>( Sys::getCurrentFrame() / (Sys::FPS / 2) );
-        if(blinkClock % 2){
-            // Top point of the line, default the
-            // x is equal to the starting position of the text
-            SDL_Point p1 = {0, dRect.y + paddingY};
-            
-            // If the placeholder is not active then draw the 
-            // line at the end of the text.
-            // Else, the placeholder is active, then draw the line
-            // just few pixels behind the placeholder, so its vissible
-            if(placeholderActive){
-                if(textAlignX == GUI_ALIGN_LEFT){
-                    p1.x = dRect.x + paddingX;
-                } else if(textAlignX == GUI_ALIGN_CENTER){
-                    p1.x = dRect.x + dRect.w/2;
-                } else if(textAlignX == GUI_ALIGN_RIGHT){
-                    p1.x = dRect.x + dRect.w - paddingX;
+        SDL_Keymod mod = Sys::Keyboard::getMod();
+        bool shift = mod & KMOD_SHIFT;
+        bool command = mod & (KMOD_CTRL | KMOD_GUI);
+
+        // Typed text replaces the selection
+        const string& typed = Sys::Keyboard::getText();
+        if(!typed.empty()){
+            GUI::editArea(*state, min(state->caret, state->anchor), max(state->caret, state->anchor), typed);
+        }
+
+        // Held keys repeat with time
+        for(int k = 0; k < AREA_KEY_COUNT; k++){
+            int repeats = GUI::keyRepeats(state->repeat, AREA_KEYS, k);
+            for(int r = 0; r < repeats; r++){
+                size_t from = min(state->caret, state->anchor);
+                size_t to = max(state->caret, state->anchor);
+                bool selected = from != to;
+                int line = text.lineOf(state->caret);
+                bool vertical = false;
+
+                switch(AREA_KEYS[k]){
+                    case SDLK_BACKSPACE:
+                        if(selected) GUI::editArea(*state, from, to, "");
+                        else GUI::editArea(*state, previousBoundary(text, state->caret), state->caret, "");
+                        break;
+                    case SDLK_DELETE:
+                        if(selected) GUI::editArea(*state, from, to, "");
+                        else GUI::editArea(*state, state->caret, nextBoundary(text, state->caret), "");
+                        break;
+                    case SDLK_RETURN:
+                        GUI::editArea(*state, from, to, "\n");
+                        break;
+                    case SDLK_LEFT:
+                        // Without Shift a selection collapses to its edge
+                        if(selected && !shift) state->caret = from;
+                        else state->caret = previousBoundary(text, state->caret);
+                        break;
+                    case SDLK_RIGHT:
+                        if(selected && !shift) state->caret = to;
+                        else state->caret = nextBoundary(text, state->caret);
+                        break;
+                    case SDLK_UP:
+                    case SDLK_DOWN:
+                    case SDLK_PAGEUP:
+                    case SDLK_PAGEDOWN: {
+                        int step = 1;
+                        if(AREA_KEYS[k] == SDLK_UP) step = -1;
+                        else if(AREA_KEYS[k] == SDLK_PAGEUP) step = -rows;
+                        else if(AREA_KEYS[k] == SDLK_PAGEDOWN) step = rows;
+
+                        // A page moves the view along with the caret
+                        if(step == rows || step == -rows) state->targetY += (double)step * lineHeight;
+
+                        // The caret keeps its x over shorter lines
+                        if(state->preferredX < 0){
+                            const AreaLine& layout = GUI::layoutAreaLine(*state, line, lineHeight, font);
+                            state->preferredX = layout.x[state->caret - text.lineStart(line)];
+                        }
+
+                        int target = min(max(line + step, 0), text.lineCount() - 1);
+                        if(target == line) state->caret = step < 0 ? 0 : text.size();
+                        else state->caret = GUI::areaOffsetAt(*state, target, state->preferredX, lineHeight, font);
+                        vertical = true;
+                        break;
+                    }
+                    case SDLK_HOME:
+                        state->caret = command ? 0 : text.lineStart(line);
+                        break;
+                    case SDLK_END:
+                        state->caret = command ? text.size() : text.lineEnd(line);
+                        break;
                 }
-            } else {
-                p1.x = textRect.x + textRect.w + 1;
+                if(!vertical) state->preferredX = -1;
+                if(!shift) state->anchor = state->caret;
+                state->reveal = true;
+                state->editedAt = now;
             }
+        }
 
-            // Bottom point of the line
-            SDL_Point p2 = {
-                p1.x, 
-                p1.y + (dRect.h - paddingY*2)
-            };
-            
-            // Draw the line
-            GUI::Line(p1, p2, SDL_COLOR_BLACK);
+        // Shortcuts
+        SDL_Keycode key = Sys::Keyboard::getKeyDown();
+        size_t from = min(state->caret, state->anchor);
+        size_t to = max(state->caret, state->anchor);
+        if(command && key == SDLK_a){
+            state->anchor = 0;
+            state->caret = text.size();
         }
+        else if(command && (key == SDLK_c || key == SDLK_x) && from != to){
+            inputScratch.clear();
+            text.copy(from, to, inputScratch);
+            SDL_SetClipboardText(inputScratch.c_str());
+            if(key == SDLK_x) GUI::editArea(*state, from, to, "");
+        }
+        else if(command && key == SDLK_v){
+            char* clipboard = SDL_GetClipboardText();
+            if(clipboard != nullptr){
+                // Windows line endings become plain newlines
+                inputScratch.clear();
+                for(const char* c = clipboard; *c != 0; c++) if(*c != '\r') inputScratch += *c;
+                SDL_free(clipboard);
+                GUI::editArea(*state, from, to, inputScratch);
+            }
+        }
+    } else {
+        // Keys held while unfocused dont repeat once focused
+        state->repeat.held = 0;
     }
-    
 
-    // EVENTS ---------------------------------
-    // If the user is hovering the input filed
-    // and he clicks then focus the input onto the filed
-    if(
-        Sys::Mouse::isHovering(dRect) &&
-        Sys::Mouse::isClicked()
-    ) {
+
+    // MOUSE -------------------------------------------------------------
+    bool hovering = Sys::Mouse::isHovering(dRect);
+    if(hovering) state->targetY -= Sys::Mouse::getWheel() * lineHeight * 3;
+
+    // If the user clicks on the field, focus it and put the caret
+    // there, else if he clicks somewhere else unfocus it
+    bool pressed = !inputLock && Sys::Mouse::isPressed();
+    if(pressed && hovering){
         Sys::Keyboard::focus();
         state->focused = true;
+        state->dragging = true;
     }
-
-    // If user is not hovering the button, cursor is outside
-    // and there is click, that means that there has been unfocus
-    if(
-        !Sys::Mouse::isHovering(dRect) &&
-        Sys::Mouse::isClicked()
-    ){
+    else if(pressed && state->focused){
         Sys::Keyboard::unfocus();
         state->focused = false;
     }
+    if(!Sys::Mouse::isDown()) state->dragging = false;
+
+    // Pressing puts the caret, dragging selects, and past the
+    // edges the caret is revealed, so the view scrolls along
+    if(state->dragging){
+        SDL_Point mouse = Sys::Mouse::getPos();
+        int line = (int)floor((mouse.y - view.y + state->scrollY) / lineHeight);
+        line = min(max(line, 0), text.lineCount() - 1);
+
+        state->caret = GUI::areaOffsetAt(*state, line, mouse.x - view.x + state->scrollX, lineHeight, font);
+        if(pressed && !(Sys::Keyboard::getMod() & KMOD_SHIFT)) state->anchor = state->caret;
+        state->preferredX = -1;
+        state->reveal = true;
+        state->editedAt = now;
+    }
 
-    // If Sys::Keyboard::unfocus() was runned but the input still wants the focus
-    if(state->focused && !Sys::Keyboard::isFocused()) Sys::Keyboard::focus(); 
+    // If Sys::Keyboard::unfocus() was runned but the area still wants the focus
+    if(state->focused && !Sys::Keyboard::isFocused()) Sys::Keyboard::focus();
 
-    // A small lambda funtion for handling deletion
-    auto deleteLastChar = [&]() {
-        // If value is already empty skip
-        if (state->value.empty()) return;
 
-        // Pop last char and mark change has been made
-        state->value.pop_back();
-        state->change = true;
+    // SCROLL ------------------------------------------------------------
+    int lineCount = text.lineCount();
+    double maxY = max(0.0, (double)lineCount * lineHeight - view.h);
 
-        // If there was any chars to be removed, decrease the amount
-        if (state->removed != 0) state->removed--;
-    };
+    if(state->reveal){
+        state->reveal = false;
+        int line = text.lineOf(state->caret);
+        double top = (double)line * lineHeight;
+        if(top < state->targetY) state->targetY = top;
+        else if(top + lineHeight > state->targetY + view.h) state->targetY = top + lineHeight - view.h;
 
-    // If the input is focused handle key presses
-    if(state->focused){
-        // Add the text inputed into the value
-        if(Sys::Keyboard::getText() != "") {
-            state->change = true;
-            state->value += Sys::Keyboard::getText();
+        const AreaLine& layout = GUI::layoutAreaLine(*state, line, lineHeight, font);
+        int x = layout.x[state->caret - text.lineStart(line)];
+        if(x < state->scrollX) state->scrollX = max(x - view.w / 4, 0);
+        else if(x >= state->scrollX + view.w) state->scrollX = x - view.w * 3 / 4;
+    }
+    state->targetY = min(max(state->targetY, 0.0), maxY);
+
+    // Eases towards the target, halving the distance every 40ms at any frame rate
+    state->scrollY += (state->targetY - state->scrollY) * (1 - pow(0.5, Sys::deltaTime / 40.0));
+    if(fabs(state->targetY - state->scrollY) < 0.5) state->scrollY = state->targetY;
+    state->scrollY = min(max(state->scrollY, 0.0), maxY);
+
+
+    // DRAW --------------------------------------------------------------
+    int first = (int)(state->scrollY / lineHeight);
+    int last = min(lineCount - 1, (int)((state->scrollY + view.h) / lineHeight));
+
+    // Lines cut at the edges stay within the field
+    SDL_Rect clip = toLayer(view);
+    SDL_Rect previousClip;
+    bool clipped = SDL_RenderIsClipEnabled(Sys::renderer);
+    SDL_RenderGetClipRect(Sys::renderer, &previousClip);
+    SDL_RenderSetClipRect(Sys::renderer, &clip);
+
+    size_t selectFrom = min(state->caret, state->anchor);
+    size_t selectTo = max(state->caret, state->anchor);
+    SDL_Color selection = {foreground.r, foreground.g, foreground.b, 70};
+
+    for(int line = first; line <= last; line++){
+        const AreaLine& layout = GUI::layoutAreaLine(*state, line, lineHeight, font);
+        size_t size = layout.text.size();
+        int x = view.x - state->scrollX;
+        int y = view.y + (int)lround((double)line * lineHeight - state->scrollY);
+
+        // Selection, a selected newline is a bit of space after the line
+        size_t start = text.lineStart(line);
+        if(selectFrom < selectTo && selectFrom <= start + size && selectTo > start){
+            int x1 = layout.x[max(selectFrom, start) - start];
+            int x2 = layout.x[min(selectTo, start + size) - start];
+            if(selectTo > start + size) x2 += lineHeight / 4;
+            GUI::Rect({x + x1, y, x2 - x1, lineHeight}, selection);
         }
 
-        // If the backspace has been pressed handle deletion
-        if(Sys::Keyboard::getKeyDown() == SDLK_BACKSPACE){
-            // If the input is not in the state of deletion
-            // that menas that this is the first frame that
-            // backspace was pressed, so delete the last char
-            // and mark that the hold of the button has begun
-            if(!state->deleting){
-                deleteLastChar();
-                state->deleting = true;
-            } else{
-                // If the deletion has been going, and the
-                // backspace is still down, holding, every
-                // 200ms delete one last char from the field
-                if(Sys::getCurrentFrame() % (Sys::FPS / 5)){
-                    deleteLastChar();
-                }
+        // Only the glyphs within the field are drawn, found
+        // by a binary search over the x of the bytes
+        if(!layerCached && size > 0){
+            size_t from = std::upper_bound(layout.x.begin(), layout.x.end(), state->scrollX) - layout.x.begin();
+            from = min(from > 0 ? from - 1 : 0, size);
+            while(from > 0 && isContinuation(layout.text[from])) from--;
+
+            size_t to = std::lower_bound(layout.x.begin(), layout.x.end(), state->scrollX + view.w) - layout.x.begin();
+            to = min(to, size);
+            while(to < size && isContinuation(layout.text[to])) to++;
+
+            if(from < to){
+                SDL_Rect rect = toLayer({x + layout.x[from], y, 0, lineHeight});
+                int err = GlyphAtlas::draw(string_view(layout.text).substr(from, to - from), rect, foreground, textQuality, font);
+                CHECK_ERROR(err);
             }
-        } else{
-            // If the backspace is not pressed end the deletion process
-            state->deleting = false;
         }
     }
 
-    // Now handle the value changes and updating the texture
-    if(state->change){
-        TM::freeTexture(state->td);
-        
-        string textToCompile;
-        SDL_Color colorOfText = foreground;
-        if(state->value == ""){
-            colorOfText.a *= 0.75;
-            textToCompile = placeholder;
-        } else {
-            // So bc text can get longer then it can fit in the field
-            // program also keeps track of how many characters it needs
-            // to hide from the left side in order for text from the right
-            // side to be vissible and with in the bounds
-            textToCompile = state->value;
-            textToCompile.erase(0, state->removed);
+    // The caret is shown for GUI_CARET_BLINK ms after every edit, and then blinks
+    if(state->focused && (now - state->editedAt) / GUI_CARET_BLINK % 2 == 0){
+        int line = text.lineOf(state->caret);
+        if(line >= first && line <= last){
+            const AreaLine& layout = GUI::layoutAreaLine(*state, line, lineHeight, font);
+            int x = view.x - state->scrollX + layout.x[state->caret - text.lineStart(line)];
+            int y = view.y + (int)lround((double)line * lineHeight - state->scrollY);
+            GUI::Line({x, y}, {x, y + lineHeight - 1}, foreground);
         }
+    }
+
+    SDL_RenderSetClipRect(Sys::renderer, clipped ? &previousClip : nullptr);
 
-        TM::createTextTexture(state->td, textToCompile, colorOfText);
-        state->change = false;
+    // Scrollbar, when not all lines fit
+    if(maxY > 0){
+        int track = dRect.h - 2;
+        int thumb = max((int)(track * view.h / ((double)lineCount * lineHeight)), 12);
+        int thumbY = dRect.y + 1 + (int)((track - thumb) * state->scrollY / maxY);
+        GUI::Rect({dRect.x + dRect.w - 5, thumbY, 4, thumb}, {foreground.r, foreground.g, foreground.b, 110});
     }
 
-    // Return the value
-    return state->value;
+    if(inputLock) GUI::Rect(dRect, {120, 120, 120, 120});
+
+
+    // PRUNE -------------------------------------------------------------
+    // The layouts far from the view are dropped
+    if(state->lines.size() > GUI_AREA_LINE_CACHE){
+        staleLines.clear();
+        state->lines.forEach([&](Uint64 key, AreaLine&){
+            int line = (int)key - 1;
+            if(line < first - rows || line > last + rows) staleLines.push_back(key);
+        });
+        for(Uint64 key : staleLines) state->lines.erase(key);
+    }
+
+    // A focused or scrolling area is rendered again next frame
+    if(activeLayer != 0 && (state->focused || state->scrollY != state->targetY)) GUI::getActiveLayer()->invalidated = true;
+
+    return text;
 }
 
 
 
 
+/** Destroy Text Area
+ * 
+ * Frees the text and the state of the text area, should be
+ * called once it is no longer shown and its text is not needed.
+ * 
+ * @param uniqueId Id of the text area to be destroyed
+ */
+void GUI::DestroyTextArea(string_view uniqueId){
+    Uint64 id = GUI::getID(uniqueId);
+    TextAreaState* state = textAreas.find(id);
+    if(state == nullptr) return;
 
-/** Destroy Input / Reset Input
+    if(state->focused) Sys::Keyboard::unfocus();
+    textAreas.erase(id);
+}
+
+
+
+
+// LAYERS ------------------------------------------------------------------------------------------
+
+/** Layer ID
  * 
- * This function  should be called if you need to 
- * restart the field or you are sure that its out 
- * of scope and its data is no longer important.
+ * INTERNAL USE
  * 
- * @param uniqueId Id of the input to be reset, destroyed.
+ * Same as GUI::getID, but never 0, since activeLayer uses it for no layer.
  */
-void GUI::DestroyInput(const string& uniqueId){
-    InputState* state = nullptr;
-    auto it = inputStates.find(uniqueId);
-    if(it != inputStates.end()){
-        state = &it->second;
-    } else{
-        return;
+Uint64 GUI::layerID(string_view id){
+    Uint64 key = GUI::getID(id);
+    return key != 0 ? key : 1;
+}
+
+
+
+
+/** Get Active Layer
+ * 
+ * INTERNAL USE
+ * 
+ * Looks the layer up by its id every time, a pointer into layers
+ * wouldnt survive the map growing while the layer is drawn.
+ * 
+ * @return The layer between beginLayer and endLayer, or nullptr if there is none
+ */
+GUI::Layer* GUI::getActiveLayer(){
+    if(activeLayer == 0) return nullptr;
+    return layers.find(activeLayer);
+}
+
+
+
+
+/** To Layer
+ * 
+ * INTERNAL USE
+ * 
+ * Moves the screen rect into the space of the layer being recorded.
+ */
+SDL_Rect GUI::toLayer(SDL_Rect rect){
+    Layer* layer = GUI::getActiveLayer();
+    if(layer == nullptr) return rect;
+    rect.x -= layer->rect.x;
+    rect.y -= layer->rect.y;
+    return rect;
+}
+
+SDL_Point GUI::toLayer(SDL_Point point){
+    Layer* layer = GUI::getActiveLayer();
+    if(layer == nullptr) return point;
+    point.x -= layer->rect.x;
+    point.y -= layer->rect.y;
+    return point;
+}
+
+
+
+
+/** Render In Layer
+ * 
+ * INTERNAL USE
+ * 
+ * Renders the texture just like TM::renderTexture, into the layer being
+ * recorded if there is one. Inside a cached layer only the missing
+ * dimension of the dRect is calculated, so the hit tests still work.
+ * 
+ * @param td TextureData to be rendered
+ * @param dRect Where to render it, in the screen space
+ */
+void GUI::renderInLayer(const TextureData& td, SDL_Rect& dRect){
+    if(dRect.w < 0 && dRect.h < 0) return;
+    if(dRect.w == -1) dRect.w = dRect.h * (float)td.width / td.height;
+    if(dRect.h == -1) dRect.h = dRect.w * (float)td.height / td.width;
+
+    if(layerCached) return;
+
+    SDL_Rect rect = toLayer(dRect);
+    int err = TM::renderTexture(td, rect);
+    CHECK_ERROR(err);
+}
+
+
+
+
+/** Render Text In Layer
+ * 
+ * INTERNAL USE
+ * 
+ * Same as GUI::renderInLayer, for the text drawn out of the glyph atlas.
+ * 
+ * @param text Text to be rendered
+ * @param dRect Where to render it, in the screen space, one dimension can be -1
+ * @param color The color of the text
+ * @param quality TEXT_SOLID, TEXT_SHADED or TEXT_BLENDED
+ * @param font Font registered with Fonts::load
+ */
+void GUI::renderTextInLayer(string_view text, SDL_Rect& dRect, const SDL_Color& color, int quality, int font){
+    if(dRect.w < 0 && dRect.h < 0) return;
+
+    // The missing dimension follows the natural ratio of the text
+    if(dRect.w == -1){
+        int err = GlyphAtlas::measure(text, dRect.h, dRect.w, font);
+        CHECK_ERROR(err);
+    }
+    if(dRect.h == -1){
+        const int reference = 64;
+        int width = 0;
+        int err = GlyphAtlas::measure(text, reference, width, font);
+        CHECK_ERROR(err);
+        dRect.h = width > 0 ? dRect.w * reference / width : 0;
     }
 
-    TM::freeTexture(state->td);
-    Sys::Keyboard::unfocus();
-    state->focused = false;
-    state->value.clear();
-    inputStates.erase(it);
-    return;
+    if(layerCached) return;
+
+    SDL_Rect rect = toLayer(dRect);
+    int err = GlyphAtlas::draw(text, rect, color, quality, font);
+    CHECK_ERROR(err);
+}
+
+
+
+
+/** Begin Layer
+ * 
+ * Starts a retained layer, every GUI call until GUI::endLayer() is
+ * rendered into a texture of the rect size instead of the screen. On the
+ * next frames the calls skip the drawing and the texture is just blitted,
+ * until the hash changes or the layer is invalidated. The calls still run,
+ * so hovering and clicking the buttons inside the layer keeps working.
+ * Button colors are tracked, so hover colors show up a frame later, anything
+ * else the content depends on should be a part of the hash. Focused inputs
+ * keep the layer rendering every frame.
+ * 
+ * Layers can not be nested, the inner begin/end pair draws straight into
+ * the outer layer and GUI_LAYER_NESTED is returned. Its endLayer() has to
+ * be called all the same.
+ * 
+ * @param id Unique id of the layer
+ * @param rect Where the layer is on the screen, GUI calls inside use screen coordinates
+ * @param hash Hash of everything the content depends on
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int GUI::beginLayer(string_view id, const SDL_Rect& rect, Uint64 hash){
+    if(layerDepth++ > 0) return GUI_LAYER_NESTED;
+    if(rect.w <= 0 || rect.h <= 0) return TM_INVALID_DRECT;
+
+    Uint64 key = GUI::layerID(id);
+    Layer& layer = layers[key];
+
+    // (RE)CREATE THE TARGET ----------------------------------------------------------------
+    bool resized = layer.rect.w != rect.w || layer.rect.h != rect.h;
+    if(resized || TM::resolve(layer.td) == nullptr){
+        TM::freeTexture(layer.td);
+        layer.valid = false;
+
+        int err = TM::acquireTexture(layer.td, rect.w, rect.h);
+        if(err != NO_ERROR) return err;
+
+        // Drawing onto the transparent target leaves premultiplied colors in it
+        SDL_SetTextureBlendMode(TM::resolve(layer.td), TM::getPremultipliedBlendMode());
+    }
+    layer.rect = rect;
+
+    if(layer.hash != hash){
+        layer.hash = hash;
+        layer.valid = false;
+    }
+
+    activeLayer = key;
+    layerColors = GUI_HASH_SEED;
+
+    // CACHED -------------------------------------------------------------------------------
+    if(layer.valid){
+        layerCached = true;
+        return NO_ERROR;
+    }
+
+    // RECORD -------------------------------------------------------------------------------
+    layerPreviousTarget = SDL_GetRenderTarget(Sys::renderer);
+    if(SDL_SetRenderTarget(Sys::renderer, TM::resolve(layer.td))){
+        activeLayer = 0;
+        return TM_SRT_FAILED;
+    }
+
+    SDL_SetRenderDrawColor(Sys::renderer, 0, 0, 0, 0);
+    SDL_RenderClear(Sys::renderer);
+    return NO_ERROR;
+}
+
+
+
+
+/** End Layer
+ * 
+ * Ends the layer started by GUI::beginLayer() and blits its texture.
+ */
+void GUI::endLayer(){
+    if(layerDepth == 0) return;
+    if(--layerDepth > 0) return;
+    Layer* found = GUI::getActiveLayer();
+    activeLayer = 0;
+    if(found == nullptr) return;
+
+    Layer& layer = *found;
+
+    if(!layerCached){
+        SDL_SetRenderTarget(Sys::renderer, layerPreviousTarget);
+        layer.valid = true;
+    }
+    layerCached = false;
+
+    // A button changed its color, most likely hovered
+    if(layer.colors != layerColors){
+        layer.colors = layerColors;
+        layer.valid = false;
+    }
+
+    // Invalidated while drawing, render it again next frame
+    if(layer.invalidated){
+        layer.valid = false;
+        layer.invalidated = false;
+    }
+
+    SDL_Rect dRect = layer.rect;
+    int err = TM::renderTexture(layer.td, dRect);
+    CHECK_ERROR(err);
+}
+
+
+
+
+/** Invalidate Layer
+ * 
+ * Makes the layer render its content again next time it is drawn.
+ * 
+ * @param id Id of the layer
+ */
+void GUI::invalidateLayer(string_view id){
+    Uint64 key = GUI::layerID(id);
+    Layer* layer = layers.find(key);
+    if(layer == nullptr) return;
+
+    if(key == activeLayer) layer->invalidated = true;
+    else layer->valid = false;
+}
+
+
+
+
+/** Free Layer
+ * 
+ * Frees the texture of the layer, should be called once it is no longer drawn.
+ * 
+ * @param id Id of the layer
+ */
+void GUI::freeLayer(string_view id){
+    Uint64 key = GUI::layerID(id);
+    Layer* layer = layers.find(key);
+    if(layer == nullptr || key == activeLayer) return;
+
+    TM::freeTexture(layer->td);
+    layers.erase(key);
+}
+
+
+
+
+// WIDGET IDS --------------------------------------------------------------------------------------
+
+/** Push ID
+ * 
+ * Opens an id scope, the ids of the inputs and layers inside it are hashed
+ * together with it, so the same label can be reused in every row of a list.
+ * Every push needs its GUI::popID().
+ * 
+ *     for(int i = 0; i < rows; i++){
+ *         GUI::pushID(i);
+ *         GUI::Input("name", rect);
+ *         GUI::popID();
+ *     }
+ * 
+ * @param id Name or hash of the scope, like "toolbar"_id
+ */
+void GUI::pushID(string_view id){ GUI::pushID(GUI::hash(id)); }
+
+void GUI::pushID(Uint64 id){
+    Uint64 scope = GUI::combine(idStack[min(idDepth, GUI_ID_STACK_DEPTH - 1)], id);
+
+    // Scopes nested deeper then the stack share the innermost one
+    idDepth++;
+    if(idDepth < GUI_ID_STACK_DEPTH) idStack[idDepth] = scope;
+}
+
+
+
+
+/** Pop ID
+ * 
+ * Closes the scope opened by GUI::pushID().
+ */
+void GUI::popID(){
+    if(idDepth > 0) idDepth--;
+}
+
+
+
+
+/** Get ID
+ * 
+ * @param label Label of the widget
+ * @return Id of the widget within the current scope
+ */
+Uint64 GUI::getID(string_view label){
+    return GUI::hash(label, idStack[min(idDepth, GUI_ID_STACK_DEPTH - 1)]);
 }
 
 
 
 
 void GUI::pushFontSize(const int& fontSize) { pFontSize = fontSize; }
+void GUI::pushFont(const int& fontId)       { pFont = fontId; }
+void GUI::pushTextQuality(const int& value) { pTextQuality = value; }
 void GUI::pushTextAlignX(const int& value)  { pTextAlignX = value;  }
 void GUI::pushTextAlignY(const int& value)  { pTextAlignY = value;  }
 void GUI::pushAutoFocus()                   { pAutoFocus = true;    }
@@ -4,6 +4,11 @@
 
 #include "../lib.h"
 #include "../TextureManager/TM.h"
+#include "../Plot/Plot.h"
+#include "../Text/Text.h"
+#include "./FlatMap.h"
+#include "./GapBuffer.h"
+#include "./Rope.h"
 
 #define GUI_CURSOR_OUTSIDE     0
 #define GUI_CURSOR_CLICKED     1
@@ -16,19 +21,55 @@
 #define GUI_ALIGN_TOP       4
 #define GUI_ALIGN_BOTTOM    5
 
+#define GUI_TEXT_ATLAS      0   // Text drawn glyph by glyph out of the glyph atlas, no texture per string
+#define GUI_TEXT_TEXTURES   1   // A cached texture per (string, color), in loadedTexts
+
+#define GUI_HASH_SEED       14695981039346656037ULL     // FNV-1a offset basis, the id of the root scope
+#define GUI_HASH_PRIME      1099511628211ULL
+#define GUI_ID_STACK_DEPTH  32
+
+#define GUI_KEY_REPEAT_DELAY    400     // ms a key is held before it starts repeating in GUI::Input and GUI::TextArea
+#define GUI_KEY_REPEAT_INTERVAL 35      // ms between the repeats
+#define GUI_CARET_BLINK         530     // ms the caret is shown, and then hidden
+
+#define GUI_DEFAULT_LINE_HEIGHT 20      // Of GUI::Paragraph without a pushed font size
+#define GUI_LAYOUT_CACHE_SIZE   256     // Layouts kept before the ones not drawn this frame are dropped
+#define GUI_AREA_LINE_CACHE     512     // Line layouts a GUI::TextArea keeps before the ones far from the view are dropped
+
 
 
 string color2hex(const SDL_Color& color);
 
+
+
+// TEXT CACHE STATS --------------------------------------------------------------------------------
+struct TextCacheStats{
+    Uint64 hits = 0;            // Texts drawn with an already cached texture
+    Uint64 misses = 0;          // Texts that had to be rendered into a new texture
+    Uint64 evictions = 0;       // Textures dropped to stay within the budget
+    size_t residentBytes = 0;   // Memory held by the cached text textures
+    size_t budget = 0;
+    int entries = 0;
+
+    double hitRate() const { return (hits + misses) ? (double)hits / (hits + misses) : 0; }
+};
+
+
+
 class GUI{
 private:
-    static inline int max_num_of_loaded_textures = 50;
+    static inline int max_num_of_loaded_textures = -1;     // -1 for no limit, only the byte budget
+    static inline int textMode = GUI_TEXT_ATLAS;
 
     struct LoadedText {
         int frame;
         TextureData td;
         SDL_Color color;
         string title;
+        size_t bytes = 0;               // Texture memory of td
+        Uint64 style = 0;               // Size bucket, quality and font, GUI::textStyle
+        Uint64 key = 0;                 // Key in loadedTexts
+        list<Uint64>::iterator lru;     // Position in textLru
 
         LoadedText(
             int frame = 0,
@@ -39,67 +80,218 @@ private:
             td(td),
             color(color),
             title(title) {}
-        
-        string getId(){ return title + color2hex(this->color); }
 
         // Comparator: sort by value
         bool operator<(const LoadedText& other) const { return frame < other.frame; }
         bool operator>(const LoadedText& other) const { return frame > other.frame; }
     };
 
-    static inline unordered_map<string, LoadedText> loadedTexts;
-    static LoadedText* loadNewText(const string& title, const SDL_Color& color);
+    // Text textures of GUI_TEXT_TEXTURES, kept within a byte budget
+    static inline FlatMap<LoadedText> loadedTexts;  // By GUI::textKey
+    static inline list<Uint64> textLru;             // Keys of loadedTexts, most recently drawn first
+    static inline size_t textBudget = 32 * 1024 * 1024;
+    static inline bool pinTexts = true;             // Texts drawn this frame are never evicted
+    static inline TextCacheStats textStats;
+
+    static Uint64 textStyle(int height, int quality, int font);
+    static Uint64 textKey(string_view title, const SDL_Color& color, Uint64 style);
+    static LoadedText* getText(string_view title, const SDL_Color& color, int height, int quality, int font);
+    static LoadedText* loadNewText(string_view title, const SDL_Color& color, int height, int quality, int font);
+    static void removeText(LoadedText* text);
     static void removeOldest();
+    static void evictTexts(size_t incoming);
+
+
+    // Wrapped paragraph, laid out once and reused while its text, font and width stay the same
+    struct CachedLayout {
+        string text;
+        int height = 0;
+        int font = 0;
+        int width = 0;
+        int frame = 0;
+        TextLayout layout;
+    };
+
+    static inline FlatMap<CachedLayout> layouts;        // By text, height, font and width
+    static inline vector<Uint64> staleLayouts;          // Reused by GUI::pruneLayouts
+
+    static void pruneLayouts();
+
+
+    // Keys held by the focused input and the one of them that repeats
+    struct KeyRepeat {
+        Uint32 held = 0;        // Bit per key of the list passed to GUI::keyRepeats
+        SDL_Keycode key = 0;    // Held key that repeats
+        Uint64 at = 0;          // Ticks of its next repeat
+    };
+
+    static int keyRepeats(KeyRepeat& repeat, const SDL_Keycode* keys, int key);
 
 
+    // A character of an input, with its metrics at the size bucket of the input
+    struct InputGlyph {
+        Uint32 codepoint = 0;
+        int advance = 0;
+        int kerning = 0;        // With the glyph before it
+    };
+
     struct InputState {
         string id; // Holds the uniqueId
-        string value; // Holds the input value
+        string value; // Holds the input value, encoded from glyphs after every edit
         bool focused; // Checks if the keyboard is focused on this field
-        int removed = 0; // Holds how many characters needs to be removed in order for text to be within the bounds
-        bool deleting = false; // Checks if the backspace has been down 
-        TextureData td = TextureData(); // The text texture
-        bool change = true; // Keeps track of if the value has been changed and texture needs to be reCompiled
+        GapBuffer<InputGlyph> glyphs; // The characters, edited at the caret
+        int caret = 0; // Glyph index the caret is before
+        int anchor = 0; // Other end of the selection, same as caret if nothing is selected
+        int scroll = 0; // First visible glyph
+        bool dragging = false; // Selecting with the mouse
+        Uint64 metrics = 0; // Height and font the glyph metrics were measured for
+        KeyRepeat repeat; // Held keys
+        Uint64 editedAt = 0; // Ticks of the last edit or caret move, the caret blinks from it
+        int offsetGlyph = 0; // A glyph and its byte offset in the value, GUI::inputByteOffset walks from it
+        size_t offsetByte = 0;
 
         InputState(
-            const string& id, 
+            const string& id = "", 
             const string& value = "",
             const bool& focused = false
         ): id(id), value(value), focused(focused) {}
     };
 
-    static inline unordered_map<string, InputState> inputStates;
+    static inline FlatMap<InputState> inputStates;      // By widget id, GUI::getID
+    static inline string inputScratch;                  // UTF-8 of the visible glyphs, reused by every input
+
+    static void measureInput(InputState& state, int from, int to, int height, int font);
+    static void insertInput(InputState& state, string_view text, int height, int font);
+    static void eraseInput(InputState& state, int from, int to, int height, int font);
+    static void encodeInput(InputState& state, int from, int to, string& out);
+    static size_t inputByteOffset(InputState& state, int glyph);
+    static int inputCaretAt(const InputState& state, double units, int end);
+
+
+    // Layout of a line of a text area, cached by the line index
+    struct AreaLine {
+        string text;            // Without the newline
+        vector<int> x;          // Pixels from the line start to each byte, and to the end
+    };
+
+    struct TextAreaState {
+        unique_ptr<Rope> text;  // Own allocation, so the rope returned by GUI::TextArea keeps its address
+        bool focused = false;
+        size_t caret = 0;       // Byte offset the caret is before
+        size_t anchor = 0;      // Other end of the selection, same as caret if nothing is selected
+        int preferredX = -1;    // X the caret keeps moving up and down, -1 if it moved otherwise
+        double scrollY = 0;     // Pixels scrolled down, moving towards targetY
+        double targetY = 0;
+        int scrollX = 0;
+        bool dragging = false;
+        bool reveal = false;    // Scroll to the caret
+        Uint64 metrics = 0;     // Height and font the lines were laid out for
+        Uint64 version = 0;     // Version of the text the lines were laid out for
+        KeyRepeat repeat;
+        Uint64 editedAt = 0;
+        FlatMap<AreaLine> lines;
+    };
+
+    static inline FlatMap<TextAreaState> textAreas;     // By widget id, GUI::getID
+    static inline vector<Uint64> staleLines;            // Reused by GUI::TextArea to prune the line layouts
+
+    static const AreaLine& layoutAreaLine(TextAreaState& state, int line, int height, int font);
+    static void editArea(TextAreaState& state, size_t from, size_t to, string_view text);
+    static void dropAreaLines(TextAreaState& state, int from);
+    static size_t areaOffsetAt(TextAreaState& state, int line, int x, int height, int font);
+
+
+    // Retained layer, a block of GUI calls rendered into a texture and
+    // blitted on the next frames until its hash changes or it is invalidated
+    struct Layer {
+        TextureData td;             // Cached content, holds premultiplied alpha
+        SDL_Rect rect = {0, 0, 0, 0};
+        Uint64 hash = 0;            // Hash of the inputs the content was rendered with
+        Uint64 colors = 0;          // Hash of the button colors the content was rendered with
+        bool valid = false;         // Content is up to date
+        bool invalidated = false;   // Invalidated while it was being drawn
+    };
+
+    static inline FlatMap<Layer> layers;                // By widget id, GUI::getID
+    static inline Uint64 activeLayer = 0;               // Id of the layer between beginLayer and endLayer, 0 for none
+    static inline bool layerCached = false;             // Drawing is skipped, the cached content is blitted
+    static inline int layerDepth = 0;
+    static inline Uint64 layerColors = 0;               // Hash of the button colors drawn this frame
+    static inline SDL_Texture* layerPreviousTarget = nullptr;
+
+    static Uint64 layerID(string_view id);
+    static Layer* getActiveLayer();
+    static SDL_Rect toLayer(SDL_Rect rect);
+    static SDL_Point toLayer(SDL_Point point);
+    static void renderInLayer(const TextureData& td, SDL_Rect& dRect);
+    static void renderTextInLayer(string_view text, SDL_Rect& dRect, const SDL_Color& color, int quality, int font);
+
+
+    // Widget id scopes, the top is the seed of the ids hashed inside it
+    static inline Uint64 idStack[GUI_ID_STACK_DEPTH] = {GUI_HASH_SEED};
+    static inline int idDepth = 0;
 
 
     // Pushed styles
     static inline int pFontSize = -1;
+    static inline int pFont = -1;
+    static inline int pTextQuality = -1;
     static inline int pTextAlignY = -1;
     static inline int pTextAlignX = -1; 
     static inline bool pAutoFocus = false;
     static inline bool pInputLock = false;
 
 public:
+    // FNV-1a, constexpr so literal labels can be hashed at compile time
+    static constexpr Uint64 hash(string_view text, Uint64 seed = GUI_HASH_SEED){
+        for(char c : text) seed = (seed ^ (Uint8)c) * GUI_HASH_PRIME;
+        return seed;
+    }
+
+    static constexpr Uint64 combine(Uint64 seed, Uint64 id){
+        for(int i = 0; i < 8; i++) seed = (seed ^ ((id >> (i * 8)) & 0xff)) * GUI_HASH_PRIME;
+        return seed;
+    }
+
+    static void pushID(string_view id);
+    static void pushID(Uint64 id);
+    static void popID();
+    static Uint64 getID(string_view label);
+
     static int Button(
-        const string& title, 
+        string_view title, 
         const SDL_Rect& dRect,
         const SDL_Color& textColor = SDL_COLOR_WHITE,
         const SDL_Color& buttonColor = SDL_COLOR_M_GUN
     );
 
     static void Text(
-        const string& title, 
+        string_view title, 
         SDL_Rect& dRect, 
         const SDL_Color& color = SDL_COLOR_WHITE
     );
 
     static void TextDynamic(
-        const string& title, 
+        string_view title, 
         SDL_Rect& dRect, 
         const SDL_Color& color = SDL_COLOR_WHITE
     );
 
+    static int measureText(string_view text, int height, int fontId = FONT_DEFAULT);
+    static const TextLayout& layoutText(string_view text, int height, int maxWidth, int fontId = FONT_DEFAULT);
+
+    static void Paragraph(
+        string_view text,
+        SDL_Rect& dRect,
+        const SDL_Color& color = SDL_COLOR_WHITE
+    );
+
     static void clearLoadedTexts();
     static void setMaxNumOfLoadedTextures(const int& num);
+    static void setTextCacheBudget(size_t bytes);
+    static void setTextCachePinning(bool pin);
+    static TextCacheStats getTextCacheStats();
+    static void setTextMode(int mode);
     
     static void Rect(
         const SDL_Rect& dRect,
@@ -113,22 +305,48 @@ public:
         const SDL_Color& color
     );
 
+    static void Polyline(
+        const SDL_FPoint* points,
+        int count,
+        const SDL_Color& color = SDL_COLOR_WHITE,
+        float thickness = 1.0f
+    );
+
     static string Input(
-        const string& uniqeId, 
+        string_view uniqeId, 
         const SDL_Rect& dRect,
         const string& placeholder = "Type something...",
         const SDL_Color& background = SDL_COLOR_WHITE,
         const SDL_Color& foreground = SDL_COLOR_BLACK
     );
 
-    static void DestroyInput(const string& uniqueId);
+    static void DestroyInput(string_view uniqueId);
+
+    static Rope& TextArea(
+        string_view uniqueId,
+        const SDL_Rect& dRect,
+        const SDL_Color& background = SDL_COLOR_WHITE,
+        const SDL_Color& foreground = SDL_COLOR_BLACK
+    );
+
+    static void DestroyTextArea(string_view uniqueId);
+
+    static int beginLayer(string_view id, const SDL_Rect& rect, Uint64 hash = 0);
+    static void endLayer();
+    static void invalidateLayer(string_view id);
+    static void freeLayer(string_view id);
 
     static void pushFontSize(const int& fontSize);
+    static void pushFont(const int& fontId);
+    static void pushTextQuality(const int& quality);
     static void pushTextAlignY(const int& direction);
     static void pushTextAlignX(const int& direction);
     static void pushAutoFocus();
     static void pushInputLock();
 };
 
+// Hashes a literal label at compile time, "toolbar"_id == GUI::hash("toolbar")
+constexpr Uint64 operator""_id(const char* text, size_t length){ return GUI::hash(string_view(text, length)); }
+
 #endif
 // Creator: @AndrijaRD
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "./Jobs.h"
+
+
+
+/** Init
+ * 
+ * Starts the worker threads. It is called automaticly on the first
+ * submitted job, so calling it is only needed for custom thread count.
+ * 
+ * @param threads Number of worker threads, 0 for one less then the number of CPU cores
+ */
+void Jobs::init(int threads){
+    lock_guard<mutex> lock(queueMutex);
+    if(!workers.empty()) return;
+
+    if(threads <= 0) threads = max(1, (int)thread::hardware_concurrency() - 1);
+
+    stopping = false;
+    for(int i = 0; i < threads; i++){
+        workers.emplace_back(Jobs::workerLoop);
+    }
+}
+
+
+
+
+/** Shutdown
+ * 
+ * Finishes the already queued jobs and stops the worker threads.
+ * Called by Sys::cleanup.
+ */
+void Jobs::shutdown(){
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCV.notify_all();
+
+    for(auto& worker : workers) worker.join();
+    workers.clear();
+}
+
+
+
+
+/** Worker Loop
+ * 
+ * INTERNAL USE
+ * 
+ * Runs the queued jobs until shutdown.
+ */
+void Jobs::workerLoop(){
+    while(true){
+        function<void()> job;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCV.wait(lock, []{ return stopping || !queue.empty(); });
+
+            if(queue.empty()) return;   // Stopping and nothing left to do
+
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        job();
+    }
+}
+
+
+
+
+/** Submit
+ * 
+ * Queues the job to be run on one of the worker threads.
+ * 
+ * @param job Function to be run
+ */
+void Jobs::submit(function<void()> job){
+    if(workers.empty()) Jobs::init();
+    {
+        lock_guard<mutex> lock(queueMutex);
+        queue.push_back(std::move(job));
+    }
+    queueCV.notify_one();
+}
+
+
+
+
+/** Parallel For
+ * 
+ * Splits [0, count) into chunks and runs fn on them across the worker
+ * threads and the calling thread, returning once all of them are done.
+ * 
+ * @param count Number of items
+ * @param fn Function called for each chunk with its [begin, end) range
+ * @param minChunk Smallest number of items worth giving to a thread
+ */
+void Jobs::parallelFor(int count, const function<void(int begin, int end)>& fn, int minChunk){
+    if(count <= 0) return;
+    if(workers.empty()) Jobs::init();
+
+    int threads = (int)workers.size() + 1;     // Workers and the caller
+    int chunks = min(threads, max(1, count / max(1, minChunk)));
+    if(chunks == 1){
+        fn(0, count);
+        return;
+    }
+
+    // The chunks are picked up from a shared counter, so the calling
+    // thread keeps working instead of just waiting for the workers
+    struct Shared{
+        atomic<int> next{0};
+        atomic<int> done{0};
+        mutex m;
+        condition_variable cv;
+    };
+    auto shared = make_shared<Shared>();
+    int chunkSize = (count + chunks - 1) / chunks;
+
+    auto run = [shared, &fn, count, chunks, chunkSize](){
+        int chunk;
+        while((chunk = shared->next.fetch_add(1)) < chunks){
+            int begin = chunk * chunkSize;
+            int end = min(count, begin + chunkSize);
+            if(begin < end) fn(begin, end);
+
+            if(shared->done.fetch_add(1) + 1 == chunks){
+                lock_guard<mutex> lock(shared->m);
+                shared->cv.notify_all();
+            }
+        }
+    };
+
+    for(int i = 0; i < chunks - 1; i++) Jobs::submit(run);
+    run();
+
+    unique_lock<mutex> lock(shared->m);
+    shared->cv.wait(lock, [&]{ return shared->done.load() == chunks; });
+}
+
+
+
+
+int Jobs::getThreadCount(){ return workers.size(); }
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef MySDL_JOBS
+#define MySDL_JOBS
+
+#include "../lib.h"
+
+
+// A small pool of worker threads used for the CPU heavy work, like
+// image scaling and encoding, so it doesnt stall the main loop.
+// SDL rendering functions must not be called from the jobs.
+class Jobs{
+    private:
+    static inline vector<thread> workers;
+    static inline deque<function<void()>> queue;
+    static inline mutex queueMutex;
+    static inline condition_variable queueCV;
+    static inline bool stopping = false;
+
+    static void workerLoop();
+
+    public:
+    static void init(int threads = 0);
+    static void shutdown();
+
+    static void submit(function<void()> job);
+
+    static void parallelFor(
+        int count,
+        const function<void(int begin, int end)>& fn,
+        int minChunk = 1
+    );
+
+    static int getThreadCount();
+};
+
+#endif
+// Creator: @AndrijaRD
@@ -6,6 +6,18 @@
 #include "Lumos/TextureManager/TM.h"
 #include "Lumos/PqDB/db.h"
 #include "Lumos/Gui/gui.h"
+#include "Lumos/Jobs/Jobs.h"
+#include "Lumos/Pixel/Pixel.h"
+#include "Lumos/Plot/Plot.h"
+#include "Lumos/Qoi/Qoi.h"
+#include "Lumos/Capture/Capture.h"
+#include "Lumos/Particles/Particles.h"
+#include "Lumos/Tilemap/Tilemap.h"
+#include "Lumos/Scene/Scene.h"
+#include "Lumos/Animation/Animation.h"
+#include "Lumos/Raster/Raster.h"
+#include "Lumos/FrameSink/FrameSink.h"
+#include "Lumos/Text/Text.h"
 #include "Lumos/lib.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,529 @@
+#include "./Particles.h"
+#include "../System/Sys.h"
+#include "../Jobs/Jobs.h"
+
+#ifdef LUMOS_X86
+#include <immintrin.h>
+#endif
+
+
+
+// Pointers into the arrays of a batch, for the integration kernels
+struct ParticleArrays{
+    float *x, *y, *vx, *vy;
+    const float *ax, *ay, *drag;
+    float *life, *size;
+    const float *dsize;
+    float *r, *g, *b, *a;
+    const float *dr, *dg, *db, *da;
+};
+
+typedef void (*IntegrateKernel)(const ParticleArrays& p, int begin, int end, float dt);
+
+
+vector<float> ParticleSystem::Batch::* const ParticleSystem::arrays[18] = {
+    &Batch::x,      &Batch::y,
+    &Batch::vx,     &Batch::vy,
+    &Batch::ax,     &Batch::ay,
+    &Batch::drag,   &Batch::life,
+    &Batch::size,   &Batch::dsize,
+    &Batch::r,      &Batch::g,
+    &Batch::b,      &Batch::a,
+    &Batch::dr,     &Batch::dg,
+    &Batch::db,     &Batch::da
+};
+
+// Particle counts from which the work is split across the worker threads
+static const int PARALLEL_INTEGRATE = 16384;
+static const int PARALLEL_VERTICES = 8192;
+
+
+
+// SCALAR KERNEL -----------------------------------------------------------------------------------
+// Also used for the particles left over at the end of the SIMD loops
+
+static void integrateScalar(const ParticleArrays& p, int begin, int end, float dt){
+    for(int i = begin; i < end; i++){
+        float damp = max(0.0f, 1.0f - p.drag[i] * dt);
+        p.vx[i] = (p.vx[i] + p.ax[i] * dt) * damp;
+        p.vy[i] = (p.vy[i] + p.ay[i] * dt) * damp;
+        p.x[i] += p.vx[i] * dt;
+        p.y[i] += p.vy[i] * dt;
+
+        p.life[i] -= dt;
+        p.size[i] += p.dsize[i] * dt;
+
+        p.r[i] += p.dr[i] * dt;
+        p.g[i] += p.dg[i] * dt;
+        p.b[i] += p.db[i] * dt;
+        p.a[i] += p.da[i] * dt;
+    }
+}
+
+
+
+#ifdef LUMOS_X86
+
+// SSE4.1 KERNEL -----------------------------------------------------------------------------------
+
+// v += d * dt, for 4 particles
+__attribute__((target("sse4.1")))
+static inline void stepSSE41(float* v, const float* d, int i, __m128 dt){
+    _mm_storeu_ps(v + i, _mm_add_ps(_mm_loadu_ps(v + i), _mm_mul_ps(_mm_loadu_ps(d + i), dt)));
+}
+
+
+__attribute__((target("sse4.1")))
+static void integrateSSE41(const ParticleArrays& p, int begin, int end, float dt){
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    int i = begin;
+    for(; i + 4 <= end; i += 4){
+        __m128 damp = _mm_max_ps(zero, _mm_sub_ps(one, _mm_mul_ps(_mm_loadu_ps(p.drag + i), vdt)));
+        __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p.vx + i), _mm_mul_ps(_mm_loadu_ps(p.ax + i), vdt)), damp);
+        __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p.vy + i), _mm_mul_ps(_mm_loadu_ps(p.ay + i), vdt)), damp);
+        _mm_storeu_ps(p.vx + i, vx);
+        _mm_storeu_ps(p.vy + i, vy);
+        _mm_storeu_ps(p.x + i, _mm_add_ps(_mm_loadu_ps(p.x + i), _mm_mul_ps(vx, vdt)));
+        _mm_storeu_ps(p.y + i, _mm_add_ps(_mm_loadu_ps(p.y + i), _mm_mul_ps(vy, vdt)));
+
+        _mm_storeu_ps(p.life + i, _mm_sub_ps(_mm_loadu_ps(p.life + i), vdt));
+        stepSSE41(p.size, p.dsize, i, vdt);
+
+        stepSSE41(p.r, p.dr, i, vdt);
+        stepSSE41(p.g, p.dg, i, vdt);
+        stepSSE41(p.b, p.db, i, vdt);
+        stepSSE41(p.a, p.da, i, vdt);
+    }
+    if(i < end) integrateScalar(p, i, end, dt);
+}
+
+
+
+// AVX2 KERNEL -------------------------------------------------------------------------------------
+
+// v += d * dt, for 8 particles
+__attribute__((target("avx2")))
+static inline void stepAVX2(float* v, const float* d, int i, __m256 dt){
+    _mm256_storeu_ps(v + i, _mm256_add_ps(_mm256_loadu_ps(v + i), _mm256_mul_ps(_mm256_loadu_ps(d + i), dt)));
+}
+
+
+__attribute__((target("avx2")))
+static void integrateAVX2(const ParticleArrays& p, int begin, int end, float dt){
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    int i = begin;
+    for(; i + 8 <= end; i += 8){
+        __m256 damp = _mm256_max_ps(zero, _mm256_sub_ps(one, _mm256_mul_ps(_mm256_loadu_ps(p.drag + i), vdt)));
+        __m256 vx = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(p.vx + i), _mm256_mul_ps(_mm256_loadu_ps(p.ax + i), vdt)), damp);
+        __m256 vy = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(p.vy + i), _mm256_mul_ps(_mm256_loadu_ps(p.ay + i), vdt)), damp);
+        _mm256_storeu_ps(p.vx + i, vx);
+        _mm256_storeu_ps(p.vy + i, vy);
+        _mm256_storeu_ps(p.x + i, _mm256_add_ps(_mm256_loadu_ps(p.x + i), _mm256_mul_ps(vx, vdt)));
+        _mm256_storeu_ps(p.y + i, _mm256_add_ps(_mm256_loadu_ps(p.y + i), _mm256_mul_ps(vy, vdt)));
+
+        _mm256_storeu_ps(p.life + i, _mm256_sub_ps(_mm256_loadu_ps(p.life + i), vdt));
+        stepAVX2(p.size, p.dsize, i, vdt);
+
+        stepAVX2(p.r, p.dr, i, vdt);
+        stepAVX2(p.g, p.dg, i, vdt);
+        stepAVX2(p.b, p.db, i, vdt);
+        stepAVX2(p.a, p.da, i, vdt);
+    }
+    if(i < end) integrateSSE41(p, i, end, dt);
+}
+
+#endif
+
+
+
+
+// DISPATCH ----------------------------------------------------------------------------------------
+struct ParticleKernel{
+    IntegrateKernel integrate;
+    const char* name;
+};
+
+
+static ParticleKernel pickKernel(){
+#ifdef LUMOS_X86
+    if(cpuHasAVX2()) return {integrateAVX2, "AVX2"};
+    if(cpuHasSSE41()) return {integrateSSE41, "SSE4.1"};
+#endif
+    return {integrateScalar, "scalar"};
+}
+
+
+static const ParticleKernel& kernel(){
+    static const ParticleKernel picked = pickKernel();
+    return picked;
+}
+
+
+
+
+ParticleSystem::ParticleSystem(int capacity): capacity(capacity) {}
+
+
+
+
+/** Get Kernel Name
+ * 
+ * @return Name of the integration kernel picked for this CPU, "AVX2", "SSE4.1" or "scalar"
+ */
+const char* ParticleSystem::getKernelName(){ return kernel().name; }
+
+
+
+
+/** Add Emitter
+ * 
+ * Adds an emitter, reusing the slot of a removed one if there is any.
+ * 
+ * @param config How the particles are emitted, can be changed later trough getEmitter()
+ * @param td Texture of the particles, they are solid squares without one
+ * @return Id of the emitter
+ */
+int ParticleSystem::addEmitter(const EmitterConfig& config, const TextureData& td){
+    // FIND THE BATCH OF THE TEXTURE --------------------------------------------------------
+    uintptr_t key = td.id != 0 ? td.id : (uintptr_t)td.tex;
+    auto it = batchOf.find(key);
+    int batch;
+    if(it != batchOf.end()){
+        batch = it->second;
+    } else {
+        batch = batches.size();
+        batches.emplace_back();
+        batches.back().td = td;
+        batchOf[key] = batch;
+    }
+
+    // TAKE A POOLED SLOT -------------------------------------------------------------------
+    int id;
+    if(!freeEmitters.empty()){
+        id = freeEmitters.back();
+        freeEmitters.pop_back();
+    } else {
+        id = emitters.size();
+        emitters.emplace_back();
+    }
+
+    Emitter& emitter = emitters[id];
+    emitter.config = config;
+    emitter.batch = batch;
+    emitter.pending = 0;
+    emitter.active = true;
+    return id;
+}
+
+
+
+
+/** Remove Emitter
+ * 
+ * Stops the emitter and returns its slot to the pool,
+ * the already emitted particles live out their life.
+ * 
+ * @param id Id of the emitter
+ */
+void ParticleSystem::removeEmitter(int id){
+    if(id < 0 || id >= (int)emitters.size() || !emitters[id].active) return;
+
+    emitters[id].active = false;
+    freeEmitters.push_back(id);
+}
+
+
+
+
+/** Get Emitter
+ * 
+ * @param id Id of the emitter
+ * @return Config of the emitter to be changed, like its position, or nullptr if there is no such emitter
+ */
+EmitterConfig* ParticleSystem::getEmitter(int id){
+    if(id < 0 || id >= (int)emitters.size() || !emitters[id].active) return nullptr;
+    return &emitters[id].config;
+}
+
+
+
+
+/** Burst
+ * 
+ * Emits the particles right away.
+ * 
+ * @param id Id of the emitter
+ * @param count Number of particles
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int ParticleSystem::burst(int id, int count){
+    if(id < 0 || id >= (int)emitters.size() || !emitters[id].active) return PARTICLE_INVALID_EMITTER;
+
+    emit(emitters[id], count);
+    return NO_ERROR;
+}
+
+
+
+
+/** Random
+ * 
+ * INTERNAL USE
+ * 
+ * @return Random number in [0, 1), xorshift, much cheaper then rand()
+ */
+float ParticleSystem::random(){
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+
+
+
+/** Grow
+ * 
+ * INTERNAL USE
+ * 
+ * Makes room for at least size particles in every array of the batch.
+ */
+void ParticleSystem::grow(Batch& batch, int size){
+    int current = batch.x.size();
+    if(size <= current) return;
+
+    int grown = min(capacity, max(size, max(1024, current * 2)));
+    for(auto array : arrays) (batch.*array).resize(grown);
+}
+
+
+
+
+/** Emit
+ * 
+ * INTERNAL USE
+ * 
+ * Spawns the particles of the emitter, as many as fit within the capacity.
+ */
+void ParticleSystem::emit(Emitter& emitter, int count){
+    count = min(count, capacity - alive);
+    if(count <= 0) return;
+
+    const EmitterConfig& c = emitter.config;
+    Batch& batch = batches[emitter.batch];
+    grow(batch, batch.count + count);
+
+    for(int n = 0; n < count; n++){
+        int i = batch.count++;
+
+        float angle = c.angle + c.spread * (random() * 2 - 1);
+        float speed = c.speedMin + (c.speedMax - c.speedMin) * random();
+        float life = max(0.001f, c.lifeMin + (c.lifeMax - c.lifeMin) * random());
+
+        batch.x[i] = c.position.x;
+        batch.y[i] = c.position.y;
+        batch.vx[i] = cosf(angle) * speed;
+        batch.vy[i] = sinf(angle) * speed;
+        batch.ax[i] = c.gravity.x;
+        batch.ay[i] = c.gravity.y;
+        batch.drag[i] = c.drag;
+        batch.life[i] = life;
+
+        // Start values and their change per second, reaching the end values at the death
+        batch.size[i] = c.sizeStart;
+        batch.dsize[i] = (c.sizeEnd - c.sizeStart) / life;
+        batch.r[i] = c.colorStart.r;
+        batch.g[i] = c.colorStart.g;
+        batch.b[i] = c.colorStart.b;
+        batch.a[i] = c.colorStart.a;
+        batch.dr[i] = (c.colorEnd.r - c.colorStart.r) / life;
+        batch.dg[i] = (c.colorEnd.g - c.colorStart.g) / life;
+        batch.db[i] = (c.colorEnd.b - c.colorStart.b) / life;
+        batch.da[i] = (c.colorEnd.a - c.colorStart.a) / life;
+    }
+
+    alive += count;
+}
+
+
+
+
+/** Kill
+ * 
+ * INTERNAL USE
+ * 
+ * Removes the particle by moving the last one into its place.
+ */
+void ParticleSystem::kill(Batch& batch, int i){
+    int last = --batch.count;
+    if(i != last){
+        for(auto array : arrays) (batch.*array)[i] = (batch.*array)[last];
+    }
+    alive--;
+}
+
+
+
+
+/** Update
+ * 
+ * Emits the new particles, moves all of them and removes the dead ones.
+ * 
+ * @param dt Time since the last update in seconds
+ */
+void ParticleSystem::update(float dt){
+    if(dt <= 0) return;
+
+    // EMIT ---------------------------------------------------------------------------------
+    // Starting from another emitter every update, so at the capacity
+    // the first emitters dont take every freed slot
+    int emitterCount = emitters.size();
+    firstEmitter = emitterCount > 0 ? (firstEmitter + 1) % emitterCount : 0;
+    for(int n = 0; n < emitterCount; n++){
+        Emitter& emitter = emitters[(firstEmitter + n) % emitterCount];
+        if(!emitter.active || emitter.config.rate <= 0) continue;
+
+        emitter.pending += emitter.config.rate * dt;
+        int count = (int)emitter.pending;
+        emitter.pending -= count;
+        emit(emitter, count);
+    }
+
+    // INTEGRATE ----------------------------------------------------------------------------
+    IntegrateKernel integrate = kernel().integrate;
+    for(Batch& batch : batches){
+        if(batch.count == 0) continue;
+
+        ParticleArrays p = {
+            batch.x.data(), batch.y.data(), batch.vx.data(), batch.vy.data(),
+            batch.ax.data(), batch.ay.data(), batch.drag.data(),
+            batch.life.data(), batch.size.data(), batch.dsize.data(),
+            batch.r.data(), batch.g.data(), batch.b.data(), batch.a.data(),
+            batch.dr.data(), batch.dg.data(), batch.db.data(), batch.da.data()
+        };
+
+        if(batch.count >= PARALLEL_INTEGRATE){
+            Jobs::parallelFor(batch.count, [&](int begin, int end){ integrate(p, begin, end, dt); }, PARALLEL_INTEGRATE / 2);
+        } else {
+            integrate(p, 0, batch.count, dt);
+        }
+
+        // REMOVE THE DEAD ONES -------------------------------------------------------------
+        for(int i = 0; i < batch.count;){
+            if(batch.life[i] <= 0) kill(batch, i);
+            else i++;
+        }
+    }
+}
+
+
+
+
+/** Build Vertices
+ * 
+ * INTERNAL USE
+ * 
+ * Turns the particles [begin, end) into quads, 4 vertices each.
+ * 
+ * @param uv Top left and bottom right texture coordinates
+ */
+void ParticleSystem::buildVertices(Batch& batch, int begin, int end, const SDL_FPoint uv[2]){
+    auto channel = [](float value){ return (Uint8)min(255.0f, max(0.0f, value)); };
+
+    for(int i = begin; i < end; i++){
+        float half = max(0.0f, batch.size[i]) / 2;
+        float x = batch.x[i], y = batch.y[i];
+        SDL_Color color = {channel(batch.r[i]), channel(batch.g[i]), channel(batch.b[i]), channel(batch.a[i])};
+
+        SDL_Vertex* v = &batch.vertices[(size_t)i * 4];
+        v[0] = {{x - half, y - half}, color, {uv[0].x, uv[0].y}};
+        v[1] = {{x + half, y - half}, color, {uv[1].x, uv[0].y}};
+        v[2] = {{x + half, y + half}, color, {uv[1].x, uv[1].y}};
+        v[3] = {{x - half, y + half}, color, {uv[0].x, uv[1].y}};
+    }
+}
+
+
+
+
+/** Render
+ * 
+ * Draws the particles, with one SDL_RenderGeometry call per texture.
+ * 
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int ParticleSystem::render(){
+    submissions = 0;
+    int error = NO_ERROR;
+
+    // SHARED QUAD INDICES ------------------------------------------------------------------
+    int largest = 0;
+    for(const Batch& batch : batches) largest = max(largest, batch.count);
+
+    const int quad[6] = {0, 1, 2, 0, 2, 3};
+    for(int q = indices.size() / 6; q < largest; q++){
+        for(int k : quad) indices.push_back(q * 4 + k);
+    }
+
+    for(Batch& batch : batches){
+        if(batch.count == 0) continue;
+
+        // TEXTURE COORDINATES OF THE IMAGE PART --------------------------------------------
+        SDL_Texture* tex = nullptr;
+        SDL_FPoint uv[2] = {{0, 0}, {1, 1}};
+
+        if(batch.td.id != 0 || batch.td.tex != nullptr){
+            tex = TM::resolve(batch.td);
+            int texWidth, texHeight;
+            if(tex == nullptr || SDL_QueryTexture(tex, NULL, NULL, &texWidth, &texHeight)){
+                error = TM_GOT_NULLPTR_TEX;
+                continue;
+            }
+
+            if(batch.td.srcRect()){
+                const SDL_Rect& src = batch.td.src;
+                uv[0] = {(float)src.x / texWidth, (float)src.y / texHeight};
+                uv[1] = {(float)(src.x + src.w) / texWidth, (float)(src.y + src.h) / texHeight};
+            }
+        }
+
+        // VERTICES -------------------------------------------------------------------------
+        batch.vertices.resize((size_t)batch.count * 4);
+        if(batch.count >= PARALLEL_VERTICES){
+            Jobs::parallelFor(batch.count, [&](int begin, int end){ buildVertices(batch, begin, end, uv); }, PARALLEL_VERTICES / 2);
+        } else {
+            buildVertices(batch, 0, batch.count, uv);
+        }
+
+        int err = SDL_RenderGeometry(
+            Sys::renderer,
+            tex,
+            batch.vertices.data(),
+            batch.count * 4,
+            indices.data(),
+            batch.count * 6
+        );
+        submissions++;
+        if(err != 0) error = PARTICLE_RENDER_GEOMETRY_FAILED;
+    }
+
+    return error;
+}
+
+
+
+
+/** Clear
+ * 
+ * Removes all the particles, the emitters stay.
+ */
+void ParticleSystem::clear(){
+    for(Batch& batch : batches) batch.count = 0;
+    alive = 0;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#ifndef MySDL_PARTICLES
+#define MySDL_PARTICLES
+
+#include "../lib.h"
+#include "../TextureManager/TM.h"
+
+
+// EMITTER CONFIG ----------------------------------------------------------------------------------
+// Particles fly out of the position in the direction of the angle, spread
+// to both sides. Size and color change linearly from start to end over
+// the life of each particle. Angles are in radians, 0 points to the right.
+struct EmitterConfig{
+    SDL_FPoint position = {0, 0};
+    float rate = 100;                   // Particles emitted per second, 0 for bursts only
+
+    float angle = -M_PI / 2;            // Up
+    float spread = M_PI / 8;
+    float speedMin = 50;                // Pixels per second
+    float speedMax = 150;
+    float lifeMin = 1;                  // Seconds
+    float lifeMax = 2;
+
+    float sizeStart = 8;                // Pixels
+    float sizeEnd = 0;
+    SDL_Color colorStart = SDL_COLOR_WHITE;
+    SDL_Color colorEnd = {255, 255, 255, 0};
+
+    SDL_FPoint gravity = {0, 0};        // Pixels per second squared
+    float drag = 0;                     // Fraction of the velocity lost per second
+};
+
+
+
+// PARTICLE SYSTEM ---------------------------------------------------------------------------------
+// Particles are kept in structure of arrays buffers, one set per texture,
+// and integrated with AVX2/SSE kernels picked at runtime, across the worker
+// threads for large counts. Color and size are integrated too, as a rate of
+// change, so the render only turns them into vertices. Every texture is
+// drawn with a single SDL_RenderGeometry call, whatever the particle count.
+//
+// Emitters are pooled, removed emitters free their slot right away while
+// their particles live on.
+class ParticleSystem{
+    public:
+    ParticleSystem(int capacity = 65536);
+
+    int addEmitter(const EmitterConfig& config, const TextureData& td = TextureData());
+    void removeEmitter(int id);
+    EmitterConfig* getEmitter(int id);
+    int burst(int id, int count);
+
+    void update(float dt);
+    int render();
+    void clear();
+
+    int getAliveCount() const { return alive; }
+    int getSubmissions() const { return submissions; }
+    static const char* getKernelName();
+
+    private:
+    // Particles using one texture, every array holds `count` particles
+    struct Batch{
+        TextureData td;                 // Not owned, it must outlive the particles
+        int count = 0;
+
+        vector<float> x, y, vx, vy;     // Position and velocity
+        vector<float> ax, ay, drag;     // Gravity and drag of the emitter
+        vector<float> life;             // Seconds left
+        vector<float> size, dsize;      // Size and its change per second
+        vector<float> r, g, b, a;       // Color in 0-255
+        vector<float> dr, dg, db, da;   // Change of the color per second
+
+        vector<SDL_Vertex> vertices;
+    };
+
+    // Every array of a batch, so growing and removing particles cant miss one
+    static vector<float> Batch::* const arrays[18];
+
+    struct Emitter{
+        EmitterConfig config;
+        int batch = -1;
+        float pending = 0;              // Fraction of a particle left to be emitted
+        bool active = false;
+    };
+
+    int capacity;
+    int alive = 0;
+    int submissions = 0;                // SDL_RenderGeometry calls made by the last render
+    Uint32 seed = 0x9e3779b9;
+    int firstEmitter = 0;                       // Emitter the emission starts from, rotated every update
+
+    vector<Batch> batches;
+    unordered_map<uintptr_t, int> batchOf;      // Texture -> batch index
+
+    vector<Emitter> emitters;
+    vector<int> freeEmitters;                   // Pooled emitter slots
+
+    vector<int> indices;                        // Shared quad indices, 6 per particle
+
+    float random();
+    void emit(Emitter& emitter, int count);
+    void grow(Batch& batch, int size);
+    void kill(Batch& batch, int i);
+    void buildVertices(Batch& batch, int begin, int end, const SDL_FPoint uv[2]);
+};
+
+#endif
+// Creator: @AndrijaRD
@@ -0,0 +1,722 @@
+#include "./Pixel.h"
+#include "../Jobs/Jobs.h"
+
+#ifdef LUMOS_X86
+#include <immintrin.h>
+#endif
+
+
+
+typedef void (*Kernel)(const Uint8* src, Uint8* dst, int count);
+typedef void (*TintKernel)(const Uint8* src, Uint8* dst, int count, const Uint8* color);
+typedef void (*FillKernel)(Uint8* dst, int count, const Uint8* color);
+
+
+// SCALAR KERNELS ----------------------------------------------------------------------------------
+// Also used for the pixels left over at the end of the SIMD loops
+
+// Exact round(a * b / 255) for a, b in [0, 255]
+static inline Uint8 mulDiv255(int a, int b){
+    int t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+
+static void rgb24Scalar(const Uint8* src, Uint8* dst, int count){
+    for(int i = 0; i < count; i++, src += 3, dst += 4){
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = 255;
+    }
+}
+
+
+static void bgra32Scalar(const Uint8* src, Uint8* dst, int count){
+    for(int i = 0; i < count; i++, src += 4, dst += 4){
+        Uint8 b = src[0], g = src[1], r = src[2], a = src[3];
+        dst[0] = r; dst[1] = g; dst[2] = b; dst[3] = a;
+    }
+}
+
+
+static void argb32Scalar(const Uint8* src, Uint8* dst, int count){
+    for(int i = 0; i < count; i++, src += 4, dst += 4){
+        Uint8 a = src[0], r = src[1], g = src[2], b = src[3];
+        dst[0] = r; dst[1] = g; dst[2] = b; dst[3] = a;
+    }
+}
+
+
+static void grayScalar(const Uint8* src, Uint8* dst, int count){
+    for(int i = 0; i < count; i++, src++, dst += 4){
+        dst[0] = dst[1] = dst[2] = *src;
+        dst[3] = 255;
+    }
+}
+
+
+static void premultiplyScalar(const Uint8* src, Uint8* dst, int count){
+    for(int i = 0; i < count; i++, src += 4, dst += 4){
+        int a = src[3];
+        dst[0] = mulDiv255(src[0], a);
+        dst[1] = mulDiv255(src[1], a);
+        dst[2] = mulDiv255(src[2], a);
+        dst[3] = a;
+    }
+}
+
+
+// Same float math as the SIMD kernels, so every CPU gives the same result
+static void unpremultiplyScalar(const Uint8* src, Uint8* dst, int count){
+    for(int i = 0; i < count; i++, src += 4, dst += 4){
+        int a = src[3];
+        float scale = a ? 255.0f / a : 0.0f;
+        for(int c = 0; c < 3; c++){
+            dst[c] = (Uint8)min(255.0f, nearbyintf(src[c] * scale));
+        }
+        dst[3] = a;
+    }
+}
+
+
+static void tintScalar(const Uint8* src, Uint8* dst, int count, const Uint8* color){
+    for(int i = 0; i < count; i++, src += 4, dst += 4){
+        for(int c = 0; c < 4; c++) dst[c] = mulDiv255(src[c], color[c]);
+    }
+}
+
+
+// Premultiplied source over: dst = src + dst * (255 - src alpha) / 255
+static void blendScalar(const Uint8* src, Uint8* dst, int count){
+    for(int i = 0; i < count; i++, src += 4, dst += 4){
+        int inv = 255 - src[3];
+        for(int c = 0; c < 4; c++) dst[c] = min(255, src[c] + mulDiv255(dst[c], inv));
+    }
+}
+
+
+static void fillScalar(Uint8* dst, int count, const Uint8* color){
+    int inv = 255 - color[3];
+    for(int i = 0; i < count; i++, dst += 4){
+        for(int c = 0; c < 4; c++) dst[c] = min(255, color[c] + mulDiv255(dst[c], inv));
+    }
+}
+
+
+
+
+#ifdef LUMOS_X86
+
+// SSE4.1 KERNELS ----------------------------------------------------------------------------------
+
+// round(x * y / 255) on 16 bit lanes
+__attribute__((target("sse4.1")))
+static inline __m128i mulDiv255SSE(__m128i x, __m128i y){
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+
+__attribute__((target("sse4.1")))
+static void swizzleSSE41(const Uint8* src, Uint8* dst, int count, __m128i mask, Kernel tail){
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128i px = _mm_loadu_si128((const __m128i*)(src + i*4));
+        _mm_storeu_si128((__m128i*)(dst + i*4), _mm_shuffle_epi8(px, mask));
+    }
+    if(i < count) tail(src + i*4, dst + i*4, count - i);
+}
+
+
+__attribute__((target("sse4.1")))
+static void bgra32SSE41(const Uint8* src, Uint8* dst, int count){
+    swizzleSSE41(src, dst, count, _mm_setr_epi8(2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15), bgra32Scalar);
+}
+
+
+__attribute__((target("sse4.1")))
+static void argb32SSE41(const Uint8* src, Uint8* dst, int count){
+    swizzleSSE41(src, dst, count, _mm_setr_epi8(1,2,3,0, 5,6,7,4, 9,10,11,8, 13,14,15,12), argb32Scalar);
+}
+
+
+__attribute__((target("sse4.1")))
+static void rgb24SSE41(const Uint8* src, Uint8* dst, int count){
+    const __m128i mask = _mm_setr_epi8(0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1);
+    const __m128i alpha = _mm_set1_epi32(0xFF000000);
+
+    // 16 bytes are loaded for 4 pixels, so stop while there are still 16 readable
+    int i = 0;
+    for(; i + 6 <= count; i += 4){
+        __m128i px = _mm_loadu_si128((const __m128i*)(src + i*3));
+        _mm_storeu_si128((__m128i*)(dst + i*4), _mm_or_si128(_mm_shuffle_epi8(px, mask), alpha));
+    }
+    if(i < count) rgb24Scalar(src + i*3, dst + i*4, count - i);
+}
+
+
+__attribute__((target("sse4.1")))
+static void graySSE41(const Uint8* src, Uint8* dst, int count){
+    const __m128i spread = _mm_set1_epi32(0x010101);
+    const __m128i alpha = _mm_set1_epi32(0xFF000000);
+
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        int gray;
+        memcpy(&gray, src + i, 4);
+        __m128i v = _mm_mullo_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(gray)), spread);
+        _mm_storeu_si128((__m128i*)(dst + i*4), _mm_or_si128(v, alpha));
+    }
+    if(i < count) grayScalar(src + i, dst + i*4, count - i);
+}
+
+
+// Multiplies the 4 pixels by the 16 bit factors picked by the shuffle mask, or'ed with keep
+__attribute__((target("sse4.1")))
+static inline __m128i multiplySSE41(__m128i px, __m128i mask, __m128i keep){
+    __m128i lo = _mm_cvtepu8_epi16(px);
+    __m128i hi = _mm_unpackhi_epi8(px, _mm_setzero_si128());
+
+    __m128i flo = _mm_or_si128(_mm_shuffle_epi8(lo, mask), keep);
+    __m128i fhi = _mm_or_si128(_mm_shuffle_epi8(hi, mask), keep);
+
+    return _mm_packus_epi16(mulDiv255SSE(lo, flo), mulDiv255SSE(hi, fhi));
+}
+
+
+__attribute__((target("sse4.1")))
+static void premultiplySSE41(const Uint8* src, Uint8* dst, int count){
+    // Color channels get multiplied by alpha, alpha by 255 so it stays the same
+    const __m128i mask = _mm_setr_epi8(6,7,6,7,6,7,-1,-1, 14,15,14,15,14,15,-1,-1);
+    const __m128i keep = _mm_setr_epi16(0,0,0,255, 0,0,0,255);
+
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128i px = _mm_loadu_si128((const __m128i*)(src + i*4));
+        _mm_storeu_si128((__m128i*)(dst + i*4), multiplySSE41(px, mask, keep));
+    }
+    if(i < count) premultiplyScalar(src + i*4, dst + i*4, count - i);
+}
+
+
+__attribute__((target("sse4.1")))
+static void tintSSE41(const Uint8* src, Uint8* dst, int count, const Uint8* color){
+    const __m128i mask = _mm_set1_epi8(-1);     // Nothing from the pixel, only the color
+    const __m128i keep = _mm_setr_epi16(color[0], color[1], color[2], color[3], color[0], color[1], color[2], color[3]);
+
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128i px = _mm_loadu_si128((const __m128i*)(src + i*4));
+        _mm_storeu_si128((__m128i*)(dst + i*4), multiplySSE41(px, mask, keep));
+    }
+    if(i < count) tintScalar(src + i*4, dst + i*4, count - i, color);
+}
+
+
+// Unpremultiplies one pixel held as 4 int32 lanes
+__attribute__((target("sse4.1")))
+static inline __m128i unpremultiplyPixelSSE41(__m128i v){
+    __m128 f = _mm_cvtepi32_ps(v);
+    __m128 alpha = _mm_shuffle_ps(f, f, 0xFF);
+
+    __m128 scale = _mm_div_ps(_mm_set1_ps(255.0f), alpha);
+    scale = _mm_and_ps(scale, _mm_cmpgt_ps(alpha, _mm_setzero_ps()));  // 0 for transparent pixels
+    scale = _mm_blend_ps(scale, _mm_set1_ps(1.0f), 0x8);                 // Alpha stays the same
+
+    return _mm_cvtps_epi32(_mm_min_ps(_mm_mul_ps(f, scale), _mm_set1_ps(255.0f)));
+}
+
+
+__attribute__((target("sse4.1")))
+static void unpremultiplySSE41(const Uint8* src, Uint8* dst, int count){
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128i px = _mm_loadu_si128((const __m128i*)(src + i*4));
+
+        __m128i p0 = unpremultiplyPixelSSE41(_mm_cvtepu8_epi32(px));
+        __m128i p1 = unpremultiplyPixelSSE41(_mm_cvtepu8_epi32(_mm_srli_si128(px, 4)));
+        __m128i p2 = unpremultiplyPixelSSE41(_mm_cvtepu8_epi32(_mm_srli_si128(px, 8)));
+        __m128i p3 = unpremultiplyPixelSSE41(_mm_cvtepu8_epi32(_mm_srli_si128(px, 12)));
+
+        __m128i packed = _mm_packus_epi16(_mm_packus_epi32(p0, p1), _mm_packus_epi32(p2, p3));
+        _mm_storeu_si128((__m128i*)(dst + i*4), packed);
+    }
+    if(i < count) unpremultiplyScalar(src + i*4, dst + i*4, count - i);
+}
+
+
+
+
+__attribute__((target("sse4.1")))
+static void blendSSE41(const Uint8* src, Uint8* dst, int count){
+    const __m128i alpha = _mm_setr_epi8(3,3,3,3, 7,7,7,7, 11,11,11,11, 15,15,15,15);
+    const __m128i zero = _mm_setzero_si128(), ones = _mm_set1_epi8(-1);
+
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i*4));
+        if(_mm_testz_si128(s, s)) continue;     // Fully transparent, nothing to do
+
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i*4));
+        __m128i inv = _mm_xor_si128(_mm_shuffle_epi8(s, alpha), ones);
+
+        __m128i lo = mulDiv255SSE(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(inv, zero));
+        __m128i hi = mulDiv255SSE(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(inv, zero));
+        _mm_storeu_si128((__m128i*)(dst + i*4), _mm_adds_epu8(s, _mm_packus_epi16(lo, hi)));
+    }
+    if(i < count) blendScalar(src + i*4, dst + i*4, count - i);
+}
+
+
+__attribute__((target("sse4.1")))
+static void fillSSE41(Uint8* dst, int count, const Uint8* color){
+    Uint32 packed;
+    memcpy(&packed, color, 4);
+    const __m128i s = _mm_set1_epi32(packed);
+    const __m128i inv = _mm_set1_epi16(255 - color[3]);
+    const __m128i zero = _mm_setzero_si128();
+    bool opaque = color[3] == 255;
+
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128i* p = (__m128i*)(dst + i*4);
+        if(opaque){
+            _mm_storeu_si128(p, s);
+            continue;
+        }
+
+        __m128i d = _mm_loadu_si128(p);
+        __m128i lo = mulDiv255SSE(_mm_unpacklo_epi8(d, zero), inv);
+        __m128i hi = mulDiv255SSE(_mm_unpackhi_epi8(d, zero), inv);
+        _mm_storeu_si128(p, _mm_adds_epu8(s, _mm_packus_epi16(lo, hi)));
+    }
+    if(i < count) fillScalar(dst + i*4, count - i, color);
+}
+
+
+
+
+// AVX2 KERNELS ------------------------------------------------------------------------------------
+// 8 pixels per iteration, the rest is left to the SSE4.1 kernels
+
+__attribute__((target("avx2")))
+static inline __m256i mulDiv255AVX2(__m256i x, __m256i y){
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, y), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+
+__attribute__((target("avx2")))
+static void swizzleAVX2(const Uint8* src, Uint8* dst, int count, __m256i mask, Kernel tail){
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256i px = _mm256_loadu_si256((const __m256i*)(src + i*4));
+        _mm256_storeu_si256((__m256i*)(dst + i*4), _mm256_shuffle_epi8(px, mask));
+    }
+    if(i < count) tail(src + i*4, dst + i*4, count - i);
+}
+
+
+__attribute__((target("avx2")))
+static void bgra32AVX2(const Uint8* src, Uint8* dst, int count){
+    swizzleAVX2(src, dst, count, _mm256_setr_epi8(
+        2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15,
+        2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15
+    ), bgra32SSE41);
+}
+
+
+__attribute__((target("avx2")))
+static void argb32AVX2(const Uint8* src, Uint8* dst, int count){
+    swizzleAVX2(src, dst, count, _mm256_setr_epi8(
+        1,2,3,0, 5,6,7,4, 9,10,11,8, 13,14,15,12,
+        1,2,3,0, 5,6,7,4, 9,10,11,8, 13,14,15,12
+    ), argb32SSE41);
+}
+
+
+__attribute__((target("avx2")))
+static void rgb24AVX2(const Uint8* src, Uint8* dst, int count){
+    const __m256i mask = _mm256_setr_epi8(
+        0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1,
+        0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1
+    );
+    const __m256i alpha = _mm256_set1_epi32(0xFF000000);
+
+    // Each lane gets 4 pixels out of its own 16 byte load
+    int i = 0;
+    for(; i + 10 <= count; i += 8){
+        __m128i lo = _mm_loadu_si128((const __m128i*)(src + i*3));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(src + i*3 + 12));
+        __m256i px = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+        _mm256_storeu_si256((__m256i*)(dst + i*4), _mm256_or_si256(_mm256_shuffle_epi8(px, mask), alpha));
+    }
+    if(i < count) rgb24SSE41(src + i*3, dst + i*4, count - i);
+}
+
+
+__attribute__((target("avx2")))
+static void grayAVX2(const Uint8* src, Uint8* dst, int count){
+    const __m256i spread = _mm256_set1_epi32(0x010101);
+    const __m256i alpha = _mm256_set1_epi32(0xFF000000);
+
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+        v = _mm256_or_si256(_mm256_mullo_epi32(v, spread), alpha);
+        _mm256_storeu_si256((__m256i*)(dst + i*4), v);
+    }
+    if(i < count) graySSE41(src + i, dst + i*4, count - i);
+}
+
+
+__attribute__((target("avx2")))
+static inline __m256i multiplyAVX2(__m256i px, __m256i mask, __m256i keep){
+    __m256i lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(px));       // Pixels 0-3
+    __m256i hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(px, 1));  // Pixels 4-7
+
+    __m256i flo = _mm256_or_si256(_mm256_shuffle_epi8(lo, mask), keep);
+    __m256i fhi = _mm256_or_si256(_mm256_shuffle_epi8(hi, mask), keep);
+
+    // Packing works per lane, which leaves the pixel pairs as 0-1, 4-5, 2-3, 6-7
+    __m256i packed = _mm256_packus_epi16(mulDiv255AVX2(lo, flo), mulDiv255AVX2(hi, fhi));
+    return _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+
+__attribute__((target("avx2")))
+static void premultiplyAVX2(const Uint8* src, Uint8* dst, int count){
+    const __m256i mask = _mm256_setr_epi8(
+        6,7,6,7,6,7,-1,-1, 14,15,14,15,14,15,-1,-1,
+        6,7,6,7,6,7,-1,-1, 14,15,14,15,14,15,-1,-1
+    );
+    const __m256i keep = _mm256_setr_epi16(0,0,0,255, 0,0,0,255, 0,0,0,255, 0,0,0,255);
+
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256i px = _mm256_loadu_si256((const __m256i*)(src + i*4));
+        _mm256_storeu_si256((__m256i*)(dst + i*4), multiplyAVX2(px, mask, keep));
+    }
+    if(i < count) premultiplySSE41(src + i*4, dst + i*4, count - i);
+}
+
+
+__attribute__((target("avx2")))
+static void tintAVX2(const Uint8* src, Uint8* dst, int count, const Uint8* color){
+    const __m256i mask = _mm256_set1_epi8(-1);
+    const __m256i keep = _mm256_setr_epi16(
+        color[0], color[1], color[2], color[3], color[0], color[1], color[2], color[3],
+        color[0], color[1], color[2], color[3], color[0], color[1], color[2], color[3]
+    );
+
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256i px = _mm256_loadu_si256((const __m256i*)(src + i*4));
+        _mm256_storeu_si256((__m256i*)(dst + i*4), multiplyAVX2(px, mask, keep));
+    }
+    if(i < count) tintSSE41(src + i*4, dst + i*4, count - i, color);
+}
+
+
+// Unpremultiplies two pixels held as 8 int32 lanes
+__attribute__((target("avx2")))
+static inline __m256i unpremultiplyPairAVX2(__m256i v){
+    __m256 f = _mm256_cvtepi32_ps(v);
+    __m256 alpha = _mm256_shuffle_ps(f, f, 0xFF);
+
+    __m256 scale = _mm256_div_ps(_mm256_set1_ps(255.0f), alpha);
+    scale = _mm256_and_ps(scale, _mm256_cmp_ps(alpha, _mm256_setzero_ps(), _CMP_GT_OQ));
+    scale = _mm256_blend_ps(scale, _mm256_set1_ps(1.0f), 0x88);
+
+    return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_mul_ps(f, scale), _mm256_set1_ps(255.0f)));
+}
+
+
+__attribute__((target("avx2")))
+static void unpremultiplyAVX2(const Uint8* src, Uint8* dst, int count){
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        const Uint8* p = src + i*4;
+        __m256i p01 = unpremultiplyPairAVX2(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(p))));
+        __m256i p23 = unpremultiplyPairAVX2(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(p + 8))));
+        __m256i p45 = unpremultiplyPairAVX2(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(p + 16))));
+        __m256i p67 = unpremultiplyPairAVX2(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(p + 24))));
+
+        // Per lane packing leaves the pixels as 0, 2, 4, 6, 1, 3, 5, 7
+        __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(p01, p23), _mm256_packus_epi32(p45, p67));
+        _mm256_storeu_si256((__m256i*)(dst + i*4), _mm256_permutevar8x32_epi32(packed, order));
+    }
+    if(i < count) unpremultiplySSE41(src + i*4, dst + i*4, count - i);
+}
+
+__attribute__((target("avx2")))
+static void blendAVX2(const Uint8* src, Uint8* dst, int count){
+    const __m256i alpha = _mm256_setr_epi8(
+        3,3,3,3, 7,7,7,7, 11,11,11,11, 15,15,15,15,
+        3,3,3,3, 7,7,7,7, 11,11,11,11, 15,15,15,15
+    );
+    const __m256i zero = _mm256_setzero_si256(), ones = _mm256_set1_epi8(-1);
+
+    // Unpacking and packing both work per lane, so the pixel order is kept
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i*4));
+        if(_mm256_testz_si256(s, s)) continue;  // Fully transparent, nothing to do
+
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i*4));
+        __m256i inv = _mm256_xor_si256(_mm256_shuffle_epi8(s, alpha), ones);
+
+        __m256i lo = mulDiv255AVX2(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(inv, zero));
+        __m256i hi = mulDiv255AVX2(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(inv, zero));
+        _mm256_storeu_si256((__m256i*)(dst + i*4), _mm256_adds_epu8(s, _mm256_packus_epi16(lo, hi)));
+    }
+    if(i < count) blendSSE41(src + i*4, dst + i*4, count - i);
+}
+
+
+__attribute__((target("avx2")))
+static void fillAVX2(Uint8* dst, int count, const Uint8* color){
+    Uint32 packed;
+    memcpy(&packed, color, 4);
+    const __m256i s = _mm256_set1_epi32(packed);
+    const __m256i inv = _mm256_set1_epi16(255 - color[3]);
+    const __m256i zero = _mm256_setzero_si256();
+    bool opaque = color[3] == 255;
+
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256i* p = (__m256i*)(dst + i*4);
+        if(opaque){
+            _mm256_storeu_si256(p, s);
+            continue;
+        }
+
+        __m256i d = _mm256_loadu_si256(p);
+        __m256i lo = mulDiv255AVX2(_mm256_unpacklo_epi8(d, zero), inv);
+        __m256i hi = mulDiv255AVX2(_mm256_unpackhi_epi8(d, zero), inv);
+        _mm256_storeu_si256(p, _mm256_adds_epu8(s, _mm256_packus_epi16(lo, hi)));
+    }
+    if(i < count) fillSSE41(dst + i*4, count - i, color);
+}
+
+#endif
+
+
+
+
+// DISPATCH ----------------------------------------------------------------------------------------
+struct PixelKernels{
+    Kernel rgb24, bgra32, argb32, gray, premultiply, unpremultiply;
+    TintKernel tint;
+    Kernel blend;
+    FillKernel fill;
+    const char* name;
+};
+
+
+static PixelKernels pickKernels(){
+#ifdef LUMOS_X86
+    if(cpuHasAVX2()){
+        return {rgb24AVX2, bgra32AVX2, argb32AVX2, grayAVX2, premultiplyAVX2, unpremultiplyAVX2, tintAVX2, blendAVX2, fillAVX2, "AVX2"};
+    }
+    if(cpuHasSSE41()){
+        return {rgb24SSE41, bgra32SSE41, argb32SSE41, graySSE41, premultiplySSE41, unpremultiplySSE41, tintSSE41, blendSSE41, fillSSE41, "SSE4.1"};
+    }
+#endif
+    return {rgb24Scalar, bgra32Scalar, argb32Scalar, grayScalar, premultiplyScalar, unpremultiplyScalar, tintScalar, blendScalar, fillScalar, "scalar"};
+}
+
+
+static const PixelKernels& kernels(){
+    static const PixelKernels picked = pickKernels();
+    return picked;
+}
+
+
+
+
+/** RGB24 To RGBA32
+ *
+ * Expands 3 byte RGB pixels into opaque RGBA32 pixels.
+ * src and dst must not overlap.
+ *
+ * @param src RGB24 pixels
+ * @param dst Output RGBA32 pixels
+ * @param count Number of pixels
+ */
+void Pixel::rgb24ToRGBA32(const Uint8* src, Uint8* dst, int count){ kernels().rgb24(src, dst, count); }
+
+
+/** BGRA32 To RGBA32
+ *
+ * Swaps the red and blue channels.
+ *
+ * @param src BGRA32 pixels
+ * @param dst Output RGBA32 pixels
+ * @param count Number of pixels
+ */
+void Pixel::bgra32ToRGBA32(const Uint8* src, Uint8* dst, int count){ kernels().bgra32(src, dst, count); }
+
+
+/** ARGB32 To RGBA32
+ *
+ * Moves the alpha channel from the first to the last byte.
+ *
+ * @param src ARGB32 pixels
+ * @param dst Output RGBA32 pixels
+ * @param count Number of pixels
+ */
+void Pixel::argb32ToRGBA32(const Uint8* src, Uint8* dst, int count){ kernels().argb32(src, dst, count); }
+
+
+/** Gray To RGBA32
+ *
+ * Expands 8 bit gray pixels into opaque RGBA32 pixels.
+ * src and dst must not overlap.
+ *
+ * @param src 8 bit gray pixels
+ * @param dst Output RGBA32 pixels
+ * @param count Number of pixels
+ */
+void Pixel::grayToRGBA32(const Uint8* src, Uint8* dst, int count){ kernels().gray(src, dst, count); }
+
+
+
+
+/** Premultiply
+ *
+ * Multiplies the color channels of RGBA32 pixels by their alpha.
+ * Premultiplied textures are rendered with TM::getPremultipliedBlendMode.
+ *
+ * @param src Straight alpha RGBA32 pixels
+ * @param dst Output premultiplied RGBA32 pixels
+ * @param count Number of pixels
+ */
+void Pixel::premultiply(const Uint8* src, Uint8* dst, int count){ kernels().premultiply(src, dst, count); }
+
+
+/** Unpremultiply
+ *
+ * Divides the color channels of premultiplied RGBA32 pixels by their alpha.
+ * Fully transparent pixels become transparent black.
+ *
+ * @param src Premultiplied RGBA32 pixels
+ * @param dst Output straight alpha RGBA32 pixels
+ * @param count Number of pixels
+ */
+void Pixel::unpremultiply(const Uint8* src, Uint8* dst, int count){ kernels().unpremultiply(src, dst, count); }
+
+
+/** Tint
+ *
+ * Multiplies every channel of RGBA32 pixels by the color,
+ * the same thing SDL_SetTextureColorMod does when rendering.
+ *
+ * @param src RGBA32 pixels
+ * @param dst Output RGBA32 pixels
+ * @param count Number of pixels
+ * @param color The tint, white leaves the pixels unchanged
+ */
+void Pixel::tint(const Uint8* src, Uint8* dst, int count, const SDL_Color& color){
+    Uint8 c[4] = {color.r, color.g, color.b, color.a};
+    kernels().tint(src, dst, count, c);
+}
+
+
+/** Blend
+ *
+ * Draws premultiplied RGBA32 pixels over the dst pixels,
+ * the same thing TM::getPremultipliedBlendMode does when rendering.
+ *
+ * @param src Premultiplied RGBA32 pixels
+ * @param dst Premultiplied RGBA32 pixels drawn over
+ * @param count Number of pixels
+ */
+void Pixel::blend(const Uint8* src, Uint8* dst, int count){ kernels().blend(src, dst, count); }
+
+
+/** Fill
+ *
+ * Draws a single premultiplied color over the dst pixels.
+ *
+ * @param dst Premultiplied RGBA32 pixels drawn over
+ * @param count Number of pixels
+ * @param color Premultiplied color
+ */
+void Pixel::fill(Uint8* dst, int count, const SDL_Color& color){
+    Uint8 c[4] = {color.r, color.g, color.b, color.a};
+    kernels().fill(dst, count, c);
+}
+
+
+
+
+/** Convert To RGBA32
+ *
+ * Converts the surface into a new RGBA32 surface, using the SIMD kernels for
+ * the RGB24, BGRA32, ARGB32 and 8 bit grayscale images, split by rows across
+ * the worker threads. Any other format is converted by SDL_ConvertSurfaceFormat.
+ * The original surface is left to the caller to free.
+ *
+ * @param surface Surface to be converted
+ * @return The new RGBA32 surface, or nullptr on error
+ */
+SDL_Surface* Pixel::convertToRGBA32(SDL_Surface* surface){
+    if(surface == nullptr) return nullptr;
+
+    // PICK THE KERNEL -------------------------------------------------------------------
+    Kernel kernel = nullptr;
+    switch(surface->format->format){
+        case SDL_PIXELFORMAT_RGB24:  kernel = kernels().rgb24;  break;
+        case SDL_PIXELFORMAT_BGRA32: kernel = kernels().bgra32; break;
+        case SDL_PIXELFORMAT_ARGB32: kernel = kernels().argb32; break;
+        case SDL_PIXELFORMAT_INDEX8: {
+            // Only if the palette is a plain gray ramp, like the one of grayscale PNGs
+            SDL_Palette* palette = surface->format->palette;
+            if(palette == nullptr || palette->ncolors != 256 || SDL_HasColorKey(surface)) break;
+
+            bool gray = true;
+            for(int i = 0; i < 256 && gray; i++){
+                const SDL_Color& c = palette->colors[i];
+                gray = c.r == i && c.g == i && c.b == i && c.a == 255;
+            }
+            if(gray) kernel = kernels().gray;
+            break;
+        }
+        default: break;
+    }
+
+    if(kernel == nullptr) return SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+
+    // CONVERT ROW BY ROW ----------------------------------------------------------------
+    SDL_Surface* converted = SDL_CreateRGBSurfaceWithFormat(0, surface->w, surface->h, 32, SDL_PIXELFORMAT_RGBA32);
+    if(converted == nullptr) return nullptr;
+
+    if(SDL_MUSTLOCK(surface)) SDL_LockSurface(surface);
+
+    const Uint8* src = (const Uint8*)surface->pixels;
+    Uint8* dst = (Uint8*)converted->pixels;
+    int width = surface->w;
+    Jobs::parallelFor(surface->h, [&](int begin, int end){
+        for(int y = begin; y < end; y++){
+            kernel(src + (size_t)y * surface->pitch, dst + (size_t)y * converted->pitch, width);
+        }
+    }, 64);
+
+    if(SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
+
+    return converted;
+}
+
+
+
+
+/** Get Kernel Name
+ *
+ * Returns which kernels are used on this CPU: "AVX2", "SSE4.1" or "scalar".
+ */
+const char* Pixel::getKernelName(){ return kernels().name; }
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef MySDL_PIXEL
+#define MySDL_PIXEL
+
+#include "../lib.h"
+
+
+// CPU pixel kernels working on tightly packed rows of `count` pixels.
+// Each one has AVX2, SSE4.1 and scalar versions, picked at runtime by
+// the CPU features. src and dst can be the same buffer, except for the
+// conversions that expand the pixels (RGB24 and gray).
+//
+// RGBA32, BGRA32 and ARGB32 are the SDL byte order names, so RGBA32
+// is R, G, B, A in memory on every platform.
+class Pixel{
+    public:
+    // FORMAT CONVERSION --------------------------------------------------------------------------
+    static void rgb24ToRGBA32(const Uint8* src, Uint8* dst, int count);
+    static void bgra32ToRGBA32(const Uint8* src, Uint8* dst, int count);
+    static void argb32ToRGBA32(const Uint8* src, Uint8* dst, int count);
+    static void grayToRGBA32(const Uint8* src, Uint8* dst, int count);
+
+    static SDL_Surface* convertToRGBA32(SDL_Surface* surface);
+
+    // ALPHA -------------------------------------------------------------------------------------
+    static void premultiply(const Uint8* src, Uint8* dst, int count);
+    static void unpremultiply(const Uint8* src, Uint8* dst, int count);
+
+    // COLOR -------------------------------------------------------------------------------------
+    static void tint(const Uint8* src, Uint8* dst, int count, const SDL_Color& color);
+
+    // BLENDING ----------------------------------------------------------------------------------
+    static void blend(const Uint8* src, Uint8* dst, int count);
+    static void fill(Uint8* dst, int count, const SDL_Color& color);
+
+    static const char* getKernelName();
+};
+
+#endif
+// Creator: @AndrijaRD
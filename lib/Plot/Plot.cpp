@@ -0,0 +1,372 @@
+#include "./Plot.h"
+#include "../System/Sys.h"
+
+
+
+PlotSeries::PlotSeries(const SDL_Color& color, float thickness, int decimation)
+    : color(color), thickness(thickness), decimation(decimation), mesh(thickness, color) {}
+
+
+
+
+/** Append
+ *
+ * Adds a sample to the end of the series. The x values must not decrease,
+ * samples going back in x are ignored. A sample past the right edge of the
+ * view scrolls the view, keeping its width, so the newest sample is at it.
+ *
+ * @param x Sample position, usually time
+ * @param y Sample value
+ */
+void PlotSeries::append(double x, double y){
+    if(!xs.empty() && x < xs.back()) return;
+    if(x > xMax) scrollTo(x);
+
+    xs.push_back(x);
+    ys.push_back(y);
+    if(!rebuild) addToColumn(xs.size() - 1);
+}
+
+
+
+
+/** Append
+ *
+ * Adds the samples to the end of the series.
+ *
+ * @param xs Sample positions
+ * @param ys Sample values
+ * @param count Number of samples
+ */
+void PlotSeries::append(const double* xs, const double* ys, int count){
+    this->xs.reserve(this->xs.size() + count);
+    this->ys.reserve(this->ys.size() + count);
+    for(int i = 0; i < count; i++) append(xs[i], ys[i]);
+}
+
+
+
+
+/** Clear
+ *
+ * Removes all the samples.
+ */
+void PlotSeries::clear(){
+    xs.clear();
+    ys.clear();
+    rebuild = true;
+}
+
+
+
+
+/** Set View
+ *
+ * Sets the range of the data shown in the rect. Appending samples is cheap
+ * only while the view stays the same, changing it tessellates everything again.
+ * Appending past xMax scrolls the view on its own, so it is set only once.
+ *
+ * @param xMin Data x at the left edge
+ * @param xMax Data x at the right edge
+ * @param yMin Data y at the bottom edge
+ * @param yMax Data y at the top edge
+ */
+void PlotSeries::setView(double xMin, double xMax, double yMin, double yMax){
+    if(xMin == this->xMin && xMax == this->xMax && yMin == this->yMin && yMax == this->yMax) return;
+
+    this->xMin = xMin;
+    this->xMax = xMax;
+    this->yMin = yMin;
+    this->yMax = yMax;
+    rebuild = true;
+}
+
+
+
+
+/** Set Style
+ *
+ * @param color Color of the line
+ * @param thickness Thickness of the line in pixels
+ */
+void PlotSeries::setStyle(const SDL_Color& color, float thickness){
+    this->color = color;
+    this->thickness = thickness;
+    rebuild = true;
+}
+
+
+
+
+/** Set Decimation
+ *
+ * @param decimation PLOT_DECIMATE_NONE, PLOT_DECIMATE_MINMAX or PLOT_DECIMATE_LTTB
+ */
+void PlotSeries::setDecimation(int decimation){
+    this->decimation = decimation;
+    rebuild = true;
+}
+
+
+
+
+/** Column Of
+ *
+ * INTERNAL USE
+ *
+ * @return Column of the data x, or -1 if it is outside of the view
+ */
+int PlotSeries::columnOf(double x) const{
+    if(x < xMin || x > xMax) return -1;
+    int c = (int)((x - xOrigin) / (xMax - xMin) * width);
+    return max(origin, min(c, origin + width - 1));
+}
+
+
+
+
+/** To Pixel
+ *
+ * INTERNAL USE
+ *
+ * @return Position of the sample, relative to the left edge of the column 0 and the top of the rect
+ */
+SDL_FPoint PlotSeries::toPixel(size_t i) const{
+    return {
+        (float)((xs[i] - xOrigin) / (xMax - xMin) * width),
+        (float)(height - (ys[i] - yMin) / (yMax - yMin) * height)
+    };
+}
+
+
+
+
+/** Scroll To
+ *
+ * INTERNAL USE
+ *
+ * Moves the view right by whole columns, until the data x is in its last
+ * column. The columns stay where they are, the view just reads them from
+ * further on, so only once they run out are the samples put into columns again.
+ *
+ * @param x Data x of the new sample, past xMax
+ */
+void PlotSeries::scrollTo(double x){
+    double span = xMax - xMin;
+    double columnWidth = span / max(width, 1);
+    double steps = floor((x - xMax) / columnWidth) + 1;
+
+    // Out of columns, they are filled again from the new view
+    if(rebuild || width <= 0 || origin + width + steps > columnBegin.size()){
+        xMin = x - span;
+        xMax = x;
+        rebuild = true;
+        return;
+    }
+
+    // Computed from xOrigin every time, so the edges never drift from the columns
+    origin += (int)steps;
+    xMin = xOrigin + origin * columnWidth;
+    xMax = xMin + span;
+}
+
+
+
+
+/** Add To Column
+ *
+ * INTERNAL USE
+ *
+ * Puts the sample into its pixel column and marks the column dirty.
+ *
+ * @param i Index of the sample
+ */
+void PlotSeries::addToColumn(size_t i){
+    int c = columnOf(xs[i]);
+    if(c < 0) return;
+
+    if(columnBegin[c] == columnEnd[c]) columnBegin[c] = i;
+    columnEnd[c] = i + 1;
+
+    lastColumn = max(lastColumn, c);
+    dirtyColumn = min(dirtyColumn, c);
+}
+
+
+
+
+/** Emit Column
+ *
+ * INTERNAL USE
+ *
+ * Adds the decimated samples of the column to the mesh.
+ *
+ * @param c Pixel column
+ */
+void PlotSeries::emitColumn(int c){
+    size_t begin = columnBegin[c], end = columnEnd[c];
+    if(begin == end) return;
+
+    // NONE ---------------------------------------------------------------------------------
+    if(decimation == PLOT_DECIMATE_NONE || end - begin <= 2){
+        for(size_t i = begin; i < end; i++) mesh.add(toPixel(i));
+        drawnPoints += end - begin;
+        return;
+    }
+
+    // MIN/MAX ------------------------------------------------------------------------------
+    // First, min, max and last, in the order of the samples, so the
+    // lines between the columns connect just like without decimation
+    if(decimation == PLOT_DECIMATE_MINMAX){
+        size_t lo = begin, hi = begin;
+        for(size_t i = begin + 1; i < end; i++){
+            if(ys[i] < ys[lo]) lo = i;
+            if(ys[i] > ys[hi]) hi = i;
+        }
+
+        size_t picked[4] = {begin, min(lo, hi), max(lo, hi), end - 1};
+        for(int k = 0; k < 4; k++){
+            if(k > 0 && picked[k] == picked[k - 1]) continue;
+            mesh.add(toPixel(picked[k]));
+            drawnPoints++;
+        }
+        return;
+    }
+
+    // LTTB ---------------------------------------------------------------------------------
+    // The sample making the largest triangle with the previously drawn
+    // point and the average of the next column holding samples
+    SDL_FPoint a = mesh.getState().last;
+    if(mesh.getState().points == 0){
+        a = toPixel(begin);
+        mesh.add(a);
+        drawnPoints++;
+    }
+
+    int next = c + 1;
+    while(next <= lastColumn && columnBegin[next] == columnEnd[next]) next++;
+
+    size_t best = end - 1;     // The last column keeps its last sample
+    if(next <= lastColumn){
+        double cx = 0, cy = 0;
+        for(size_t i = columnBegin[next]; i < columnEnd[next]; i++){
+            SDL_FPoint p = toPixel(i);
+            cx += p.x;
+            cy += p.y;
+        }
+        size_t n = columnEnd[next] - columnBegin[next];
+        cx /= n;
+        cy /= n;
+
+        double bestArea = -1;
+        for(size_t i = begin; i < end; i++){
+            SDL_FPoint p = toPixel(i);
+            double area = fabs((a.x - cx) * (p.y - a.y) - (a.x - p.x) * (cy - a.y));
+            if(area > bestArea){
+                bestArea = area;
+                best = i;
+            }
+        }
+    }
+
+    mesh.add(toPixel(best));
+    drawnPoints++;
+}
+
+
+
+
+/** Tessellate
+ *
+ * INTERNAL USE
+ *
+ * Tessellates the dirty columns, going back to the mesh state saved before
+ * them. The column with samples before the dirty one is redone as well,
+ * since its LTTB pick depends on the samples of the next column.
+ */
+void PlotSeries::tessellate(){
+    if(rebuild){
+        // Twice the width, so the view can scroll by its width before this is done again
+        int columns = width * 2;
+        columnBegin.assign(columns, 0);
+        columnEnd.assign(columns, 0);
+        checkpoints.assign(columns, PolylineMesh::State());
+        drawnAt.assign(columns, 0);
+        xOrigin = xMin;
+        origin = 0;
+        lastColumn = -1;
+        dirtyColumn = 0;
+        tessellatedColumn = -1;
+
+        mesh.setStyle(thickness, color);
+        mesh.clear();
+        drawnPoints = 0;
+
+        // Only the samples within the view get a column
+        auto first = std::lower_bound(xs.begin(), xs.end(), xMin);
+        for(size_t i = first - xs.begin(); i < xs.size() && xs[i] <= xMax; i++) addToColumn(i);
+
+        rebuild = false;
+    }
+
+    if(lastColumn < 0 || dirtyColumn > lastColumn) return;
+
+    // Back to the last column with samples before the dirty one
+    int from = min(dirtyColumn - 1, tessellatedColumn);
+    while(from > 0 && columnBegin[from] == columnEnd[from]) from--;
+    from = max(0, from);
+
+    mesh.restore(checkpoints[from]);
+    drawnPoints = drawnAt[from];
+
+    for(int c = from; c <= lastColumn; c++){
+        checkpoints[c] = mesh.getState();
+        drawnAt[c] = drawnPoints;
+        emitColumn(c);
+    }
+
+    tessellatedColumn = lastColumn;
+    dirtyColumn = columnBegin.size();
+}
+
+
+
+
+/** Render
+ *
+ * Draws the series into the rect, with a single SDL_RenderGeometry call.
+ * The line is clipped to the rect.
+ *
+ * @param rect Where to draw the series
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int PlotSeries::render(const SDL_Rect& rect){
+    if(rect.w <= 0 || rect.h <= 0) return PLOT_INVALID_VIEW;
+    if(xMax <= xMin || yMax <= yMin) return PLOT_INVALID_VIEW;
+
+    // The mesh is relative to the rect, so moving it is free
+    if(rect.w != width || rect.h != height){
+        width = rect.w;
+        height = rect.h;
+        rebuild = true;
+    }
+    tessellate();
+
+    // The column 0 is origin pixels left of the rect, what is
+    // left of the rect is clipped, just like what is outside of it
+    SDL_Rect previousViewport, previousClip;
+    SDL_RenderGetViewport(Sys::renderer, &previousViewport);
+    bool clipped = SDL_RenderIsClipEnabled(Sys::renderer);
+    SDL_RenderGetClipRect(Sys::renderer, &previousClip);
+
+    SDL_Rect viewport = {rect.x - origin, rect.y, rect.w + origin, rect.h};
+    SDL_Rect clip = {origin, 0, rect.w, rect.h};
+    SDL_RenderSetViewport(Sys::renderer, &viewport);
+    SDL_RenderSetClipRect(Sys::renderer, &clip);
+
+    int err = mesh.render();
+
+    SDL_RenderSetViewport(Sys::renderer, &previousViewport);
+    SDL_RenderSetClipRect(Sys::renderer, clipped ? &previousClip : nullptr);
+    return err;
+}
@@ -0,0 +1,136 @@
+#pragma once
+#ifndef MySDL_PLOT
+#define MySDL_PLOT
+
+#include "../lib.h"
+#include "../Raster/Raster.h"
+
+// DECIMATION --------------------------------------------------------------------------------------
+#define PLOT_DECIMATE_NONE      0   // Every sample is drawn
+#define PLOT_DECIMATE_MINMAX    1   // First, min, max and last sample of every pixel column
+#define PLOT_DECIMATE_LTTB      2   // Largest-Triangle-Three-Buckets, one sample per pixel column
+
+
+
+// POLYLINE MESH -----------------------------------------------------------------------------------
+// Tessellates a thick polyline, with mitered (or beveled when too sharp)
+// joins, into one vertex buffer drawn with a single SDL_RenderGeometry.
+// Points are appended one by one, and only the new segment and its join
+// are tessellated, so growing lines never rebuild the existing geometry.
+// The triangles are opaque and the alpha of the color is applied to the
+// whole line once it is drawn, so where it overlaps itself it isnt darker.
+class PolylineMesh{
+    friend class TM;
+
+    public:
+    // Where the tessellation is, to go back to with restore()
+    struct State{
+        size_t vertices = 0;
+        size_t indices = 0;
+        int points = 0;
+        SDL_FPoint last = {0, 0};
+        SDL_FPoint prev = {0, 0};
+    };
+
+    PolylineMesh(float thickness = 1.0f, const SDL_Color& color = SDL_COLOR_WHITE);
+
+    void setStyle(float thickness, const SDL_Color& color);
+    void add(const SDL_FPoint& p);
+    void add(const SDL_FPoint* points, int count);
+    void clear();
+
+    State getState() const;
+    void restore(const State& state);
+
+    int render() const;
+    int render(RasterCanvas& canvas) const;
+
+    size_t getVertexCount() const { return vertices.size(); }
+
+    private:
+    vector<SDL_Vertex> vertices;
+    vector<int> indices;
+    float half;
+    SDL_Color color;            // Opaque
+    Uint8 alpha = 255;          // Of the whole line
+    mutable RasterImage layer;  // A translucent line drawn onto a canvas, until it is flushed
+
+    static inline TextureData translucentLayer;     // Every translucent line is drawn into it by render()
+
+    int points = 0;
+    SDL_FPoint last = {0, 0};
+    SDL_FPoint prev = {0, 0};
+
+    void addJoin(const SDL_FPoint& p);
+    void addTriangle(const SDL_FPoint& a, const SDL_FPoint& b, const SDL_FPoint& c);
+    int renderGeometry() const;
+    static void cleanup();
+};
+
+
+
+// PLOT SERIES -------------------------------------------------------------------------------------
+// A time series drawn as a thick polyline in a rect. Samples are decimated to
+// the pixel width of the rect, so millions of them draw as a few thousand
+// points. Appending samples only re-tessellates the last pixel columns,
+// as long as the view and the rect size stay the same. A sample past the
+// right edge scrolls the view by whole columns, which only moves where the
+// columns are read from, the samples are put into columns again only once
+// the view has scrolled by its whole width.
+class PlotSeries{
+    public:
+    PlotSeries(
+        const SDL_Color& color = SDL_COLOR_WHITE,
+        float thickness = 1.0f,
+        int decimation = PLOT_DECIMATE_MINMAX
+    );
+
+    void append(double x, double y);
+    void append(const double* xs, const double* ys, int count);
+    void clear();
+
+    void setView(double xMin, double xMax, double yMin, double yMax);
+    void setStyle(const SDL_Color& color, float thickness);
+    void setDecimation(int decimation);
+
+    int render(const SDL_Rect& rect);
+
+    size_t size() const { return xs.size(); }
+    size_t getDrawnPoints() const { return drawnPoints; }
+
+    private:
+    vector<double> xs, ys;
+    SDL_Color color;
+    float thickness;
+    int decimation;
+
+    // Mapping of the data into the rect
+    double xMin = 0, xMax = 1, yMin = 0, yMax = 1;
+    int width = 0, height = 0;
+
+    // Samples [columnBegin[c], columnEnd[c]) fall into the column c, counted
+    // from xOrigin. There are twice as many as the rect is wide, the view
+    // shows the columns [origin, origin + width) of them
+    vector<size_t> columnBegin, columnEnd;
+    double xOrigin = 0;                     // Data x at the left edge of the column 0
+    int origin = 0;                         // Columns scrolled since they were filled
+    int lastColumn = -1;                    // Last column holding samples
+    int dirtyColumn = 0;                    // First column that needs to be tessellated again
+    int tessellatedColumn = -1;             // Last column in the mesh
+    bool rebuild = true;                    // Everything has to be tessellated again
+
+    PolylineMesh mesh;
+    vector<PolylineMesh::State> checkpoints;   // Mesh state before each column
+    size_t drawnPoints = 0;
+    vector<size_t> drawnAt;                     // drawnPoints before each column
+
+    int columnOf(double x) const;
+    SDL_FPoint toPixel(size_t i) const;
+    void scrollTo(double x);
+    void addToColumn(size_t i);
+    void tessellate();
+    void emitColumn(int c);
+};
+
+#endif
+// Creator: @AndrijaRD
@@ -0,0 +1,325 @@
+#include "./Plot.h"
+#include "../System/Sys.h"
+
+
+
+// Joins sharper then this get beveled, as the ratio of miter length to half thickness
+static const float MITER_LIMIT = 2.0f;
+
+
+
+PolylineMesh::PolylineMesh(float thickness, const SDL_Color& color){
+    setStyle(thickness, color);
+}
+
+
+
+
+/** Set Style
+ *
+ * Sets the thickness and the color of the points added from now on.
+ * The alpha of the color is used for the whole line.
+ *
+ * @param thickness Thickness of the line in pixels
+ * @param color Color of the line
+ */
+void PolylineMesh::setStyle(float thickness, const SDL_Color& color){
+    this->half = max(thickness, 1.0f) / 2;
+    this->color = {color.r, color.g, color.b, 255};
+    this->alpha = color.a;
+}
+
+
+
+
+/** Add Triangle
+ *
+ * INTERNAL USE
+ */
+void PolylineMesh::addTriangle(const SDL_FPoint& a, const SDL_FPoint& b, const SDL_FPoint& c){
+    int first = vertices.size();
+    vertices.push_back({a, color, {0, 0}});
+    vertices.push_back({b, color, {0, 0}});
+    vertices.push_back({c, color, {0, 0}});
+
+    indices.push_back(first);
+    indices.push_back(first + 1);
+    indices.push_back(first + 2);
+}
+
+
+
+
+/** Add Join
+ *
+ * INTERNAL USE
+ *
+ * Fills the gap on the outer side of the corner at the last point,
+ * between the previous segment and the one going to p.
+ *
+ * @param p The point the new segment goes to
+ */
+void PolylineMesh::addJoin(const SDL_FPoint& p){
+    float d0x = last.x - prev.x, d0y = last.y - prev.y;
+    float d1x = p.x - last.x, d1y = p.y - last.y;
+
+    float l0 = std::sqrt(d0x * d0x + d0y * d0y);
+    float l1 = std::sqrt(d1x * d1x + d1y * d1y);
+    d0x /= l0; d0y /= l0;
+    d1x /= l1; d1y /= l1;
+
+    float cross = d0x * d1y - d0y * d1x;
+    if(fabsf(cross) < 1e-4f) return;    // Straight, the segments already meet
+
+    // Unit normals of both segments, on the outer side of the turn
+    float side = cross > 0 ? -1.0f : 1.0f;
+    SDL_FPoint n0 = {-d0y * side, d0x * side};
+    SDL_FPoint n1 = {-d1y * side, d1x * side};
+
+    SDL_FPoint a = {last.x + n0.x * half, last.y + n0.y * half};
+    SDL_FPoint b = {last.x + n1.x * half, last.y + n1.y * half};
+
+    // MITER --------------------------------------------------------------------------------
+    float mx = n0.x + n1.x, my = n0.y + n1.y;
+    float ml = std::sqrt(mx * mx + my * my);
+    if(ml > 1e-4f){
+        mx /= ml; my /= ml;
+        float cosHalf = mx * n0.x + my * n0.y;
+        if(cosHalf > 1.0f / MITER_LIMIT){
+            float length = half / cosHalf;
+            SDL_FPoint m = {last.x + mx * length, last.y + my * length};
+            addTriangle(last, a, m);
+            addTriangle(last, m, b);
+            return;
+        }
+    }
+
+    // BEVEL --------------------------------------------------------------------------------
+    addTriangle(last, a, b);
+}
+
+
+
+
+/** Add
+ *
+ * Appends a point to the line, tessellating the segment
+ * from the previous point and the join between them.
+ *
+ * @param p The new point
+ */
+void PolylineMesh::add(const SDL_FPoint& p){
+    if(points == 0){
+        last = p;
+        points = 1;
+        return;
+    }
+
+    float dx = p.x - last.x, dy = p.y - last.y;
+    float length = std::sqrt(dx * dx + dy * dy);
+    if(length < 1e-3f) return;      // Same point, nothing to draw
+
+    if(points >= 2) addJoin(p);
+
+    // SEGMENT QUAD -------------------------------------------------------------------------
+    float nx = -dy / length * half, ny = dx / length * half;
+
+    int first = vertices.size();
+    vertices.push_back({{last.x + nx, last.y + ny}, color, {0, 0}});
+    vertices.push_back({{last.x - nx, last.y - ny}, color, {0, 0}});
+    vertices.push_back({{p.x - nx, p.y - ny}, color, {0, 0}});
+    vertices.push_back({{p.x + nx, p.y + ny}, color, {0, 0}});
+
+    const int quad[6] = {0, 1, 2, 0, 2, 3};
+    for(int i : quad) indices.push_back(first + i);
+
+    prev = last;
+    last = p;
+    points++;
+}
+
+
+
+
+/** Add
+ *
+ * Appends the points to the line.
+ *
+ * @param points Array of the new points
+ * @param count Number of points
+ */
+void PolylineMesh::add(const SDL_FPoint* points, int count){
+    vertices.reserve(vertices.size() + (size_t)count * 7);
+    indices.reserve(indices.size() + (size_t)count * 12);
+    for(int i = 0; i < count; i++) add(points[i]);
+}
+
+
+
+
+/** Clear
+ *
+ * Removes all the points, keeping the allocated memory.
+ */
+void PolylineMesh::clear(){
+    restore(State());
+}
+
+
+
+
+/** Get State
+ *
+ * Returns where the tessellation is now, so it can go back to it later,
+ * to replace the last points without tessellating the whole line again.
+ */
+PolylineMesh::State PolylineMesh::getState() const{
+    return {vertices.size(), indices.size(), points, last, prev};
+}
+
+
+
+
+/** Restore
+ *
+ * Drops everything added after the state was taken.
+ *
+ * @param state A state returned by getState()
+ */
+void PolylineMesh::restore(const State& state){
+    vertices.resize(state.vertices);
+    indices.resize(state.indices);
+    points = state.points;
+    last = state.last;
+    prev = state.prev;
+}
+
+
+
+
+/** Render Geometry
+ *
+ * INTERNAL USE
+ *
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int PolylineMesh::renderGeometry() const{
+    int err = SDL_RenderGeometry(
+        Sys::renderer,
+        nullptr,
+        vertices.data(),
+        vertices.size(),
+        indices.data(),
+        indices.size()
+    );
+    if(err != 0) return PLOT_RENDER_GEOMETRY_FAILED;
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Render
+ *
+ * Draws the whole line with a single SDL_RenderGeometry call. A translucent
+ * line is drawn opaque into a texture the size of the viewport first, which
+ * is then blended in with its alpha, so the triangles overlapping at the
+ * joins and where the line folds back are blended only once.
+ *
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int PolylineMesh::render() const{
+    if(indices.empty()) return NO_ERROR;
+    if(alpha == 255) return renderGeometry();
+
+    // The target, viewport and clip are all put back afterwards,
+    // switching the target resets them for a GUI layer or an overlay
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(Sys::renderer);
+    SDL_Rect viewport, clip;
+    SDL_RenderGetViewport(Sys::renderer, &viewport);
+    bool clipped = SDL_RenderIsClipEnabled(Sys::renderer);
+    SDL_RenderGetClipRect(Sys::renderer, &clip);
+
+    // Shared by every translucent line, they are drawn one at a time
+    TextureData& layer = PolylineMesh::translucentLayer;
+    if(layer.tex == nullptr || layer.width != viewport.w || layer.height != viewport.h){
+        int err = TM::acquireTexture(layer, viewport.w, viewport.h);
+        if(err != NO_ERROR) return err;
+    }
+    SDL_Texture* tex = TM::resolve(layer);
+    if(tex == nullptr) return TM_GOT_NULLPTR_TEX;
+
+    int err = NO_ERROR;
+    if(SDL_SetRenderTarget(Sys::renderer, tex)){
+        err = TM_SRT_FAILED;
+    } else {
+        SDL_SetRenderDrawColor(Sys::renderer, 0, 0, 0, 0);
+        if(SDL_RenderClear(Sys::renderer)) err = TM_RCLR_FAILED;
+        else err = renderGeometry();
+    }
+
+    if(SDL_SetRenderTarget(Sys::renderer, previousTarget) && err == NO_ERROR) err = TM_SRT_FAILED;
+    SDL_RenderSetViewport(Sys::renderer, &viewport);
+    SDL_RenderSetClipRect(Sys::renderer, clipped ? &clip : nullptr);
+    if(err != NO_ERROR) return err;
+
+    SDL_Rect dst = {0, 0, viewport.w, viewport.h};
+    SDL_SetTextureAlphaMod(tex, alpha);
+    err = SDL_RenderCopy(Sys::renderer, tex, &layer.src, &dst) ? TM_RCPY_FAILED : NO_ERROR;
+    SDL_SetTextureAlphaMod(tex, 255);
+
+    return err;
+}
+
+
+
+
+/** Render
+ *
+ * Draws the whole line onto the CPU canvas, as it would be drawn by
+ * PolylineMesh::render(). A translucent line is blended in by the next
+ * canvas.flush(), until then the mesh shouldnt be drawn onto another canvas.
+ *
+ * @param canvas Canvas to draw on
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int PolylineMesh::render(RasterCanvas& canvas) const{
+    if(indices.empty()) return NO_ERROR;
+    if(alpha == 255){
+        canvas.geometry(vertices.data(), vertices.size(), indices.data(), indices.size());
+        return NO_ERROR;
+    }
+
+    // Drawn opaque onto a canvas of its own, then blended in with the alpha
+    static RasterCanvas scratch(1, 1);
+    int width = canvas.getWidth(), height = canvas.getHeight();
+    if(scratch.getWidth() != width || scratch.getHeight() != height){
+        int err = scratch.resize(width, height);
+        if(err != NO_ERROR) return err;
+    }
+
+    scratch.clear({0, 0, 0, 0});
+    scratch.geometry(vertices.data(), vertices.size(), indices.data(), indices.size());
+    int err = scratch.flush();
+    if(err != NO_ERROR) return err;
+
+    layer.width = width;
+    layer.height = height;
+    layer.pixels.assign(scratch.getPixels(), scratch.getPixels() + (size_t)width * height * 4);
+    canvas.blit(layer, nullptr, {0, 0, width, height}, alpha);
+    return NO_ERROR;
+}
+
+
+
+
+/** Cleanup
+ *
+ * INTERNAL USE
+ *
+ * Frees the texture the translucent lines are drawn into. Called by TM::cleanup.
+ */
+void PolylineMesh::cleanup(){
+    TM::freeTexture(PolylineMesh::translucentLayer);
+}
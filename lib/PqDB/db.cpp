@@ -98,7 +98,17 @@ bool DB::checkResult(const PGresult* res, const int type){
 
 
 
-int DB::execPrepared(Statement& s, const vector<string>& params, DBResult& result){
+/** Exec Prepared
+ * 
+ * Executes the prepared statement with the params.
+ * 
+ * @param s Prepared statement
+ * @param params Values of the statement parameters, as text
+ * @param result Gets the result
+ * @param resultFormat DB_FORMAT_TEXT or DB_FORMAT_BINARY, binary returns bytea columns as the raw bytes (DBResult::getBytes)
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int DB::execPrepared(Statement& s, const vector<string>& params, DBResult& result, int resultFormat){
     if(!s.prepared) return DB_EXEC_NOT_PREPARED_ERROR;
 
     const char* formatedParams[s.nParams];
@@ -114,7 +124,7 @@ int DB::execPrepared(Statement& s, const vector<string>& params, DBResult& resul
         formatedParams, 
         nullptr, 
         nullptr, 
-        0
+        resultFormat
     );
 
     if(!checkResult(result.result, s.type)) {
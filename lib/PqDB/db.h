@@ -3,6 +3,7 @@
 #define MySDL_DB
 
 #include "../lib.h"
+#include "../TextureManager/TM.h"
 
 #define SQL_SELECT      0
 #define SQL_INSERT      1
@@ -16,6 +17,10 @@
 #define SQL_REVOKE      9
 #define SQL_VACUUM      10
 
+// RESULT FORMATS
+#define DB_FORMAT_TEXT      0   // Every value as a string
+#define DB_FORMAT_BINARY    1   // Values in their binary representation, bytea as the raw bytes
+
 
 
 struct Statement {
@@ -77,6 +82,19 @@ public:
         return PQgetvalue(result, row, column);
     };
 
+    // Raw bytes of the value, pointing into the result, valid for as long as the result is
+    int getBytes(int row, int column, const Uint8*& data, int& length) const {
+        if ( !isValid() || row < 0 || column < 0 || row >= rowCount() || column >= columnCount()) return DB_INVALID_ROW_COLUMN;
+        if (PQgetisnull(result, row, column)) return DB_INVALID_RES_VALUE;
+
+        data = (const Uint8*)PQgetvalue(result, row, column);
+        length = PQgetlength(result, row, column);
+        return NO_ERROR;
+    };
+
+    bool isNull(int row, int column) const { return isValid() && PQgetisnull(result, row, column); };
+    bool isBinary(int column) const        { return isValid() && PQfformat(result, column) == DB_FORMAT_BINARY; };
+
     ExecStatusType status() const    { return PQresultStatus(result); };
     const char* errorMessage() const { return PQresultErrorMessage(result); };
 };
@@ -103,6 +121,19 @@ class DB{
 
     static inline PGconn* dbConn = nullptr;
 
+    // Image fetched out of a bytea column, decoded on a worker thread
+    struct ImageJob{
+        shared_ptr<DBResult> result;    // Holds the bytes until they are decoded
+        vector<Uint8> pixels;
+        int width = 0;
+        int height = 0;
+        bool premultiplied = false;
+        int error = NO_ERROR;
+        shared_future<void> done;
+    };
+
+    static inline unordered_map<string, shared_ptr<ImageJob>> pendingImages;   // Cache key -> job
+
     public:
     static int init(
         const string& dbName,
@@ -113,7 +144,20 @@ class DB{
     );
 
     static int prepareStatement(Statement& statement);
-    static int execPrepared(Statement& statement, const vector<string>& params, DBResult& result);
+    static int execPrepared(
+        Statement& statement,
+        const vector<string>& params,
+        DBResult& result,
+        int resultFormat = DB_FORMAT_TEXT
+    );
+
+    static int loadTexture(
+        TextureData& td,
+        Statement& statement,
+        const string& key,
+        const string& version,
+        bool wait = true
+    );
 
     private:
     static bool checkResult(const PGresult* s, const int type);
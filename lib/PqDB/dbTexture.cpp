@@ -0,0 +1,81 @@
+#include "./db.h"
+#include "../Jobs/Jobs.h"
+
+
+
+/** Load Texture
+ * 
+ * Loads an image stored in a bytea column straight into a texture. The
+ * statement takes the row key as its only parameter and returns the image
+ * in the first column. The result is fetched in the binary format and the
+ * image is decoded in place out of it, on a worker thread.
+ * 
+ * The texture is cached by (statement, key, version), so as long as it is
+ * held somewhere, loading a row whose version didnt change doesnt touch
+ * the database. The version is whatever the table uses to mark changed
+ * rows, like an updated_at or a revision column.
+ * 
+ *     Statement image("productImage", "SELECT image FROM products WHERE id = $1", 1);
+ *     DB::prepareStatement(image);
+ *     DB::loadTexture(td, image, id, updatedAt);
+ * 
+ * @param td TextureData object into which the image should be loaded
+ * @param statement Prepared statement selecting the image of the row
+ * @param key Key of the row, passed as the statement parameter
+ * @param version Version of the row, a new version fetches the image again
+ * @param wait If false DB_TEXTURE_PENDING is returned until the image is
+ *             decoded, call it again on the next frames
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int DB::loadTexture(TextureData& td, Statement& statement, const string& key, const string& version, bool wait){
+    string cacheKey = "db|" + statement.name + "|" + key + "|" + version;
+    bool premultiplied = TM::getLoadPremultiplied();
+
+    // Unchanged rows are never fetched again
+    if(!pendingImages.count(cacheKey) && TM::getCached(td, cacheKey, premultiplied)) return NO_ERROR;
+
+    // FETCH THE ROW AND DECODE IT ON A WORKER --------------------------------------------
+    if(!pendingImages.count(cacheKey)){
+        auto result = make_shared<DBResult>();
+        int err = DB::execPrepared(statement, {key}, *result, DB_FORMAT_BINARY);
+        if(err != NO_ERROR) return err;
+        if(result->rowCount() < 1) return DB_INVALID_ROW_COLUMN;
+        if(!result->isBinary(0)) return DB_INVALID_RES_VALUE;
+
+        const Uint8* data;
+        int length;
+        err = result->getBytes(0, 0, data, length);
+        if(err != NO_ERROR) return err;
+
+        auto job = make_shared<ImageJob>();
+        job->result = result;
+        job->premultiplied = premultiplied;
+
+        auto promise = make_shared<std::promise<void>>();
+        job->done = promise->get_future().share();
+        pendingImages.insert({cacheKey, job});
+
+        auto work = [job, promise, data, length](){
+            job->error = TM::decodeImage(data, length, job->pixels, job->width, job->height, job->premultiplied);
+
+            // The bytes are no longer needed, PQclear doesnt touch the connection
+            job->result.reset();
+            promise->set_value();
+        };
+
+        if(wait) work();
+        else Jobs::submit(std::move(work));
+    }
+
+    // UPLOAD IT ONCE IT IS DECODED ---------------------------------------------------------
+    auto pending = pendingImages.find(cacheKey);
+    shared_ptr<ImageJob> job = pending->second;
+    if(!wait && job->done.wait_for(std::chrono::seconds(0)) != std::future_status::ready){
+        return DB_TEXTURE_PENDING;
+    }
+    job->done.wait();
+    pendingImages.erase(pending);
+
+    if(job->error != NO_ERROR) return job->error;
+    return TM::uploadImage(td, job->pixels, job->width, job->height, cacheKey, job->premultiplied);
+}
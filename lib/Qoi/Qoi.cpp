@@ -0,0 +1,362 @@
+#include "./Qoi.h"
+
+
+
+// OPCODES -------------------------------------------------------------------------------
+static const Uint8 QOI_OP_INDEX = 0x00;     // 00xxxxxx
+static const Uint8 QOI_OP_DIFF  = 0x40;     // 01xxxxxx
+static const Uint8 QOI_OP_LUMA  = 0x80;     // 10xxxxxx
+static const Uint8 QOI_OP_RUN   = 0xc0;     // 11xxxxxx
+static const Uint8 QOI_OP_RGB   = 0xfe;
+static const Uint8 QOI_OP_RGBA  = 0xff;
+
+static const Uint8 QOI_END[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+
+
+static inline int qoiHash(const Uint8* px){
+    return (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+}
+
+static inline int opLength(Uint8 op){
+    if(op == QOI_OP_RGBA) return 5;
+    if(op == QOI_OP_RGB) return 4;
+    if((op & 0xc0) == QOI_OP_LUMA) return 2;
+    return 1;
+}
+
+static inline Uint32 getBigEndian(const Uint8* bytes){
+    return (Uint32)bytes[0] << 24 | (Uint32)bytes[1] << 16 | (Uint32)bytes[2] << 8 | bytes[3];
+}
+
+static inline void putBigEndian(vector<Uint8>& out, Uint32 value){
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+
+
+
+/** Encode
+ * 
+ * Encodes the pixels as a QOI image, with the header and the end marker.
+ * 
+ * @param rgba Tightly packed RGBA32 pixels
+ * @param width Width of the image
+ * @param height Height of the image
+ * @param out Vector the encoded image is written into, its old content is removed
+ */
+void QOI::encode(const Uint8* rgba, int width, int height, vector<Uint8>& out){
+    size_t count = (size_t)width * height;
+
+    out.clear();
+    out.reserve(14 + count * 5 + sizeof(QOI_END));     // The worst case, every pixel as QOI_OP_RGBA
+
+    // HEADER -------------------------------------------------------------------------------
+    out.insert(out.end(), {'q', 'o', 'i', 'f'});
+    putBigEndian(out, width);
+    putBigEndian(out, height);
+    out.push_back(4);       // Channels, RGBA
+    out.push_back(0);       // Colorspace, sRGB with linear alpha
+
+    // PIXELS -------------------------------------------------------------------------------
+    Uint8 index[64][4] = {};
+    Uint8 prev[4] = {0, 0, 0, 255};
+    int run = 0;
+
+    for(size_t i = 0; i < count; i++){
+        const Uint8* px = rgba + i * 4;
+
+        if(memcmp(px, prev, 4) == 0){
+            run++;
+            if(run == 62 || i == count - 1){
+                out.push_back(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+
+        if(run > 0){
+            out.push_back(QOI_OP_RUN | (run - 1));
+            run = 0;
+        }
+
+        int h = qoiHash(px);
+        if(memcmp(index[h], px, 4) == 0){
+            out.push_back(QOI_OP_INDEX | h);
+        } else {
+            memcpy(index[h], px, 4);
+
+            if(px[3] == prev[3]){
+                // Differences wrap around, just like the decoder adds them
+                int8_t dr = px[0] - prev[0];
+                int8_t dg = px[1] - prev[1];
+                int8_t db = px[2] - prev[2];
+                int8_t drg = dr - dg;
+                int8_t dbg = db - dg;
+
+                if(dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1){
+                    out.push_back(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                } else if(drg >= -8 && drg <= 7 && dg >= -32 && dg <= 31 && dbg >= -8 && dbg <= 7){
+                    out.push_back(QOI_OP_LUMA | (dg + 32));
+                    out.push_back((drg + 8) << 4 | (dbg + 8));
+                } else {
+                    out.insert(out.end(), {QOI_OP_RGB, px[0], px[1], px[2]});
+                }
+            } else {
+                out.insert(out.end(), {QOI_OP_RGBA, px[0], px[1], px[2], px[3]});
+            }
+        }
+
+        memcpy(prev, px, 4);
+    }
+
+    out.insert(out.end(), QOI_END, QOI_END + sizeof(QOI_END));
+}
+
+
+
+
+/** Save
+ * 
+ * Encodes the pixels and writes them into a .qoi file.
+ * Safe to call from the jobs, it uses no renderer state.
+ * 
+ * @param path Path of the file to be written
+ * @param rgba Tightly packed RGBA32 pixels
+ * @param width Width of the image
+ * @param height Height of the image
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int QOI::save(const string& path, const Uint8* rgba, int width, int height){
+    vector<Uint8> encoded;
+    QOI::encode(rgba, width, height, encoded);
+
+    SDL_RWops* file = SDL_RWFromFile(path.c_str(), "wb");
+    if(file == nullptr) return QOI_WRITE_ERROR;
+
+    size_t written = SDL_RWwrite(file, encoded.data(), 1, encoded.size());
+    SDL_RWclose(file);
+
+    if(written != encoded.size()) return QOI_WRITE_ERROR;
+    return NO_ERROR;
+}
+
+
+
+
+/** Is QOI
+ * 
+ * Checks the signature of the file, so the extension doesnt matter.
+ * 
+ * @param path Path to the image on the filesystem
+ * @return True if the file starts with the QOI magic bytes
+ */
+bool QOI::isQOI(const string& path){
+    SDL_RWops* file = SDL_RWFromFile(path.c_str(), "rb");
+    if(file == nullptr) return false;
+
+    char magic[4];
+    size_t got = SDL_RWread(file, magic, 1, 4);
+    SDL_RWclose(file);
+
+    return got == 4 && memcmp(magic, "qoif", 4) == 0;
+}
+
+
+
+
+/** Load
+ * 
+ * Decodes the .qoi file, streaming it in chunks straight into the pixels.
+ * 
+ * @param path Path to the image on the filesystem
+ * @param pixels Gets the tightly packed RGBA32 pixels
+ * @param width Gets the width of the image
+ * @param height Gets the height of the image
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int QOI::load(const string& path, vector<Uint8>& pixels, int& width, int& height){
+    SDL_RWops* file = SDL_RWFromFile(path.c_str(), "rb");
+    if(file == nullptr) return QOI_READ_ERROR;
+
+    QOIDecoder decoder([&pixels](int width, int height, int& pitch){
+        pitch = width * 4;
+        pixels.resize((size_t)pitch * height);
+        return pixels.data();
+    });
+
+    // Small enough to stay in the cache while it is decoded
+    vector<Uint8> chunk(64 * 1024);
+    int err = NO_ERROR;
+    while(err == NO_ERROR && !decoder.isDone()){
+        size_t got = SDL_RWread(file, chunk.data(), 1, chunk.size());
+        if(got == 0) break;
+        err = decoder.feed(chunk.data(), got);
+    }
+    SDL_RWclose(file);
+
+    if(err != NO_ERROR) return err;
+    if(!decoder.isDone()) return QOI_TRUNCATED;
+
+    width = decoder.getWidth();
+    height = decoder.getHeight();
+    return NO_ERROR;
+}
+
+
+
+
+// DECODER -------------------------------------------------------------------------------
+
+QOIDecoder::QOIDecoder(Allocate allocate): allocate(std::move(allocate)) {}
+
+
+
+
+/** Parse Header
+ * 
+ * INTERNAL USE
+ * 
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int QOIDecoder::parseHeader(){
+    if(memcmp(headerBytes, "qoif", 4) != 0) return QOI_INVALID_HEADER;
+
+    Uint32 w = getBigEndian(headerBytes + 4);
+    Uint32 h = getBigEndian(headerBytes + 8);
+    channels = headerBytes[12];
+    int colorspace = headerBytes[13];
+
+    // Same limit as the reference decoder, 400 million pixels
+    if(w == 0 || h == 0 || w > 0x7fffffff || h > 0x7fffffff || h >= 400000000 / w) return QOI_INVALID_HEADER;
+    if((channels != 3 && channels != 4) || colorspace > 1) return QOI_INVALID_HEADER;
+
+    width = w;
+    height = h;
+    total = (size_t)w * h;
+
+    out = allocate(width, height, pitch);
+    if(out == nullptr) return QOI_INVALID_HEADER;
+
+    header = true;
+    return NO_ERROR;
+}
+
+
+
+
+/** Decode
+ * 
+ * INTERNAL USE
+ * 
+ * Decodes the whole ops of the data into the output.
+ * 
+ * @return Number of bytes used, the rest is the start of an op split between the chunks
+ */
+size_t QOIDecoder::decode(const Uint8* data, size_t size){
+    size_t pos = 0;
+    int x = pixel % width;
+    Uint8* row = out + (pixel / width) * pitch;
+
+    while(pixel < total && pos < size){
+        Uint8 op = data[pos];
+        int length = opLength(op);
+        if(size - pos < (size_t)length) break;
+
+        size_t run = 1;
+        if(op == QOI_OP_RGB){
+            px[0] = data[pos + 1];
+            px[1] = data[pos + 2];
+            px[2] = data[pos + 3];
+        } else if(op == QOI_OP_RGBA){
+            memcpy(px, data + pos + 1, 4);
+        } else if((op & 0xc0) == QOI_OP_INDEX){
+            memcpy(px, index[op], 4);
+        } else if((op & 0xc0) == QOI_OP_DIFF){
+            px[0] += ((op >> 4) & 3) - 2;
+            px[1] += ((op >> 2) & 3) - 2;
+            px[2] += (op & 3) - 2;
+        } else if((op & 0xc0) == QOI_OP_LUMA){
+            int dg = (op & 0x3f) - 32;
+            Uint8 next = data[pos + 1];
+            px[0] += dg - 8 + (next >> 4);
+            px[1] += dg;
+            px[2] += dg - 8 + (next & 0x0f);
+        } else {
+            run = (op & 0x3f) + 1;
+        }
+        pos += length;
+
+        // After every op, a run of the starting pixel is the first time it gets there
+        memcpy(index[qoiHash(px)], px, 4);
+
+        run = min(run, total - pixel);
+        pixel += run;
+        while(run-- > 0){
+            memcpy(row + x * 4, px, 4);
+            if(++x == width){
+                x = 0;
+                row += pitch;
+            }
+        }
+    }
+
+    return pos;
+}
+
+
+
+
+/** Feed
+ * 
+ * Decodes the next chunk of the file. Chunks can be of any size and can
+ * split the header or the ops, the decoder keeps the split part.
+ * 
+ * @param data Next bytes of the file
+ * @param size Number of bytes
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int QOIDecoder::feed(const Uint8* data, size_t size){
+    // HEADER -------------------------------------------------------------------------------
+    if(!header){
+        size_t n = min(size, sizeof(headerBytes) - headerSize);
+        memcpy(headerBytes + headerSize, data, n);
+        headerSize += n;
+        data += n;
+        size -= n;
+
+        if(headerSize < sizeof(headerBytes)) return NO_ERROR;
+
+        int err = parseHeader();
+        if(err != NO_ERROR) return err;
+    }
+
+    if(isDone() || size == 0) return NO_ERROR;
+
+    // FINISH THE OP SPLIT BETWEEN THE CHUNKS -----------------------------------------------
+    if(carrySize > 0){
+        int length = opLength(carry[0]);
+        size_t n = min(size, (size_t)(length - carrySize));
+        memcpy(carry + carrySize, data, n);
+        carrySize += n;
+        data += n;
+        size -= n;
+
+        if(carrySize < length) return NO_ERROR;
+
+        decode(carry, carrySize);
+        carrySize = 0;
+    }
+
+    // PIXELS -------------------------------------------------------------------------------
+    size_t used = decode(data, size);
+    if(!isDone() && used < size){
+        carrySize = size - used;
+        memcpy(carry, data + used, carrySize);
+    }
+
+    return NO_ERROR;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef MySDL_QOI
+#define MySDL_QOI
+
+#include "../lib.h"
+
+
+// QOI DECODER -------------------------------------------------------------------------------------
+// Streaming decoder, the file can be fed in chunks of any size. Once the
+// header is decoded the allocate callback is asked where the pixels go,
+// so they are decoded straight into the buffer the texture is uploaded
+// from, without a surface or a format conversion in between.
+class QOIDecoder{
+    public:
+    // Returns the buffer for the RGBA32 pixels and its pitch, or nullptr to stop
+    using Allocate = function<Uint8*(int width, int height, int& pitch)>;
+
+    QOIDecoder(Allocate allocate);
+
+    int feed(const Uint8* data, size_t size);
+    bool isDone() const { return header && pixel == total; }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getChannels() const { return channels; }
+
+    private:
+    Allocate allocate;
+
+    Uint8 headerBytes[14];
+    size_t headerSize = 0;
+    bool header = false;
+    int width = 0, height = 0, channels = 0;
+
+    Uint8* out = nullptr;
+    int pitch = 0;
+    size_t pixel = 0;       // Pixels decoded so far
+    size_t total = 0;
+
+    Uint8 index[64][4] = {};
+    Uint8 px[4] = {0, 0, 0, 255};
+
+    Uint8 carry[5];         // Start of an op split between two chunks
+    int carrySize = 0;
+
+    int parseHeader();
+    size_t decode(const Uint8* data, size_t size);
+};
+
+
+
+// The "Quite OK Image" format, lossless like PNG but encoded and decoded
+// many times faster, since it is a single pass over the pixels without
+// any entropy coding. Used for the frame captures and texture dumps.
+// Pixels are always RGBA32, R, G, B, A in memory.
+class QOI{
+    public:
+    static void encode(const Uint8* rgba, int width, int height, vector<Uint8>& out);
+    static int save(const string& path, const Uint8* rgba, int width, int height);
+
+    static bool isQOI(const string& path);
+    static int load(const string& path, vector<Uint8>& pixels, int& width, int& height);
+};
+
+#endif
+// Creator: @AndrijaRD
@@ -0,0 +1,481 @@
+#include "./Raster.h"
+#include "../System/Sys.h"
+#include "../Pixel/Pixel.h"
+#include "../Jobs/Jobs.h"
+
+
+
+// Exact round(a * b / 255) for a, b in [0, 255]
+static inline Uint8 mulDiv255(int a, int b){
+    int t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+
+static inline SDL_Color premultiplied(const SDL_Color& c){
+    return {mulDiv255(c.r, c.a), mulDiv255(c.g, c.a), mulDiv255(c.b, c.a), c.a};
+}
+
+
+
+
+// RASTER IMAGE ------------------------------------------------------------------------------------
+
+/** Load
+ * 
+ * Loads the image file into premultiplied pixels.
+ * 
+ * @param path Path of the image, any format IMG_Load supports
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int RasterImage::load(const string& path){
+    SDL_Surface* surface = IMG_Load(path.c_str());
+    if(surface == nullptr) return RASTER_LOAD_FAILED;
+
+    int err = fromSurface(surface);
+    SDL_FreeSurface(surface);
+    return err;
+}
+
+
+
+
+/** From Surface
+ * 
+ * Copies the surface into premultiplied pixels, the surface is left to the caller to free.
+ * 
+ * @param surface Surface of any format
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int RasterImage::fromSurface(SDL_Surface* surface){
+    SDL_Surface* converted = Pixel::convertToRGBA32(surface);
+    if(converted == nullptr) return TM_SURFACE_CONVERT_ERROR;
+
+    width = converted->w;
+    height = converted->h;
+    pixels.resize((size_t)width * height * 4);
+    for(int y = 0; y < height; y++){
+        Pixel::premultiply(
+            (const Uint8*)converted->pixels + (size_t)y * converted->pitch,
+            &pixels[(size_t)y * width * 4],
+            width
+        );
+    }
+
+    SDL_FreeSurface(converted);
+    return NO_ERROR;
+}
+
+
+
+
+
+// RASTER CANVAS -----------------------------------------------------------------------------------
+
+/** Raster Canvas
+ * 
+ * @param width Width of the canvas in pixels, usually Sys::winWidth
+ * @param height Height of the canvas in pixels, usually Sys::winHeight
+ */
+RasterCanvas::RasterCanvas(int width, int height){
+    resize(width, height);
+}
+
+
+
+
+RasterCanvas::~RasterCanvas(){
+    TM::freeTexture(td);
+}
+
+
+
+
+/** Resize
+ * 
+ * Changes the size of the canvas, the recorded draws are dropped
+ * and the pixels have to be cleared again.
+ * 
+ * @param width Width of the canvas in pixels
+ * @param height Height of the canvas in pixels
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int RasterCanvas::resize(int width, int height){
+    if(width < 1 || height < 1) return RASTER_INVALID_SIZE;
+
+    this->width = width;
+    this->height = height;
+    pixels.assign((size_t)width * height * 4, 0);
+
+    tilesX = (width + TILE - 1) / TILE;
+    tilesY = (height + TILE - 1) / TILE;
+    commands.clear();
+    bins.assign((size_t)tilesX * tilesY, vector<int>());
+    return NO_ERROR;
+}
+
+
+
+
+/** Add
+ * 
+ * INTERNAL USE
+ * 
+ * Records the command, clipped to the canvas, into the bins of the tiles it touches.
+ */
+void RasterCanvas::add(const Command& command){
+    SDL_Rect canvas = {0, 0, width, height};
+    SDL_Rect bounds;
+    if(!SDL_IntersectRect(&command.bounds, &canvas, &bounds)) return;
+
+    int index = commands.size();
+    commands.push_back(command);
+    commands.back().bounds = bounds;
+
+    int tx0 = bounds.x / TILE, tx1 = (bounds.x + bounds.w - 1) / TILE;
+    int ty0 = bounds.y / TILE, ty1 = (bounds.y + bounds.h - 1) / TILE;
+    for(int ty = ty0; ty <= ty1; ty++){
+        for(int tx = tx0; tx <= tx1; tx++) bins[(size_t)ty * tilesX + tx].push_back(index);
+    }
+}
+
+
+
+
+/** Clear
+ * 
+ * Fills the whole canvas with the color, the draws recorded before it are dropped.
+ * 
+ * @param color Color of the canvas
+ */
+void RasterCanvas::clear(const SDL_Color& color){
+    commands.clear();
+    for(vector<int>& bin : bins) bin.clear();
+
+    Command command = {};
+    command.type = RASTER_CLEAR;
+    command.bounds = {0, 0, width, height};
+    command.color = premultiplied(color);
+    add(command);
+}
+
+
+
+
+/** Fill Rect
+ * 
+ * @param rect Rect to be filled
+ * @param color Color of the rect, blended over the canvas
+ */
+void RasterCanvas::fillRect(const SDL_Rect& rect, const SDL_Color& color){
+    if(color.a == 0) return;
+
+    Command command = {};
+    command.type = RASTER_FILL;
+    command.bounds = rect;
+    command.color = premultiplied(color);
+    add(command);
+}
+
+
+
+
+/** Blit
+ * 
+ * Draws the image scaled into the dst rect, with nearest sampling
+ * like SDL does by default. The image must live until the flush.
+ * 
+ * @param image Image to be drawn
+ * @param src Part of the image, nullptr for the whole image
+ * @param dst Where to draw it on the canvas
+ * @param alpha Opacity of the whole image
+ */
+void RasterCanvas::blit(const RasterImage& image, const SDL_Rect* src, const SDL_Rect& dst, Uint8 alpha){
+    if(alpha == 0 || dst.w <= 0 || dst.h <= 0) return;
+
+    SDL_Rect whole = {0, 0, image.width, image.height};
+    SDL_Rect part;
+    if(!SDL_IntersectRect(src != nullptr ? src : &whole, &whole, &part)) return;
+
+    Command command = {};
+    command.type = RASTER_BLIT;
+    command.bounds = dst;
+    command.image = &image;
+    command.src = part;
+    command.dst = dst;
+    command.alpha = alpha;
+    add(command);
+}
+
+
+
+
+/** Geometry
+ * 
+ * Draws untextured triangles, the same way SDL_RenderGeometry does
+ * with a nullptr texture, like the lines of PolylineMesh.
+ * 
+ * @param vertices Vertices of the triangles, the colors are straight alpha
+ * @param count Number of vertices
+ * @param indices Three per triangle, or nullptr to take the vertices in order
+ * @param indexCount Number of indices
+ */
+void RasterCanvas::geometry(const SDL_Vertex* vertices, int count, const int* indices, int indexCount){
+    int total = indices != nullptr ? indexCount : count;
+
+    for(int t = 0; t + 2 < total; t += 3){
+        const SDL_Vertex* v[3];
+        for(int k = 0; k < 3; k++){
+            int i = indices != nullptr ? indices[t + k] : t + k;
+            if(i < 0 || i >= count) return;
+            v[k] = &vertices[i];
+        }
+
+        float area = (v[1]->position.x - v[0]->position.x) * (v[2]->position.y - v[0]->position.y)
+                   - (v[1]->position.y - v[0]->position.y) * (v[2]->position.x - v[0]->position.x);
+        if(area == 0) continue;
+        if(area < 0) std::swap(v[1], v[2]);     // Always clockwise on the screen
+
+        Command command = {};
+        command.type = RASTER_TRIANGLE;
+
+        float x0 = INFINITY, y0 = INFINITY, x1 = -INFINITY, y1 = -INFINITY;
+        for(int k = 0; k < 3; k++){
+            command.p[k] = v[k]->position;
+            command.colors[k] = premultiplied(v[k]->color);
+            x0 = min(x0, command.p[k].x);
+            y0 = min(y0, command.p[k].y);
+            x1 = max(x1, command.p[k].x);
+            y1 = max(y1, command.p[k].y);
+        }
+        if(command.colors[0].a == 0 && command.colors[1].a == 0 && command.colors[2].a == 0) continue;
+
+        command.flat = !memcmp(&command.colors[0], &command.colors[1], sizeof(SDL_Color))
+                    && !memcmp(&command.colors[0], &command.colors[2], sizeof(SDL_Color));
+
+        // Far outside of the canvas, dont let the conversion overflow
+        x0 = max(x0, -1.0f); y0 = max(y0, -1.0f);
+        x1 = min(x1, (float)width + 1); y1 = min(y1, (float)height + 1);
+        if(x1 < x0 || y1 < y0) continue;
+
+        command.bounds = {(int)floorf(x0), (int)floorf(y0), (int)ceilf(x1) - (int)floorf(x0) + 1, (int)ceilf(y1) - (int)floorf(y0) + 1};
+        add(command);
+    }
+}
+
+
+
+
+/** Draw Blit
+ * 
+ * INTERNAL USE
+ */
+void RasterCanvas::drawBlit(const Command& command, const SDL_Rect& clip){
+    const RasterImage& image = *command.image;
+    const SDL_Rect& src = command.src;
+    const SDL_Rect& dst = command.dst;
+
+    Uint8 row[TILE * 4];
+    const SDL_Color fade = {command.alpha, command.alpha, command.alpha, command.alpha};
+    bool unscaled = src.w == dst.w && src.h == dst.h;
+
+    for(int y = clip.y; y < clip.y + clip.h; y++){
+        // Sampling at the pixel centers
+        int sy = src.y + (int)(((Sint64)(y - dst.y) * 2 + 1) * src.h / (2 * dst.h));
+        const Uint8* line = &image.pixels[(size_t)sy * image.width * 4];
+        Uint8* out = &pixels[((size_t)y * width + clip.x) * 4];
+
+        if(unscaled && command.alpha == 255){
+            Pixel::blend(line + (size_t)(src.x + clip.x - dst.x) * 4, out, clip.w);
+            continue;
+        }
+
+        for(int x = 0; x < clip.w; x++){
+            int sx = src.x + (int)(((Sint64)(clip.x + x - dst.x) * 2 + 1) * src.w / (2 * dst.w));
+            memcpy(row + x * 4, line + (size_t)sx * 4, 4);
+        }
+        if(command.alpha != 255) Pixel::tint(row, row, clip.w, fade);
+        Pixel::blend(row, out, clip.w);
+    }
+}
+
+
+
+
+/** Draw Triangle
+ * 
+ * INTERNAL USE
+ * 
+ * Fills the pixels whose centers are inside the triangle, with the top-left
+ * rule on the edges, so triangles sharing an edge never blend it twice.
+ */
+void RasterCanvas::drawTriangle(const Command& command, const SDL_Rect& clip){
+    // Edge functions E(x, y) = a*x + b*y + c, positive inside
+    float a[3], b[3], c[3];
+    bool inclusive[3];
+    for(int k = 0; k < 3; k++){
+        const SDL_FPoint& p = command.p[k];
+        const SDL_FPoint& q = command.p[(k + 1) % 3];
+        a[k] = -(q.y - p.y);
+        b[k] = q.x - p.x;
+        c[k] = -(a[k] * p.x + b[k] * p.y);
+        inclusive[k] = a[k] > 0 || (a[k] == 0 && b[k] > 0);     // Left and top edges
+    }
+    float area = a[0] * command.p[2].x + b[0] * command.p[2].y + c[0];
+
+    Uint8 row[TILE * 4];
+    for(int y = clip.y; y < clip.y + clip.h; y++){
+        float yc = y + 0.5f;
+
+        // SPAN OF THE ROW ------------------------------------------------------------------
+        int lo = clip.x, hi = clip.x + clip.w;
+        for(int k = 0; k < 3 && lo < hi; k++){
+            float v = b[k] * yc + c[k];
+            if(a[k] == 0){
+                if(v < 0 || (v == 0 && !inclusive[k])) hi = lo;
+                continue;
+            }
+
+            // Where the edge crosses the row, in pixel center coordinates
+            float t = -v / a[k] - 0.5f;
+            if(a[k] > 0){
+                int first = inclusive[k] ? (int)ceilf(t) : (int)floorf(t) + 1;
+                lo = max(lo, first);
+            }
+            else{
+                int last = inclusive[k] ? (int)floorf(t) + 1 : (int)ceilf(t);
+                hi = min(hi, last);
+            }
+        }
+        if(lo >= hi) continue;
+
+        Uint8* out = &pixels[((size_t)y * width + lo) * 4];
+        if(command.flat){
+            Pixel::fill(out, hi - lo, command.colors[0]);
+            continue;
+        }
+
+        // GOURAUD ------------------------------------------------------------------------
+        // Each vertex weighted by the edge opposite to it
+        for(int x = lo; x < hi; x++){
+            float xc = x + 0.5f;
+            float w0 = (a[1] * xc + b[1] * yc + c[1]) / area;
+            float w1 = (a[2] * xc + b[2] * yc + c[2]) / area;
+            float w2 = 1.0f - w0 - w1;
+
+            const SDL_Color* col = command.colors;
+            Uint8* px = row + (x - lo) * 4;
+            px[0] = (Uint8)min(255.0f, max(0.0f, col[0].r * w0 + col[1].r * w1 + col[2].r * w2 + 0.5f));
+            px[1] = (Uint8)min(255.0f, max(0.0f, col[0].g * w0 + col[1].g * w1 + col[2].g * w2 + 0.5f));
+            px[2] = (Uint8)min(255.0f, max(0.0f, col[0].b * w0 + col[1].b * w1 + col[2].b * w2 + 0.5f));
+            px[3] = (Uint8)min(255.0f, max(0.0f, col[0].a * w0 + col[1].a * w1 + col[2].a * w2 + 0.5f));
+        }
+        Pixel::blend(row, out, hi - lo);
+    }
+}
+
+
+
+
+/** Rasterize
+ * 
+ * INTERNAL USE
+ * 
+ * Runs the commands binned into the tile, in the order they were recorded.
+ * 
+ * @param tile Index of the tile
+ */
+void RasterCanvas::rasterize(int tile){
+    int tx = tile % tilesX, ty = tile / tilesX;
+    SDL_Rect area = {tx * TILE, ty * TILE, min(TILE, width - tx * TILE), min(TILE, height - ty * TILE)};
+
+    for(int index : bins[tile]){
+        const Command& command = commands[index];
+
+        SDL_Rect clip;
+        if(!SDL_IntersectRect(&command.bounds, &area, &clip)) continue;
+
+        switch(command.type){
+            case RASTER_CLEAR: {
+                Uint32 color;
+                memcpy(&color, &command.color, 4);
+                for(int y = clip.y; y < clip.y + clip.h; y++){
+                    Uint32* out = (Uint32*)&pixels[((size_t)y * width + clip.x) * 4];
+                    std::fill(out, out + clip.w, color);
+                }
+                break;
+            }
+            case RASTER_FILL:
+                for(int y = clip.y; y < clip.y + clip.h; y++){
+                    Pixel::fill(&pixels[((size_t)y * width + clip.x) * 4], clip.w, command.color);
+                }
+                break;
+            case RASTER_BLIT:
+                drawBlit(command, clip);
+                break;
+            case RASTER_TRIANGLE:
+                drawTriangle(command, clip);
+                break;
+        }
+    }
+}
+
+
+
+
+/** Flush
+ * 
+ * Rasterizes the recorded draws, the tiles are split across the jobs.
+ * 
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int RasterCanvas::flush(){
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    // Only the tiles with something to draw
+    vector<int> tiles;
+    for(int i = 0; i < (int)bins.size(); i++){
+        if(!bins[i].empty()) tiles.push_back(i);
+    }
+
+    Jobs::parallelFor(tiles.size(), [&](int begin, int end){
+        for(int i = begin; i < end; i++) rasterize(tiles[i]);
+    });
+
+    stats.commands = commands.size();
+    stats.tiles = tiles.size();
+    stats.flushMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    commands.clear();
+    for(vector<int>& bin : bins) bin.clear();
+    return NO_ERROR;
+}
+
+
+
+
+/** Present
+ * 
+ * Flushes the draws and renders the canvas, uploaded into a streaming texture.
+ * 
+ * @param dr Where to draw the canvas, nullptr for its own size at the top-left corner
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int RasterCanvas::present(const SDL_Rect* dr){
+    int err = flush();
+    if(err != NO_ERROR) return err;
+
+    if(td.tex == nullptr || td.width != width || td.height != height){
+        err = TM::acquireTexture(td, width, height, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING);
+        if(err != NO_ERROR) return err;
+    }
+
+    SDL_Texture* tex = TM::resolve(td);
+    if(SDL_SetTextureBlendMode(tex, TM::getPremultipliedBlendMode())) return TM_TEXTURE_SET_BLENDMODE_ERROR;
+
+    SDL_Rect area = {0, 0, width, height};
+    if(SDL_UpdateTexture(tex, &area, pixels.data(), width * 4)) return TM_TEXTURE_UPDATE_ERROR;
+
+    SDL_Rect rect = dr != nullptr ? *dr : area;
+    return TM::renderTexture(td, rect);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#ifndef MySDL_RASTER
+#define MySDL_RASTER
+
+#include "../lib.h"
+#include "../TextureManager/TM.h"
+
+
+// RASTER IMAGE ------------------------------------------------------------------------------------
+// Premultiplied RGBA32 pixels kept on the CPU, drawn by RasterCanvas::blit
+struct RasterImage{
+    vector<Uint8> pixels;
+    int width = 0;
+    int height = 0;
+
+    int load(const string& path);
+    int fromSurface(SDL_Surface* surface);
+};
+
+
+
+// RASTER STATS ------------------------------------------------------------------------------------
+struct RasterStats{
+    int commands = 0;           // Commands drawn by the last flush
+    int tiles = 0;              // Tiles touched by them
+    double flushMs = 0;         // Time the last flush took
+};
+
+
+
+// RASTER CANVAS -----------------------------------------------------------------------------------
+// A CPU render target for the machines without a GPU, where SDL falls back
+// to its generic software renderer. The draws are only recorded and binned
+// into tiles of 64x64 pixels, flush() then rasterizes the tiles in parallel
+// on the jobs, each tile running its commands in order with the SIMD blend
+// kernels of Pixel. present() uploads the result with one SDL_UpdateTexture.
+// Everything is premultiplied, like TM::getPremultipliedBlendMode.
+class RasterCanvas{
+    public:
+    RasterCanvas(int width, int height);
+    RasterCanvas(const RasterCanvas&) = delete;
+    RasterCanvas& operator=(const RasterCanvas&) = delete;
+    ~RasterCanvas();
+
+    int resize(int width, int height);
+
+    void clear(const SDL_Color& color);
+    void fillRect(const SDL_Rect& rect, const SDL_Color& color);
+    void blit(const RasterImage& image, const SDL_Rect* src, const SDL_Rect& dst, Uint8 alpha = 255);
+    void geometry(const SDL_Vertex* vertices, int count, const int* indices = nullptr, int indexCount = 0);
+
+    int flush();
+    int present(const SDL_Rect* dr = nullptr);
+
+    const Uint8* getPixels() const { return pixels.data(); }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    RasterStats getStats() const { return stats; }
+
+    private:
+    static const int TILE = 64;
+
+    enum CommandType{ RASTER_CLEAR, RASTER_FILL, RASTER_BLIT, RASTER_TRIANGLE };
+
+    struct Command{
+        CommandType type;
+        SDL_Rect bounds;                // Pixels it can touch, within the canvas
+        SDL_Color color;                // Premultiplied, for clear and fill
+
+        const RasterImage* image;       // Blit
+        SDL_Rect src, dst;
+        Uint8 alpha;
+
+        SDL_FPoint p[3];                // Triangle, in clockwise order on the screen
+        SDL_Color colors[3];            // Premultiplied
+        bool flat;                      // All three colors are the same
+    };
+
+    int width = 0, height = 0;
+    vector<Uint8> pixels;
+
+    int tilesX = 0, tilesY = 0;
+    vector<Command> commands;
+    vector<vector<int>> bins;           // Commands touching each tile, in order
+
+    TextureData td;                     // The canvas is presented trough it
+    RasterStats stats;
+
+    void add(const Command& command);
+    void rasterize(int tile);
+    void drawBlit(const Command& command, const SDL_Rect& clip);
+    void drawTriangle(const Command& command, const SDL_Rect& clip);
+};
+
+#endif
+// Creator: @AndrijaRD
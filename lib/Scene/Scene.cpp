@@ -0,0 +1,400 @@
+#include "./Scene.h"
+#include "../System/Sys.h"
+
+
+
+// CAMERA ------------------------------------------------------------------------------------------
+
+/** To Screen
+ * 
+ * @param world Position in the world
+ * @return Position of it on the screen
+ */
+SDL_FPoint Camera::toScreen(const SDL_FPoint& world) const{
+    return {
+        viewport.x + (world.x - position.x) * zoom,
+        viewport.y + (world.y - position.y) * zoom
+    };
+}
+
+
+
+
+/** To World
+ * 
+ * @param screen Position on the screen, like the mouse position
+ * @return Position of it in the world
+ */
+SDL_FPoint Camera::toWorld(const SDL_FPoint& screen) const{
+    return {
+        position.x + (screen.x - viewport.x) / zoom,
+        position.y + (screen.y - viewport.y) / zoom
+    };
+}
+
+
+
+
+/** Get View
+ * 
+ * @return Part of the world seen trough the camera
+ */
+SDL_FRect Camera::getView() const{
+    int w = viewport.w > 0 ? viewport.w : Sys::winWidth;
+    int h = viewport.h > 0 ? viewport.h : Sys::winHeight;
+    return {position.x, position.y, w / zoom, h / zoom};
+}
+
+
+
+
+
+// SCENE -------------------------------------------------------------------------------------------
+
+/** Scene
+ * 
+ * @param cellSize Size of a grid cell in world units, around the size of
+ *                 the objects or a bit larger works best, the objects
+ *                 larger than it are tested by every query
+ */
+Scene::Scene(float cellSize) : cellSize(max(cellSize, 1.0f)) {}
+
+
+
+
+/** Cell Of
+ * 
+ * INTERNAL USE
+ * 
+ * @return Key of the grid cell holding the center of the rect
+ */
+Uint64 Scene::cellOf(const SDL_FRect& rect) const{
+    Sint32 cx = (Sint32)floorf((rect.x + rect.w / 2) / cellSize);
+    Sint32 cy = (Sint32)floorf((rect.y + rect.h / 2) / cellSize);
+    return ((Uint64)(Uint32)cx << 32) | (Uint32)cy;
+}
+
+
+
+
+/** Insert
+ * 
+ * INTERNAL USE
+ * 
+ * Puts the object into the cell holding its center, or into largeIds if it is larger than a cell.
+ */
+void Scene::insert(int id){
+    Object& object = objects[id];
+    object.large = isLarge(object.rect);
+    object.cell = cellOf(object.rect);
+
+    vector<int>& cell = object.large ? largeIds : cells[object.cell];
+    object.slot = cell.size();
+    cell.push_back(id);
+}
+
+
+
+
+/** Unlink
+ * 
+ * INTERNAL USE
+ * 
+ * Takes the object out of its cell, moving the last object of the cell into its slot.
+ */
+void Scene::unlink(int id){
+    Object& object = objects[id];
+    if(object.large){
+        int last = largeIds.back();
+        largeIds[object.slot] = last;
+        objects[last].slot = object.slot;
+        largeIds.pop_back();
+        return;
+    }
+
+    auto it = cells.find(object.cell);
+    vector<int>& cell = it->second;
+
+    int last = cell.back();
+    cell[object.slot] = last;
+    objects[last].slot = object.slot;
+    cell.pop_back();
+
+    if(cell.empty()) cells.erase(it);
+}
+
+
+
+
+/** Add
+ * 
+ * Adds an object to the scene.
+ * 
+ * @param td Texture of the object, it must outlive the object
+ * @param rect Where the object is in the world
+ * @param layer Objects on higher layers are drawn over the lower ones,
+ *              within a layer they are drawn in the order they were added
+ * @return Id of the object, used to change it later
+ */
+int Scene::add(const TextureData& td, const SDL_FRect& rect, int layer){
+    int id;
+    if(!freeIds.empty()){
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else{
+        id = objects.size();
+        objects.emplace_back();
+    }
+
+    Object& object = objects[id];
+    object.td = td;
+    object.rect = rect;
+    object.layer = layer;
+    object.visible = true;
+    object.alive = true;
+    object.order = nextOrder++;
+
+    insert(id);
+    count++;
+    return id;
+}
+
+
+
+
+/** Remove
+ * 
+ * Removes the object, its id can be given to a newly added object.
+ * 
+ * @param id Id returned by Scene::add
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Scene::remove(int id){
+    if(!isValid(id)) return SCENE_INVALID_OBJECT;
+
+    unlink(id);
+    objects[id].alive = false;
+    objects[id].td = TextureData();
+    freeIds.push_back(id);
+    count--;
+    return NO_ERROR;
+}
+
+
+
+
+/** Move
+ * 
+ * Moves the top-left corner of the object. While it stays in the same
+ * grid cell only the position changes, otherwise it goes into the new cell.
+ * 
+ * @param id Id returned by Scene::add
+ * @param x New x in the world
+ * @param y New y in the world
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Scene::move(int id, float x, float y){
+    if(!isValid(id)) return SCENE_INVALID_OBJECT;
+
+    SDL_FRect rect = objects[id].rect;
+    rect.x = x;
+    rect.y = y;
+    return setRect(id, rect);
+}
+
+
+
+
+/** Set Rect
+ * 
+ * Moves and resizes the object.
+ * 
+ * @param id Id returned by Scene::add
+ * @param rect Where the object is in the world
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Scene::setRect(int id, const SDL_FRect& rect){
+    if(!isValid(id)) return SCENE_INVALID_OBJECT;
+
+    Object& object = objects[id];
+    object.rect = rect;
+
+    if(isLarge(rect) != object.large || (!object.large && cellOf(rect) != object.cell)){
+        unlink(id);
+        insert(id);
+    }
+    return NO_ERROR;
+}
+
+
+
+
+/** Set Texture
+ * 
+ * @param id Id returned by Scene::add
+ * @param td New texture of the object, it must outlive the object
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Scene::setTexture(int id, const TextureData& td){
+    if(!isValid(id)) return SCENE_INVALID_OBJECT;
+
+    objects[id].td = td;
+    return NO_ERROR;
+}
+
+
+
+
+/** Set Visible
+ * 
+ * Hidden objects stay in the scene, but are not drawn or returned by Scene::query.
+ * 
+ * @param id Id returned by Scene::add
+ * @param visible Should the object be drawn
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Scene::setVisible(int id, bool visible){
+    if(!isValid(id)) return SCENE_INVALID_OBJECT;
+
+    objects[id].visible = visible;
+    return NO_ERROR;
+}
+
+
+
+
+/** Get Rect
+ * 
+ * @param id Id returned by Scene::add
+ * @return Where the object is in the world, or nullptr if there is no such object
+ */
+const SDL_FRect* Scene::getRect(int id) const{
+    if(!isValid(id)) return nullptr;
+    return &objects[id].rect;
+}
+
+
+
+
+/** Clear
+ * 
+ * Removes all the objects.
+ */
+void Scene::clear(){
+    objects.clear();
+    freeIds.clear();
+    cells.clear();
+    largeIds.clear();
+    nextOrder = 0;
+    count = 0;
+}
+
+
+
+
+/** Query
+ * 
+ * Finds the visible objects overlapping the area. Only the grid cells
+ * around the area are looked at, widened by half a cell since an object in
+ * the grid can stick out of the cell holding its center by that much, and
+ * the objects larger than a cell.
+ * 
+ * @param area Part of the world
+ * @param ids Filled with the ids of the objects, in no particular order
+ * @return Number of objects found
+ */
+int Scene::query(const SDL_FRect& area, vector<int>& ids) const{
+    ids.clear();
+    if(count == 0) return 0;
+
+    auto overlaps = [&](const SDL_FRect& r){
+        return r.x < area.x + area.w && r.x + r.w > area.x
+            && r.y < area.y + area.h && r.y + r.h > area.y;
+    };
+    auto collect = [&](const vector<int>& cell){
+        for(int id : cell){
+            const Object& object = objects[id];
+            if(object.visible && overlaps(object.rect)) ids.push_back(id);
+        }
+    };
+
+    collect(largeIds);
+    if(cells.empty()) return ids.size();
+
+    float margin = cellSize / 2;
+    int cx0 = (int)floorf((area.x - margin) / cellSize);
+    int cy0 = (int)floorf((area.y - margin) / cellSize);
+    int cx1 = (int)floorf((area.x + area.w + margin) / cellSize);
+    int cy1 = (int)floorf((area.y + area.h + margin) / cellSize);
+
+    // Zoomed far out, going trough the occupied cells is cheaper then looking up every cell in the area
+    if((Uint64)(cx1 - cx0 + 1) * (cy1 - cy0 + 1) > cells.size()){
+        for(const auto& [key, cell] : cells){
+            int cx = (Sint32)(key >> 32), cy = (Sint32)(Uint32)key;
+            if(cx >= cx0 && cx <= cx1 && cy >= cy0 && cy <= cy1) collect(cell);
+        }
+        return ids.size();
+    }
+
+    for(int cy = cy0; cy <= cy1; cy++){
+        for(int cx = cx0; cx <= cx1; cx++){
+            auto it = cells.find(((Uint64)(Uint32)cx << 32) | (Uint32)cy);
+            if(it != cells.end()) collect(it->second);
+        }
+    }
+    return ids.size();
+}
+
+
+
+
+/** Render
+ * 
+ * Draws the objects seen trough the camera, clipped to its viewport.
+ * Objects outside of the view are culled before anything reaches SDL.
+ * 
+ * @param camera Camera to look trough
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Scene::render(const Camera& camera){
+    drawn = 0;
+    if(camera.zoom <= 0) return TM_INVALID_DRECT;
+
+    SDL_FRect view = camera.getView();
+    if(view.w <= 0 || view.h <= 0) return TM_INVALID_DRECT;
+    if(query(view, visibleIds) == 0) return NO_ERROR;
+
+    std::sort(visibleIds.begin(), visibleIds.end(), [&](int a, int b){
+        if(objects[a].layer != objects[b].layer) return objects[a].layer < objects[b].layer;
+        return objects[a].order < objects[b].order;
+    });
+
+    SDL_Rect viewport = camera.viewport;
+    if(viewport.w <= 0 || viewport.h <= 0) viewport = {0, 0, Sys::winWidth, Sys::winHeight};
+
+    SDL_Rect previousClip;
+    bool clipped = SDL_RenderIsClipEnabled(Sys::renderer);
+    SDL_RenderGetClipRect(Sys::renderer, &previousClip);
+    SDL_RenderSetClipRect(Sys::renderer, &viewport);
+
+    int error = NO_ERROR;
+    for(int id : visibleIds){
+        const Object& object = objects[id];
+
+        // Both edges are rounded, so objects placed side by side never leave a gap
+        SDL_FPoint a = camera.toScreen({object.rect.x, object.rect.y});
+        SDL_FPoint b = camera.toScreen({object.rect.x + object.rect.w, object.rect.y + object.rect.h});
+        int x0 = (int)lroundf(a.x), y0 = (int)lroundf(a.y);
+
+        SDL_Rect dr = {x0, y0, (int)lroundf(b.x) - x0, (int)lroundf(b.y) - y0};
+        if(dr.w <= 0 || dr.h <= 0) continue;
+
+        int err = TM::renderTexture(object.td, dr);
+        if(err != NO_ERROR) error = err;
+        drawn++;
+    }
+
+    SDL_RenderSetClipRect(Sys::renderer, clipped ? &previousClip : nullptr);
+    return error;
+}
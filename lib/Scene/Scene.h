@@ -0,0 +1,84 @@
+#pragma once
+#ifndef MySDL_SCENE
+#define MySDL_SCENE
+
+#include "../lib.h"
+#include "../TextureManager/TM.h"
+
+
+// CAMERA ------------------------------------------------------------------------------------------
+// Shows the world from the position, at the top-left corner of the viewport
+struct Camera{
+    SDL_FPoint position = {0, 0};   // World position at the top-left corner of the viewport
+    float zoom = 1.0f;              // 2 makes everything twice as big
+    SDL_Rect viewport = {0, 0, 0, 0};   // Where on the screen the world is shown, empty for the whole window
+
+    SDL_FPoint toScreen(const SDL_FPoint& world) const;
+    SDL_FPoint toWorld(const SDL_FPoint& screen) const;
+    SDL_FRect getView() const;
+};
+
+
+
+// SCENE -------------------------------------------------------------------------------------------
+// A container of textured objects placed in the world, drawn trough a
+// camera. Objects are kept in a loose grid, each one in the cell holding
+// its center, so only the cells around the view are looked at and the
+// objects outside of it never reach SDL. Moving an object within its cell
+// doesnt touch the grid at all, moving it to another cell is O(1). Objects
+// larger than a cell are kept out of the grid, in a list every query tests,
+// so a single huge object doesnt make every query look at more cells.
+class Scene{
+    public:
+    Scene(float cellSize = 256);
+
+    int add(const TextureData& td, const SDL_FRect& rect, int layer = 0);
+    int remove(int id);
+    int move(int id, float x, float y);
+    int setRect(int id, const SDL_FRect& rect);
+    int setTexture(int id, const TextureData& td);
+    int setVisible(int id, bool visible);
+    const SDL_FRect* getRect(int id) const;
+    void clear();
+
+    int query(const SDL_FRect& area, vector<int>& ids) const;
+    int render(const Camera& camera);
+
+    int getCount() const { return count; }
+    int getDrawnCount() const { return drawn; }
+
+    private:
+    struct Object{
+        TextureData td;         // Not owned
+        SDL_FRect rect;
+        int layer = 0;
+        bool visible = true;
+        bool alive = false;
+
+        Uint64 order = 0;       // When it was added, ids are reused so they cant order the drawing
+        bool large = false;     // Larger than a cell, kept in largeIds instead of the grid
+        Uint64 cell = 0;        // Grid cell holding the center
+        int slot = 0;           // Index in the vector of that cell, or in largeIds
+    };
+
+    float cellSize;
+
+    vector<Object> objects;
+    vector<int> freeIds;        // Pooled slots of removed objects
+    unordered_map<Uint64, vector<int>> cells;
+    vector<int> largeIds;       // Objects larger than a cell, tested by every query
+    Uint64 nextOrder = 0;
+    int count = 0;
+
+    vector<int> visibleIds;     // Reused by render
+    int drawn = 0;              // Objects drawn by the last render
+
+    bool isValid(int id) const { return id >= 0 && id < (int)objects.size() && objects[id].alive; }
+    Uint64 cellOf(const SDL_FRect& rect) const;
+    bool isLarge(const SDL_FRect& rect) const { return rect.w > cellSize || rect.h > cellSize; }
+    void insert(int id);
+    void unlink(int id);
+};
+
+#endif
+// Creator: @AndrijaRD
@@ -1,4 +1,9 @@
 #include "./Sys.h"
+#include "../TextureManager/TM.h"
+#include "../Jobs/Jobs.h"
+#include "../Capture/Capture.h"
+#include "../FrameSink/FrameSink.h"
+#include "../Text/Text.h"
 
 
 unordered_map<int, string> Sys::errorMap = {
@@ -25,6 +30,14 @@ unordered_map<int, string> Sys::errorMap = {
     {TM_RCLR_FAILED,                    "TM_RCLR_FAILED"},
     {TM_FILL_RECT_ERROR,                "TM_FILL_RECT_ERROR"},
     {TM_INVALID_LINE_LENGTH,            "TM_INVALID_LINE_LENGTH"},
+    {TM_READ_PIXELS_FAILED,             "TM_READ_PIXELS_FAILED"},
+    {TM_COMPRESSION_ERROR,              "TM_COMPRESSION_ERROR"},
+    {TM_STREAM_LOCK_ERROR,              "TM_STREAM_LOCK_ERROR"},
+    {TM_VARIANT_PENDING,                "TM_VARIANT_PENDING"},
+    {TM_OVERLAY_ENDED,                  "TM_OVERLAY_ENDED"},
+    {TM_RENDER_GEOMETRY_FAILED,         "TM_RENDER_GEOMETRY_FAILED"},
+    {TM_SAVE_FAILED,                    "TM_SAVE_FAILED"},
+    {TM_SOURCE_CHANGED,                 "TM_SOURCE_CHANGED"},
     
 
     {DB_CONNECTION_ERROR,               "DB_CONNECTION_ERROR"},
@@ -34,7 +47,53 @@ unordered_map<int, string> Sys::errorMap = {
     {DB_INVALID_RESULT,                 "DB_INVALID_RESULT"},
     {DB_INVALID_ROW_COLUMN,             "DB_INVALID_ROW_COLUMN"},
     {DB_INVALID_RES_VALUE,              "DB_INVALID_RES_VALUE"},
-    {DB_EMPTY_STATEMENT_PARAM,          "DB_EMPTY_STATEMENT_PARAM"}
+    {DB_EMPTY_STATEMENT_PARAM,          "DB_EMPTY_STATEMENT_PARAM"},
+    {DB_TEXTURE_PENDING,                "DB_TEXTURE_PENDING"},
+
+    {PLOT_RENDER_GEOMETRY_FAILED,       "PLOT_RENDER_GEOMETRY_FAILED"},
+    {PLOT_INVALID_VIEW,                 "PLOT_INVALID_VIEW"},
+
+    {QOI_WRITE_ERROR,                   "QOI_WRITE_ERROR"},
+    {QOI_READ_ERROR,                    "QOI_READ_ERROR"},
+    {QOI_INVALID_HEADER,                "QOI_INVALID_HEADER"},
+    {QOI_TRUNCATED,                     "QOI_TRUNCATED"},
+
+    {CAPTURE_READ_PIXELS_FAILED,        "CAPTURE_READ_PIXELS_FAILED"},
+    {CAPTURE_ENCODE_ERROR,              "CAPTURE_ENCODE_ERROR"},
+    {CAPTURE_INVALID_FORMAT,            "CAPTURE_INVALID_FORMAT"},
+
+    {PARTICLE_RENDER_GEOMETRY_FAILED,   "PARTICLE_RENDER_GEOMETRY_FAILED"},
+    {PARTICLE_INVALID_EMITTER,          "PARTICLE_INVALID_EMITTER"},
+
+    {TILEMAP_OUT_OF_BOUNDS,             "TILEMAP_OUT_OF_BOUNDS"},
+    {TILEMAP_INVALID_TILESET,           "TILEMAP_INVALID_TILESET"},
+    {TILEMAP_NO_TILESET,                "TILEMAP_NO_TILESET"},
+
+    {SCENE_INVALID_OBJECT,              "SCENE_INVALID_OBJECT"},
+
+    {ANIM_OPEN_FAILED,                  "ANIM_OPEN_FAILED"},
+    {ANIM_INVALID_GIF,                  "ANIM_INVALID_GIF"},
+    {ANIM_FRAME_SIZE_MISMATCH,          "ANIM_FRAME_SIZE_MISMATCH"},
+    {ANIM_NOT_OPEN,                     "ANIM_NOT_OPEN"},
+    {ANIM_NO_FRAMES,                    "ANIM_NO_FRAMES"},
+
+    {RASTER_INVALID_SIZE,               "RASTER_INVALID_SIZE"},
+    {RASTER_LOAD_FAILED,                "RASTER_LOAD_FAILED"},
+
+    {FRAMESINK_SHM_FAILED,              "FRAMESINK_SHM_FAILED"},
+    {FRAMESINK_FRAME_TOO_LARGE,         "FRAMESINK_FRAME_TOO_LARGE"},
+    {FRAMESINK_INVALID,                 "FRAMESINK_INVALID"},
+    {FRAMESINK_TIMEOUT,                 "FRAMESINK_TIMEOUT"},
+    {FRAMESINK_UNSUPPORTED,             "FRAMESINK_UNSUPPORTED"},
+
+    {TEXT_FONT_OPEN_FAILED,             "TEXT_FONT_OPEN_FAILED"},
+    {TEXT_GLYPH_FAILED,                 "TEXT_GLYPH_FAILED"},
+    {TEXT_RENDER_GEOMETRY_FAILED,       "TEXT_RENDER_GEOMETRY_FAILED"},
+    {TEXT_FONT_MAP_FAILED,              "TEXT_FONT_MAP_FAILED"},
+    {TEXT_INVALID_FONT,                 "TEXT_INVALID_FONT"},
+
+
+    {GUI_LAYER_NESTED,                  "GUI_LAYER_NESTED"}
 };
 
 
@@ -57,6 +116,9 @@ int Sys::initWindow(
     Sys::wWidth = windowWidth;
     Sys::wHeight = windowHeight;
 
+    // LUMOS_HEADLESS and LUMOS_CAPTURE, used by the golden image tests
+    Capture::initFromEnv();
+
     // SDL INIT ----------------------------------------------------------
     int status = SDL_Init(SDL_INIT_EVERYTHING);
     if(status == 0){
@@ -70,6 +132,7 @@ int Sys::initWindow(
     // CREATE WINDOW ------------------------------------------------------
     int flags = 0;
     if(isFullscreen) flags = SDL_WINDOW_FULLSCREEN;
+    if(Capture::isHeadless()) flags |= SDL_WINDOW_HIDDEN;
 
     win = SDL_CreateWindow(
         windowTitle.c_str(), 
@@ -88,7 +151,8 @@ int Sys::initWindow(
 
 
     // CREATE RENDERER -----------------------------------------------------
-    r = SDL_CreateRenderer(win, -1, 0);
+    // Headless runs use the software renderer, so the output is the same on every machine
+    r = SDL_CreateRenderer(win, -1, Capture::isHeadless() ? SDL_RENDERER_SOFTWARE : 0);
     if(r){
         cout << "[INIT] Renderer created..." << endl;
     }
@@ -118,9 +182,11 @@ int Sys::initFont(const string& fontPath){
         return SYS_FONT_INIT_ERROR;
     }
 
-    // Create Font Object
-    font = TTF_OpenFont(fontPath.c_str(), 108);
-    if(font == nullptr){
+    // Map the font file, every size is opened out of it when first used
+    int fontId;
+    int err = Fonts::load(fontPath, fontId);
+    font = Fonts::getSize(FONT_REFERENCE_SIZE, fontId);
+    if(err != NO_ERROR || font == nullptr){
         cout << "[FATAL] Failed to load font!" << endl;
         return SYS_FONT_PATH_ERROR;
     }
@@ -180,6 +246,9 @@ int Sys::handleEvents(){
     Mouse::clicked = false; // Firstly reset it
     if(Mouse::down && !isMouseDown) Mouse::clicked = true;
 
+    // And the other way around, it went down this frame
+    Mouse::pressed = !Mouse::down && isMouseDown;
+
     // Now update the Mouse::down
     Mouse::down = isMouseDown;
 
@@ -190,6 +259,7 @@ int Sys::handleEvents(){
     Keyboard::text.clear();
     Keyboard::keyUp = 0;
     Keyboard::keyDown = 0;
+    Mouse::wheel = 0;
 
     while(SDL_PollEvent(&event)){
         if(event.type == SDL_QUIT){
@@ -207,6 +277,11 @@ int Sys::handleEvents(){
         if(event.type == SDL_TEXTINPUT){
             Keyboard::text += event.text.text;
         }
+
+        // Scrolled this frame, positive is up, fractional on touchpads
+        if(event.type == SDL_MOUSEWHEEL){
+            Mouse::wheel += event.wheel.preciseY;
+        }
     }
 
     return error;
@@ -226,9 +301,20 @@ int Sys::handleEvents(){
 int Sys::presentFrame(){
     uint64_t error = NO_ERROR;
 
+    // Read the frame back if it is being captured, before the back buffer is gone
+    int err = Capture::endFrame();
+    CHECK_ERROR(err);
+
+    // And published to the frame sink ring, if one is open
+    err = FrameSink::endFrame();
+    CHECK_ERROR(err);
+
     // PRESENT THE NEW FRAME ON THE SCREEN ----------------------------------------------------------------------------
     SDL_RenderPresent(Sys::r);
 
+    // Let the Texture Manager keep the textures within the memory budget
+    TM::endFrame();
+
 
     // FRAME DELAY ----------------------------------------------------------------------------------------------------
     Uint64 currentFrameDuration = SDL_GetTicks() - frameStart;
@@ -268,6 +354,11 @@ int Sys::presentFrame(){
  */
 int Sys::cleanup(){
     // DESTROY AND FREE EVERYTHING ------------------------------------------------------------------------------------
+    Capture::wait();
+    FrameSink::close();
+    GlyphAtlas::cleanup();
+    Fonts::cleanup();
+    Jobs::shutdown();
     SDL_DestroyWindow(win);
     SDL_DestroyRenderer(r);
     TTF_Quit();
@@ -305,6 +396,8 @@ int Sys::getCurrentFrame() { return frameCounter; }
 SDL_Point Sys::Mouse::getPos() { return pos; }
 bool Sys::Mouse::isClicked() { return clicked; }
 bool Sys::Mouse::isDown() { return down; }
+bool Sys::Mouse::isPressed() { return pressed; }
+float Sys::Mouse::getWheel() { return wheel; }
 bool Sys::Mouse::isHovering(const SDL_Rect& rect) { 
     return pos.x >= rect.x && pos.x <= rect.x+rect.w &&
         pos.y >= rect.y && pos.y <= rect.y+rect.h; 
@@ -313,7 +406,14 @@ bool Sys::Mouse::isHovering(const SDL_Rect& rect) {
 
 SDL_Keycode Sys::Keyboard::getKeyUp() { return keyUp; }
 SDL_Keycode Sys::Keyboard::getKeyDown() { return keyDown; }
-string Sys::Keyboard::getText() { return text; }
+const string& Sys::Keyboard::getText() { return text; }
+SDL_Keymod Sys::Keyboard::getMod() { return SDL_GetModState(); }
+
+// Is the key held down right now, unlike getKeyDown it stays true while its held
+bool Sys::Keyboard::isKeyDown(SDL_Keycode key) {
+    const Uint8* state = SDL_GetKeyboardState(nullptr);
+    return state != nullptr && state[SDL_GetScancodeFromKey(key)];
+}
 
 bool Sys::Keyboard::isFocused() { return focused; }
 void Sys::Keyboard::focus() { pendingFocus = true; }
@@ -17,6 +17,8 @@ class Sys{
     friend class Mouse;
     friend class TM;
     friend class GUI;
+    friend class Animation;
+    friend class GlyphAtlas;
 
     private:
     static inline int OS;
@@ -37,7 +39,7 @@ class Sys{
     static inline SDL_Window* win = nullptr;
     static inline SDL_Renderer* r = nullptr;
 
-    static inline TTF_Font* font;
+    static inline TTF_Font* font;       // FONT_DEFAULT at FONT_REFERENCE_SIZE, owned by Fonts
 
     static inline int wWidth = 0;
     static inline int wHeight = 0;
@@ -85,11 +87,15 @@ class Sys{
             static inline SDL_Point pos = {0, 0};
             static inline bool clicked = false;
             static inline bool down = false;
+            static inline bool pressed = false;
+            static inline float wheel = 0;
 
         public:
             static SDL_Point getPos();
             static bool isClicked();
             static bool isDown();
+            static bool isPressed();
+            static float getWheel();
             static bool isHovering(const SDL_Rect& area);
     };
 
@@ -108,7 +114,9 @@ class Sys{
         public:
             static SDL_Keycode getKeyUp();
             static SDL_Keycode getKeyDown();
-            static string getText();
+            static bool isKeyDown(SDL_Keycode key);
+            static SDL_Keymod getMod();
+            static const string& getText();
             static bool isFocused();
             static void focus();
             static void unfocus();
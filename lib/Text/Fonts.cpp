@@ -0,0 +1,552 @@
+#include "./Text.h"
+#include "../System/Sys.h"
+#include "../Pixel/Pixel.h"
+
+#include <climits>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+
+// Point sizes the fonts are opened at, a target height goes to the closest larger one
+static const int SIZE_BUCKETS[] = {8, 10, 12, 14, 16, 18, 20, 24, 28, 32, 40, 48, 56, 64, 80, 96, 128, 160};
+
+
+
+/** Map
+ *
+ * INTERNAL USE
+ *
+ * Maps the font file into memory, read only, or finds the mapping it already has.
+ * Where mmap isnt available the file is read into memory instead.
+ *
+ * @param path Path of the font file
+ * @param mapping Gets the index of the mapping
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Fonts::map(const string& path, int& mapping){
+    for(size_t i = 0; i < mappings.size(); i++){
+        if(mappings[i].path == path){
+            mapping = i;
+            return NO_ERROR;
+        }
+    }
+
+    Mapping m;
+    m.path = path;
+
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) return TEXT_FONT_MAP_FAILED;
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size <= 0){
+        ::close(fd);
+        return TEXT_FONT_MAP_FAILED;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED) return TEXT_FONT_MAP_FAILED;
+
+    m.data = (Uint8*)data;
+    m.size = info.st_size;
+    m.mapped = true;
+#else
+    m.data = (Uint8*)SDL_LoadFile(path.c_str(), &m.size);
+    if(m.data == nullptr) return TEXT_FONT_MAP_FAILED;
+#endif
+
+    mappings.push_back(m);
+    mapping = mappings.size() - 1;
+
+    stats.files = mappings.size();
+    stats.mappedBytes += m.size;
+    return NO_ERROR;
+}
+
+
+
+
+/** Unmap
+ *
+ * INTERNAL USE
+ *
+ * Frees the memory of the file, mapped or loaded by Fonts::map.
+ *
+ * @param mapping Mapping of the file, no face can be open out of it
+ */
+void Fonts::unmap(Mapping& mapping){
+#ifdef __linux__
+    if(mapping.mapped) munmap(mapping.data, mapping.size);
+#endif
+    if(!mapping.mapped) SDL_free(mapping.data);
+
+    mapping.data = nullptr;
+    mapping.size = 0;
+}
+
+
+
+
+/** Load
+ *
+ * Registers a font, its file is mapped once and shared by every
+ * face and size opened from it. Loading the same font again gives
+ * back the same id. The first font loaded, by Sys::initFont, is
+ * FONT_DEFAULT.
+ *
+ * @param path Path of the TTF or OTF file
+ * @param fontId Gets the id of the font
+ * @param faceIndex Face in the file, for font collections with several faces
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Fonts::load(const string& path, int& fontId, long faceIndex){
+    int mapping;
+    int err = Fonts::map(path, mapping);
+    if(err != NO_ERROR) return err;
+
+    for(size_t i = 0; i < fonts.size(); i++){
+        if(fonts[i].mapping == mapping && fonts[i].index == faceIndex){
+            fontId = i;
+            return NO_ERROR;
+        }
+    }
+
+    Font font;
+    font.mapping = mapping;
+    font.index = faceIndex;
+    fonts.push_back(font);
+    fontId = fonts.size() - 1;
+
+    // The reference size gives the line height of a point, for picking the sizes
+    TTF_Font* reference = Fonts::getSize(FONT_REFERENCE_SIZE, fontId);
+    if(reference == nullptr){
+        fonts.pop_back();
+
+        // A file mapped just for it isnt kept, another face of it may still use it
+        bool used = false;
+        for(const Font& other : fonts) used |= other.mapping == mapping;
+        if(!used && mapping == (int)mappings.size() - 1){
+            stats.mappedBytes -= mappings.back().size;
+            Fonts::unmap(mappings.back());
+            mappings.pop_back();
+            stats.files = mappings.size();
+        }
+        return TEXT_FONT_OPEN_FAILED;
+    }
+    fonts[fontId].heightPerPoint = (double)TTF_FontHeight(reference) / FONT_REFERENCE_SIZE;
+
+    stats.fonts = fonts.size();
+    return NO_ERROR;
+}
+
+
+
+
+/** Point Size
+ *
+ * @param height Line height the text will be drawn at, in pixels, 0 or less for the reference size
+ * @param fontId Font the text is drawn with
+ * @return Point size of the bucket closest to the height, not smaller then it unless its the largest
+ */
+int Fonts::pointSize(int height, int fontId){
+    if(height <= 0 || fontId < 0 || fontId >= (int)fonts.size()) return FONT_REFERENCE_SIZE;
+
+    int points = (int)ceil(height / fonts[fontId].heightPerPoint);
+    for(int size : SIZE_BUCKETS){
+        if(size >= points) return size;
+    }
+    return SIZE_BUCKETS[sizeof(SIZE_BUCKETS) / sizeof(int) - 1];
+}
+
+
+
+
+/** Get Metrics
+ *
+ * INTERNAL USE
+ *
+ * @param pointSize Point size of the face
+ * @param fontId Font of the face
+ * @return The face at the point size with its advance cache, opened out of the mapped file on first use, nullptr if it failed
+ */
+Fonts::Size* Fonts::getMetrics(int pointSize, int fontId){
+    if(fontId < 0 || fontId >= (int)fonts.size()) return nullptr;
+
+    Font& font = fonts[fontId];
+    auto it = font.sizes.find(pointSize);
+    if(it != font.sizes.end()) return &it->second;
+
+    // The RWops only reads the mapping, FreeType never copies the file
+    const Mapping& mapping = mappings[font.mapping];
+    SDL_RWops* rw = SDL_RWFromConstMem(mapping.data, mapping.size);
+    if(rw == nullptr) return nullptr;
+
+    TTF_Font* face = TTF_OpenFontIndexRW(rw, 1, pointSize, font.index);
+    if(face == nullptr) return nullptr;
+
+    Size& size = font.sizes[pointSize];
+    size.font = face;
+    size.height = TTF_FontHeight(face);
+    size.kerning = TTF_GetFontKerning(face) != 0;
+    std::fill(std::begin(size.ascii), std::end(size.ascii), -1);
+
+    stats.faces++;
+    return &size;
+}
+
+
+
+
+/** Get Size
+ *
+ * @param pointSize Point size of the face
+ * @param fontId Font of the face
+ * @return Face of the font at the point size, opened out of the mapped file on first use, nullptr if it failed
+ */
+TTF_Font* Fonts::getSize(int pointSize, int fontId){
+    Size* size = Fonts::getMetrics(pointSize, fontId);
+    return size == nullptr ? nullptr : size->font;
+}
+
+
+
+
+/** Get
+ *
+ * @param height Line height the text will be drawn at, in pixels
+ * @param fontId Font of the face
+ * @return Face of the size bucket for the height, nullptr if it cant be opened
+ */
+TTF_Font* Fonts::get(int height, int fontId){
+    return Fonts::getSize(Fonts::pointSize(height, fontId), fontId);
+}
+
+
+
+
+/** Render
+ *
+ * Renders the text at the size bucket of the height, in the quality tier.
+ * The surface is always 32 bit with alpha, its height is the line height of the bucket,
+ * so it is scaled a little when drawn at the exact height.
+ *
+ * @param surface Gets the rendered text, has to be freed with SDL_FreeSurface
+ * @param text UTF-8 text
+ * @param height Line height the text will be drawn at, 0 or less for FONT_REFERENCE_SIZE
+ * @param color Color of the text
+ * @param quality TEXT_SOLID, TEXT_SHADED or TEXT_BLENDED
+ * @param fontId Font to render with
+ * @param background Background of TEXT_SHADED
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Fonts::render(
+    SDL_Surface*& surface,
+    const string& text,
+    int height,
+    const SDL_Color& color,
+    int quality,
+    int fontId,
+    const SDL_Color& background
+){
+    surface = nullptr;
+    if(fontId < 0 || fontId >= (int)fonts.size()) return TEXT_INVALID_FONT;
+
+    TTF_Font* font = Fonts::get(height, fontId);
+    if(font == nullptr) return TEXT_FONT_OPEN_FAILED;
+
+    SDL_Surface* rendered = nullptr;
+    if(quality == TEXT_SOLID)       rendered = TTF_RenderUTF8_Solid(font, text.c_str(), color);
+    else if(quality == TEXT_SHADED) rendered = TTF_RenderUTF8_Shaded(font, text.c_str(), color, background);
+    else                            rendered = TTF_RenderUTF8_Blended(font, text.c_str(), color);
+    if(rendered == nullptr) return TM_SURFACE_CREATE_ERROR;
+
+    // Solid and shaded come palettized, textures cant hold that
+    if(SDL_ISPIXELFORMAT_INDEXED(rendered->format->format)){
+        SDL_Surface* converted = Pixel::convertToRGBA32(rendered);
+        SDL_FreeSurface(rendered);
+        if(converted == nullptr) return TM_SURFACE_CREATE_ERROR;
+        rendered = converted;
+    }
+
+    surface = rendered;
+    return NO_ERROR;
+}
+
+
+
+
+/** Next Codepoint
+ *
+ * Decodes the UTF-8 character at i and moves i past it.
+ * Invalid bytes are returned as U+FFFD.
+ */
+Uint32 Fonts::nextCodepoint(string_view text, size_t& i){
+    Uint8 c = text[i++];
+    if(c < 0x80) return c;
+
+    int extra = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : -1;
+    if(extra < 0) return 0xfffd;
+
+    Uint32 codepoint = c & (0x3f >> extra);
+    for(int k = 0; k < extra; k++){
+        if(i >= text.size() || ((Uint8)text[i] & 0xc0) != 0x80) return 0xfffd;
+        codepoint = (codepoint << 6) | ((Uint8)text[i++] & 0x3f);
+    }
+    return codepoint;
+}
+
+
+
+
+/** Advance
+ *
+ * INTERNAL USE
+ *
+ * @return Advance of the glyph at the size, looked up once and cached. Characters
+ *         missing from the font get the advance of the replacement character, or '?',
+ *         just like the glyph atlas draws them
+ */
+int Fonts::advance(Size& size, Uint32 codepoint){
+    if(codepoint < 128 && size.ascii[codepoint] >= 0) return size.ascii[codepoint];
+    if(codepoint >= 128){
+        auto it = size.advances.find(codepoint);
+        if(it != size.advances.end()) return it->second;
+    }
+
+    Uint32 drawn = codepoint;
+    if(!TTF_GlyphIsProvided32(size.font, codepoint)){
+        drawn = TTF_GlyphIsProvided32(size.font, 0xfffd) ? 0xfffd : '?';
+    }
+
+    int minX, maxX, minY, maxY, advance = 0;
+    if(TTF_GlyphMetrics32(size.font, drawn, &minX, &maxX, &minY, &maxY, &advance) != 0) advance = 0;
+
+    if(codepoint < 128) size.ascii[codepoint] = advance;
+    else size.advances[codepoint] = advance;
+    return advance;
+}
+
+
+
+
+/** Measure
+ *
+ * Measures the text out of the cached glyph advances, with kerning,
+ * without rendering anything. Newlines are measured as any other character.
+ *
+ * @param text UTF-8 text
+ * @param height Line height the text would be drawn at
+ * @param width Gets the width of the text at that height
+ * @param fontId Font of the text
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Fonts::measure(string_view text, int height, int& width, int fontId){
+    width = 0;
+    if(height <= 0) return NO_ERROR;
+    if(fontId < 0 || fontId >= (int)fonts.size()) return TEXT_INVALID_FONT;
+
+    Size* size = Fonts::getMetrics(Fonts::pointSize(height, fontId), fontId);
+    if(size == nullptr) return TEXT_FONT_OPEN_FAILED;
+
+    int pen = 0;
+    Uint32 previous = 0;
+    for(size_t i = 0; i < text.size();){
+        Uint32 codepoint = Fonts::nextCodepoint(text, i);
+        if(size->kerning && previous != 0) pen += TTF_GetFontKerningSizeGlyphs32(size->font, previous, codepoint);
+        pen += Fonts::advance(*size, codepoint);
+        previous = codepoint;
+    }
+
+    width = (int)round(pen * (double)height / size->height);
+    return NO_ERROR;
+}
+
+
+
+
+/** Glyph Metrics
+ *
+ * Gives the cached metrics of one glyph, for laying text out glyph by glyph.
+ * They are in the units of the size bucket of the height, multiplied by
+ * Fonts::getScale they are in pixels, the same as the glyph atlas draws them.
+ *
+ * @param codepoint The glyph
+ * @param previous The glyph before it, 0 if there is none
+ * @param height Line height the text will be drawn at
+ * @param advance Gets the advance of the glyph
+ * @param kerning Gets the kerning between the previous glyph and this one
+ * @param fontId Font of the text
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Fonts::glyphMetrics(Uint32 codepoint, Uint32 previous, int height, int& advance, int& kerning, int fontId){
+    advance = kerning = 0;
+    if(fontId < 0 || fontId >= (int)fonts.size()) return TEXT_INVALID_FONT;
+
+    Size* size = Fonts::getMetrics(Fonts::pointSize(height, fontId), fontId);
+    if(size == nullptr) return TEXT_FONT_OPEN_FAILED;
+
+    advance = Fonts::advance(*size, codepoint);
+    if(size->kerning && previous != 0) kerning = TTF_GetFontKerningSizeGlyphs32(size->font, previous, codepoint);
+    return NO_ERROR;
+}
+
+
+
+
+/** Get Scale
+ *
+ * @param height Line height the text will be drawn at
+ * @param fontId Font of the text
+ * @return Pixels per unit of Fonts::glyphMetrics at the height, 0 if the font cant be opened
+ */
+double Fonts::getScale(int height, int fontId){
+    Size* size = Fonts::getMetrics(Fonts::pointSize(height, fontId), fontId);
+    if(size == nullptr || size->height <= 0) return 0;
+    return (double)height / size->height;
+}
+
+
+
+
+/** Wrap
+ *
+ * Breaks the text into lines no wider then maxWidth. Lines are broken
+ * at the newlines and at the spaces, the spaces a line is broken at
+ * are dropped. A word wider then maxWidth on its own is broken
+ * between its characters.
+ *
+ * @param text UTF-8 text
+ * @param height Line height the text will be drawn at
+ * @param maxWidth Width to wrap at, 0 or less to break only at the newlines
+ * @param layout Gets the lines, the memory of its previous lines is reused
+ * @param fontId Font of the text
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Fonts::wrap(string_view text, int height, int maxWidth, TextLayout& layout, int fontId){
+    layout.lines.clear();
+    layout.width = 0;
+    layout.height = 0;
+    layout.lineHeight = max(0, height);
+    if(height <= 0 || text.empty()) return NO_ERROR;
+    if(fontId < 0 || fontId >= (int)fonts.size()) return TEXT_INVALID_FONT;
+
+    Size* size = Fonts::getMetrics(Fonts::pointSize(height, fontId), fontId);
+    if(size == nullptr) return TEXT_FONT_OPEN_FAILED;
+
+    // Everything is laid out in the units of the face, and scaled to the height at the end
+    double scale = (double)height / size->height;
+    int limit = maxWidth > 0 ? (int)(maxWidth / scale) : INT_MAX;
+
+    auto addLine = [&](size_t begin, size_t end, int pen){
+        layout.lines.push_back({(int)begin, (int)end, (int)round(pen * scale)});
+    };
+
+    size_t lineBegin = 0;
+    int pen = 0;
+    Uint32 previous = 0;
+
+    // End of the last character that isnt a space, the trailing spaces dont count
+    size_t contentEnd = 0;
+    int contentPen = 0;
+
+    // Last space of the line, where it can be broken
+    size_t breakAt = string_view::npos;
+    int breakPen = 0;
+
+    for(size_t i = 0; i < text.size();){
+        size_t at = i;
+        Uint32 codepoint = Fonts::nextCodepoint(text, i);
+
+        // NEWLINE --------------------------------------------------------------------------
+        if(codepoint == '\n'){
+            addLine(lineBegin, contentEnd, contentPen);
+            lineBegin = contentEnd = i;
+            pen = contentPen = 0;
+            previous = 0;
+            breakAt = string_view::npos;
+            continue;
+        }
+
+        // Only the first space of a run is a break, the rest would hang off the line.
+        // The spaces indenting the line are kept
+        if(codepoint == ' ' && previous != ' ' && at > lineBegin){
+            breakAt = at;
+            breakPen = pen;
+        }
+
+        int next = pen + Fonts::advance(*size, codepoint);
+        if(size->kerning && previous != 0) next += TTF_GetFontKerningSizeGlyphs32(size->font, previous, codepoint);
+
+        // WRAP -----------------------------------------------------------------------------
+        // Spaces never wrap, they are dropped with the break before the next word.
+        // Every line keeps at least one character after its indentation
+        if(next > limit && codepoint != ' ' && contentEnd > lineBegin){
+            if(breakAt != string_view::npos){
+                addLine(lineBegin, breakAt, breakPen);
+                i = breakAt;
+            } else {
+                addLine(lineBegin, at, pen);
+                i = at;
+            }
+
+            // The next line starts at the word, past the spaces
+            while(i < text.size() && text[i] == ' ') i++;
+            lineBegin = contentEnd = i;
+            pen = contentPen = 0;
+            previous = 0;
+            breakAt = string_view::npos;
+            continue;
+        }
+
+        pen = next;
+        previous = codepoint;
+        if(codepoint != ' '){
+            contentEnd = i;
+            contentPen = pen;
+        }
+    }
+    addLine(lineBegin, contentEnd, contentPen);
+
+    for(const TextLine& line : layout.lines) layout.width = max(layout.width, line.width);
+    layout.height = layout.lines.size() * height;
+    return NO_ERROR;
+}
+
+
+
+
+/** Cleanup
+ *
+ * INTERNAL USE
+ *
+ * Closes every face and unmaps the files. Called by Sys::cleanup,
+ * after the glyph atlas let go of the faces.
+ */
+void Fonts::cleanup(){
+    for(Font& font : fonts){
+        for(auto& [points, size] : font.sizes) TTF_CloseFont(size.font);
+    }
+    fonts.clear();
+
+    for(Mapping& mapping : mappings) Fonts::unmap(mapping);
+    mappings.clear();
+
+    stats = FontStats();
+}
+
+
+
+
+/** Get Stats
+ *
+ * @return Counters of the mapped files and the opened faces
+ */
+FontStats Fonts::getStats(){ return stats; }
@@ -0,0 +1,380 @@
+#include "./Text.h"
+#include "../System/Sys.h"
+#include "../Pixel/Pixel.h"
+
+
+
+/** Face Key
+ *
+ * INTERNAL USE
+ *
+ * @return Key of the face in GlyphAtlas::faces
+ */
+int GlyphAtlas::faceKey(int fontId, int size, bool solid){
+    return (fontId << 16) | (size << 1) | (solid ? 1 : 0);
+}
+
+
+
+
+/** Get Face
+ *
+ * INTERNAL USE
+ *
+ * @param height Line height the text will be drawn at, in pixels
+ * @param quality TEXT_SOLID gets its own glyphs, the other tiers are blended
+ * @param fontId Font of the text
+ * @return Face of the size bucket of the height, nullptr if it cant be opened
+ */
+GlyphAtlas::Face* GlyphAtlas::getFace(int height, int quality, int fontId){
+    int size = Fonts::pointSize(height, fontId);
+    bool solid = quality == TEXT_SOLID;
+
+    int key = GlyphAtlas::faceKey(fontId, size, solid);
+    auto it = faces.find(key);
+    if(it != faces.end()) return &it->second;
+
+    TTF_Font* font = Fonts::getSize(size, fontId);
+    if(font == nullptr) return nullptr;
+
+    Face& face = faces[key];
+    face.font = font;
+    face.size = size;
+    face.solid = solid;
+    face.height = TTF_FontHeight(font);
+    face.kerning = TTF_GetFontKerning(font) != 0;
+    stats.faces = faces.size();
+    return &face;
+}
+
+
+
+
+/** Get Glyph
+ *
+ * INTERNAL USE
+ *
+ * @return The glyph, rasterized into the atlas on first use, nullptr if it failed
+ */
+GlyphAtlas::Glyph* GlyphAtlas::getGlyph(Face& face, Uint32 codepoint){
+    if(codepoint < 128){
+        if(face.ascii[codepoint].loaded) return &face.ascii[codepoint];
+    } else {
+        auto it = face.glyphs.find(codepoint);
+        if(it != face.glyphs.end() && it->second.loaded) return &it->second;
+    }
+
+    // Rasterized into a copy, placing it can start the atlas over, which
+    // forgets every glyph, so it is stored only once it is in a page
+    Glyph glyph;
+    int err = GlyphAtlas::rasterize(face, codepoint, glyph);
+    CHECK_ERROR(err);
+    if(err != NO_ERROR) return nullptr;
+
+    Glyph& stored = codepoint < 128 ? face.ascii[codepoint] : face.glyphs[codepoint];
+    stored = glyph;
+    return &stored;
+}
+
+
+
+
+/** Rasterize
+ *
+ * INTERNAL USE
+ *
+ * Renders the glyph in white and uploads it into a free spot of the atlas.
+ * The glyph shouldnt be a part of the face, the atlas can start over meanwhile.
+ *
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int GlyphAtlas::rasterize(Face& face, Uint32 codepoint, Glyph& glyph){
+    // Characters missing from the font are drawn as the replacement character, or '?'
+    if(!TTF_GlyphIsProvided32(face.font, codepoint)){
+        Uint32 replacement = TTF_GlyphIsProvided32(face.font, 0xfffd) ? 0xfffd : '?';
+        if(codepoint != replacement){
+            Glyph* substitute = GlyphAtlas::getGlyph(face, replacement);
+            if(substitute == nullptr) return TEXT_GLYPH_FAILED;
+            glyph = *substitute;
+            return NO_ERROR;
+        }
+    }
+
+    int minX, maxX, minY, maxY, advance;
+    if(TTF_GlyphMetrics32(face.font, codepoint, &minX, &maxX, &minY, &maxY, &advance) != 0) return TEXT_GLYPH_FAILED;
+
+    glyph = Glyph();
+    glyph.advance = advance;
+    glyph.offsetX = min(0, minX);   // The rendered glyph starts at its leftmost ink, if it hangs left
+    glyph.loaded = true;
+    stats.rasterized++;
+
+    // Nothing to draw, just the advance
+    if(maxX <= minX || maxY <= minY) return NO_ERROR;
+
+    // RENDER IT ----------------------------------------------------------------------------
+    SDL_Surface* surface = face.solid
+        ? TTF_RenderGlyph32_Solid(face.font, codepoint, SDL_COLOR_WHITE)
+        : TTF_RenderGlyph32_Blended(face.font, codepoint, SDL_COLOR_WHITE);
+    if(surface == nullptr) return TEXT_GLYPH_FAILED;
+
+    if(surface->format->format != SDL_PIXELFORMAT_RGBA32){
+        SDL_Surface* converted = Pixel::convertToRGBA32(surface);
+        SDL_FreeSurface(surface);
+        if(converted == nullptr) return TEXT_GLYPH_FAILED;
+        surface = converted;
+    }
+
+    // With a transparent pixel around it, so the filtering doesnt bleed in the neighbours
+    int width = surface->w + 2, height = surface->h + 2;
+    vector<Uint8> pixels((size_t)width * height * 4, 0);
+    for(int y = 0; y < surface->h; y++){
+        memcpy(
+            pixels.data() + ((size_t)(y + 1) * width + 1) * 4,
+            (Uint8*)surface->pixels + (size_t)y * surface->pitch,
+            (size_t)surface->w * 4
+        );
+    }
+    SDL_FreeSurface(surface);
+
+    // PUT IT INTO THE ATLAS ----------------------------------------------------------------
+    int page;
+    SDL_Point pos;
+    int err = GlyphAtlas::place(width, height, page, pos);
+    if(err != NO_ERROR) return err;
+
+    SDL_Rect area = {pos.x, pos.y, width, height};
+    if(SDL_UpdateTexture(TM::resolve(pages[page].td), &area, pixels.data(), width * 4) != 0) return TM_TEXTURE_UPDATE_ERROR;
+
+    glyph.page = page;
+    glyph.src = {pos.x + 1, pos.y + 1, width - 2, height - 2};
+    stats.glyphs++;
+    return NO_ERROR;
+}
+
+
+
+
+/** Place
+ *
+ * INTERNAL USE
+ *
+ * Finds a free spot for a glyph, on the shelf of the last page, on a new
+ * shelf, or on a new page. Once all the pages are full the atlas starts over.
+ *
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int GlyphAtlas::place(int width, int height, int& page, SDL_Point& pos){
+    if(width > GLYPH_ATLAS_PAGE_SIZE || height > GLYPH_ATLAS_PAGE_SIZE) return TEXT_GLYPH_FAILED;
+
+    if(!pages.empty()){
+        Page& last = pages.back();
+
+        // A new shelf once the current one is full, or too low for the glyph
+        if(last.x + width > GLYPH_ATLAS_PAGE_SIZE || height > last.shelfHeight){
+            if(last.x == 0){
+                last.shelfHeight = max(last.shelfHeight, height);
+            } else {
+                last.shelfY += last.shelfHeight;
+                last.shelfHeight = height;
+                last.x = 0;
+            }
+        }
+
+        if(last.shelfY + last.shelfHeight <= GLYPH_ATLAS_PAGE_SIZE){
+            page = pages.size() - 1;
+            pos = {last.x, last.shelfY};
+            last.x += width;
+            return NO_ERROR;
+        }
+    }
+
+    // NEW PAGE -----------------------------------------------------------------------------
+    // Everything drawn so far was already submitted, so the atlas can start over
+    if((int)pages.size() >= GLYPH_ATLAS_MAX_PAGES) GlyphAtlas::reset();
+
+    Page fresh;
+    int err = TM::acquireTexture(fresh.td, GLYPH_ATLAS_PAGE_SIZE, GLYPH_ATLAS_PAGE_SIZE, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC);
+    if(err != NO_ERROR) return err;
+
+    fresh.shelfHeight = height;
+    fresh.x = width;
+    pages.push_back(fresh);
+    stats.pages = pages.size();
+
+    page = pages.size() - 1;
+    pos = {0, 0};
+    return NO_ERROR;
+}
+
+
+
+
+/** Reset
+ *
+ * INTERNAL USE
+ *
+ * Forgets every glyph and frees the pages, they are rasterized again when used.
+ */
+void GlyphAtlas::reset(){
+    for(auto& [size, face] : faces){
+        for(Glyph& glyph : face.ascii) glyph = Glyph();
+        face.glyphs.clear();
+    }
+
+    for(Page& page : pages) TM::freeTexture(page.td);
+    pages.clear();
+
+    stats.pages = 0;
+    stats.glyphs = 0;
+    stats.resets++;
+}
+
+
+
+
+/** Cleanup
+ *
+ * INTERNAL USE
+ *
+ * Frees the pages and forgets the faces, Fonts closes them. Called by Sys::cleanup.
+ */
+void GlyphAtlas::cleanup(){
+    GlyphAtlas::reset();
+
+    faces.clear();
+    stats.faces = 0;
+}
+
+
+
+
+/** Measure
+ *
+ * Lays the text out without drawing it, out of the glyph advances cached
+ * by Fonts, so nothing is rasterized. The quality tiers share the metrics.
+ *
+ * @param text UTF-8 text
+ * @param height Line height the text would be drawn at
+ * @param width Gets the width of the text at that height
+ * @param fontId Font of the text
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int GlyphAtlas::measure(string_view text, int height, int& width, int fontId){
+    return Fonts::measure(text, height, width, fontId);
+}
+
+
+
+
+/** Draw
+ *
+ * Draws the text stretched into the rect, its height is the line height.
+ * If the width is 0 or less the text keeps its natural width.
+ *
+ * @param text UTF-8 text
+ * @param dRect Where to draw the text
+ * @param color Color of the text
+ * @param quality TEXT_SOLID, TEXT_SHADED or TEXT_BLENDED
+ * @param fontId Font of the text
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int GlyphAtlas::draw(string_view text, const SDL_Rect& dRect, const SDL_Color& color, int quality, int fontId){
+    if(dRect.h <= 0 || text.empty()) return NO_ERROR;
+
+    Face* face = GlyphAtlas::getFace(dRect.h, quality, fontId);
+    if(face == nullptr) return TEXT_FONT_OPEN_FAILED;
+
+    float scaleY = (float)dRect.h / face->height;
+    float scaleX = scaleY;
+    if(dRect.w > 0){
+        int natural;
+        GlyphAtlas::measure(text, dRect.h, natural, fontId);
+        if(natural > 0) scaleX = scaleY * dRect.w / natural;
+    }
+
+    for(auto& run : vertices) run.clear();
+    for(auto& run : indices) run.clear();
+
+    // LAY OUT THE QUADS --------------------------------------------------------------------
+    // The glyphs are looked up first, a reset in the middle would move the earlier ones
+    int pen = 0;
+    Uint32 previous = 0;
+    Uint64 resets = stats.resets;
+    for(size_t i = 0; i < text.size();){
+        Uint32 codepoint = Fonts::nextCodepoint(text, i);
+        Glyph* glyph = GlyphAtlas::getGlyph(*face, codepoint);
+        if(glyph == nullptr) continue;
+
+        // The atlas started over, so the quads so far point at freed pages.
+        // Drawn again into the empty atlas, unless the text alone overflows it
+        if(stats.resets != resets){
+            static bool retrying = false;
+            if(retrying) return TEXT_GLYPH_FAILED;
+
+            retrying = true;
+            int err = GlyphAtlas::draw(text, dRect, color, quality, fontId);
+            retrying = false;
+            return err;
+        }
+
+        if(face->kerning && previous != 0) pen += TTF_GetFontKerningSizeGlyphs32(face->font, previous, codepoint);
+        previous = codepoint;
+
+        if(glyph->page >= 0){
+            if((int)vertices.size() <= glyph->page){
+                vertices.resize(glyph->page + 1);
+                indices.resize(glyph->page + 1);
+            }
+
+            float x0 = dRect.x + (pen + glyph->offsetX) * scaleX;
+            float y0 = dRect.y;
+            float x1 = x0 + glyph->src.w * scaleX;
+            float y1 = y0 + glyph->src.h * scaleY;
+
+            const float inv = 1.0f / GLYPH_ATLAS_PAGE_SIZE;
+            float u0 = glyph->src.x * inv, v0 = glyph->src.y * inv;
+            float u1 = (glyph->src.x + glyph->src.w) * inv, v1 = (glyph->src.y + glyph->src.h) * inv;
+
+            vector<SDL_Vertex>& run = vertices[glyph->page];
+            int first = run.size();
+            run.push_back({{x0, y0}, color, {u0, v0}});
+            run.push_back({{x1, y0}, color, {u1, v0}});
+            run.push_back({{x1, y1}, color, {u1, v1}});
+            run.push_back({{x0, y1}, color, {u0, v1}});
+
+            const int quad[6] = {0, 1, 2, 0, 2, 3};
+            for(int k : quad) indices[glyph->page].push_back(first + k);
+        }
+
+        pen += glyph->advance;
+    }
+
+    // SUBMIT, ONE CALL PER PAGE ------------------------------------------------------------
+    for(size_t page = 0; page < vertices.size() && page < pages.size(); page++){
+        if(indices[page].empty()) continue;
+
+        int err = SDL_RenderGeometry(
+            Sys::renderer,
+            TM::resolve(pages[page].td),
+            vertices[page].data(),
+            vertices[page].size(),
+            indices[page].data(),
+            indices[page].size()
+        );
+        if(err != 0) return TEXT_RENDER_GEOMETRY_FAILED;
+
+        stats.quads += vertices[page].size() / 4;
+    }
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Get Stats
+ *
+ * @return Counters of the atlas pages and glyphs
+ */
+GlyphAtlasStats GlyphAtlas::getStats(){ return stats; }
@@ -0,0 +1,196 @@
+#pragma once
+#ifndef MySDL_TEXT
+#define MySDL_TEXT
+
+#include "../lib.h"
+#include "../TextureManager/TM.h"
+
+
+#define GLYPH_ATLAS_PAGE_SIZE   1024    // Width and height of an atlas page
+#define GLYPH_ATLAS_MAX_PAGES   8       // Once they are all full the atlas starts over
+
+#define FONT_REFERENCE_SIZE     128     // Point size of Sys::font, the sizes without a target height use it
+
+
+
+// FONT STATS --------------------------------------------------------------------------------------
+struct FontStats{
+    int files = 0;              // Mapped font files
+    int fonts = 0;              // Registered fonts, faces of those files
+    int faces = 0;              // Opened point sizes of all the fonts
+    size_t mappedBytes = 0;     // Size of the mapped files, shared by all the faces
+};
+
+
+
+// TEXT LAYOUT -------------------------------------------------------------------------------------
+struct TextLine{
+    int begin = 0;              // Byte range of the line in the text, without the
+    int end = 0;                // newline or the spaces it was wrapped at
+    int width = 0;              // In pixels, at the height of the layout
+};
+
+struct TextLayout{
+    vector<TextLine> lines;
+    int width = 0;              // Of the widest line
+    int height = 0;             // Of all the lines
+    int lineHeight = 0;
+};
+
+
+
+// FONTS -------------------------------------------------------------------------------------------
+// Registry of the fonts, every file is memory mapped once and all the faces
+// and point sizes of it are opened out of that mapping. Text is rendered at
+// the size bucket closest to its target height, instead of one large size
+// scaled down, so small text is rasterized and uploaded at the size it is
+// drawn at.
+class Fonts{
+    friend class Sys;
+
+    private:
+    struct Mapping{
+        string path;
+        Uint8* data = nullptr;
+        size_t size = 0;
+        bool mapped = false;        // mmap, otherwise loaded with SDL_LoadFile
+    };
+
+    // Face of a point size, with the advances of the glyphs looked up so far
+    struct Size{
+        TTF_Font* font = nullptr;
+        int height = 0;
+        bool kerning = false;
+        int ascii[128];                         // -1 until looked up
+        unordered_map<Uint32, int> advances;
+    };
+
+    struct Font{
+        int mapping = -1;
+        long index = 0;                         // Face of the file, for font collections
+        double heightPerPoint = 0;              // Line height of one point
+        unordered_map<int, Size> sizes;         // By point size
+    };
+
+    static inline vector<Mapping> mappings;
+    static inline vector<Font> fonts;
+    static inline FontStats stats;
+
+    static int map(const string& path, int& mapping);
+    static void unmap(Mapping& mapping);
+    static Size* getMetrics(int pointSize, int fontId);
+    static int advance(Size& size, Uint32 codepoint);
+    static void cleanup();
+
+    public:
+    static int load(const string& path, int& fontId, long faceIndex = 0);
+
+    static int pointSize(int height, int fontId = FONT_DEFAULT);
+    static TTF_Font* getSize(int pointSize, int fontId = FONT_DEFAULT);
+    static TTF_Font* get(int height, int fontId = FONT_DEFAULT);
+
+    static int render(
+        SDL_Surface*& surface,
+        const string& text,
+        int height,
+        const SDL_Color& color,
+        int quality = TEXT_BLENDED,
+        int fontId = FONT_DEFAULT,
+        const SDL_Color& background = SDL_COLOR_BLACK
+    );
+
+    static int measure(string_view text, int height, int& width, int fontId = FONT_DEFAULT);
+    static int glyphMetrics(Uint32 codepoint, Uint32 previous, int height, int& advance, int& kerning, int fontId = FONT_DEFAULT);
+    static double getScale(int height, int fontId = FONT_DEFAULT);
+    static int wrap(string_view text, int height, int maxWidth, TextLayout& layout, int fontId = FONT_DEFAULT);
+
+    static Uint32 nextCodepoint(string_view text, size_t& i);
+
+    static FontStats getStats();
+};
+
+
+
+// GLYPH ATLAS STATS -------------------------------------------------------------------------------
+struct GlyphAtlasStats{
+    int pages = 0;              // Atlas page textures
+    int faces = 0;              // Font sizes in use
+    int glyphs = 0;             // Glyphs in the atlas
+    Uint64 rasterized = 0;      // Glyphs rasterized since the start
+    Uint64 resets = 0;          // Times the atlas filled up and started over
+    Uint64 quads = 0;           // Glyph quads drawn since the start
+};
+
+
+
+// GLYPH ATLAS -------------------------------------------------------------------------------------
+// Text renderer drawing strings glyph by glyph out of shared atlas textures.
+// Every glyph is rasterized once per font size, white, into a shelf of an
+// atlas page. A string is laid out with kerning and drawn as textured quads,
+// one SDL_RenderGeometry per page, with the color as the vertex color. So
+// changing strings and color variants never create textures.
+//
+// Font sizes are bucketed by Fonts, a string is drawn from the closest larger
+// size and scaled down to the requested height. TEXT_SOLID strings get their
+// own 1 bit glyphs, TEXT_SHADED ones are drawn blended since the atlas has
+// no background to shade them over.
+class GlyphAtlas{
+    friend class Sys;
+
+    private:
+    struct Glyph{
+        int page = -1;          // -1 if it has no pixels, like a space
+        SDL_Rect src = {0, 0, 0, 0};
+        int offsetX = 0;        // From the pen position to the left edge of src
+        int advance = 0;
+        bool loaded = false;
+    };
+
+    struct Face{
+        TTF_Font* font = nullptr;   // Owned by Fonts
+        int size = 0;
+        bool solid = false;
+        int height = 0;
+        bool kerning = false;
+        Glyph ascii[128];
+        unordered_map<Uint32, Glyph> glyphs;
+    };
+
+    struct Page{
+        TextureData td;
+        int shelfY = 0;         // Top of the current shelf
+        int shelfHeight = 0;
+        int x = 0;              // Where the next glyph goes on the current shelf
+    };
+
+    static inline unordered_map<int, Face> faces;   // By font, point size and solid, GlyphAtlas::faceKey
+    static inline vector<Page> pages;
+    static inline GlyphAtlasStats stats;
+
+    // Reused by every draw, one run of quads per page
+    static inline vector<vector<SDL_Vertex>> vertices;
+    static inline vector<vector<int>> indices;
+
+    static int faceKey(int fontId, int size, bool solid);
+    static Face* getFace(int height, int quality, int fontId);
+    static Glyph* getGlyph(Face& face, Uint32 codepoint);
+    static int rasterize(Face& face, Uint32 codepoint, Glyph& glyph);
+    static int place(int width, int height, int& page, SDL_Point& pos);
+    static void reset();
+    static void cleanup();
+
+    public:
+    static int measure(string_view text, int height, int& width, int fontId = FONT_DEFAULT);
+    static int draw(
+        string_view text,
+        const SDL_Rect& dRect,
+        const SDL_Color& color,
+        int quality = TEXT_BLENDED,
+        int fontId = FONT_DEFAULT
+    );
+
+    static GlyphAtlasStats getStats();
+};
+
+#endif
+// Creator: @AndrijaRD
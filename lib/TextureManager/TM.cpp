@@ -1,6 +1,10 @@
 #include "./TM.h"
 #include "../System/Sys.h"
 #include "../Gui/gui.h"
+#include "../Pixel/Pixel.h"
+#include "../Jobs/Jobs.h"
+#include "../Qoi/Qoi.h"
+#include "../Plot/Plot.h"
 
 
 
@@ -17,18 +21,93 @@ int TM::loadTexture(
     const string& path
 ){
     // Ensure that privous Texture is de-loaded -----------------------------------------
-    if(td.tex != nullptr) TM::freeTexture(td);
+    if(td.tex != nullptr || td.id != 0) TM::freeTexture(td);
+
+    // Check the cache, the same file is decoded and uploaded only once -----------------
+    // Premultiplied and straight alpha copies of the same file are cached apart
+    string key = TM::cacheKey(path);
+    if(!key.empty() && loadPremultiplied) key += "|premultiplied";
+    auto cached = textureCache.find(key);
+    if(!key.empty() && cached != textureCache.end()){
+        TextureRecord& rec = records.at(cached->second);
+        rec.refs++;
+        td = rec.td;
+
+        cacheStats.hits++;
+        return NO_ERROR;
+    }
+    cacheStats.misses++;
+
+    // Decode the file and upload it -------------------------------------------------------
+    vector<Uint8> pixels;
+    int err = TM::createFromFile(td, path, retainPixels ? &pixels : nullptr, loadPremultiplied);
+    if(err != NO_ERROR) return err;
+
+    // TRACK AND CACHE THE TEXTURE --------------------------------------------------------
+    TM::track(td);
+    TextureRecord& rec = records.at(td.id);
+    rec.sourcePath = path;
+    rec.sourceKey = TM::cacheKey(path);
+    rec.premultiplied = loadPremultiplied;
+
+    if(!pixels.empty()){
+        residencyStats.retainedBytes += pixels.size();
+        rec.pixels = std::move(pixels);
+    }
+
+    if(!key.empty()){
+        rec.cacheKey = key;
+        textureCache[key] = td.id;
+
+        cacheStats.bytes += rec.bytes;
+        cacheStats.entries = textureCache.size();
+    }
+    
+    return NO_ERROR;
+}
+
+
+
+
+/** Create From File
+ * 
+ * INTERNAL USE
+ * 
+ * Decodes the image file and uploads it into a new render target texture.
+ * The texture is not tracked, that is left to the caller.
+ * 
+ * @param td TextureData object into which image should be loaded.
+ * @param path Path to the image on the filesystem
+ * @param pixels If not nullptr it gets a RGBA32 copy of the decoded image
+ * @param premultiplied Premultiply the pixels and use the premultiplied blend mode
+ * @return Returns 0 on success and positive number on error, coresponding to the ERROR DEFINITIONS 
+ */
+int TM::createFromFile(TextureData& td, const string& path, vector<Uint8>* pixels, bool premultiplied){
+    // QOI files, picked by the signature, skip IMG_Load and the surface conversion
+    if(QOI::isQOI(path)) return TM::createFromQOI(td, path, pixels, premultiplied);
 
     // Load the image -------------------------------------------------------------------
     SDL_Surface* surface = IMG_Load(path.c_str());
     if(surface == nullptr) return TM_SURFACE_CREATE_ERROR;
 
     // Check the format of the image ----------------------------------------------------
-    if(surface->format->BitsPerPixel != 32){
-        surface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
-        if(surface == nullptr){
+    if(surface->format->format != SDL_PIXELFORMAT_RGBA32){
+        SDL_Surface* converted = Pixel::convertToRGBA32(surface);
+        SDL_FreeSurface(surface);
+        if(converted == nullptr){
             return TM_SURFACE_CONVERT_ERROR;
         }
+        surface = converted;
+    }
+
+    // Premultiply the alpha --------------------------------------------------------------
+    if(premultiplied){
+        if(SDL_MUSTLOCK(surface)) SDL_LockSurface(surface);
+        for(int y = 0; y < surface->h; y++){
+            Uint8* row = (Uint8*)surface->pixels + (size_t)y * surface->pitch;
+            Pixel::premultiply(row, row, surface->w);
+        }
+        if(SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
     }
 
 
@@ -51,18 +130,29 @@ int TM::loadTexture(
     if(s != 0){
         SDL_FreeSurface(surface);
         SDL_DestroyTexture(td.tex);
+        td.tex = nullptr;
         return TM_TEXTURE_UPDATE_ERROR;
     }
 
 
+    // KEEP A COPY OF THE PIXELS ----------------------------------------------------------
+    if(pixels != nullptr){
+        size_t rowBytes = (size_t)surface->w * 4;
+        pixels->resize(rowBytes * surface->h);
+        for(int y = 0; y < surface->h; y++){
+            memcpy(pixels->data() + y * rowBytes, (Uint8*)surface->pixels + y * surface->pitch, rowBytes);
+        }
+    }
+
+
     // CLEAN UP ---------------------------------------------------------------------------
     SDL_FreeSurface(surface);
-    loadedTextures.push_back(td.tex);
 
     // MAKE TEXTURE UPDATATBLE/MODIFIABLE -------------------------------------------------
-    if(SDL_SetTextureBlendMode(td.tex, SDL_BLENDMODE_BLEND)){
-        SDL_FreeSurface(surface);
+    SDL_BlendMode blend = premultiplied ? TM::getPremultipliedBlendMode() : SDL_BLENDMODE_BLEND;
+    if(SDL_SetTextureBlendMode(td.tex, blend)){
         SDL_DestroyTexture(td.tex);
+        td.tex = nullptr;
         return TM_TEXTURE_SET_BLENDMODE_ERROR;
     }
 
@@ -70,28 +160,209 @@ int TM::loadTexture(
     SDL_QueryTexture(td.tex, &td.format, NULL, &td.width, &td.height);
     td.orgWidth = td.width;
     td.orgHeight = td.height;
-    
+
     return NO_ERROR;
 }
 
 
 
 
-/** Free Texture
+/** Create From QOI
  * 
- * Frees the texture from memory and sets the TextureData properties to null
- * @param td TextureData to be freeed
+ * INTERNAL USE
+ * 
+ * Same as TM::createFromFile, for the QOI files. They are decoded in chunks
+ * straight into the buffer the texture is uploaded from, which is kept as
+ * the retained copy, so there is no surface and no copy of the pixels.
+ * 
+ * @param td TextureData object into which image should be loaded.
+ * @param path Path to the .qoi file
+ * @param pixels If not nullptr it gets a RGBA32 copy of the decoded image
+ * @param premultiplied Premultiply the pixels and use the premultiplied blend mode
+ * @return Returns 0 on success and positive number on error, coresponding to the ERROR DEFINITIONS 
  */
-void TM::freeTexture(TextureData& td){
-    if(td.tex != nullptr){
+int TM::createFromQOI(TextureData& td, const string& path, vector<Uint8>* pixels, bool premultiplied){
+    // Decode the image -----------------------------------------------------------------
+    vector<Uint8> decoded;
+    vector<Uint8>& buffer = pixels != nullptr ? *pixels : decoded;
+
+    int width, height;
+    int err = QOI::load(path, buffer, width, height);
+    if(err != NO_ERROR) return err;
+
+    // Premultiply the alpha --------------------------------------------------------------
+    if(premultiplied){
+        Jobs::parallelFor(height, [&](int begin, int end){
+            Uint8* rows = buffer.data() + (size_t)begin * width * 4;
+            Pixel::premultiply(rows, rows, (end - begin) * width);
+        }, 64);
+    }
+
+    // CREATING THE TEXTURE --------------------------------------------------------------
+    td.tex = SDL_CreateTexture(
+        Sys::renderer,
+        SDL_PIXELFORMAT_RGBA32,
+        SDL_TEXTUREACCESS_TARGET,
+        width,
+        height
+    );
+    if(td.tex == nullptr) return TM_TEXTURE_CREATE_ERROR;
 
-        auto it = std::remove(loadedTextures.begin(), loadedTextures.end(), td.tex);
-        loadedTextures.erase(it, loadedTextures.end());
+    if(SDL_UpdateTexture(td.tex, NULL, buffer.data(), width * 4)){
+        SDL_DestroyTexture(td.tex);
+        td.tex = nullptr;
+        return TM_TEXTURE_UPDATE_ERROR;
+    }
 
+    // MAKE TEXTURE UPDATATBLE/MODIFIABLE -------------------------------------------------
+    SDL_BlendMode blend = premultiplied ? TM::getPremultipliedBlendMode() : SDL_BLENDMODE_BLEND;
+    if(SDL_SetTextureBlendMode(td.tex, blend)){
         SDL_DestroyTexture(td.tex);
         td.tex = nullptr;
+        return TM_TEXTURE_SET_BLENDMODE_ERROR;
+    }
+
+    td.format = SDL_PIXELFORMAT_RGBA32;
+    td.width = width;
+    td.height = height;
+    td.orgWidth = width;
+    td.orgHeight = height;
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Save Texture
+ * 
+ * Writes the texture into an image file, a .qoi file if the path ends
+ * with .qoi, otherwise a PNG. Useful for screenshots and cache files,
+ * the QOI ones load many times faster trough TM::loadTexture.
+ * 
+ * @param td TextureData to be saved, a render target or one with retained pixels
+ * @param path Path of the file to be written
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::saveTexture(const TextureData& td, const string& path){
+    auto it = records.find(td.id);
+    if(it == records.end()) return TM_GOT_NULLPTR_TEX;
+    TextureRecord& rec = it->second;
+
+    vector<Uint8> pixels;
+    int err = TM::readPixels(rec, pixels);
+    if(err != NO_ERROR) return err;
+
+    // Files hold straight alpha
+    int width = rec.td.width, height = rec.td.height;
+    if(rec.premultiplied) Pixel::unpremultiply(pixels.data(), pixels.data(), width * height);
+
+    // WRITE THE FILE ---------------------------------------------------------------------
+    bool qoi = path.size() >= 4 && path.compare(path.size() - 4, 4, ".qoi") == 0;
+    if(qoi){
+        err = QOI::save(path, pixels.data(), width, height);
+        return err == NO_ERROR ? NO_ERROR : TM_SAVE_FAILED;
+    }
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(
+        pixels.data(), width, height, 32, width * 4, SDL_PIXELFORMAT_RGBA32
+    );
+    if(surface == nullptr) return TM_SURFACE_CREATE_ERROR;
+
+    int status = IMG_SavePNG(surface, path.c_str());
+    SDL_FreeSurface(surface);
+    if(status != 0) return TM_SAVE_FAILED;
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Set Load Premultiplied
+ * 
+ * If enabled, TM::loadTexture multiplies the colors of the loaded images by
+ * their alpha and renders them with TM::getPremultipliedBlendMode. Scaled and
+ * blended edges of premultiplied textures dont get the dark or light fringes
+ * straight alpha gets from its transparent pixels. Off by default.
+ * 
+ * @param premultiplied Load the images with premultiplied alpha
+ */
+void TM::setLoadPremultiplied(bool premultiplied){ loadPremultiplied = premultiplied; }
+
+
+
+
+/** Get Premultiplied Blend Mode
+ * 
+ * Returns the blend mode for textures holding premultiplied alpha,
+ * dst = src + dst * (1 - srcAlpha), for both the color and the alpha.
+ */
+SDL_BlendMode TM::getPremultipliedBlendMode(){
+    static const SDL_BlendMode mode = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD
+    );
+    return mode;
+}
+
+
+
+
+/** Is Premultiplied
+ * 
+ * INTERNAL USE
+ * 
+ * @param td TextureData to be checked
+ * @return True if the texture holds premultiplied alpha pixels
+ */
+bool TM::isPremultiplied(const TextureData& td){
+    auto it = records.find(td.id);
+    return it != records.end() && it->second.premultiplied;
+}
+
+
+
+
+/** Mark Premultiplied
+ * 
+ * INTERNAL USE
+ * 
+ * Marks the texture as holding premultiplied alpha pixels, and
+ * sets the matching blend mode, used for copies of such textures.
+ * 
+ * @param td TextureData holding premultiplied pixels
+ */
+void TM::markPremultiplied(TextureData& td){
+    auto it = records.find(td.id);
+    if(it == records.end()) return;
+
+    it->second.premultiplied = true;
+    SDL_SetTextureBlendMode(td.tex, TM::getPremultipliedBlendMode());
+}
+
+
+
+
+/** Free Texture
+ * 
+ * Releases this reference to the texture and sets the TextureData properties to null.
+ * The texture itself is destroyed only once every reference to it has been freed,
+ * so textures shared trough the cache stay valid for the other holders.
+ * 
+ * @param td TextureData to be freeed
+ */
+void TM::freeTexture(TextureData& td){
+    if(td.id != 0){
+        TM::release(td);
+    } else if(td.tex != nullptr){
+        // Texture not created by TM, just destroy it
+        SDL_DestroyTexture(td.tex);
     }
 
+    td.tex = nullptr;
+    td.id = 0;
+    td.src = {0, 0, 0, 0};
     td.width = 0;
     td.height = 0;
     td.format = 0;
@@ -118,10 +389,25 @@ void TM::freeTexture(TextureData& td){
  * Called at the end of the program to free all of the textures
 */
 void TM::cleanup(){
-    for(auto tex : loadedTextures){
-        SDL_DestroyTexture(tex);
+    PolylineMesh::cleanup();
+
+    for(auto& record : records){
+        if(record.second.td.tex != nullptr) SDL_DestroyTexture(record.second.td.tex);
     }
-    loadedTextures.clear();
+    records.clear();
+    textureCache.clear();
+    variantCache.clear();
+    pendingScales.clear();
+    residentLru.clear();
+    TM::trimPool(0);
+
+    cacheStats.bytes = 0;
+    cacheStats.entries = 0;
+
+    residencyStats.residentBytes = 0;
+    residencyStats.packedBytes = 0;
+    residencyStats.retainedBytes = 0;
+    residencyStats.evictedTextures = 0;
 }
 
 
@@ -132,7 +418,7 @@ void TM::cleanup(){
  * 
  * Returns the number of currently loaded textures.
  */
-int TM::getLoadedTextures(){ return loadedTextures.size(); }
+int TM::getLoadedTextures(){ return records.size(); }
 
 
 
@@ -155,7 +441,8 @@ int TM::getLoadedTextures(){ return loadedTextures.size(); }
  */
 int TM::renderTexture(const TextureData& td, SDL_Rect& dr) {
     // CHECK IF TEXTURE IS VALID ---------------------------------------------------------
-    if(td.tex == nullptr) return TM_GOT_NULLPTR_TEX;
+    SDL_Texture* tex = TM::resolve(td);
+    if(tex == nullptr) return TM_GOT_NULLPTR_TEX;
 
     // CHECK IF DIMENSIONS ARE VALID ------------------------------------------------------
     if(dr.w < 0 && dr.h < 0) return TM_INVALID_DRECT;
@@ -167,7 +454,7 @@ int TM::renderTexture(const TextureData& td, SDL_Rect& dr) {
 
 
     // RENDER THE TEXTURE ON SCREEN -------------------------------------------------------
-    if(SDL_RenderCopy(Sys::renderer, td.tex, NULL, &dr)) return TM_RCPY_FAILED;
+    if(SDL_RenderCopy(Sys::renderer, tex, td.srcRect(), &dr)) return TM_RCPY_FAILED;
 
 
     return NO_ERROR;
@@ -179,47 +466,54 @@ int TM::renderTexture(const TextureData& td, SDL_Rect& dr) {
 
 /** Create Text Texture
  * 
- * Creates a texture from a text using TTF_RenderUTF8_Blended.
+ * Creates a texture from a text using Fonts::render, at the font size
+ * bucket of the height it will be drawn at.
  * It saves the texture into td TextureData and fills the rest of the object data.
+ * The texture is taken from the texture pool and goes back to it once freed.
  * 
  * @param td TextureData object where texture and side data will be placed
  * @param text The text to be compiled into texture
  * @param colo SDL_Color object, representing the color of the text
+ * @param height Height the text will be drawn at, -1 for FONT_REFERENCE_SIZE
+ * @param quality TEXT_SOLID, TEXT_SHADED or TEXT_BLENDED
+ * @param fontId Font registered with Fonts::load
  * @return 0 on success and positive error code on error
  */
 int TM::createTextTexture(
     TextureData& td, 
     const string& text,
-    const SDL_Color& color
+    const SDL_Color& color,
+    int height,
+    int quality,
+    int fontId
 ){
     // Ensure that privous Texture is de-loaded -----------------------------------------
-    if(td.tex != nullptr) TM::freeTexture(td);
+    if(td.tex != nullptr || td.id != 0) TM::freeTexture(td);
 
     // Create the text texture and store it as surface ----------------------------------
-    SDL_Surface* surface = TTF_RenderUTF8_Blended(Sys::font, text.c_str(), color);
-    if(surface == nullptr) return TM_SURFACE_CREATE_ERROR;
-
-    // Create texture from it and store it in TextureData
-    td.tex = SDL_CreateTextureFromSurface(Sys::renderer, surface);
-    if(td.tex == nullptr) {
-        SDL_FreeSurface(surface);
-        return TM_TEXTURE_CREATE_ERROR;
-    }
+    SDL_Surface* surface;
+    int err = Fonts::render(surface, text, height, color, quality, fontId);
+    if(err != NO_ERROR) return err;
 
-    // MAKE TEXTURE UPDATATBLE/MODIFIABLE -------------------------------------------------
-    if(SDL_SetTextureBlendMode(td.tex, SDL_BLENDMODE_BLEND)){
+    // Get a texture from the pool and upload the text into it -----------------------
+    err = TM::acquireTexture(
+        td,
+        surface->w,
+        surface->h,
+        surface->format->format,
+        SDL_TEXTUREACCESS_STATIC
+    );
+    if(err != NO_ERROR){
         SDL_FreeSurface(surface);
-        SDL_DestroyTexture(td.tex);
-        return TM_TEXTURE_SET_BLENDMODE_ERROR;
+        return err;
     }
 
-    // GET TEXTURE DIMENSIONS -------------------------------------------------------------
-    SDL_QueryTexture(td.tex, &td.format, NULL, &td.width, &td.height);
-    td.orgWidth = td.width;
-    td.orgHeight = td.height;
-
+    err = SDL_UpdateTexture(td.tex, &td.src, surface->pixels, surface->pitch);
     SDL_FreeSurface(surface);
-    loadedTextures.push_back(td.tex);
+    if(err != 0){
+        TM::freeTexture(td);
+        return TM_TEXTURE_UPDATE_ERROR;
+    }
 
     return NO_ERROR;
 }
@@ -244,46 +538,47 @@ int TM::createTextTexture(
  */
 int TM::copy(const TextureData& src, TextureData& dst){
     int err;
-    if(dst.tex != nullptr){
+    if(dst.tex != nullptr || dst.id != 0){
         TM::freeTexture(dst);
     }
 
-    // Create a new texture with the same format and size as the original
-    dst.tex = SDL_CreateTexture(
-        Sys::renderer, 
-        src.format, 
-        SDL_TEXTUREACCESS_TARGET, 
-        src.width, 
-        src.height
-    );
-    if (dst.tex == nullptr) {
-        return TM_TEXTURE_CREATE_ERROR;
-    }
-    
-    // Set the render target to the new texture to copy from the source texture
-    err = SDL_SetRenderTarget(Sys::renderer, dst.tex);
-    if(err) return TM_SRT_FAILED;
+    SDL_Texture* srcTex = TM::resolve(src);
+    if(srcTex == nullptr) return TM_GOT_NULLPTR_TEX;
 
-    // Clear the target texture
-    err = SDL_RenderClear(Sys::renderer);
-    if(err) return TM_RCLR_FAILED;
+    // Get a texture with the same format and size as the original
+    err = TM::acquireTexture(dst, src.width, src.height, src.format, SDL_TEXTUREACCESS_TARGET);
+    if(err != NO_ERROR) return err;
+    
+    // Set the render target to the new texture to copy from the source texture,
+    // the target set before (an overlay or a GUI layer) is put back on every path
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(Sys::renderer);
+    bool premultiplied = TM::isPremultiplied(src);
+    err = NO_ERROR;
+    if(SDL_SetRenderTarget(Sys::renderer, dst.tex)){
+        err = TM_SRT_FAILED;
+    } else {
+        // Clear the target texture, it could be a reused one
+        // Premultiplied pixels are copied exactly only onto transparent black
+        if(premultiplied) SDL_SetRenderDrawColor(Sys::renderer, 0, 0, 0, 0);
+        else SDL_SetRenderDrawColor(Sys::renderer, SDL_COLOR_TRANSP);
+
+        // Copy the content of the source texture to the new one
+        if(SDL_RenderClear(Sys::renderer)) err = TM_RCLR_FAILED;
+        else if(SDL_RenderCopy(Sys::renderer, srcTex, src.srcRect(), &dst.src)) err = TM_RCPY_FAILED;
+    }
 
-    // Copy the content of the source texture to the new one
-    err = SDL_RenderCopy(Sys::renderer, src.tex, NULL, NULL);
-    if(err) return TM_RCPY_FAILED;
+    if(SDL_SetRenderTarget(Sys::renderer, previousTarget) && err == NO_ERROR) err = TM_SRT_FAILED;
+    if(err != NO_ERROR){
+        // Give the pooled texture back
+        TM::freeTexture(dst);
+        return err;
+    }
 
-    // Reset the render target to the default (the screen)
-    err = SDL_SetRenderTarget(Sys::renderer, nullptr);
-    if(err) return TM_SRT_FAILED;
+    if(premultiplied) TM::markPremultiplied(dst);
 
-    dst.width = src.width;
-    dst.height = src.height;
-    dst.format = src.format;
     dst.orgWidth = src.orgWidth;
     dst.orgHeight = src.orgHeight;
 
-    loadedTextures.push_back(dst.tex);
-
     return NO_ERROR;
 };
 
@@ -294,41 +589,46 @@ int TM::copy(const TextureData& src, TextureData& dst){
 int TM::resize(TextureData& td, int targetWidth, int targetHeight){
     if(targetWidth == -1 && targetHeight == -1) return TM_INVALID_DRECT;
 
+    SDL_Texture* srcTex = TM::resolve(td);
+    if(srcTex == nullptr) return TM_GOT_NULLPTR_TEX;
+
     if(targetWidth == -1) targetWidth = static_cast<int>(td.width * (static_cast<float>(targetHeight) / td.height));
     if(targetHeight == -1) targetHeight = static_cast<int>(td.height * (static_cast<float>(targetWidth) / td.width));
 
-    SDL_Texture* resizedTexture = SDL_CreateTexture(
-        Sys::renderer,
-        td.format, // Use a standard pixel format
-        SDL_TEXTUREACCESS_TARGET, // Texture will be used as a render target
-        targetWidth, 
-        targetHeight
-    );
-
-    if(!resizedTexture) return TM_TEXTURE_CREATE_ERROR;
+    // Texture will be used as a render target
+    TextureData resized;
+    int err = TM::acquireTexture(resized, targetWidth, targetHeight, td.format, SDL_TEXTUREACCESS_TARGET);
+    if(err != NO_ERROR) return err;
     
-    int err = SDL_SetRenderTarget(Sys::renderer, resizedTexture);
-    if(err != 0) return TM_SRT_FAILED;
-
-    SDL_Rect srcRect = { 0, 0, td.width, td.height };
-    SDL_Rect dstRect = { 0, 0, targetWidth, targetHeight };
-    err = SDL_RenderCopy(Sys::renderer, td.tex, &srcRect, &dstRect);
-    if(err != 0) return TM_RCPY_FAILED;
-
-
-    err = SDL_SetRenderTarget(Sys::renderer, nullptr);
-    if(err != 0) return TM_SRT_FAILED;
-
-    if(SDL_SetTextureBlendMode(resizedTexture, SDL_BLENDMODE_BLEND)){
-        SDL_DestroyTexture(resizedTexture);
-        return TM_TEXTURE_SET_BLENDMODE_ERROR;
+    // The target set before is put back on every path
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(Sys::renderer);
+    bool premultiplied = TM::isPremultiplied(td);
+    err = NO_ERROR;
+    if(SDL_SetRenderTarget(Sys::renderer, resized.tex)){
+        err = TM_SRT_FAILED;
+    } else {
+        // Clear the target texture, it could be a reused one
+        if(premultiplied) SDL_SetRenderDrawColor(Sys::renderer, 0, 0, 0, 0);
+        else SDL_SetRenderDrawColor(Sys::renderer, SDL_COLOR_TRANSP);
+
+        SDL_Rect srcRect = { td.src.x, td.src.y, td.width, td.height };
+        if(SDL_RenderClear(Sys::renderer)) err = TM_RCLR_FAILED;
+        else if(SDL_RenderCopy(Sys::renderer, srcTex, &srcRect, &resized.src)) err = TM_RCPY_FAILED;
     }
 
-    SDL_DestroyTexture(td.tex);
+    if(SDL_SetRenderTarget(Sys::renderer, previousTarget) && err == NO_ERROR) err = TM_SRT_FAILED;
+    if(err != NO_ERROR){
+        TM::freeTexture(resized);
+        return err;
+    }
 
-    td.tex = resizedTexture;
-    td.width = targetWidth;
-    td.height = targetHeight;
+    // Release the old texture, if it is shared trough the cache the
+    // other holders keep it, and the resized one takes its place
+    resized.orgWidth = td.orgWidth;
+    resized.orgHeight = td.orgHeight;
+    if(premultiplied) TM::markPremultiplied(resized);
+    TM::release(td);
+    td = resized;
 
     return NO_ERROR;
 }
@@ -338,7 +638,8 @@ int TM::resize(TextureData& td, int targetWidth, int targetHeight){
 
 /** Draw Overlay Texture
  * 
- * Draws a texture on top of this texture.
+ * Draws a texture on top of this texture. For drawing more then one
+ * thing use an OverlayScope, which switches the render target only once.
  * Just like the TM::renderTexture it is able to dinamicly calculate one
  * missing dimension of the dRect, {10, 10, 100, -1}, and it calculates the
  * missing height and it updates it and then renderes the texture
@@ -348,28 +649,12 @@ int TM::resize(TextureData& td, int targetWidth, int targetHeight){
  * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
  */
 int TextureData::drawOverlayTexture(const TextureData& td, SDL_Rect& dr){
-    int err;
-
-    // CHECK IF DIMENSIONS ARE VALID ------------------------------------------------------
-    if(dr.w < 0 && dr.h < 0) return TM_INVALID_DRECT;
-
-    // CALCULATE IF ONE DIMENSION IS MISSING ----------------------------------------------
-    if(dr.w == -1) dr.w = dr.h * (float)td.width / td.height;
-    if(dr.h == -1) dr.h = dr.w * (float)td.height / td.width;
-
-    // Set the render target to the new texture ----------------------------------------
-    err = SDL_SetRenderTarget(Sys::renderer, this->tex);
-    if(err != 0) return TM_SRT_FAILED;
-
-    // Copy the content of the source texture to the new one ---------------------------
-    err = SDL_RenderCopy(Sys::renderer, td.tex, NULL, &dr);
-    if(err != 0) return TM_RCPY_FAILED;
+    OverlayScope overlay(*this);
 
-    // Reset the render target to the default (the screen) -----------------------------
-    err = SDL_SetRenderTarget(Sys::renderer, nullptr);
-    if(err != 0) return TM_SRT_FAILED;
+    int err = overlay.texture(td, dr);
+    if(err != NO_ERROR) return err;
 
-    return NO_ERROR;
+    return overlay.end();
 }
 
 
@@ -405,28 +690,12 @@ int TextureData::drawOverlayTexture(const TextureData& td){
  * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
  */
 int TextureData::drawOverlayFRect(const SDL_Rect& rect, const SDL_Color& color){
-    int err;
-
-    // CHECK IF DIMENSIONS ARE VALID ------------------------------------------------------
-    if(rect.w < 0 && rect.h < 0) return TM_INVALID_DRECT;
-
-    // Set the texture as the target for drawing
-    err = SDL_SetRenderTarget(Sys::renderer, this->tex);
-    if(err != 0) return TM_SRT_FAILED;
-
-    // Set the color for use by renderer
-    err = SDL_SetRenderDrawColor(Sys::renderer, color);
-    if(err != 0) return TM_SRDC_FAILED;
+    OverlayScope overlay(*this);
 
-    // Draw Filled Rect
-    err = SDL_RenderFillRect(Sys::renderer, &rect);
-    if(err != 0) return TM_FILL_RECT_ERROR;
+    int err = overlay.fillRect(rect, color);
+    if(err != NO_ERROR) return err;
 
-    // Reset the render target back to window
-    err = SDL_SetRenderTarget(Sys::renderer, nullptr);
-    if(err != 0) return TM_SRT_FAILED;
-
-    return NO_ERROR;
+    return overlay.end();
 }
 
 
@@ -444,50 +713,12 @@ int TextureData::drawOverlayFRect(const SDL_Rect& rect, const SDL_Color& color){
  * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
  */
 int TextureData::drawOverlayLine(const SDL_Point& p1, const SDL_Point& p2, const SDL_Color& color, const int& thickness){
-    int err;
-
-    // Set the texture as the target for drawing
-    err = SDL_SetRenderTarget(Sys::renderer, this->tex);
-    if(err != 0) return TM_SRT_FAILED;
-
-    // Set the color for use by renderer
-    err = SDL_SetRenderDrawColor(Sys::renderer, color);
-    if(err != 0) return TM_SRDC_FAILED;
-
-    // DRAWING LINE ------------------------------------------
+    OverlayScope overlay(*this);
 
-    // Calculate the line's direction vector
-    double dx = p2.x - p1.x;
-    double dy = p2.y - p1.y;
-    double length = std::sqrt(dx * dx + dy * dy);
+    int err = overlay.line(p1, p2, color, thickness);
+    if(err != NO_ERROR) return err;
 
-    if(length <= 0) return TM_INVALID_LINE_LENGTH;
-
-    // Normalize the direction vector
-    dx /= length;
-    dy /= length;
-
-    // Calculate the perpendicular vector for thickness
-    double px = -dy * (thickness / 2.0);
-    double py = dx * (thickness / 2.0);
-
-    // Define the four corners of the rectangle representing the thick line
-    SDL_Vertex vertices[4] = {
-        {SDL_FPoint{static_cast<float>(p1.x + px), static_cast<float>(p1.y + py)}, color, SDL_FPoint{0, 0}},
-        {SDL_FPoint{static_cast<float>(p1.x - px), static_cast<float>(p1.y - py)}, color, SDL_FPoint{0, 0}},
-        {SDL_FPoint{static_cast<float>(p2.x - px), static_cast<float>(p2.y - py)}, color, SDL_FPoint{0, 0}},
-        {SDL_FPoint{static_cast<float>(p2.x + px), static_cast<float>(p2.y + py)}, color, SDL_FPoint{0, 0}}
-    };
-
-
-    // Draw the thick line as a filled polygon
-    SDL_RenderGeometry(Sys::renderer, nullptr, vertices, 4, nullptr, 0);
-    
-    // Reset the render target back to window
-    err = SDL_SetRenderTarget(Sys::renderer, nullptr);
-    if(err != 0) return TM_SRT_FAILED;
-
-    return NO_ERROR;
+    return overlay.end();
 }
 
 
@@ -495,17 +726,12 @@ int TextureData::drawOverlayLine(const SDL_Point& p1, const SDL_Point& p2, const
 
 
 int TextureData::drawOverlayText(const string& text, SDL_Rect& dRect, const SDL_Color& color){
-    int err;
+    OverlayScope overlay(*this);
 
-    err = SDL_SetRenderTarget(Sys::renderer, this->tex);
-    if(err != 0) return TM_SRT_FAILED;
+    int err = overlay.text(text, dRect, color);
+    if(err != NO_ERROR) return err;
 
-    GUI::Text(text, dRect, color);
-
-    err = SDL_SetRenderTarget(Sys::renderer, nullptr);
-    if(err != 0) return TM_SRT_FAILED;
-
-    return NO_ERROR;
+    return overlay.end();
 }
 
 
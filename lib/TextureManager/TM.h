@@ -4,6 +4,11 @@
 
 #include "../lib.h"
 
+// SCALING FILTERS ---------------------------------------------------------------------------------
+#define TM_FILTER_BOX       0
+#define TM_FILTER_BILINEAR  1
+#define TM_FILTER_LANCZOS   2
+
 
 // GENERAL STRUCT FOR IMAGES -----------------------------------------------------------------------
 struct TextureData{
@@ -13,13 +18,18 @@ struct TextureData{
     int height;
     int orgWidth;
     int orgHeight;
+    Uint32 id;          // TM handle id, shared by every copy of the same texture, 0 if not tracked by TM
+    SDL_Rect src;       // Part of the texture holding the image, empty if it is the whole texture
 
     TextureData(
         SDL_Texture* t = nullptr,
         Uint32 f = SDL_PIXELFORMAT_RGBA32,
         int w = 0,
         int h = 0
-    ): tex(t), format(f), width(w), height(h) {};
+    ): tex(t), format(f), width(w), height(h), id(0), src({0, 0, 0, 0}) {};
+
+    // Source rect to be used when rendering the texture, nullptr for the whole texture
+    const SDL_Rect* srcRect() const { return src.w > 0 ? &src : nullptr; }
 
     int drawOverlayTexture(
         const TextureData& td,
@@ -50,6 +60,72 @@ struct TextureData{
 };
 
 
+// STREAMING TEXTURE -------------------------------------------------------------------------------
+// Texture for content that changes every frame. The application writes into
+// the CPU copy while the renderer reads the front buffer, and on unlock only
+// the dirty area is uploaded into the back buffer which then becomes the front.
+struct StreamingTexture{
+    TextureData buffers[2];
+    int front = 0;              // Index of the buffer that is rendered
+    vector<Uint8> pixels;       // CPU copy of the content
+    int pitch = 0;
+    SDL_Rect dirty[2] = {};     // Area in which each buffer is behind the CPU copy
+    bool locked = false;
+
+    const TextureData& td() const { return buffers[front]; }
+};
+
+
+// OVERLAY SCOPE -----------------------------------------------------------------------------------
+// Draws any number of primitives onto a texture with a single render target
+// switch. Rects, lines and textures are recorded as quads and submitted with
+// one SDL_RenderGeometry call per run of primitives using the same texture.
+// The batch is submitted on flush(), on text or once the scope ends, and then
+// the previously active render target is restored.
+//
+//     OverlayScope overlay(badge);
+//     overlay.fillRect({0, 0, 64, 64}, SDL_COLOR_BLUE);
+//     overlay.line({0, 0}, {64, 64}, SDL_COLOR_WHITE, 3);
+//     overlay.end();     // Or just let it go out of scope
+class OverlayScope{
+    public:
+    OverlayScope(TextureData& target);
+    ~OverlayScope();
+
+    OverlayScope(const OverlayScope&) = delete;
+    OverlayScope& operator=(const OverlayScope&) = delete;
+
+    int fillRect(const SDL_Rect& rect, const SDL_Color& color);
+    int line(const SDL_Point& p1, const SDL_Point& p2, const SDL_Color& color, int thickness);
+    int texture(const TextureData& td, SDL_Rect& dr);
+    int text(const string& text, SDL_Rect& dRect, const SDL_Color& color);
+
+    int flush();
+    int end();
+
+    int getError() const { return error; }
+    int getSubmissions() const { return submissions; }
+
+    private:
+    static inline OverlayScope* current = nullptr;  // Innermost active scope
+
+    TextureData& target;
+    OverlayScope* parent = nullptr;
+    SDL_Texture* previousTarget = nullptr;
+    bool active = false;
+    int error = NO_ERROR;
+    int submissions = 0;        // SDL_RenderGeometry calls made
+
+    // Current batch, nullptr texture for the solid color primitives
+    SDL_Texture* batchTexture = nullptr;
+    vector<SDL_Vertex> vertices;
+    vector<int> indices;
+
+    int addQuad(SDL_Texture* tex, const SDL_FPoint pos[4], const SDL_Color& color, const SDL_FPoint uv[4]);
+};
+
+
+
 // CREATE << OPERATOR HANDLE FUNC ------------------------------------------------------------------
 inline std::ostream& operator<<(std::ostream& os, const TextureData& td){
     os << "TextureData(";
@@ -63,12 +139,155 @@ inline std::ostream& operator<<(std::ostream& os, const TextureData& td){
 
 
 
+// TEXTURE CACHE STATS -----------------------------------------------------------------------------
+struct TextureCacheStats{
+    Uint64 hits = 0;        // loadTexture calls served from the cache
+    Uint64 misses = 0;      // loadTexture calls that had to decode the file
+    size_t bytes = 0;       // Texture memory held by the cached textures
+    int entries = 0;        // Number of currently cached files
+};
+
+
+// TEXTURE RESIDENCY STATS -------------------------------------------------------------------------
+struct TextureResidencyStats{
+    size_t budget = 0;              // Texture memory budget, 0 means unlimited
+    size_t residentBytes = 0;       // Memory of the textures currently on the GPU
+    size_t packedBytes = 0;         // RAM held by the compressed copies of evicted textures
+    size_t retainedBytes = 0;       // RAM held by the retained pixels (TM::setRetainPixels)
+    int evictedTextures = 0;        // Number of currently evicted textures
+    Uint64 evictions = 0;           // Total number of evictions
+    Uint64 restores = 0;            // Total number of restores
+    double restoreMs = 0;           // Total time spent restoring evicted textures
+    double lastFrameRestoreMs = 0;  // Time spent restoring textures during the last frame
+};
+
+
+// TEXTURE POOL STATS ------------------------------------------------------------------------------
+struct TexturePoolStats{
+    Uint64 hits = 0;            // Textures handed out from the pool
+    Uint64 misses = 0;          // Textures that had to be created
+    int pooledTextures = 0;     // Idle textures waiting in the pool
+    size_t pooledBytes = 0;     // Memory held by the idle textures
+
+    double hitRate() const { return (hits + misses) ? (double)hits / (hits + misses) : 0; }
+};
+
+
+// STREAMING UPLOAD STATS --------------------------------------------------------------------------
+struct TextureUploadStats{
+    size_t lastFrameBytes = 0;      // Bytes uploaded to streaming textures during the last frame
+    int lastFrameUploads = 0;       // Number of SDL_UpdateTexture calls during the last frame
+    Uint64 totalBytes = 0;          // Bytes uploaded since the start
+};
+
+
+
 class TM{
+    friend struct TextureData;
+    friend class OverlayScope;
+
     private:
-    static inline vector<SDL_Texture*> loadedTextures;
+    // Every texture created by TM is tracked by a record, TextureData
+    // copies share the record trough TextureData::id, and the texture
+    // is destroyed once the last reference is freed.
+    struct TextureRecord{
+        TextureData td;     // The shared texture and its dimensions
+        int refs = 1;       // Number of references, each freed by one TM::freeTexture
+        size_t bytes = 0;   // Texture memory size
+        string cacheKey;    // Key in textureCache, empty if texture is not cached
+
+        // Residency, only render targets can be evicted since only they can be read back
+        int access = SDL_TEXTUREACCESS_STATIC;
+        SDL_BlendMode blend = SDL_BLENDMODE_BLEND;
+        int lastFrame = 0;                  // Last frame the texture was used in
+        bool evicted = false;
+        string sourcePath;                  // File the texture can be reloaded from, empty if it was modified
+        string sourceKey;                   // TM::cacheKey of the file when it was loaded, it has to match to reload it
+        bool lost = false;                  // Couldnt be restored, stays evicted and isnt tried again
+        vector<char> packed;                // LZ4 compressed pixels of an evicted texture without source file
+        list<Uint32>::iterator lru;         // Position in residentLru
+
+        // Actual texture size, pooled textures can be larger then the image they hold
+        int texWidth = 0;
+        int texHeight = 0;
+        bool pooled = false;                // Goes back to the pool once freed
+        Uint64 poolKey = 0;
+
+        vector<Uint8> pixels;               // Retained RGBA32 copy of the loaded image, see TM::setRetainPixels
+        Uint64 variantKey = 0;              // Key in variantCache if this is a scaled variant
+        bool hasVariants = false;           // Has scaled variants in variantCache
+        bool premultiplied = false;         // Holds premultiplied alpha pixels, see TM::setLoadPremultiplied
+    };
+
+    // Scaling done on the worker threads, uploaded once it is done
+    struct ScaleJob{
+        vector<Uint8> pixels;
+        int width = 0;
+        int height = 0;
+        shared_future<void> done;
+    };
+
+    static inline unordered_map<Uint32, TextureRecord> records;
+    static inline unordered_map<string, Uint32> textureCache;   // Cache key -> record id
+    static inline TextureCacheStats cacheStats;
+    static inline Uint32 nextId = 1;
+
+    static inline list<Uint32> residentLru;     // Evictable resident textures, most recently used first
+    static inline size_t textureBudget = 0;
+    static inline TextureResidencyStats residencyStats;
+    static inline double frameRestoreMs = 0;
+
+    // Idle textures, by format, access and power of two size class
+    static inline unordered_map<Uint64, vector<SDL_Texture*>> texturePool;
+    static inline TexturePoolStats poolStats;
+    static inline size_t poolBudget = 64 * 1024 * 1024;
+
+    static inline bool retainPixels = false;
+    static inline bool loadPremultiplied = false;
+    static inline unordered_map<Uint64, Uint32> variantCache;              // (source, size, filter) -> record id
+    static inline unordered_map<Uint64, shared_ptr<ScaleJob>> pendingScales;
+
+    static inline TextureUploadStats uploadStats;
+    static inline size_t frameUploadBytes = 0;
+    static inline int frameUploads = 0;
+
+    static void track(TextureData& td);
+    static void release(TextureData& td);
+    static void detach(TextureData& td);
+    static string cacheKey(const string& path);
+    static int createFromFile(
+        TextureData& td,
+        const string& path,
+        vector<Uint8>* pixels = nullptr,
+        bool premultiplied = false
+    );
+    static int createFromQOI(
+        TextureData& td,
+        const string& path,
+        vector<Uint8>* pixels = nullptr,
+        bool premultiplied = false
+    );
+    static bool isPremultiplied(const TextureData& td);
+    static void markPremultiplied(TextureData& td);
+    static int readPixels(TextureRecord& rec, vector<Uint8>& pixels);
+    static int uploadVariant(Uint64 key, Uint32 sourceId, ScaleJob& job);
+    static void dropVariants(Uint32 sourceId);
+
+    static Uint64 poolKey(Uint32 format, int access, int& width, int& height);
+    static size_t poolBytes(Uint64 key);
+    static int clearPadding(SDL_Texture* tex, Uint32 format, int width, int height, int classWidth, int classHeight);
+    static SDL_Texture* takeFromPool(Uint64 key);
+    static void returnToPool(TextureRecord& rec);
+    static void trimPool(size_t bytes);
+
+    static void enforceBudget();
+    static int evict(TextureRecord& rec);
+    static int restore(TextureRecord& rec);
 
     public:
     static int loadTexture(TextureData& td, const string& path);
+    static int loadTexture(TextureData& td, const void* data, size_t size, const string& key = "");
+    static int saveTexture(const TextureData& td, const string& path);
 
     static void freeTexture(TextureData& td);
     // static void freeTexture(SDL_Texture* tex); // Dangerous, dangling pointer left
@@ -76,6 +295,13 @@ class TM{
     static void cleanup();
     static int getLoadedTextures();
 
+    static TextureCacheStats getCacheStats();
+
+    static SDL_Texture* resolve(const TextureData& td);
+    static void setTextureBudget(size_t bytes);
+    static TextureResidencyStats getResidencyStats();
+    static void endFrame();
+
     static int renderTexture(const TextureData& td, SDL_Rect& dr);
 
     static int copy(const TextureData& src, TextureData& dst);
@@ -83,7 +309,10 @@ class TM{
     static int createTextTexture(
         TextureData& td, 
         const string& text,
-        const SDL_Color& color
+        const SDL_Color& color,
+        int height = -1,
+        int quality = TEXT_BLENDED,
+        int fontId = FONT_DEFAULT
     );
 
     static int resize(
@@ -91,6 +320,76 @@ class TM{
         int width,
         int height = -1
     );
+
+    static int scaleVariant(
+        const TextureData& src,
+        TextureData& dst,
+        int width,
+        int height = -1,
+        int filter = TM_FILTER_LANCZOS,
+        bool wait = true
+    );
+
+    static void scalePixels(
+        const Uint8* src, int srcWidth, int srcHeight,
+        Uint8* dst, int dstWidth, int dstHeight,
+        int filter = TM_FILTER_LANCZOS
+    );
+
+    static void setRetainPixels(bool retain);
+
+    static int decodeImage(
+        const void* data,
+        size_t size,
+        vector<Uint8>& pixels,
+        int& width,
+        int& height,
+        bool premultiplied = false
+    );
+
+    static int uploadImage(
+        TextureData& td,
+        vector<Uint8>& pixels,
+        int width,
+        int height,
+        const string& key = "",
+        bool premultiplied = false
+    );
+
+    static bool getCached(TextureData& td, const string& key, bool premultiplied = false);
+
+    static void setLoadPremultiplied(bool premultiplied);
+    static bool getLoadPremultiplied();
+    static SDL_BlendMode getPremultipliedBlendMode();
+
+    static int acquireTexture(
+        TextureData& td,
+        int width,
+        int height,
+        Uint32 format = SDL_PIXELFORMAT_RGBA32,
+        int access = SDL_TEXTUREACCESS_TARGET
+    );
+    static void setPoolBudget(size_t bytes);
+    static TexturePoolStats getPoolStats();
+    static size_t getTextureBytes(const TextureData& td);
+
+    static int createStreamingTexture(
+        StreamingTexture& st,
+        int width,
+        int height,
+        Uint32 format = SDL_PIXELFORMAT_RGBA32
+    );
+
+    static int lockStreamingTexture(
+        StreamingTexture& st,
+        void** pixels,
+        int* pitch,
+        const SDL_Rect* rect = nullptr
+    );
+
+    static int unlockStreamingTexture(StreamingTexture& st);
+    static void freeStreamingTexture(StreamingTexture& st);
+    static TextureUploadStats getUploadStats();
 };
 
 #endif
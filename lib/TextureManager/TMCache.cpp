@@ -0,0 +1,165 @@
+#include "./TM.h"
+#include "../System/Sys.h"
+
+
+
+/** Track
+ *
+ * INTERNAL USE
+ *
+ * Gives the newly created texture a handle id and creates its record
+ * holding the single reference owned by td.
+ *
+ * @param td TextureData holding the freshly created texture
+ */
+void TM::track(TextureData& td){
+    td.id = nextId++;
+    if(nextId == 0) nextId = 1; // 0 is reserved for untracked textures
+
+    TextureRecord rec;
+    rec.td = td;
+    rec.lastFrame = Sys::getCurrentFrame();
+    SDL_QueryTexture(td.tex, NULL, &rec.access, &rec.texWidth, &rec.texHeight);
+    rec.bytes = (size_t)rec.texWidth * rec.texHeight * SDL_BYTESPERPIXEL(td.format);
+
+    auto& inserted = records.insert({td.id, rec}).first->second;
+
+    // Render targets can be evicted, so they are kept in the LRU list
+    residencyStats.residentBytes += rec.bytes;
+    if(rec.access == SDL_TEXTUREACCESS_TARGET){
+        residentLru.push_front(td.id);
+        inserted.lru = residentLru.begin();
+    }
+
+    // Otherwise it is left to TM::endFrame, once per frame
+    if(textureBudget != 0 && residencyStats.residentBytes + poolStats.pooledBytes > textureBudget){
+        TM::enforceBudget();
+    }
+}
+
+
+
+
+/** Release
+ *
+ * INTERNAL USE
+ *
+ * Drops one reference of the texture held by td, and if it was the last one
+ * the texture is destroyed and removed from the cache. It doesnt reset td.
+ *
+ * @param td TextureData whose reference is released
+ */
+void TM::release(TextureData& td){
+    auto it = records.find(td.id);
+    if(it == records.end()) return;     // Already freed trough another copy
+
+    TextureRecord& rec = it->second;
+    if(--rec.refs > 0) return;
+
+    if(!rec.cacheKey.empty()){
+        textureCache.erase(rec.cacheKey);
+        cacheStats.bytes -= rec.bytes;
+        cacheStats.entries = textureCache.size();
+    }
+
+    // Scaled variants of this texture and the variant cache entry of this one
+    if(rec.hasVariants) TM::dropVariants(td.id);
+    if(rec.variantKey != 0) variantCache.erase(rec.variantKey);
+    residencyStats.retainedBytes -= rec.pixels.size();
+
+    if(rec.evicted){
+        residencyStats.packedBytes -= rec.packed.size();
+        residencyStats.evictedTextures--;
+    } else {
+        residencyStats.residentBytes -= rec.bytes;
+        if(rec.access == SDL_TEXTUREACCESS_TARGET) residentLru.erase(rec.lru);
+
+        if(rec.pooled) TM::returnToPool(rec);
+        else SDL_DestroyTexture(rec.td.tex);
+    }
+
+    records.erase(it);
+}
+
+
+
+
+/** Detach
+ *
+ * INTERNAL USE
+ *
+ * Called before the texture content is modified. If the texture is shared
+ * with other holders td gets its own copy of it (copy-on-write), and if it
+ * is the only holder the texture is just removed from the cache since it
+ * no longer matches the file it was loaded from.
+ *
+ * @param td TextureData that is about to be modified
+ */
+void TM::detach(TextureData& td){
+    auto it = records.find(td.id);
+    if(it == records.end()) return;
+
+    TextureRecord& rec = it->second;
+    if(rec.refs > 1){
+        TextureData own;
+        if(TM::copy(td, own) != NO_ERROR) return;
+
+        TM::release(td);
+        td = own;
+        return;
+    }
+
+    if(!rec.cacheKey.empty()){
+        textureCache.erase(rec.cacheKey);
+        rec.cacheKey.clear();
+        cacheStats.bytes -= rec.bytes;
+        cacheStats.entries = textureCache.size();
+    }
+
+    // Can no longer be restored by reloading the file, and
+    // neither the retained pixels nor the variants are valid
+    rec.sourcePath.clear();
+    residencyStats.retainedBytes -= rec.pixels.size();
+    vector<Uint8>().swap(rec.pixels);
+    if(rec.hasVariants) TM::dropVariants(td.id);
+}
+
+
+
+
+/** Cache Key
+ *
+ * INTERNAL USE
+ *
+ * Builds the texture cache key out of the canonical path and the files
+ * modification time and size, so an edited file is loaded again.
+ *
+ * @param path Path to the image on the filesystem
+ * @return The key, or empty string if the file cant be accessed
+ */
+string TM::cacheKey(const string& path){
+    std::error_code ec;
+
+    fs::path canonical = fs::canonical(path, ec);
+    if(ec) return "";
+
+    auto mtime = fs::last_write_time(canonical, ec);
+    if(ec) return "";
+
+    auto size = fs::file_size(canonical, ec);
+    if(ec) return "";
+
+    return canonical.string() + "|" +
+           to_string(mtime.time_since_epoch().count()) + "|" +
+           to_string(size);
+}
+
+
+
+
+/** Get Cache Stats
+ *
+ * Returns the texture cache hits, misses and the amount of
+ * texture memory currently held by the cached textures.
+ */
+TextureCacheStats TM::getCacheStats(){ return cacheStats; }
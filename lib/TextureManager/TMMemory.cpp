@@ -0,0 +1,232 @@
+#include "./TM.h"
+#include "../System/Sys.h"
+#include "../Pixel/Pixel.h"
+#include "../Qoi/Qoi.h"
+#include <climits>
+
+
+
+/** Memory Cache Key
+ *
+ * Keys of the images loaded from memory, kept apart from the file paths.
+ */
+static string memoryCacheKey(const string& key, bool premultiplied){
+    if(key.empty()) return "";
+    return "memory|" + key + (premultiplied ? "|premultiplied" : "");
+}
+
+
+
+
+/** Decode Image
+ *
+ * Decodes an encoded image (PNG, JPG, QOI, ...) held in memory into tightly
+ * packed RGBA32 pixels. It is read in place trough SDL_RWFromConstMem, so the
+ * data isnt copied. Doesnt touch the renderer, so it is safe to call from the
+ * worker threads, the pixels are uploaded later with TM::uploadImage.
+ *
+ * @param data Encoded image
+ * @param size Size of the data in bytes
+ * @param pixels Gets the decoded pixels
+ * @param width Gets the width of the image
+ * @param height Gets the height of the image
+ * @param premultiplied Premultiply the alpha of the pixels
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::decodeImage(const void* data, size_t size, vector<Uint8>& pixels, int& width, int& height, bool premultiplied){
+    if(data == nullptr || size == 0 || size > INT_MAX) return TM_SURFACE_CREATE_ERROR;
+
+    // QOI, decoded straight into the pixels -------------------------------------------
+    if(size >= 4 && memcmp(data, "qoif", 4) == 0){
+        QOIDecoder decoder([&pixels](int width, int height, int& pitch){
+            pitch = width * 4;
+            pixels.resize((size_t)pitch * height);
+            return pixels.data();
+        });
+
+        int err = decoder.feed((const Uint8*)data, size);
+        if(err != NO_ERROR) return err;
+        if(!decoder.isDone()) return QOI_TRUNCATED;
+
+        width = decoder.getWidth();
+        height = decoder.getHeight();
+    }
+
+    // EVERYTHING ELSE TROUGH SDL_IMAGE -------------------------------------------------
+    else {
+        SDL_RWops* rw = SDL_RWFromConstMem(data, (int)size);
+        if(rw == nullptr) return TM_SURFACE_CREATE_ERROR;
+
+        SDL_Surface* surface = IMG_Load_RW(rw, 1);
+        if(surface == nullptr) return TM_SURFACE_CREATE_ERROR;
+
+        if(surface->format->format != SDL_PIXELFORMAT_RGBA32){
+            SDL_Surface* converted = Pixel::convertToRGBA32(surface);
+            SDL_FreeSurface(surface);
+            if(converted == nullptr) return TM_SURFACE_CONVERT_ERROR;
+            surface = converted;
+        }
+
+        width = surface->w;
+        height = surface->h;
+        size_t rowBytes = (size_t)width * 4;
+        pixels.resize(rowBytes * height);
+
+        if(SDL_MUSTLOCK(surface)) SDL_LockSurface(surface);
+        for(int y = 0; y < height; y++){
+            memcpy(pixels.data() + y * rowBytes, (Uint8*)surface->pixels + (size_t)y * surface->pitch, rowBytes);
+        }
+        if(SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
+        SDL_FreeSurface(surface);
+    }
+
+    if(premultiplied) Pixel::premultiply(pixels.data(), pixels.data(), width * height);
+    return NO_ERROR;
+}
+
+
+
+
+/** Upload Image
+ *
+ * Creates a texture out of the decoded pixels and caches it under the key,
+ * so TM::getCached finds it until its last reference is freed.
+ *
+ * @param td TextureData object into which the image should be loaded
+ * @param pixels RGBA32 pixels, from TM::decodeImage. They are moved out if TM keeps the pixels (TM::setRetainPixels)
+ * @param width Width of the image
+ * @param height Height of the image
+ * @param key Cache key, empty to not cache the texture
+ * @param premultiplied The pixels have premultiplied alpha
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::uploadImage(TextureData& td, vector<Uint8>& pixels, int width, int height, const string& key, bool premultiplied){
+    if(td.tex != nullptr || td.id != 0) TM::freeTexture(td);
+    if(width <= 0 || height <= 0 || pixels.size() < (size_t)width * height * 4) return TM_INVALID_DRECT;
+
+    // CREATING THE TEXTURE --------------------------------------------------------------
+    td.tex = SDL_CreateTexture(
+        Sys::renderer,
+        SDL_PIXELFORMAT_RGBA32,
+        SDL_TEXTUREACCESS_TARGET,
+        width,
+        height
+    );
+    if(td.tex == nullptr) return TM_TEXTURE_CREATE_ERROR;
+
+    if(SDL_UpdateTexture(td.tex, NULL, pixels.data(), width * 4)){
+        SDL_DestroyTexture(td.tex);
+        td.tex = nullptr;
+        return TM_TEXTURE_UPDATE_ERROR;
+    }
+
+    SDL_BlendMode blend = premultiplied ? TM::getPremultipliedBlendMode() : SDL_BLENDMODE_BLEND;
+    if(SDL_SetTextureBlendMode(td.tex, blend)){
+        SDL_DestroyTexture(td.tex);
+        td.tex = nullptr;
+        return TM_TEXTURE_SET_BLENDMODE_ERROR;
+    }
+
+    td.format = SDL_PIXELFORMAT_RGBA32;
+    td.width = width;
+    td.height = height;
+    td.orgWidth = width;
+    td.orgHeight = height;
+
+    // TRACK AND CACHE THE TEXTURE --------------------------------------------------------
+    // No source file, so it is compressed in RAM if it gets evicted
+    TM::track(td);
+    TextureRecord& rec = records.at(td.id);
+    rec.premultiplied = premultiplied;
+
+    if(retainPixels){
+        pixels.resize((size_t)width * height * 4);
+        residencyStats.retainedBytes += pixels.size();
+        rec.pixels = std::move(pixels);
+    }
+
+    string cacheKey = memoryCacheKey(key, premultiplied);
+    if(!cacheKey.empty()){
+        // An older texture with the same key stays alive for its holders, just uncached
+        auto old = textureCache.find(cacheKey);
+        if(old != textureCache.end()){
+            TextureRecord& oldRec = records.at(old->second);
+            oldRec.cacheKey.clear();
+            cacheStats.bytes -= oldRec.bytes;
+        }
+
+        rec.cacheKey = cacheKey;
+        textureCache[cacheKey] = td.id;
+
+        cacheStats.bytes += rec.bytes;
+        cacheStats.entries = textureCache.size();
+    }
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Get Cached
+ *
+ * Looks up an image uploaded with TM::uploadImage or TM::loadTexture from
+ * memory, and gives td a reference to it. The previous texture of td is freed.
+ *
+ * @param td TextureData which gets the cached texture
+ * @param key Cache key the image was uploaded with
+ * @param premultiplied Look for the premultiplied copy of the image
+ * @return True if it was cached
+ */
+bool TM::getCached(TextureData& td, const string& key, bool premultiplied){
+    auto cached = textureCache.find(memoryCacheKey(key, premultiplied));
+    if(key.empty() || cached == textureCache.end()){
+        cacheStats.misses++;
+        return false;
+    }
+
+    TextureData old = td;
+
+    TextureRecord& rec = records.at(cached->second);
+    rec.refs++;
+    td = rec.td;
+    cacheStats.hits++;
+
+    TM::freeTexture(old);
+    return true;
+}
+
+
+
+
+/** Load Texture
+ *
+ * Loads an encoded image held in memory, like a blob out of a database or
+ * an archive. Decoded on the calling thread, for decoding on the worker
+ * threads use TM::decodeImage and TM::uploadImage.
+ *
+ * @param td TextureData object into which the image should be loaded
+ * @param data Encoded image
+ * @param size Size of the data in bytes
+ * @param key Cache key, loading the same key again doesnt decode it. Empty to not cache it
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::loadTexture(TextureData& td, const void* data, size_t size, const string& key){
+    if(TM::getCached(td, key, loadPremultiplied)) return NO_ERROR;
+
+    vector<Uint8> pixels;
+    int width, height;
+    int err = TM::decodeImage(data, size, pixels, width, height, loadPremultiplied);
+    if(err != NO_ERROR) return err;
+
+    return TM::uploadImage(td, pixels, width, height, key, loadPremultiplied);
+}
+
+
+
+
+/** Get Load Premultiplied
+ *
+ * @return True if the images are loaded with premultiplied alpha, see TM::setLoadPremultiplied
+ */
+bool TM::getLoadPremultiplied(){ return loadPremultiplied; }
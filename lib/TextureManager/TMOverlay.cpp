@@ -0,0 +1,262 @@
+#include "./TM.h"
+#include "../System/Sys.h"
+#include "../Gui/gui.h"
+
+
+
+/** Overlay Scope
+ *
+ * Makes the texture the render target until the scope ends. If the texture
+ * is shared it gets its own copy first. An enclosing scope gets its recorded
+ * primitives flushed, so everything is drawn in the order it was recorded.
+ * If the target cant be set every draw returns the error, see getError().
+ *
+ * @param target TextureData to be drawn onto
+ */
+OverlayScope::OverlayScope(TextureData& target): target(target){
+    // The target of the enclosing scope or GUI layer, read before
+    // anything below could switch it, and restored when this one ends
+    previousTarget = SDL_GetRenderTarget(Sys::renderer);
+
+    // The enclosing scope draws what it recorded while its target is still set
+    if(current != nullptr){
+        int err = current->flush();
+        CHECK_ERROR(err);
+    }
+
+    // Make sure that the texture is not shared before drawing onto it
+    TM::detach(target);
+
+    SDL_Texture* tex = TM::resolve(target);
+    if(tex == nullptr){
+        error = TM_GOT_NULLPTR_TEX;
+        return;
+    }
+
+    if(SDL_SetRenderTarget(Sys::renderer, tex)){
+        error = TM_SRT_FAILED;
+        return;
+    }
+
+    parent = current;
+    current = this;
+    active = true;
+}
+
+
+
+
+OverlayScope::~OverlayScope(){
+    int err = end();
+    CHECK_ERROR(err);
+}
+
+
+
+
+/** Add Quad
+ *
+ * INTERNAL USE
+ *
+ * Records the quad into the batch, the batch is submitted first
+ * if it holds primitives of another texture.
+ *
+ * @param tex Texture of the quad, nullptr for solid color
+ * @param pos Corners of the quad, clockwise
+ * @param color Color of the quad, white for textures
+ * @param uv Texture coordinates of the corners
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int OverlayScope::addQuad(SDL_Texture* tex, const SDL_FPoint pos[4], const SDL_Color& color, const SDL_FPoint uv[4]){
+    if(!active) return error != NO_ERROR ? error : TM_OVERLAY_ENDED;
+
+    if(tex != batchTexture && !vertices.empty()){
+        int err = flush();
+        if(err != NO_ERROR) return err;
+    }
+    batchTexture = tex;
+
+    int first = vertices.size();
+    for(int i = 0; i < 4; i++) vertices.push_back({pos[i], color, uv[i]});
+
+    const int quad[6] = {0, 1, 2, 0, 2, 3};
+    for(int i : quad) indices.push_back(first + i);
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Fill Rect
+ *
+ * Records a filled rect.
+ *
+ * @param rect SDL_Rect specifing where and how big should rect be
+ * @param color SDL_Color representing what color should rect be
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int OverlayScope::fillRect(const SDL_Rect& rect, const SDL_Color& color){
+    if(rect.w < 0 && rect.h < 0) return TM_INVALID_DRECT;
+
+    float x1 = rect.x, y1 = rect.y;
+    float x2 = rect.x + rect.w, y2 = rect.y + rect.h;
+
+    const SDL_FPoint pos[4] = {{x1, y1}, {x2, y1}, {x2, y2}, {x1, y2}};
+    const SDL_FPoint uv[4] = {};
+    return addQuad(nullptr, pos, color, uv);
+}
+
+
+
+
+/** Line
+ *
+ * Records a line with custom thickness.
+ *
+ * @param p1 SDL_Point representing coordinates for starting point of the line
+ * @param p2 SDL_Point representing coordinates for ending point of the line
+ * @param color SDL_Color color of the line
+ * @param thickness Thickness of the line
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int OverlayScope::line(const SDL_Point& p1, const SDL_Point& p2, const SDL_Color& color, int thickness){
+    // Calculate the line's direction vector
+    double dx = p2.x - p1.x;
+    double dy = p2.y - p1.y;
+    double length = std::sqrt(dx * dx + dy * dy);
+
+    if(length <= 0) return TM_INVALID_LINE_LENGTH;
+
+    // Normalize the direction vector
+    dx /= length;
+    dy /= length;
+
+    // Calculate the perpendicular vector for thickness
+    double px = -dy * (thickness / 2.0);
+    double py = dx * (thickness / 2.0);
+
+    // The four corners of the rectangle representing the thick line
+    const SDL_FPoint pos[4] = {
+        {static_cast<float>(p1.x + px), static_cast<float>(p1.y + py)},
+        {static_cast<float>(p1.x - px), static_cast<float>(p1.y - py)},
+        {static_cast<float>(p2.x - px), static_cast<float>(p2.y - py)},
+        {static_cast<float>(p2.x + px), static_cast<float>(p2.y + py)}
+    };
+    const SDL_FPoint uv[4] = {};
+    return addQuad(nullptr, pos, color, uv);
+}
+
+
+
+
+/** Texture
+ *
+ * Records a texture. Just like the TM::renderTexture it is able to
+ * dinamicly calculate one missing dimension of the dRect, {10, 10, 100, -1}.
+ * Consecutive draws of the same texture, like sprites from one atlas,
+ * end up in one submission.
+ *
+ * @param td TextureData object to be drawn
+ * @param dr SDL_Rect specifing where and how big should Texture be drawn
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int OverlayScope::texture(const TextureData& td, SDL_Rect& dr){
+    // CHECK IF DIMENSIONS ARE VALID ------------------------------------------------------
+    if(dr.w < 0 && dr.h < 0) return TM_INVALID_DRECT;
+
+    // CALCULATE IF ONE DIMENSION IS MISSING ----------------------------------------------
+    if(dr.w == -1) dr.w = dr.h * (float)td.width / td.height;
+    if(dr.h == -1) dr.h = dr.w * (float)td.height / td.width;
+
+    SDL_Texture* tex = TM::resolve(td);
+    if(tex == nullptr) return TM_GOT_NULLPTR_TEX;
+
+    // TEXTURE COORDINATES OF THE IMAGE PART ----------------------------------------------
+    int texWidth, texHeight;
+    if(SDL_QueryTexture(tex, NULL, NULL, &texWidth, &texHeight)) return TM_GOT_NULLPTR_TEX;
+
+    SDL_Rect src = td.srcRect() ? td.src : SDL_Rect{0, 0, texWidth, texHeight};
+    float u1 = (float)src.x / texWidth, v1 = (float)src.y / texHeight;
+    float u2 = (float)(src.x + src.w) / texWidth, v2 = (float)(src.y + src.h) / texHeight;
+
+    float x1 = dr.x, y1 = dr.y;
+    float x2 = dr.x + dr.w, y2 = dr.y + dr.h;
+
+    const SDL_FPoint pos[4] = {{x1, y1}, {x2, y1}, {x2, y2}, {x1, y2}};
+    const SDL_FPoint uv[4] = {{u1, v1}, {u2, v1}, {u2, v2}, {u1, v2}};
+    return addQuad(tex, pos, SDL_COLOR_WHITE, uv);
+}
+
+
+
+
+/** Text
+ *
+ * Draws the text right away, after the recorded primitives.
+ *
+ * @param text Text to be drawn
+ * @param dRect Where to draw the text, same as GUI::Text
+ * @param color Color of the text
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int OverlayScope::text(const string& text, SDL_Rect& dRect, const SDL_Color& color){
+    if(!active) return error != NO_ERROR ? error : TM_OVERLAY_ENDED;
+
+    int err = flush();
+    if(err != NO_ERROR) return err;
+
+    GUI::Text(text, dRect, color);
+    return NO_ERROR;
+}
+
+
+
+
+/** Flush
+ *
+ * Submits the recorded primitives with a single SDL_RenderGeometry call.
+ *
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int OverlayScope::flush(){
+    if(vertices.empty()) return NO_ERROR;
+
+    int err = SDL_RenderGeometry(
+        Sys::renderer,
+        batchTexture,
+        vertices.data(),
+        vertices.size(),
+        indices.data(),
+        indices.size()
+    );
+    submissions++;
+
+    vertices.clear();
+    indices.clear();
+    batchTexture = nullptr;
+
+    if(err != 0) return TM_RENDER_GEOMETRY_FAILED;
+    return NO_ERROR;
+}
+
+
+
+
+/** End
+ *
+ * Submits the recorded primitives and restores the render target that was
+ * active before the scope. Called by the destructor if not called before.
+ *
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int OverlayScope::end(){
+    if(!active) return NO_ERROR;
+
+    int err = flush();
+    active = false;
+    current = parent;
+
+    if(SDL_SetRenderTarget(Sys::renderer, previousTarget) && err == NO_ERROR) err = TM_SRT_FAILED;
+    return err;
+}
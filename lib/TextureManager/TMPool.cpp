@@ -0,0 +1,274 @@
+#include "./TM.h"
+#include "../System/Sys.h"
+
+
+
+/** Pool Key
+ *
+ * INTERNAL USE
+ *
+ * Rounds the size up to its power of two size class, and packs the format,
+ * access and the size class into the texture pool key.
+ *
+ * @param format Pixel format of the texture
+ * @param access SDL_TextureAccess of the texture
+ * @param width Requested width, gets the size class width
+ * @param height Requested height, gets the size class height
+ * @return The pool key
+ */
+Uint64 TM::poolKey(Uint32 format, int access, int& width, int& height){
+    int logW = 5, logH = 5;     // Smallest size class is 32x32
+    while((1 << logW) < width) logW++;
+    while((1 << logH) < height) logH++;
+
+    width = 1 << logW;
+    height = 1 << logH;
+
+    return ((Uint64)format << 32) | ((Uint64)access << 16) | (logW << 8) | logH;
+}
+
+
+
+
+/** Pool Bytes
+ *
+ * INTERNAL USE
+ *
+ * @param key Texture pool key
+ * @return Memory held by a texture of the size class of the key
+ */
+size_t TM::poolBytes(Uint64 key){
+    Uint32 format = key >> 32;
+    return ((size_t)1 << ((key >> 8) & 0xff)) * ((size_t)1 << (key & 0xff)) * SDL_BYTESPERPIXEL(format);
+}
+
+
+
+
+/** Clear Padding
+ *
+ * INTERNAL USE
+ *
+ * Clears the column right of and the row below the width x height image to
+ * transparent. Linear filtering samples one texel past the image, so
+ * without it a scaled copy would bleed in whatever a reused texture held
+ * there before. The rest of the padding is never sampled.
+ *
+ * @param tex The texture
+ * @param format Pixel format of the texture
+ * @param width Width of the image
+ * @param height Height of the image
+ * @param classWidth Width of the texture
+ * @param classHeight Height of the texture
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::clearPadding(SDL_Texture* tex, Uint32 format, int width, int height, int classWidth, int classHeight){
+    int bpp = SDL_BYTESPERPIXEL(format);
+    if(bpp == 0 || SDL_ISPIXELFORMAT_FOURCC(format)) return NO_ERROR;
+
+    static vector<Uint8> zeros;
+    size_t needed = (size_t)max(classWidth, classHeight) * bpp;
+    if(zeros.size() < needed) zeros.resize(needed, 0);
+
+    // The corner is in the column
+    if(width < classWidth){
+        SDL_Rect column = {width, 0, 1, min(height + 1, classHeight)};
+        if(SDL_UpdateTexture(tex, &column, zeros.data(), bpp)) return TM_TEXTURE_UPDATE_ERROR;
+    }
+    if(height < classHeight){
+        SDL_Rect row = {0, height, width, 1};
+        if(SDL_UpdateTexture(tex, &row, zeros.data(), width * bpp)) return TM_TEXTURE_UPDATE_ERROR;
+    }
+    return NO_ERROR;
+}
+
+
+
+
+/** Acquire Texture
+ *
+ * Gives a texture of at least width x height, reusing an idle one from the pool
+ * if there is one of the same format, access and size class. The image occupies
+ * the top-left width x height part of it, td.src, which TM uses when rendering.
+ * Once freed with TM::freeTexture it goes back to the pool instead of being destroyed.
+ *
+ * @param td TextureData object where texture will be placed
+ * @param width Width of the needed texture
+ * @param height Height of the needed texture
+ * @param format Pixel format of the texture
+ * @param access SDL_TextureAccess of the texture
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::acquireTexture(TextureData& td, int width, int height, Uint32 format, int access){
+    if(width < 1 || height < 1) return TM_INVALID_DRECT;
+    if(td.tex != nullptr || td.id != 0) TM::freeTexture(td);
+
+    int classWidth = width, classHeight = height;
+    Uint64 key = TM::poolKey(format, access, classWidth, classHeight);
+
+    // REUSE AN IDLE TEXTURE ---------------------------------------------------------------
+    td.tex = TM::takeFromPool(key);
+    if(td.tex != nullptr){
+        poolStats.hits++;
+    } else {
+        // OR CREATE A NEW ONE --------------------------------------------------------------
+        td.tex = SDL_CreateTexture(Sys::renderer, format, access, classWidth, classHeight);
+        if(td.tex == nullptr) return TM_TEXTURE_CREATE_ERROR;
+
+        poolStats.misses++;
+    }
+
+    if(SDL_SetTextureBlendMode(td.tex, SDL_BLENDMODE_BLEND)){
+        SDL_DestroyTexture(td.tex);
+        td.tex = nullptr;
+        return TM_TEXTURE_SET_BLENDMODE_ERROR;
+    }
+
+    // Fresh textures are undefined and reused ones hold an old image
+    int err = TM::clearPadding(td.tex, format, width, height, classWidth, classHeight);
+    if(err != NO_ERROR){
+        SDL_DestroyTexture(td.tex);
+        td.tex = nullptr;
+        return err;
+    }
+
+    td.format = format;
+    td.width = width;
+    td.height = height;
+    td.orgWidth = width;
+    td.orgHeight = height;
+    td.src = {0, 0, width, height};
+
+    TM::track(td);
+    TextureRecord& rec = records.at(td.id);
+    rec.pooled = true;
+    rec.poolKey = key;
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Take From Pool
+ *
+ * INTERNAL USE
+ *
+ * Takes an idle texture out of the pool, with the modulation its last
+ * user left on it reset. Its pixels are still the old ones.
+ *
+ * @param key Size class of the texture, TM::poolKey
+ * @return The texture, nullptr if there is no idle one of the size class
+ */
+SDL_Texture* TM::takeFromPool(Uint64 key){
+    auto bucket = texturePool.find(key);
+    if(bucket == texturePool.end() || bucket->second.empty()) return nullptr;
+
+    SDL_Texture* tex = bucket->second.back();
+    bucket->second.pop_back();
+
+    poolStats.pooledTextures--;
+    poolStats.pooledBytes -= TM::poolBytes(key);
+
+    SDL_SetTextureAlphaMod(tex, 255);
+    SDL_SetTextureColorMod(tex, 255, 255, 255);
+    return tex;
+}
+
+
+
+
+/** Return To Pool
+ *
+ * INTERNAL USE
+ *
+ * Puts the texture of the freed record back into the pool, or destroys
+ * it if the pool has reached its budget.
+ *
+ * @param rec Record of the freed pooled texture
+ */
+void TM::returnToPool(TextureRecord& rec){
+    if(poolStats.pooledBytes + rec.bytes > poolBudget){
+        SDL_DestroyTexture(rec.td.tex);
+        return;
+    }
+
+    texturePool[rec.poolKey].push_back(rec.td.tex);
+    poolStats.pooledTextures++;
+    poolStats.pooledBytes += rec.bytes;
+}
+
+
+
+
+/** Trim Pool
+ *
+ * INTERNAL USE
+ *
+ * Destroys idle pooled textures until the pool holds at most bytes of memory.
+ *
+ * @param bytes Amount of memory the pool is allowed to keep
+ */
+void TM::trimPool(size_t bytes){
+    for(auto it = texturePool.begin(); it != texturePool.end() && poolStats.pooledBytes > bytes; ){
+        size_t textureBytes = TM::poolBytes(it->first);
+
+        auto& idle = it->second;
+        while(!idle.empty() && poolStats.pooledBytes > bytes){
+            SDL_DestroyTexture(idle.back());
+            idle.pop_back();
+
+            poolStats.pooledTextures--;
+            poolStats.pooledBytes -= textureBytes;
+        }
+
+        if(idle.empty()) it = texturePool.erase(it);
+        else ++it;
+    }
+}
+
+
+
+
+/** Set Pool Budget
+ *
+ * Sets how much memory, in bytes, the idle pooled textures may hold.
+ * Textures freed past it are destroyed instead of being pooled.
+ *
+ * @param bytes Pool memory budget in bytes, 64MB by default
+ */
+void TM::setPoolBudget(size_t bytes){
+    poolBudget = bytes;
+    TM::trimPool(bytes);
+}
+
+
+
+
+/** Get Pool Stats
+ *
+ * Returns the pool hits and misses (and their hit rate) and
+ * the number and memory of the idle pooled textures.
+ */
+TexturePoolStats TM::getPoolStats(){ return poolStats; }
+
+
+
+
+/** Get Texture Bytes
+ *
+ * Returns the texture memory held by the texture of td. For a pooled
+ * texture that is its whole size class, not just the td.src part, so
+ * budgets kept outside of TM should count this.
+ *
+ * @param td The TextureData
+ * @return Texture memory in bytes
+ */
+size_t TM::getTextureBytes(const TextureData& td){
+    auto it = records.find(td.id);
+    if(it != records.end()) return it->second.bytes;
+
+    int width = 0, height = 0;
+    if(td.tex != nullptr) SDL_QueryTexture(td.tex, NULL, NULL, &width, &height);
+    return (size_t)width * height * SDL_BYTESPERPIXEL(td.format);
+}
@@ -0,0 +1,307 @@
+#include "./TM.h"
+#include "../System/Sys.h"
+
+
+
+/** Resolve
+ *
+ * Returns the SDL_Texture currently backing the TextureData. If the texture
+ * was evicted to stay within the memory budget it is restored first.
+ * It also marks the texture as used in this frame.
+ *
+ * All TM and GUI functions render trough this, so when the budget is set the
+ * td.tex should not be passed to SDL directly, use TM::resolve(td) instead.
+ *
+ * @param td TextureData whose texture is needed
+ * @return The texture or nullptr if it was freed or cant be restored
+ */
+SDL_Texture* TM::resolve(const TextureData& td){
+    if(td.id == 0) return td.tex;   // Not tracked by TM
+
+    auto it = records.find(td.id);
+    if(it == records.end()) return nullptr;
+
+    TextureRecord& rec = it->second;
+    if(rec.lost) return nullptr;    // Reported once, when restoring it failed
+    if(rec.evicted){
+        int err = TM::restore(rec);
+        CHECK_ERROR(err);
+        if(err != NO_ERROR) return nullptr;
+    }
+
+    // Mark the texture as the most recently used one
+    int frame = Sys::getCurrentFrame();
+    if(rec.lastFrame != frame){
+        rec.lastFrame = frame;
+        if(rec.access == SDL_TEXTUREACCESS_TARGET){
+            residentLru.splice(residentLru.begin(), residentLru, rec.lru);
+        }
+    }
+
+    return rec.td.tex;
+}
+
+
+
+
+/** Evict
+ *
+ * INTERNAL USE
+ *
+ * Destroys the texture to free the GPU memory, a pooled one goes back to
+ * the pool. Textures loaded from a file (or with retained pixels) are later
+ * just reloaded from it, all others are read back and kept as a LZ4
+ * compressed copy in RAM.
+ *
+ * @param rec Record of the resident render target to be evicted
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::evict(TextureRecord& rec){
+    if(rec.sourcePath.empty() && rec.pixels.empty()){
+        // READ BACK THE PIXELS ---------------------------------------------------------
+        // Only the image part, pooled textures can be larger then it
+        SDL_Rect area = {rec.td.src.x, rec.td.src.y, rec.td.width, rec.td.height};
+        int pitch = rec.td.width * SDL_BYTESPERPIXEL(rec.td.format);
+        vector<char> pixels((size_t)pitch * rec.td.height);
+
+        SDL_Texture* previousTarget = SDL_GetRenderTarget(Sys::renderer);
+        if(SDL_SetRenderTarget(Sys::renderer, rec.td.tex)) return TM_SRT_FAILED;
+
+        int err = SDL_RenderReadPixels(Sys::renderer, &area, rec.td.format, pixels.data(), pitch);
+        SDL_SetRenderTarget(Sys::renderer, previousTarget);
+        if(err != 0) return TM_READ_PIXELS_FAILED;
+
+        // COMPRESS THEM ----------------------------------------------------------------
+        rec.packed.resize(LZ4_compressBound(pixels.size()));
+        int packedSize = LZ4_compress_default(pixels.data(), rec.packed.data(), pixels.size(), rec.packed.size());
+        if(packedSize <= 0){
+            vector<char>().swap(rec.packed);
+            return TM_COMPRESSION_ERROR;
+        }
+        rec.packed.resize(packedSize);
+        rec.packed.shrink_to_fit();
+
+        residencyStats.packedBytes += rec.packed.size();
+    }
+
+    // DESTROY THE TEXTURE ----------------------------------------------------------------
+    SDL_GetTextureBlendMode(rec.td.tex, &rec.blend);
+    if(rec.pooled) TM::returnToPool(rec);
+    else SDL_DestroyTexture(rec.td.tex);
+    rec.td.tex = nullptr;
+    rec.evicted = true;
+    residentLru.erase(rec.lru);
+
+    residencyStats.residentBytes -= rec.bytes;
+    residencyStats.evictedTextures++;
+    residencyStats.evictions++;
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Restore
+ *
+ * INTERNAL USE
+ *
+ * Re-creates the evicted texture, from the retained pixels, its source
+ * file or from the compressed copy, and measures how long it took. If the
+ * source file changed or cant be loaded, or the copy is corrupt, the
+ * texture is marked as lost and stays evicted for good.
+ *
+ * @param rec Record of the evicted texture
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::restore(TextureRecord& rec){
+    Uint64 start = SDL_GetPerformanceCounter();
+    TextureData td;
+
+    if(!rec.pixels.empty()){
+        // UPLOAD THE RETAINED PIXELS ---------------------------------------------------
+        td.tex = SDL_CreateTexture(
+            Sys::renderer,
+            SDL_PIXELFORMAT_RGBA32,
+            SDL_TEXTUREACCESS_TARGET,
+            rec.texWidth,
+            rec.texHeight
+        );
+        if(td.tex == nullptr) return TM_TEXTURE_CREATE_ERROR;
+
+        SDL_Rect area = {rec.td.src.x, rec.td.src.y, rec.td.width, rec.td.height};
+        if(SDL_UpdateTexture(td.tex, &area, rec.pixels.data(), rec.td.width * 4)){
+            SDL_DestroyTexture(td.tex);
+            return TM_TEXTURE_UPDATE_ERROR;
+        }
+    } else if(!rec.sourcePath.empty()){
+        // RELOAD FROM THE FILE ---------------------------------------------------------
+        // Every holder still uses the old image, so a file that changed since,
+        // by its modification time or size, cant take its place
+        if(TM::cacheKey(rec.sourcePath) != rec.sourceKey){
+            rec.lost = true;
+            return TM_SOURCE_CHANGED;
+        }
+
+        // Not decoded again on every render if it fails
+        int err = TM::createFromFile(td, rec.sourcePath, nullptr, rec.premultiplied);
+        if(err != NO_ERROR){
+            rec.lost = true;
+            return err;
+        }
+
+        int width = 0, height = 0;
+        SDL_QueryTexture(td.tex, NULL, NULL, &width, &height);
+        if(width != rec.texWidth || height != rec.texHeight){
+            SDL_DestroyTexture(td.tex);
+            rec.lost = true;
+            return TM_SOURCE_CHANGED;
+        }
+    } else {
+        // DECOMPRESS THE PIXELS --------------------------------------------------------
+        int pitch = rec.td.width * SDL_BYTESPERPIXEL(rec.td.format);
+        int size = pitch * rec.td.height;
+        vector<char> pixels(size);
+
+        int got = LZ4_decompress_safe(rec.packed.data(), pixels.data(), rec.packed.size(), size);
+        if(got != size){
+            rec.lost = true;
+            return TM_COMPRESSION_ERROR;
+        }
+
+        // UPLOAD THEM ------------------------------------------------------------------
+        // Same size as before, so a pooled texture still fits its size class,
+        // and can take an idle one of it back, with its padding cleared
+        td.tex = rec.pooled ? TM::takeFromPool(rec.poolKey) : nullptr;
+        if(td.tex != nullptr){
+            int err = TM::clearPadding(td.tex, rec.td.format, rec.td.width, rec.td.height, rec.texWidth, rec.texHeight);
+            if(err != NO_ERROR){
+                SDL_DestroyTexture(td.tex);
+                return err;
+            }
+        } else {
+            td.tex = SDL_CreateTexture(
+                Sys::renderer,
+                rec.td.format,
+                SDL_TEXTUREACCESS_TARGET,
+                rec.texWidth,
+                rec.texHeight
+            );
+            if(td.tex == nullptr) return TM_TEXTURE_CREATE_ERROR;
+        }
+
+        SDL_Rect area = {rec.td.src.x, rec.td.src.y, rec.td.width, rec.td.height};
+        if(SDL_UpdateTexture(td.tex, &area, pixels.data(), pitch)){
+            SDL_DestroyTexture(td.tex);
+            return TM_TEXTURE_UPDATE_ERROR;
+        }
+
+        residencyStats.packedBytes -= rec.packed.size();
+        vector<char>().swap(rec.packed);
+    }
+
+    SDL_SetTextureBlendMode(td.tex, rec.blend);
+
+    // MAKE IT RESIDENT AGAIN -------------------------------------------------------------
+    rec.td.tex = td.tex;
+    rec.evicted = false;
+    rec.lastFrame = Sys::getCurrentFrame();
+    residentLru.push_front(rec.td.id);
+    rec.lru = residentLru.begin();
+
+    residencyStats.residentBytes += rec.bytes;
+    residencyStats.evictedTextures--;
+    residencyStats.restores++;
+
+    // MEASURE THE COST -------------------------------------------------------------------
+    double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    residencyStats.restoreMs += ms;
+    frameRestoreMs += ms;
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Enforce Budget
+ *
+ * INTERNAL USE
+ *
+ * Drops the idle pooled textures and evicts the least recently used render
+ * targets until the texture memory fits the budget. Textures used in the
+ * current frame are never evicted.
+ */
+void TM::enforceBudget(){
+    if(textureBudget == 0) return;
+
+    // Idle pooled textures go first
+    size_t used = residencyStats.residentBytes + poolStats.pooledBytes;
+    if(used > textureBudget){
+        size_t resident = residencyStats.residentBytes;
+        TM::trimPool(resident < textureBudget ? textureBudget - resident : 0);
+    }
+
+    int frame = Sys::getCurrentFrame();
+    while(residencyStats.residentBytes > textureBudget && !residentLru.empty()){
+        TextureRecord& rec = records.at(residentLru.back());
+
+        // Everything left has been used in this frame
+        if(rec.lastFrame == frame) break;
+
+        int err = TM::evict(rec);
+        CHECK_ERROR(err);
+        if(err != NO_ERROR) break;
+    }
+
+    // Evicted pooled textures went back to the pool, only what fits is kept
+    size_t resident = residencyStats.residentBytes;
+    TM::trimPool(resident < textureBudget ? textureBudget - resident : 0);
+}
+
+
+
+
+/** Set Texture Budget
+ *
+ * Sets how much texture memory, in bytes, TM is allowed to keep on the GPU.
+ * Past it the least recently rendered textures are evicted, and restored
+ * again on their next render. 0 means unlimited, which is the default.
+ *
+ * @param bytes Texture memory budget in bytes
+ */
+void TM::setTextureBudget(size_t bytes){
+    textureBudget = bytes;
+    residencyStats.budget = bytes;
+    TM::enforceBudget();
+}
+
+
+
+
+/** End Frame
+ *
+ * Called by Sys::presentFrame at the end of each frame, it keeps the textures
+ * within the budget and closes the per-frame statistics.
+ */
+void TM::endFrame(){
+    TM::enforceBudget();
+
+    residencyStats.lastFrameRestoreMs = frameRestoreMs;
+    frameRestoreMs = 0;
+
+    uploadStats.lastFrameBytes = frameUploadBytes;
+    uploadStats.lastFrameUploads = frameUploads;
+    frameUploadBytes = 0;
+    frameUploads = 0;
+}
+
+
+
+
+/** Get Residency Stats
+ *
+ * Returns the resident and evicted texture memory, the number of
+ * evictions and restores and the time spent restoring textures.
+ */
+TextureResidencyStats TM::getResidencyStats(){ return residencyStats; }
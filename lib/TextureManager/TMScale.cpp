@@ -0,0 +1,510 @@
+#include "./TM.h"
+#include "../System/Sys.h"
+#include "../Jobs/Jobs.h"
+#include "../Pixel/Pixel.h"
+
+#ifdef LUMOS_X86
+#include <immintrin.h>
+#endif
+
+
+
+// RESAMPLING WEIGHTS ------------------------------------------------------------------------------
+// For every output pixel on one axis, the first source pixel and
+// the `taps` weights of the source pixels starting from it.
+struct ScaleWeights{
+    int taps = 0;
+    vector<int> start;
+    vector<float> weights;
+};
+
+
+static double filterSupport(int filter){
+    if(filter == TM_FILTER_BOX) return 0.5;
+    if(filter == TM_FILTER_BILINEAR) return 1.0;
+    return 3.0;     // Lanczos3
+}
+
+
+static double filterWeight(int filter, double x){
+    if(filter == TM_FILTER_BOX) return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+
+    x = fabs(x);
+    if(filter == TM_FILTER_BILINEAR) return x < 1.0 ? 1.0 - x : 0.0;
+
+    // Lanczos3
+    if(x >= 3.0) return 0.0;
+    if(x < 1e-8) return 1.0;
+    double px = M_PI * x;
+    return 3.0 * sin(px) * sin(px / 3.0) / (px * px);
+}
+
+
+static ScaleWeights computeWeights(int srcSize, int dstSize, int filter){
+    ScaleWeights sw;
+
+    // When downscaling the filter is stretched over the source pixels
+    // so every one of them contributes, which is what avoids the aliasing
+    double scale = (double)srcSize / dstSize;
+    double filterScale = max(scale, 1.0);
+    double support = filterSupport(filter) * filterScale;
+
+    sw.taps = min(srcSize, (int)ceil(support * 2) + 1);
+    sw.start.resize(dstSize);
+    sw.weights.assign((size_t)dstSize * sw.taps, 0.0f);
+
+    for(int i = 0; i < dstSize; i++){
+        double center = (i + 0.5) * scale;
+        int xmin = max(0, (int)floor(center - support + 0.5));
+        int xmax = min(srcSize, (int)floor(center + support + 0.5));
+        if(xmax - xmin > sw.taps) xmax = xmin + sw.taps;
+
+        // Every output pixel reads exactly `taps` source pixels, within the image
+        int start = min(xmin, srcSize - sw.taps);
+        float* w = &sw.weights[(size_t)i * sw.taps];
+
+        double total = 0;
+        for(int x = xmin; x < xmax; x++){
+            double weight = filterWeight(filter, (x + 0.5 - center) / filterScale);
+            w[x - start] = weight;
+            total += weight;
+        }
+
+        if(total != 0){
+            for(int k = 0; k < sw.taps; k++) w[k] /= total;
+        } else {
+            int nearest = min(srcSize - 1, max(0, (int)center));
+            w[nearest - start] = 1.0f;
+        }
+
+        sw.start[i] = start;
+    }
+
+    return sw;
+}
+
+
+
+
+// KERNELS -----------------------------------------------------------------------------------------
+// Horizontal pass: RGBA8 source row -> float RGBA row of the output width
+// Vertical pass: `taps` float rows -> RGBA8 output row
+
+typedef void (*HorizontalKernel)(const Uint8* row, float* out, const ScaleWeights& sw, int outWidth);
+typedef void (*VerticalKernel)(const float* rows, int stride, Uint8* out, const float* w, int taps, int count);
+
+
+static inline Uint8 clampByte(float v){
+    if(v <= 0.0f) return 0;
+    if(v >= 255.0f) return 255;
+    return (Uint8)(v + 0.5f);
+}
+
+
+static void horizontalScalar(const Uint8* row, float* out, const ScaleWeights& sw, int outWidth){
+    for(int x = 0; x < outWidth; x++){
+        const float* w = &sw.weights[(size_t)x * sw.taps];
+        const Uint8* p = row + sw.start[x] * 4;
+
+        float r = 0, g = 0, b = 0, a = 0;
+        for(int k = 0; k < sw.taps; k++, p += 4){
+            r += w[k] * p[0];
+            g += w[k] * p[1];
+            b += w[k] * p[2];
+            a += w[k] * p[3];
+        }
+
+        out[x*4 + 0] = r;
+        out[x*4 + 1] = g;
+        out[x*4 + 2] = b;
+        out[x*4 + 3] = a;
+    }
+}
+
+
+static void verticalScalar(const float* rows, int stride, Uint8* out, const float* w, int taps, int count){
+    for(int i = 0; i < count; i++){
+        float v = 0;
+        for(int k = 0; k < taps; k++) v += w[k] * rows[(size_t)k * stride + i];
+        out[i] = clampByte(v);
+    }
+}
+
+
+#ifdef LUMOS_X86
+
+// One RGBA pixel is one 4 float vector
+__attribute__((target("sse4.1")))
+static void horizontalSSE41(const Uint8* row, float* out, const ScaleWeights& sw, int outWidth){
+    for(int x = 0; x < outWidth; x++){
+        const float* w = &sw.weights[(size_t)x * sw.taps];
+        const Uint8* p = row + sw.start[x] * 4;
+
+        __m128 acc = _mm_setzero_ps();
+        for(int k = 0; k < sw.taps; k++){
+            int px;
+            memcpy(&px, p + k*4, 4);
+            __m128 v = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(px)));
+            acc = _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(w[k])));
+        }
+        _mm_storeu_ps(out + x*4, acc);
+    }
+}
+
+
+__attribute__((target("sse4.1")))
+static void verticalSSE41(const float* rows, int stride, Uint8* out, const float* w, int taps, int count){
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128 acc = _mm_setzero_ps();
+        for(int k = 0; k < taps; k++){
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(rows + (size_t)k * stride + i), _mm_set1_ps(w[k])));
+        }
+
+        __m128i v = _mm_cvtps_epi32(acc);
+        v = _mm_packus_epi32(v, v);
+        v = _mm_packus_epi16(v, v);
+
+        int packed = _mm_cvtsi128_si32(v);
+        memcpy(out + i, &packed, 4);
+    }
+
+    if(i < count) verticalScalar(rows + i, stride, out + i, w, taps, count - i);
+}
+
+
+// Two source pixels per 8 float vector
+__attribute__((target("avx2")))
+static void horizontalAVX2(const Uint8* row, float* out, const ScaleWeights& sw, int outWidth){
+    for(int x = 0; x < outWidth; x++){
+        const float* w = &sw.weights[(size_t)x * sw.taps];
+        const Uint8* p = row + sw.start[x] * 4;
+
+        __m256 acc = _mm256_setzero_ps();
+        int k = 0;
+        for(; k + 1 < sw.taps; k += 2){
+            __m128i two = _mm_loadl_epi64((const __m128i*)(p + k*4));
+            __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(two));
+            __m256 weights = _mm256_set_m128(_mm_set1_ps(w[k + 1]), _mm_set1_ps(w[k]));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(v, weights));
+        }
+
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        if(k < sw.taps){
+            int px;
+            memcpy(&px, p + k*4, 4);
+            __m128 v = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(px)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(v, _mm_set1_ps(w[k])));
+        }
+        _mm_storeu_ps(out + x*4, sum);
+    }
+}
+
+
+__attribute__((target("avx2")))
+static void verticalAVX2(const float* rows, int stride, Uint8* out, const float* w, int taps, int count){
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256 acc = _mm256_setzero_ps();
+        for(int k = 0; k < taps; k++){
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(rows + (size_t)k * stride + i), _mm256_set1_ps(w[k])));
+        }
+
+        __m256i v = _mm256_cvtps_epi32(acc);
+        __m128i v16 = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        __m128i v8 = _mm_packus_epi16(v16, v16);
+        _mm_storel_epi64((__m128i*)(out + i), v8);
+    }
+
+    if(i < count) verticalSSE41(rows + i, stride, out + i, w, taps, count - i);
+}
+
+#endif
+
+
+static HorizontalKernel pickHorizontal(){
+#ifdef LUMOS_X86
+    if(cpuHasAVX2()) return horizontalAVX2;
+    if(cpuHasSSE41()) return horizontalSSE41;
+#endif
+    return horizontalScalar;
+}
+
+
+static VerticalKernel pickVertical(){
+#ifdef LUMOS_X86
+    if(cpuHasAVX2()) return verticalAVX2;
+    if(cpuHasSSE41()) return verticalSSE41;
+#endif
+    return verticalScalar;
+}
+
+
+/** Scale Pixels
+ *
+ * Scales a RGBA32 image on the CPU with a separable box, bilinear or Lanczos3
+ * filter, using the AVX2 or SSE4.1 kernels when the CPU has them. The rows are
+ * split across the worker threads. Filtering is done in premultiplied alpha
+ * so the color of the transparent pixels doesnt bleed into the edges.
+ *
+ * @param src Source RGBA32 pixels, tightly packed
+ * @param srcWidth Source width
+ * @param srcHeight Source height
+ * @param dst Output RGBA32 pixels, dstWidth * dstHeight * 4 bytes
+ * @param dstWidth Output width
+ * @param dstHeight Output height
+ * @param filter TM_FILTER_BOX, TM_FILTER_BILINEAR or TM_FILTER_LANCZOS
+ */
+void TM::scalePixels(
+    const Uint8* src, int srcWidth, int srcHeight,
+    Uint8* dst, int dstWidth, int dstHeight,
+    int filter
+){
+    static const HorizontalKernel horizontal = pickHorizontal();
+    static const VerticalKernel vertical = pickVertical();
+
+    size_t srcPitch = (size_t)srcWidth * 4;
+    size_t dstPitch = (size_t)dstWidth * 4;
+
+    ScaleWeights wx = computeWeights(srcWidth, dstWidth, filter);
+    ScaleWeights wy = computeWeights(srcHeight, dstHeight, filter);
+
+    // PREMULTIPLY AND HORIZONTAL PASS ------------------------------------------------------
+    vector<float> tmp((size_t)srcHeight * dstPitch);
+    Jobs::parallelFor(srcHeight, [&](int begin, int end){
+        vector<Uint8> row(srcPitch);
+        for(int y = begin; y < end; y++){
+            Pixel::premultiply(src + y * srcPitch, row.data(), srcWidth);
+            horizontal(row.data(), tmp.data() + y * dstPitch, wx, dstWidth);
+        }
+    }, 16);
+
+    // VERTICAL PASS AND UNPREMULTIPLY ------------------------------------------------------
+    Jobs::parallelFor(dstHeight, [&](int begin, int end){
+        for(int y = begin; y < end; y++){
+            const float* rows = tmp.data() + wy.start[y] * dstPitch;
+            const float* w = &wy.weights[(size_t)y * wy.taps];
+
+            vertical(rows, dstPitch, dst + y * dstPitch, w, wy.taps, dstPitch);
+            Pixel::unpremultiply(dst + y * dstPitch, dst + y * dstPitch, dstWidth);
+        }
+    }, 8);
+}
+
+
+
+
+/** Scale Variant
+ *
+ * Gives a scaled version of the texture, computed on the CPU with a proper
+ * downscaling filter so large reductions, like photos shown as thumbnails,
+ * dont alias. The variants are cached by (texture, size, filter), so asking
+ * for the same one again is just a lookup, and they are kept until the source
+ * texture is freed or modified. Free dst with TM::freeTexture as usual.
+ *
+ * The source pixels are the retained ones (TM::setRetainPixels) or are read
+ * back, so the source must be a loaded image or a render target.
+ *
+ * @param src TextureData to be scaled
+ * @param dst TextureData where the variant will be placed
+ * @param width Target width, -1 to calculate it from the height and aspect ratio
+ * @param height Target height, -1 to calculate it from the width and aspect ratio
+ * @param filter TM_FILTER_BOX, TM_FILTER_BILINEAR or TM_FILTER_LANCZOS
+ * @param wait If false the scaling runs on a worker thread and TM_VARIANT_PENDING
+ *             is returned until it is done, call it again on the next frames
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::scaleVariant(const TextureData& src, TextureData& dst, int width, int height, int filter, bool wait){
+    if(width == -1 && height == -1) return TM_INVALID_DRECT;
+
+    auto source = records.find(src.id);
+    if(source == records.end()) return TM_GOT_NULLPTR_TEX;
+    const TextureData& srcTd = source->second.td;
+
+    if(width == -1) width = static_cast<int>(srcTd.width * (static_cast<float>(height) / srcTd.height));
+    if(height == -1) height = static_cast<int>(srcTd.height * (static_cast<float>(width) / srcTd.width));
+    if(width < 1 || height < 1 || width > 0x7fff || height > 0x7fff) return TM_INVALID_DRECT;
+
+    Uint32 sourceId = src.id;
+    Uint64 key = ((Uint64)sourceId << 32) | ((Uint64)width << 17) | ((Uint64)height << 2) | (filter & 3);
+
+    // START THE SCALING IF IT IS NOT CACHED OR ALREADY RUNNING -----------------------------
+    if(!variantCache.count(key) && !pendingScales.count(key)){
+        vector<Uint8> pixels;
+        int err = TM::readPixels(source->second, pixels);
+        if(err != NO_ERROR) return err;
+
+        // The scaler works on straight alpha, the variants are straight too
+        if(source->second.premultiplied){
+            Pixel::unpremultiply(pixels.data(), pixels.data(), srcTd.width * srcTd.height);
+        }
+
+        auto job = make_shared<ScaleJob>();
+        job->width = width;
+        job->height = height;
+        job->pixels.resize((size_t)width * height * 4);
+
+        auto promise = make_shared<std::promise<void>>();
+        job->done = promise->get_future().share();
+        pendingScales.insert({key, job});
+
+        int srcWidth = srcTd.width, srcHeight = srcTd.height;
+        auto work = [job, promise, pixels = std::move(pixels), srcWidth, srcHeight, filter](){
+            TM::scalePixels(
+                pixels.data(), srcWidth, srcHeight,
+                job->pixels.data(), job->width, job->height,
+                filter
+            );
+            promise->set_value();
+        };
+
+        if(wait) work();
+        else Jobs::submit(std::move(work));
+    }
+
+    // UPLOAD IT ONCE IT IS DONE -----------------------------------------------------------
+    auto pending = pendingScales.find(key);
+    if(pending != pendingScales.end()){
+        shared_ptr<ScaleJob> job = pending->second;
+        if(!wait && job->done.wait_for(std::chrono::seconds(0)) != std::future_status::ready){
+            return TM_VARIANT_PENDING;
+        }
+        job->done.wait();
+
+        pendingScales.erase(pending);
+        int err = TM::uploadVariant(key, sourceId, *job);
+        if(err != NO_ERROR) return err;
+    }
+
+    // GIVE A REFERENCE TO THE CACHED VARIANT ----------------------------------------------
+    TextureData old = dst;
+
+    TextureRecord& rec = records.at(variantCache.at(key));
+    rec.refs++;
+    dst = rec.td;
+
+    TM::freeTexture(old);
+    return NO_ERROR;
+}
+
+
+
+
+/** Upload Variant
+ *
+ * INTERNAL USE
+ *
+ * Uploads the finished scaling job into a texture and caches it.
+ * The cache holds the first reference, released with the source.
+ *
+ * @param key Variant cache key
+ * @param sourceId Record id of the scaled texture
+ * @param job The finished scaling job
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::uploadVariant(Uint64 key, Uint32 sourceId, ScaleJob& job){
+    TextureData variant;
+    int err = TM::acquireTexture(variant, job.width, job.height, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET);
+    if(err != NO_ERROR) return err;
+
+    if(SDL_UpdateTexture(variant.tex, &variant.src, job.pixels.data(), job.width * 4)){
+        TM::freeTexture(variant);
+        return TM_TEXTURE_UPDATE_ERROR;
+    }
+
+    records.at(variant.id).variantKey = key;
+    variantCache[key] = variant.id;
+
+    auto source = records.find(sourceId);
+    if(source != records.end()) source->second.hasVariants = true;
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Drop Variants
+ *
+ * INTERNAL USE
+ *
+ * Releases the cached and forgets the pending variants of the texture,
+ * called when it is freed or modified.
+ *
+ * @param sourceId Record id of the scaled texture
+ */
+void TM::dropVariants(Uint32 sourceId){
+    vector<Uint32> variants;
+    for(auto it = variantCache.begin(); it != variantCache.end(); ){
+        if((it->first >> 32) == sourceId){
+            variants.push_back(it->second);
+            it = variantCache.erase(it);
+        } else ++it;
+    }
+
+    for(auto it = pendingScales.begin(); it != pendingScales.end(); ){
+        if((it->first >> 32) == sourceId) it = pendingScales.erase(it);
+        else ++it;
+    }
+
+    auto source = records.find(sourceId);
+    if(source != records.end()) source->second.hasVariants = false;
+
+    // Release the cache references, variants still used elsewhere stay alive
+    for(Uint32 id : variants){
+        TextureData variant;
+        variant.id = id;
+        TM::release(variant);
+    }
+}
+
+
+
+
+/** Read Pixels
+ *
+ * INTERNAL USE
+ *
+ * Gets the RGBA32 pixels of the texture, the retained ones if there are
+ * any, otherwise they are read back from the render target.
+ *
+ * @param rec Record of the texture
+ * @param pixels Gets the tightly packed RGBA32 pixels
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::readPixels(TextureRecord& rec, vector<Uint8>& pixels){
+    if(!rec.pixels.empty()){
+        pixels = rec.pixels;
+        return NO_ERROR;
+    }
+
+    if(rec.access != SDL_TEXTUREACCESS_TARGET) return TM_READ_PIXELS_FAILED;
+
+    SDL_Texture* tex = TM::resolve(rec.td);
+    if(tex == nullptr) return TM_GOT_NULLPTR_TEX;
+
+    SDL_Rect area = {rec.td.src.x, rec.td.src.y, rec.td.width, rec.td.height};
+    pixels.resize((size_t)area.w * area.h * 4);
+
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(Sys::renderer);
+    if(SDL_SetRenderTarget(Sys::renderer, tex)) return TM_SRT_FAILED;
+
+    int err = SDL_RenderReadPixels(Sys::renderer, &area, SDL_PIXELFORMAT_RGBA32, pixels.data(), area.w * 4);
+    SDL_SetRenderTarget(Sys::renderer, previousTarget);
+    if(err != 0) return TM_READ_PIXELS_FAILED;
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Set Retain Pixels
+ *
+ * If enabled, TM::loadTexture keeps a RGBA32 copy of every loaded image in RAM.
+ * Scaled variants are then computed without a GPU read back, and evicted
+ * textures are restored without reading the file again. Off by default.
+ *
+ * @param retain Keep the pixels of the loaded images
+ */
+void TM::setRetainPixels(bool retain){ retainPixels = retain; }
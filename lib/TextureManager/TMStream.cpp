@@ -0,0 +1,162 @@
+#include "./TM.h"
+#include "../System/Sys.h"
+
+
+
+/** Create Streaming Texture
+ *
+ * Creates a double buffered streaming texture for content that changes every
+ * frame, like camera frames or live plots. Instead of freeing and re-creating
+ * the texture, write into it trough lock/unlock and render st.td().
+ *
+ * @param st StreamingTexture to be created
+ * @param width Width of the texture
+ * @param height Height of the texture
+ * @param format Pixel format of the texture and of the CPU copy
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::createStreamingTexture(StreamingTexture& st, int width, int height, Uint32 format){
+    if(width < 1 || height < 1) return TM_INVALID_DRECT;
+    TM::freeStreamingTexture(st);
+
+    // CREATE BOTH BUFFERS ------------------------------------------------------------------
+    for(auto& buffer : st.buffers){
+        buffer.tex = SDL_CreateTexture(
+            Sys::renderer,
+            format,
+            SDL_TEXTUREACCESS_STREAMING,
+            width,
+            height
+        );
+        if(buffer.tex == nullptr){
+            TM::freeStreamingTexture(st);
+            return TM_TEXTURE_CREATE_ERROR;
+        }
+
+        if(SDL_SetTextureBlendMode(buffer.tex, SDL_BLENDMODE_BLEND)){
+            SDL_DestroyTexture(buffer.tex);
+            buffer.tex = nullptr;
+            TM::freeStreamingTexture(st);
+            return TM_TEXTURE_SET_BLENDMODE_ERROR;
+        }
+
+        SDL_QueryTexture(buffer.tex, &buffer.format, NULL, &buffer.width, &buffer.height);
+        buffer.orgWidth = buffer.width;
+        buffer.orgHeight = buffer.height;
+        TM::track(buffer);
+    }
+
+    // CPU COPY, STARTS TRANSPARENT -----------------------------------------------------------
+    st.pitch = width * SDL_BYTESPERPIXEL(format);
+    st.pixels.assign((size_t)st.pitch * height, 0);
+
+    // Both buffers start with undefined content, so all of it is dirty
+    st.dirty[0] = {0, 0, width, height};
+    st.dirty[1] = {0, 0, width, height};
+    st.front = 0;
+    st.locked = false;
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Lock Streaming Texture
+ *
+ * Gives write access to the CPU copy of the texture. The locked area is marked
+ * dirty and it is uploaded on TM::unlockStreamingTexture, so lock only the
+ * area that will change to keep the uploads small.
+ *
+ * @param st StreamingTexture to be locked
+ * @param pixels Gets the pointer to the top-left pixel of the locked area
+ * @param pitch Gets the length of one row of the CPU copy in bytes
+ * @param rect Area to be written, nullptr for the whole texture
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::lockStreamingTexture(StreamingTexture& st, void** pixels, int* pitch, const SDL_Rect* rect){
+    if(st.buffers[0].tex == nullptr) return TM_GOT_NULLPTR_TEX;
+    if(st.locked) return TM_STREAM_LOCK_ERROR;
+
+    // CLIP THE AREA TO THE TEXTURE -----------------------------------------------------------
+    SDL_Rect bounds = {0, 0, st.buffers[0].width, st.buffers[0].height};
+    SDL_Rect area = bounds;
+    if(rect != nullptr && !SDL_IntersectRect(rect, &bounds, &area)) return TM_INVALID_DRECT;
+
+    // Both buffers are now behind the CPU copy in this area
+    SDL_UnionRect(&st.dirty[0], &area, &st.dirty[0]);
+    SDL_UnionRect(&st.dirty[1], &area, &st.dirty[1]);
+
+    int bpp = SDL_BYTESPERPIXEL(st.buffers[0].format);
+    *pixels = st.pixels.data() + (size_t)area.y * st.pitch + area.x * bpp;
+    *pitch = st.pitch;
+
+    st.locked = true;
+    return NO_ERROR;
+}
+
+
+
+
+/** Unlock Streaming Texture
+ *
+ * Uploads the dirty area of the back buffer with a single SDL_UpdateTexture
+ * and swaps the buffers, so the next render shows the new content. The back
+ * buffer catches up on both this and the previous frames changes.
+ *
+ * @param st StreamingTexture to be unlocked
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int TM::unlockStreamingTexture(StreamingTexture& st){
+    if(!st.locked) return TM_STREAM_LOCK_ERROR;
+    st.locked = false;
+
+    int back = 1 - st.front;
+    SDL_Rect& area = st.dirty[back];
+
+    if(area.w > 0 && area.h > 0){
+        int bpp = SDL_BYTESPERPIXEL(st.buffers[back].format);
+        const Uint8* src = st.pixels.data() + (size_t)area.y * st.pitch + area.x * bpp;
+
+        if(SDL_UpdateTexture(st.buffers[back].tex, &area, src, st.pitch)) return TM_TEXTURE_UPDATE_ERROR;
+
+        frameUploadBytes += (size_t)area.w * area.h * bpp;
+        frameUploads++;
+        uploadStats.totalBytes += (size_t)area.w * area.h * bpp;
+
+        area = {0, 0, 0, 0};
+    }
+
+    st.front = back;
+    return NO_ERROR;
+}
+
+
+
+
+/** Free Streaming Texture
+ *
+ * Frees both buffers and the CPU copy of the streaming texture.
+ *
+ * @param st StreamingTexture to be freed
+ */
+void TM::freeStreamingTexture(StreamingTexture& st){
+    for(auto& buffer : st.buffers) TM::freeTexture(buffer);
+
+    vector<Uint8>().swap(st.pixels);
+    st.pitch = 0;
+    st.dirty[0] = {0, 0, 0, 0};
+    st.dirty[1] = {0, 0, 0, 0};
+    st.front = 0;
+    st.locked = false;
+}
+
+
+
+
+/** Get Upload Stats
+ *
+ * Returns how many bytes were uploaded to streaming textures during
+ * the last frame, and since the start.
+ */
+TextureUploadStats TM::getUploadStats(){ return uploadStats; }
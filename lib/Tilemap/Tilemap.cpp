@@ -0,0 +1,260 @@
+#include "./Tilemap.h"
+#include "../System/Sys.h"
+
+
+
+/** Tilemap
+ * 
+ * Creates an empty map, every tile is TILE_EMPTY.
+ * 
+ * @param width Width of the map in tiles
+ * @param height Height of the map in tiles
+ * @param tileSize Size of a tile on the map in pixels, at zoom 1
+ * @param chunkSize Width and height of a chunk in tiles
+ */
+Tilemap::Tilemap(int width, int height, int tileSize, int chunkSize)
+    : width(max(1, width)), height(max(1, height)), tileSize(max(1, tileSize)), chunkSize(max(1, chunkSize))
+{
+    chunksX = (this->width + this->chunkSize - 1) / this->chunkSize;
+    chunksY = (this->height + this->chunkSize - 1) / this->chunkSize;
+
+    tiles.assign((size_t)this->width * this->height, TILE_EMPTY);
+    chunks.resize((size_t)chunksX * chunksY);
+}
+
+
+
+
+Tilemap::~Tilemap(){
+    for(Chunk& chunk : chunks) TM::freeTexture(chunk.td);
+}
+
+
+
+
+/** Set Tileset
+ * 
+ * Sets the atlas the tiles are taken from, tile 0 is its top-left cell,
+ * counting to the right and then down. Every chunk is drawn again.
+ * 
+ * @param tileset Atlas texture, it must outlive the map
+ * @param tileWidth Width of a cell in the atlas, -1 for the tile size of the map
+ * @param tileHeight Height of a cell in the atlas, -1 for the tile size of the map
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Tilemap::setTileset(const TextureData& tileset, int tileWidth, int tileHeight){
+    if(tileWidth == -1) tileWidth = tileSize;
+    if(tileHeight == -1) tileHeight = tileSize;
+    if(tileWidth <= 0 || tileHeight <= 0) return TILEMAP_INVALID_TILESET;
+
+    int columns = tileset.width / tileWidth;
+    int rows = tileset.height / tileHeight;
+    if(columns == 0 || rows == 0) return TILEMAP_INVALID_TILESET;
+
+    this->tileset = tileset;
+    this->tileWidth = tileWidth;
+    this->tileHeight = tileHeight;
+    tilesetColumns = columns;
+    tilesetCount = columns * rows;
+
+    invalidate();
+    return NO_ERROR;
+}
+
+
+
+
+/** Set Tile
+ * 
+ * Changes the tile, only its chunk is drawn again, once it is visible.
+ * 
+ * @param x Column of the tile
+ * @param y Row of the tile
+ * @param tile Index of the cell in the tileset, or TILE_EMPTY
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Tilemap::setTile(int x, int y, int tile){
+    if(x < 0 || y < 0 || x >= width || y >= height) return TILEMAP_OUT_OF_BOUNDS;
+
+    int& current = tiles[(size_t)y * width + x];
+    if(current == tile) return NO_ERROR;
+
+    Chunk& chunk = chunkOf(x, y);
+    if(current == TILE_EMPTY) chunk.tiles++;
+    if(tile == TILE_EMPTY) chunk.tiles--;
+    current = tile;
+    chunk.dirty = true;
+
+    // Nothing left to draw, give the texture back to the pool right away
+    if(chunk.tiles == 0) TM::freeTexture(chunk.td);
+
+    return NO_ERROR;
+}
+
+
+
+
+/** Get Tile
+ * 
+ * @param x Column of the tile
+ * @param y Row of the tile
+ * @return Index of the cell in the tileset, TILE_EMPTY if there is none or if it is out of the map
+ */
+int Tilemap::getTile(int x, int y) const{
+    if(x < 0 || y < 0 || x >= width || y >= height) return TILE_EMPTY;
+    return tiles[(size_t)y * width + x];
+}
+
+
+
+
+/** Fill
+ * 
+ * Sets every tile of the map.
+ * 
+ * @param tile Index of the cell in the tileset, or TILE_EMPTY
+ */
+void Tilemap::fill(int tile){
+    for(int y = 0; y < height; y++){
+        for(int x = 0; x < width; x++) setTile(x, y, tile);
+    }
+}
+
+
+
+
+/** Invalidate
+ * 
+ * Draws every chunk again, once it is visible. Needed if the
+ * content of the tileset texture was changed.
+ */
+void Tilemap::invalidate(){
+    for(Chunk& chunk : chunks) chunk.dirty = true;
+}
+
+
+
+
+/** Build Chunk
+ * 
+ * INTERNAL USE
+ * 
+ * Draws the tiles of the chunk into its texture. All of them come from the
+ * tileset, so the overlay submits them with a single draw call.
+ * 
+ * @param cx Column of the chunk
+ * @param cy Row of the chunk
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Tilemap::buildChunk(int cx, int cy){
+    Chunk& chunk = chunks[(size_t)cy * chunksX + cx];
+    chunk.dirty = false;
+    chunkRebuilds++;
+
+    // GET THE CHUNK TEXTURE ----------------------------------------------------------------
+    if(chunk.td.id == 0){
+        int err = TM::acquireTexture(chunk.td, chunkSize * tileSize, chunkSize * tileSize);
+        if(err != NO_ERROR) return err;
+
+        // Drawing onto the transparent texture leaves premultiplied colors in it
+        SDL_SetTextureBlendMode(TM::resolve(chunk.td), TM::getPremultipliedBlendMode());
+    }
+
+    OverlayScope overlay(chunk.td);
+    if(overlay.getError() != NO_ERROR) return overlay.getError();
+
+    // Pooled textures keep their old content
+    SDL_SetRenderDrawColor(Sys::renderer, 0, 0, 0, 0);
+    SDL_RenderClear(Sys::renderer);
+
+    // RECORD THE TILES ---------------------------------------------------------------------
+    // Pooled tilesets hold the image in their src part
+    int originX = tileset.srcRect() ? tileset.src.x : 0;
+    int originY = tileset.srcRect() ? tileset.src.y : 0;
+    TextureData cell = tileset;
+
+    int endX = min(width, (cx + 1) * chunkSize);
+    int endY = min(height, (cy + 1) * chunkSize);
+    for(int y = cy * chunkSize; y < endY; y++){
+        for(int x = cx * chunkSize; x < endX; x++){
+            int tile = tiles[(size_t)y * width + x];
+            if(tile < 0 || tile >= tilesetCount) continue;
+
+            cell.src = {
+                originX + (tile % tilesetColumns) * tileWidth,
+                originY + (tile / tilesetColumns) * tileHeight,
+                tileWidth,
+                tileHeight
+            };
+            SDL_Rect dr = {(x - cx * chunkSize) * tileSize, (y - cy * chunkSize) * tileSize, tileSize, tileSize};
+
+            int err = overlay.texture(cell, dr);
+            if(err != NO_ERROR) return err;
+        }
+    }
+
+    return overlay.end();
+}
+
+
+
+
+/** Render
+ * 
+ * Draws the part of the map seen by the camera into the viewport. Only
+ * the visible chunks are drawn, the ones with changed tiles are drawn
+ * into their textures first.
+ * 
+ * @param camera Map position, in pixels, shown at the top-left corner of the viewport
+ * @param viewport Where on the screen the map is drawn, nothing is drawn outside of it
+ * @param zoom Scale of the map, 2 makes the tiles twice as big
+ * @return 0 on success and positive on error coresponding to the ERROR DEFINITIONS
+ */
+int Tilemap::render(const SDL_FPoint& camera, const SDL_Rect& viewport, float zoom){
+    visibleChunks = 0;
+    if(zoom <= 0 || viewport.w <= 0 || viewport.h <= 0) return TM_INVALID_DRECT;
+    if(tilesetCount == 0) return TILEMAP_NO_TILESET;
+
+    // VISIBLE CHUNKS -----------------------------------------------------------------------
+    float chunkPx = (float)chunkSize * tileSize;
+    int cx0 = max(0, (int)floorf(camera.x / chunkPx));
+    int cy0 = max(0, (int)floorf(camera.y / chunkPx));
+    int cx1 = min(chunksX - 1, (int)floorf((camera.x + viewport.w / zoom) / chunkPx));
+    int cy1 = min(chunksY - 1, (int)floorf((camera.y + viewport.h / zoom) / chunkPx));
+
+    // Chunks on the edges stick out of the viewport
+    SDL_Rect previousClip;
+    bool clipped = SDL_RenderIsClipEnabled(Sys::renderer);
+    SDL_RenderGetClipRect(Sys::renderer, &previousClip);
+    SDL_RenderSetClipRect(Sys::renderer, &viewport);
+
+    int error = NO_ERROR;
+    for(int cy = cy0; cy <= cy1; cy++){
+        for(int cx = cx0; cx <= cx1; cx++){
+            Chunk& chunk = chunks[(size_t)cy * chunksX + cx];
+            if(chunk.tiles == 0) continue;
+
+            if(chunk.dirty){
+                int err = buildChunk(cx, cy);
+                if(err != NO_ERROR){
+                    error = err;
+                    continue;
+                }
+            }
+
+            // Both edges are rounded, so neighbouring chunks never leave a gap
+            int x0 = viewport.x + (int)lroundf((cx * chunkPx - camera.x) * zoom);
+            int y0 = viewport.y + (int)lroundf((cy * chunkPx - camera.y) * zoom);
+            int x1 = viewport.x + (int)lroundf(((cx + 1) * chunkPx - camera.x) * zoom);
+            int y1 = viewport.y + (int)lroundf(((cy + 1) * chunkPx - camera.y) * zoom);
+
+            SDL_Rect dr = {x0, y0, x1 - x0, y1 - y0};
+            int err = TM::renderTexture(chunk.td, dr);
+            if(err != NO_ERROR) error = err;
+            visibleChunks++;
+        }
+    }
+
+    SDL_RenderSetClipRect(Sys::renderer, clipped ? &previousClip : nullptr);
+    return error;
+}
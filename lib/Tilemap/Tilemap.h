@@ -0,0 +1,68 @@
+#pragma once
+#ifndef MySDL_TILEMAP
+#define MySDL_TILEMAP
+
+#include "../lib.h"
+#include "../TextureManager/TM.h"
+
+
+#define TILE_EMPTY  -1
+
+
+// TILEMAP -----------------------------------------------------------------------------------------
+// A grid of tiles from one tileset (atlas) texture, split into square chunks.
+// Every chunk is drawn once into its own texture, with one batched overlay,
+// and then the visible chunks are blitted each frame, a few draws instead of
+// one per tile. Changing a tile only redraws the chunk holding it.
+class Tilemap{
+    public:
+    Tilemap(int width, int height, int tileSize, int chunkSize = 16);
+    ~Tilemap();
+
+    Tilemap(const Tilemap&) = delete;
+    Tilemap& operator=(const Tilemap&) = delete;
+
+    int setTileset(const TextureData& tileset, int tileWidth = -1, int tileHeight = -1);
+
+    int setTile(int x, int y, int tile);
+    int getTile(int x, int y) const;
+    void fill(int tile);
+
+    int render(const SDL_FPoint& camera, const SDL_Rect& viewport, float zoom = 1.0f);
+    void invalidate();
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getTileSize() const { return tileSize; }
+    int getVisibleChunks() const { return visibleChunks; }
+    Uint64 getChunkRebuilds() const { return chunkRebuilds; }
+
+    private:
+    struct Chunk{
+        TextureData td;         // Pre-composited tiles, holds premultiplied alpha
+        int tiles = 0;          // Non empty tiles, chunks without any have no texture
+        bool dirty = true;
+    };
+
+    int width, height;          // In tiles
+    int tileSize;               // Size of a tile on the map, in pixels
+    int chunkSize;              // Width and height of a chunk, in tiles
+    int chunksX, chunksY;
+
+    vector<int> tiles;
+    vector<Chunk> chunks;
+
+    TextureData tileset;        // Not owned
+    int tileWidth = 0, tileHeight = 0;  // Size of a tile in the tileset
+    int tilesetColumns = 0;
+    int tilesetCount = 0;
+
+    int visibleChunks = 0;
+    Uint64 chunkRebuilds = 0;
+
+    Chunk& chunkOf(int x, int y) { return chunks[(y / chunkSize) * chunksX + x / chunkSize]; }
+    int buildChunk(int cx, int cy);
+};
+
+#endif
+// Creator: @AndrijaRD
@@ -13,6 +13,17 @@
 #include <libpq-fe.h>       // For PosgreSQL DB
 #include <unordered_map>    // For unordered_map<type, type>
 #include <set>              // For sets (gui.h)
+#include <list>             // For list<> (TM residency)
+#include <thread>           // Worker threads (Jobs.h)
+#include <mutex>            // std::mutex, std::lock_guard
+#include <condition_variable>
+#include <functional>       // std::function
+#include <deque>            // Job queue
+#include <atomic>           // std::atomic
+#include <memory>           // shared_ptr<>
+#include <future>           // promise<>, future<>
+#include <string_view>      // string_view (GUI labels)
+#include <lz4.h>            // LZ4 compression of evicted textures
 
 
 using namespace std;
@@ -25,6 +36,18 @@ namespace fs = std::filesystem;
 #define OS_WINDOWS  1
 
 
+// CPU FEATURES -----------------------------------------------------------------
+// Used to pick the SIMD kernels at runtime, the scalar ones are used on other CPUs
+#if defined(__x86_64__) || defined(__i386__)
+    #define LUMOS_X86 1
+    inline bool cpuHasAVX2()  { static const bool has = __builtin_cpu_supports("avx2"); return has; }
+    inline bool cpuHasSSE41() { static const bool has = __builtin_cpu_supports("sse4.1"); return has; }
+#else
+    inline bool cpuHasAVX2()  { return false; }
+    inline bool cpuHasSSE41() { return false; }
+#endif
+
+
 // COLORS -----------------------------------------------------------------------
 #define SDL_COLOR_WHITE         {255,   255,    255,    255}
 #define SDL_COLOR_BLACK         {0,     0,      0,      255}
@@ -48,6 +71,15 @@ inline Uint32 toUint32(const SDL_Color& color) {
 }
 
 
+// TEXT -------------------------------------------------------------------------
+// Quality tiers of the rendered text
+#define TEXT_SOLID      0       // 1 bit, no antialiasing, the fastest to rasterize
+#define TEXT_SHADED     1       // Antialiased over a solid background color, no alpha
+#define TEXT_BLENDED    2       // Antialiased with alpha, the default
+
+#define FONT_DEFAULT    0       // Id of the font opened by Sys::initFont (Fonts::load)
+
+
 // ERRORS ----------------------------------------------------------------------
 #define NO_ERROR                        0x00
 
@@ -73,6 +105,14 @@ inline Uint32 toUint32(const SDL_Color& color) {
 #define TM_RCLR_FAILED                  0x2a        // SDL_RenderClear          Failed
 #define TM_FILL_RECT_ERROR              0x2b        // SDL_RenderFillRect       Failed
 #define TM_INVALID_LINE_LENGTH          0x2c
+#define TM_READ_PIXELS_FAILED           0x2d        // SDL_RenderReadPixels     Failed
+#define TM_COMPRESSION_ERROR            0x2e        // LZ4 (de)compression      Failed
+#define TM_STREAM_LOCK_ERROR            0x2f        // Streaming texture is (not) locked
+#define TM_VARIANT_PENDING              0x30        // Scaled variant is still being computed
+#define TM_OVERLAY_ENDED                0x31        // Drawing trough an ended OverlayScope
+#define TM_RENDER_GEOMETRY_FAILED       0x32        // SDL_RenderGeometry       Failed
+#define TM_SAVE_FAILED                  0x33        // Encoding or writing the image Failed
+#define TM_SOURCE_CHANGED               0x34        // File of an evicted texture changed or is gone
 //  TM RESERVED                         0x3f
 
 #define DB_CONNECTION_ERROR             0x40
@@ -83,8 +123,64 @@ inline Uint32 toUint32(const SDL_Color& color) {
 #define DB_INVALID_ROW_COLUMN           0x45
 #define DB_INVALID_RES_VALUE            0x46
 #define DB_EMPTY_STATEMENT_PARAM        0x47
+#define DB_TEXTURE_PENDING              0x48        // Image fetched out of the db is still being decoded
 //  DB RESERVED                         0x5f
 
+#define PLOT_RENDER_GEOMETRY_FAILED     0x60        // SDL_RenderGeometry       Failed
+#define PLOT_INVALID_VIEW               0x61        // Empty rect or data range
+//  PLOT RESERVED                       0x6f
+
+#define QOI_WRITE_ERROR                 0x70        // Writing the .qoi file    Failed
+#define QOI_READ_ERROR                  0x71        // Reading the .qoi file    Failed
+#define QOI_INVALID_HEADER              0x72        // Not a QOI file, or unsupported size
+#define QOI_TRUNCATED                   0x73        // File ended before all the pixels
+//  QOI RESERVED                        0x77
+
+#define CAPTURE_READ_PIXELS_FAILED      0x78        // SDL_RenderReadPixels     Failed
+#define CAPTURE_ENCODE_ERROR            0x79        // Encoding or writing the capture Failed
+#define CAPTURE_INVALID_FORMAT          0x7a
+//  CAPTURE RESERVED                    0x7f
+
+#define PARTICLE_RENDER_GEOMETRY_FAILED 0x80        // SDL_RenderGeometry       Failed
+#define PARTICLE_INVALID_EMITTER        0x81        // No emitter with that id
+//  PARTICLE RESERVED                   0x8f
+
+#define TILEMAP_OUT_OF_BOUNDS           0x90        // Tile outside of the map
+#define TILEMAP_INVALID_TILESET         0x91        // Tileset smaller then one tile
+#define TILEMAP_NO_TILESET              0x92        // Rendering before Tilemap::setTileset
+//  TILEMAP RESERVED                    0x9f
+
+#define SCENE_INVALID_OBJECT            0xa0        // No object with that id
+//  SCENE RESERVED                      0xaf
+
+#define ANIM_OPEN_FAILED                0xb0        // Frame file couldnt be opened or loaded
+#define ANIM_INVALID_GIF                0xb1        // Not a GIF or a broken one
+#define ANIM_FRAME_SIZE_MISMATCH        0xb2        // Image sequence frames of different sizes
+#define ANIM_NOT_OPEN                   0xb3        // Animation::open wasnt called
+#define ANIM_NO_FRAMES                  0xb4        // Clip without a single frame
+//  ANIM RESERVED                       0xbf
+
+#define RASTER_INVALID_SIZE             0xc0        // Canvas smaller then 1x1
+#define RASTER_LOAD_FAILED              0xc1        // RasterImage::load        Failed
+//  RASTER RESERVED                     0xcf
+
+#define FRAMESINK_SHM_FAILED            0xd0        // shm_open, ftruncate or mmap Failed
+#define FRAMESINK_FRAME_TOO_LARGE       0xd1        // Frame larger then the slots of the ring
+#define FRAMESINK_INVALID               0xd2        // Not a frame sink ring, or not opened
+#define FRAMESINK_TIMEOUT               0xd3        // No new frame within the timeout
+#define FRAMESINK_UNSUPPORTED           0xd4        // Shared memory rings are Linux only
+//  FRAMESINK RESERVED                  0xdf
+
+#define TEXT_FONT_OPEN_FAILED           0xe0        // TTF_OpenFont of a font size Failed
+#define TEXT_GLYPH_FAILED               0xe1        // Rasterizing or placing a glyph Failed
+#define TEXT_RENDER_GEOMETRY_FAILED     0xe2        // SDL_RenderGeometry       Failed
+#define TEXT_FONT_MAP_FAILED            0xe3        // Mapping or reading the font file Failed
+#define TEXT_INVALID_FONT               0xe4        // No font registered with that id
+//  TEXT RESERVED                       0xef
+
+#define GUI_LAYER_NESTED                0xf0        // beginLayer inside of another layer
+//  GUI RESERVED                        0xff
+
 
 
 // DATE ------------------------------------------------------------------------
@@ -0,0 +1,90 @@
+// Compares two images pixel by pixel, used by the golden image tests.
+//
+// Usage: ImageDiff <expected> <actual> [tolerance] [max-differing] [diff-output]
+//   tolerance       Largest per-channel difference still counted as equal, 2 by default
+//   max-differing   Fraction of the pixels allowed to differ, 0.001 by default
+//   diff-output     Writes a PNG with the differing pixels in red
+//
+// Exit code is 0 when the images match, 1 when they dont and 2 on error.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+
+static SDL_Surface* loadRGBA(const char* path){
+    SDL_Surface* loaded = IMG_Load(path);
+    if(loaded == nullptr){
+        cerr << "[ERROR] Failed to load " << path << ": " << IMG_GetError() << endl;
+        return nullptr;
+    }
+
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    return converted;
+}
+
+
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        cerr << "Usage: " << argv[0] << " <expected> <actual> [tolerance] [max-differing] [diff-output]" << endl;
+        return 2;
+    }
+
+    int tolerance = argc > 3 ? atoi(argv[3]) : 2;
+    double maxDiffering = argc > 4 ? atof(argv[4]) : 0.001;
+    const char* diffPath = argc > 5 ? argv[5] : nullptr;
+
+    SDL_Surface* expected = loadRGBA(argv[1]);
+    SDL_Surface* actual = loadRGBA(argv[2]);
+    if(expected == nullptr || actual == nullptr) return 2;
+
+    if(expected->w != actual->w || expected->h != actual->h){
+        cout << "[DIFF] Size differs, expected " << expected->w << "x" << expected->h
+             << " got " << actual->w << "x" << actual->h << endl;
+        return 1;
+    }
+
+    // COMPARE ------------------------------------------------------------------------------
+    SDL_Surface* diff = SDL_CreateRGBSurfaceWithFormat(0, actual->w, actual->h, 32, SDL_PIXELFORMAT_RGBA32);
+    long differing = 0;
+    int largest = 0;
+
+    for(int y = 0; y < actual->h; y++){
+        const Uint8* e = (const Uint8*)expected->pixels + y * expected->pitch;
+        const Uint8* a = (const Uint8*)actual->pixels + y * actual->pitch;
+        Uint8* d = (Uint8*)diff->pixels + y * diff->pitch;
+
+        for(int x = 0; x < actual->w; x++, e += 4, a += 4, d += 4){
+            int delta = 0;
+            for(int c = 0; c < 4; c++) delta = max(delta, abs(e[c] - a[c]));
+            largest = max(largest, delta);
+
+            // Differing pixels in red, the rest as a faded gray copy of the expected image
+            if(delta > tolerance){
+                differing++;
+                d[0] = 255; d[1] = 0; d[2] = 0; d[3] = 255;
+            } else {
+                Uint8 gray = (e[0] + e[1] + e[2]) / 12;
+                d[0] = gray; d[1] = gray; d[2] = gray; d[3] = 255;
+            }
+        }
+    }
+
+    if(diffPath != nullptr && differing > 0) IMG_SavePNG(diff, diffPath);
+
+    double fraction = (double)differing / ((long)actual->w * actual->h);
+    bool pass = fraction <= maxDiffering;
+
+    cout << (pass ? "[PASS] " : "[FAIL] ") << differing << " pixels differ ("
+         << fraction * 100 << "%), largest channel difference " << largest << endl;
+
+    SDL_FreeSurface(diff);
+    SDL_FreeSurface(expected);
+    SDL_FreeSurface(actual);
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+# Shared by run.sh and update.sh, sourced from the tests/golden directory
+
+ROOT="$(cd ../.. && pwd)"
+HERE="$(pwd)"
+OUT="$HERE/out"
+EXPECTED="$HERE/expected"
+
+# Examples with deterministic output, no DB, input or timing dependent content
+EXAMPLES="Button Rectangle Text Plot Layer"
+FRAME=30
+
+# Builds and runs the example headless, with the software renderer,
+# and captures its frame FRAME into $OUT/<name>.png
+capture(){
+    local name=$1
+    make -s -C "$ROOT/examples/$name"
+    rm -f "$OUT/$name.png" "$OUT/$name.diff.png"
+
+    # The examples load their assets relative to their own directory
+    (
+        cd "$ROOT/examples/$name"
+        SDL_VIDEODRIVER=dummy \
+        SDL_AUDIODRIVER=dummy \
+        LUMOS_HEADLESS=1 \
+        LUMOS_CAPTURE="$OUT/$name.png" \
+        LUMOS_CAPTURE_FRAME=$FRAME \
+        timeout 60 "./$name" > "$OUT/$name.log" 2>&1
+    ) || true
+
+    if [ ! -f "$OUT/$name.png" ]; then
+        echo "[FAIL] No frame captured, see $OUT/$name.log"
+        return 1
+    fi
+    return 0
+}
@@ -0,0 +1,50 @@
+#!/bin/bash
+# Golden image tests. Every example is rendered headless, with the software
+# renderer, a single frame of it is captured and compared to its expected
+# image in tests/golden/expected within a tolerance, so renderer changes
+# can't silently change the output. It never writes the expected images,
+# they are only re-created by ./update.sh after an intended change.
+#
+# An example without an expected image is still run, so it has to capture
+# its frame, but it is reported as having no baseline instead of failing.
+# To create the baselines, on a machine with SDL2 run ./update.sh, review
+# the images in tests/golden/expected and commit them.
+#
+# TOLERANCE (largest channel difference, 2) and MAX_DIFFERING (fraction of
+# differing pixels, 0.001) can be set in the environment.
+
+set -e
+cd "$(dirname "$0")"
+source ./common.sh
+
+TOLERANCE=${TOLERANCE:-2}
+MAX_DIFFERING=${MAX_DIFFERING:-0.001}
+
+make -s ImageDiff
+mkdir -p "$OUT"
+
+failed=0
+missing=0
+for name in $EXAMPLES; do
+    echo "[$name]"
+
+    if ! capture "$name"; then
+        failed=$((failed + 1))
+    elif [ ! -f "$EXPECTED/$name.png" ]; then
+        # Never created here, there would be nothing to catch a wrong one
+        echo "[NO BASELINE] No expected image $EXPECTED/$name.png, create it with ./update.sh $name, review it and commit it"
+        missing=$((missing + 1))
+    elif ! ./ImageDiff "$EXPECTED/$name.png" "$OUT/$name.png" $TOLERANCE $MAX_DIFFERING "$OUT/$name.diff.png"; then
+        echo "       Differing pixels are in $OUT/$name.diff.png"
+        failed=$((failed + 1))
+    fi
+done
+
+if [ $missing -ne 0 ]; then
+    echo "$missing golden image test(s) have no baseline and were not compared"
+fi
+if [ $failed -ne 0 ]; then
+    echo "$failed golden image test(s) failed"
+    exit 1
+fi
+echo "All golden image tests with a baseline passed"
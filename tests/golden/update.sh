@@ -0,0 +1,30 @@
+#!/bin/bash
+# Re-creates the expected images of the golden image tests, after an
+# intended change of the output. Review them before committing them,
+# ./run.sh compares against whatever is in tests/golden/expected.
+#
+#   ./update.sh             Every example
+#   ./update.sh Button Plot Only the given ones
+
+set -e
+cd "$(dirname "$0")"
+source ./common.sh
+
+if [ $# -gt 0 ]; then EXAMPLES="$*"; fi
+mkdir -p "$OUT" "$EXPECTED"
+
+failed=0
+for name in $EXAMPLES; do
+    echo "[$name]"
+    if capture "$name"; then
+        cp "$OUT/$name.png" "$EXPECTED/$name.png"
+        echo "[UPDATED] $EXPECTED/$name.png"
+    else
+        failed=$((failed + 1))
+    fi
+done
+
+if [ $failed -ne 0 ]; then
+    echo "$failed expected image(s) could not be created"
+    exit 1
+fi
@@ -0,0 +1,20 @@
+// Shared by the unit tests, every test is its own executable returning
+// the number of failed checks, so run.sh only looks at the exit code
+#pragma once
+#ifndef MySDL_TESTS_CHECK
+#define MySDL_TESTS_CHECK
+
+#include <iostream>
+
+inline int checkFailures = 0;
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if(!(cond)){                                                                    \
+            std::cout << "[FAIL] " << __FILE__ << ":" << __LINE__ << " " #cond << std::endl; \
+            checkFailures++;                                                            \
+        }                                                                               \
+    } while(0)
+
+#endif
+// Creator: @AndrijaRD
@@ -0,0 +1,71 @@
+// Fills every glyph atlas page with non ASCII glyphs, so placing the next
+// one starts the atlas over in the middle of a draw, and checks the glyphs
+// are still drawn and the atlas keeps working after it.
+
+#include "../../lib/Lumos.h"
+#include "Check.h"
+
+
+static string utf8(Uint32 codepoint){
+    string out;
+    if(codepoint < 0x80){
+        out += (char)codepoint;
+    } else if(codepoint < 0x800){
+        out += (char)(0xC0 | (codepoint >> 6));
+        out += (char)(0x80 | (codepoint & 0x3F));
+    } else {
+        out += (char)(0xE0 | (codepoint >> 12));
+        out += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out += (char)(0x80 | (codepoint & 0x3F));
+    }
+    return out;
+}
+
+
+
+int main(){
+    if(Sys::initWindow("GlyphAtlas Test") != NO_ERROR) return 1;
+    if(Sys::initFont("../../assets/fonts/font.ttf") != NO_ERROR) return 1;
+
+    // Every non ASCII glyph the font has, two to a string so the reset
+    // can come between the glyphs of one draw
+    TTF_Font* font = Fonts::getSize(FONT_REFERENCE_SIZE);
+    vector<Uint32> codepoints;
+    for(Uint32 c = 0xC0; c < 0xFFFF; c++){
+        if(TTF_GlyphIsProvided32(font, c)) codepoints.push_back(c);
+    }
+    CHECK(codepoints.size() > 2);
+
+    // Pages are shared by every size, the larger ones fill them faster,
+    // solid glyphs are a face of their own
+    int fullPages = 0;
+    for(int height = 400; height >= 40 && GlyphAtlas::getStats().resets == 0; height -= 40){
+        for(int quality : {TEXT_BLENDED, TEXT_SOLID}){
+            for(size_t i = 0; i + 1 < codepoints.size(); i += 2){
+                int pagesBefore = GlyphAtlas::getStats().pages;
+                Uint64 resetsBefore = GlyphAtlas::getStats().resets;
+
+                string text = utf8(codepoints[i]) + utf8(codepoints[i + 1]);
+                SDL_Rect dRect = {0, 0, -1, height};
+                CHECK(GlyphAtlas::draw(text, dRect, SDL_COLOR_WHITE, quality) == NO_ERROR);
+
+                if(GlyphAtlas::getStats().resets != resetsBefore) fullPages = pagesBefore;
+            }
+        }
+    }
+
+    GlyphAtlasStats stats = GlyphAtlas::getStats();
+    CHECK(stats.resets > 0);
+    CHECK(fullPages == GLYPH_ATLAS_MAX_PAGES);
+    CHECK(stats.pages >= 1 && stats.pages <= GLYPH_ATLAS_MAX_PAGES);
+
+    // Glyphs from before the reset are rasterized again
+    Uint64 rasterized = stats.rasterized;
+    SDL_Rect dRect = {0, 0, -1, 100};
+    CHECK(GlyphAtlas::draw(utf8(codepoints[0]) + utf8(codepoints[1]) + "Ab", dRect, SDL_COLOR_WHITE) == NO_ERROR);
+    CHECK(GlyphAtlas::getStats().rasterized > rasterized);
+    CHECK(GlyphAtlas::getStats().glyphs > 0);
+
+    Sys::cleanup();
+    return checkFailures;
+}
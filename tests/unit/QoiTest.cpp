@@ -0,0 +1,75 @@
+// Decodes hand made QOI streams, and the encoder output, with the streaming
+// decoder, whole and fed a byte at a time.
+
+#include "../../lib/Lumos.h"
+#include "Check.h"
+
+
+static vector<Uint8> header(int width, int height){
+    vector<Uint8> out = {'q', 'o', 'i', 'f'};
+    for(int v : {width, height}){
+        for(int shift = 24; shift >= 0; shift -= 8) out.push_back((v >> shift) & 0xff);
+    }
+    out.push_back(4);   // Channels
+    out.push_back(0);   // Colorspace
+    return out;
+}
+
+
+
+static bool decode(const vector<Uint8>& stream, size_t chunk, vector<Uint8>& pixels){
+    QOIDecoder decoder([&](int width, int height, int& pitch){
+        pitch = width * 4;
+        pixels.assign((size_t)pitch * height, 0);
+        return pixels.data();
+    });
+
+    for(size_t pos = 0; pos < stream.size(); pos += chunk){
+        if(decoder.feed(stream.data() + pos, min(chunk, stream.size() - pos)) != NO_ERROR) return false;
+    }
+    return decoder.isDone();
+}
+
+
+
+int main(){
+    // A RUN OF THE STARTING PIXEL PUTS IT INTO THE INDEX -------------------------------
+    // (0, 0, 0, 255) hashes to 53, after the run QOI_OP_INDEX 53 has to be it
+    vector<Uint8> stream = header(3, 1);
+    stream.push_back(0xc0 | 1);     // QOI_OP_RUN of 2
+    stream.push_back(0x00 | 53);    // QOI_OP_INDEX 53
+    for(Uint8 b : {0, 0, 0, 0, 0, 0, 0, 1}) stream.push_back(b);
+
+    for(size_t chunk : {stream.size(), (size_t)1}){
+        vector<Uint8> pixels;
+        CHECK(decode(stream, chunk, pixels));
+        CHECK(pixels.size() == 12);
+        for(size_t i = 0; i + 3 < pixels.size(); i += 4){
+            CHECK(pixels[i] == 0 && pixels[i + 1] == 0 && pixels[i + 2] == 0 && pixels[i + 3] == 255);
+        }
+    }
+
+    // ENCODED IMAGES DECODE TO THE SAME PIXELS -----------------------------------------
+    int width = 37, height = 11;
+    vector<Uint8> image((size_t)width * height * 4);
+    Uint32 seed = 1;
+    for(size_t i = 0; i < image.size(); i += 4){
+        seed = seed * 1103515245 + 12345;
+        // Runs, small differences and repeated colors, so every op is used
+        Uint8 value = (seed >> 16) % 5 == 0 ? (seed >> 8) & 0xff : image[i >= 4 ? i - 4 : i] + (seed >> 20) % 3;
+        image[i] = value;
+        image[i + 1] = value / 2;
+        image[i + 2] = (seed >> 24) % 4 == 0 ? value : 0;
+        image[i + 3] = (seed >> 12) % 7 == 0 ? 128 : 255;
+    }
+
+    vector<Uint8> encoded;
+    QOI::encode(image.data(), width, height, encoded);
+    for(size_t chunk : {encoded.size(), (size_t)1, (size_t)7}){
+        vector<Uint8> pixels;
+        CHECK(decode(encoded, chunk, pixels));
+        CHECK(pixels == image);
+    }
+
+    return checkFailures;
+}
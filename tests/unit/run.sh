@@ -0,0 +1,29 @@
+#!/bin/bash
+# Unit tests. Every *Test.cpp is built, with the address sanitizer, into
+# its own executable and run headless, with the software renderer. A test
+# fails when it exits with anything but 0.
+
+set -e
+cd "$(dirname "$0")"
+
+make -s
+
+failed=0
+for test in *Test.cpp; do
+    name=${test%.cpp}
+    echo "[$name]"
+
+    if ! SDL_VIDEODRIVER=dummy \
+         SDL_AUDIODRIVER=dummy \
+         LUMOS_HEADLESS=1 \
+         timeout 120 "./$name"; then
+        echo "[FAIL] $name"
+        failed=$((failed + 1))
+    fi
+done
+
+if [ $failed -ne 0 ]; then
+    echo "$failed unit test(s) failed"
+    exit 1
+fi
+echo "All unit tests passed"